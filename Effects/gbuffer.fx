@@ -119,6 +119,7 @@ cbuffer TerrainCB : register(b1)
 	uint terrainHeightmapSz;
 	float terrainSegSz;
 	uint terrainNumLayers;
+	float3 terrainOrigin; // world origin, subtracted from the vertex positions
 	float4 terrainLayerParams[MAX_TERRAIN_LAYERS_IN_SHADER]; // (scale, UNUSED, UNUSED, UNUSED)
 }
 
@@ -190,9 +191,12 @@ VS_OUTPUT VS_GBufferTerrain(VS_INPUT IN)
 	// Sample vertex height from vertex heightmap texture
 	float4 wPos = float4(IN.Position, 1.0f);
 	wPos.y = SampleVertexHeightmapBilinear(IN.TexCoord) * terrainMaxHeight;
-	OUT.WorldPos = wPos.xyz;
 
-	float4 vsPos = mul(mtxView, wPos);
+	// Relative to the world origin, as the rest of the scene
+	float4 rPos = float4(wPos.xyz - terrainOrigin, 1.0f);
+	OUT.WorldPos = rPos.xyz;
+
+	float4 vsPos = mul(mtxView, rPos);
 	OUT.ViewSpacePos = vsPos.xyz;
 	OUT.Position = mul(mtxProj, vsPos);
 
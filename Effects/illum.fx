@@ -518,6 +518,7 @@ cbuffer TerrainCB : register(b1)
 	uint terrainHeightmapSz;
 	float terrainSegSz;
 	uint terrainNumLayers;
+	float3 terrainOrigin; // world origin, subtracted from the vertex positions
 	float4 terrainLayerParams[MAX_TERRAIN_LAYERS_IN_SHADER]; // (scale, UNUSED, UNUSED, UNUSED)
 }
 
@@ -588,8 +589,11 @@ VS_OUTPUT VS_DeferredShadingTerrain(VS_INPUT IN)
 	float4 wPos = float4(IN.Position, 1.0f);
 	wPos.y = SampleVertexHeightmapBilinear(IN.TexCoord) * terrainMaxHeight;
 
-	float4 viewPos = mul(mtxView, wPos);
-	OUT.WorldPosAndDepth = float4(wPos.xyz, viewPos.z);
+	// Relative to the world origin, as the rest of the scene
+	float4 rPos = float4(wPos.xyz - terrainOrigin, 1.0f);
+
+	float4 viewPos = mul(mtxView, rPos);
+	OUT.WorldPosAndDepth = float4(rPos.xyz, viewPos.z);
 	OUT.Position = mul(mtxProj, viewPos);
 	OUT.TexCoord = IN.TexCoord;
 
@@ -626,7 +630,7 @@ PS_OUTPUT_DEFERRED_SHADING PS_DeferredShadingTerrain(VS_OUTPUT IN)
 		terrainTC.z = (float)iLayer;
 		float maskSample = terrainLayerMask.Sample(LinearSampler, terrainTC).r;
 
-		detailmapTC.xy = IN.WorldPosAndDepth.xz / terrainLayerParams[iLayer].x;
+		detailmapTC.xy = (IN.WorldPosAndDepth.xz + terrainOrigin.xz) / terrainLayerParams[iLayer].x;
 		detailmapTC.z = (float)iLayer;
 		float3 textureMapSample = TextureMap.Sample(LinearSampler, detailmapTC).rgb;
 
@@ -51,12 +51,31 @@ struct S_API SHUDElement
 
 //////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 
+#define SP_MAX_SHADOW_CASCADES 4
+
 struct S_API SEnvironmentSettings
 {
 	Vec3f sunPosition;
 	SColor sunIntensity;
 	float fogStart;
 	float fogEnd;
+
+	unsigned int numShadowCascades; // 1 to SP_MAX_SHADOW_CASCADES
+	float shadowDistance; // view distance covered by all shadow cascades
+	float shadowSplitLambda; // 0 = uniform splits, 1 = logarithmic splits
+
+	SEnvironmentSettings()
+		: numShadowCascades(1),
+		shadowDistance(35.0f),
+		shadowSplitLambda(0.75f)
+	{
+	}
+};
+
+struct S_API SShadowCascade
+{
+	Mat44 mtxViewProj; // sun view-projection matrix
+	float splitNear, splitFar; // range of the camera view distance covered by this cascade
 };
 
 //////////////////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -82,14 +101,24 @@ public:
 	ILINE virtual IMaterialManager* GetMaterialManager() = 0;
 	ILINE virtual IParticleSystem* GetParticleSystem() = 0;
 
-	template<class RenderMeshImpl> void SetRenderMeshImplementation() { SetRenderMeshPool(new ComponentPool<CRenderMesh, RenderMeshImpl>()); }
+	// Use Pool = ConcurrentComponentPool<CRenderMesh, RenderMeshImpl> to create meshes from multiple threads
+	template<class RenderMeshImpl, class Pool = ComponentPool<CRenderMesh, RenderMeshImpl>>
+	void SetRenderMeshImplementation() { SetRenderMeshPool(new Pool()); }
 	ILINE virtual CRenderMesh* CreateMesh(const SInitialGeometryDesc* pGeomDesc = 0) = 0;
 	ILINE virtual void ClearRenderMeshes() = 0;
 
-	template<class RenderLightImpl> void SetRenderLightImplementation() { SetRenderLightPool(new ComponentPool<CRenderLight, RenderLightImpl>()); }
+	// Handles can be stored instead of pointers and are safely resolved to 0 once the mesh was released
+	ILINE virtual ObjectPoolHandle GetMeshHandle(const CRenderMesh* pMesh) const = 0;
+	ILINE virtual CRenderMesh* ResolveMesh(const ObjectPoolHandle& handle) const = 0;
+
+	template<class RenderLightImpl, class Pool = ComponentPool<CRenderLight, RenderLightImpl>>
+	void SetRenderLightImplementation() { SetRenderLightPool(new Pool()); }
 	ILINE virtual CRenderLight* CreateLight() = 0;
 	ILINE virtual void ClearRenderLights() = 0;
 
+	ILINE virtual ObjectPoolHandle GetLightHandle(const CRenderLight* pLight) const = 0;
+	ILINE virtual CRenderLight* ResolveLight(const ObjectPoolHandle& handle) const = 0;
+
 
 	// Will not override existing prefabs!
 	template<typename T>
@@ -151,6 +180,9 @@ public:
 	ILINE virtual void SetEnvironmentSettings(const SEnvironmentSettings& settings) = 0;
 	ILINE virtual const SEnvironmentSettings& GetEnvironmentSettings() const = 0;
 
+	// Returns the sun shadow cascades of the last rendered frame. The first cascade is used for the shadow map.
+	ILINE virtual const SShadowCascade* GetShadowCascades(unsigned int* pNumCascades) const = 0;
+
 	ILINE virtual SHUDElement* CreateHUDElement() = 0;
 	ILINE virtual void RemoveHUDElement(SHUDElement** pHUDElement) = 0;
 
@@ -166,6 +198,12 @@ public:
 	// Render lastly collected visible objects
 	ILINE virtual void RenderCollected() = 0;
 
+	// Summary:
+	//	Moves the world origin to the given world position by translating all render objects once.
+	//	Meshes with a custom view-projection matrix are not translated. The camera is not translated.
+	ILINE virtual void RebaseOrigin(const Vec3d& origin) = 0;
+	ILINE virtual const Vec3d& GetOrigin() const = 0;
+
 	ILINE virtual void Clear() = 0;
 };
 
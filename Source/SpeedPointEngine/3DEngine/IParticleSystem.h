@@ -76,6 +76,9 @@ public:
 	const Vec3f& GetPos() const { return m_Params.position; }
 	void SetPos(const Vec3f& pos) { m_Params.position = pos; }
 
+	// Called by the particle system when the world origin moved
+	virtual void RebaseOrigin(const Vec3f& shift) { m_Params.position -= shift; }
+
 	const unsigned __int32& GetCurTime() const { return m_CurTime; }
 	const unsigned __int32& GetParticleLifetime() const { return m_ParticleLifetime; }
 
@@ -97,12 +100,16 @@ public:
 
 	virtual SResult Init(IRenderer* pRenderer) = 0;
 
-	template<class ParticleEmitterImpl>
-	void SetEmitterImplementation() { SetEmitterPool(new ComponentPool<CParticleEmitter, ParticleEmitterImpl>()); }
+	template<class ParticleEmitterImpl, class Pool = ComponentPool<CParticleEmitter, ParticleEmitterImpl>>
+	void SetEmitterImplementation() { SetEmitterPool(new Pool()); }
 
 	virtual CParticleEmitter* CreateEmitter(const SParticleEmitterParams& params = SParticleEmitterParams()) = 0;
 	virtual void ClearEmitters() = 0;
 
+	// Handles can be stored instead of pointers and are safely resolved to 0 once the emitter was released
+	virtual ObjectPoolHandle GetEmitterHandle(const CParticleEmitter* pEmitter) const = 0;
+	virtual CParticleEmitter* ResolveEmitter(const ObjectPoolHandle& handle) const = 0;
+
 	virtual void Clear() = 0;
 };
 
@@ -264,6 +264,13 @@ public:
 	virtual void RequireCBUpdate() = 0;
 
 	virtual void RequireRender() = 0;
+
+	// Summary:
+	//	Sets the world origin, the rendered terrain is translated by -origin.
+	//	The terrain queries above (GetMinXZ(), RayHeightmapIntersection(), ...) are not affected and
+	//	use the terrain space, which is the render space translated by +origin.
+	virtual void SetOrigin(const Vec3f& origin) = 0;
+	virtual const Vec3f& GetOrigin() const = 0;
 };
 
 SP_NMSPACE_END
\ No newline at end of file
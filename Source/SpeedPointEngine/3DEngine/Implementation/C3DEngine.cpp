@@ -4,6 +4,8 @@
 #include <Renderer\IResourcePool.h>
 #include <Common\SPrerequisites.h>
 #include <Common\ProfilingSystem.h>
+#include <Common\FrameMemory.h>
+#include <Common\TransformBatch.h>
 #include <sstream>
 #include <Windows.h>
 
@@ -24,7 +26,9 @@ S_API C3DEngine::C3DEngine(IRenderer* pRenderer)
 	m_pTerrain(0),
 	m_MatMgr(this),
 	m_pDebugTexture(0),
-	m_bDrawNormals(false)
+	m_bDrawNormals(false),
+	m_bSceneBoundsInvalid(true),
+	m_NumShadowCascades(0)
 {
 	CreateHelperPrefab<CPointHelper>();
 	CreateHelperPrefab<CVectorHelper>();
@@ -186,6 +190,7 @@ S_API void C3DEngine::SetRenderMeshPool(IComponentPool<CRenderMesh>* pPool)
 		delete m_pMeshes;
 
 	m_pMeshes = pPool;
+	m_bSceneBoundsInvalid = true;
 }
 
 S_API void C3DEngine::ClearRenderMeshes()
@@ -202,6 +207,8 @@ S_API void C3DEngine::ClearRenderMeshes()
 
 		m_pMeshes->ReleaseAll();
 	}
+
+	m_bSceneBoundsInvalid = true;
 }
 
 ILINE CRenderMesh* C3DEngine::CreateMesh(const SInitialGeometryDesc* pGeomDesc)
@@ -216,6 +223,22 @@ ILINE CRenderMesh* C3DEngine::CreateMesh(const SInitialGeometryDesc* pGeomDesc)
 	return mesh;
 }
 
+ILINE ObjectPoolHandle C3DEngine::GetMeshHandle(const CRenderMesh* pMesh) const
+{
+	if (!m_pMeshes)
+		return ObjectPoolHandle();
+
+	return m_pMeshes->GetHandle(pMesh);
+}
+
+ILINE CRenderMesh* C3DEngine::ResolveMesh(const ObjectPoolHandle& handle) const
+{
+	if (!m_pMeshes)
+		return 0;
+
+	return m_pMeshes->Resolve(handle);
+}
+
 //////////////////////////////////////////////////////////////////////////////////////////////
 
 S_API void C3DEngine::SetRenderLightPool(IComponentPool<CRenderLight>* pPool)
@@ -252,6 +275,22 @@ S_API CRenderLight* C3DEngine::CreateLight()
 	return m_pLights->Get();
 }
 
+S_API ObjectPoolHandle C3DEngine::GetLightHandle(const CRenderLight* pLight) const
+{
+	if (!m_pLights)
+		return ObjectPoolHandle();
+
+	return m_pLights->GetHandle(pLight);
+}
+
+S_API CRenderLight* C3DEngine::ResolveLight(const ObjectPoolHandle& handle) const
+{
+	if (!m_pLights)
+		return 0;
+
+	return m_pLights->Resolve(handle);
+}
+
 S_API void C3DEngine::CreateLightVolume(ELightType type, const SInitialGeometryDesc* pGeomDesc)
 {
 	IResourcePool* pResourcePool = 0;
@@ -290,6 +329,14 @@ S_API void C3DEngine::CreateLightVolume(ELightType type, const SInitialGeometryD
 
 //////////////////////////////////////////////////////////////////////////////////////////////
 
+// Returns true if aabb reaches the boundary of bounds, so bounds might shrink without it.
+// Always false for an empty aabb.
+static inline bool TouchesBoundary(const AABB& aabb, const AABB& bounds)
+{
+	return aabb.vMin.x <= bounds.vMin.x || aabb.vMin.y <= bounds.vMin.y || aabb.vMin.z <= bounds.vMin.z
+		|| aabb.vMax.x >= bounds.vMax.x || aabb.vMax.y >= bounds.vMax.y || aabb.vMax.z >= bounds.vMax.z;
+}
+
 S_API unsigned int C3DEngine::CollectVisibleObjects(const SCamera* pCamera)
 {
 	unsigned int budgetTimer = ProfilingSystem::StartSection("C3DEngine::CollectVisibleObjects()");
@@ -311,19 +358,115 @@ S_API unsigned int C3DEngine::CollectVisibleObjects(const SCamera* pCamera)
 	m_ParticleSystem.Update(0.0f);
 
 	// MESHES
-	m_GlobalAABB.Reset();
-	unsigned int itMesh = 0;
-	CRenderMesh* pMesh = m_pMeshes->GetFirst(itMesh);
-	while (pMesh)
+	// The pool is iterated once. The meshes and their world AABBs are collected into a snapshot
+	// that is culled and written back by index, so meshes created by other threads meanwhile
+	// do not shift the visibility bits. They are collected in the next frame.
+	// Only meshes whose transform or geometry changed are transformed, in one batch.
+	// Their new world AABBs grow the scene bounds. The bounds are rebuilt if they may have
+	// shrunk, i.e. if a removed or changed mesh had its old world AABB on the boundary.
+	FrameVector<CRenderMesh*> meshes;
+	FrameVector<AABB> aabbs;
+	meshes.reserve(m_pMeshes->GetNumObjects());
+	aabbs.reserve(m_pMeshes->GetNumObjects());
+
+	FrameVector<unsigned int> changed; // indices into meshes
+	FrameVector<AABB> changedAABBs;
+	FrameVector<const Mat44*> changedTransforms;
+	m_pMeshes->ForEach([this, &meshes, &aabbs, &changed, &changedAABBs, &changedTransforms](CRenderMesh* pMesh)
 	{
-		AABB aabb = pMesh->GetAABB().Transform(pMesh->GetRenderDesc()->transform);
-		m_GlobalAABB.AddAABB(aabb);
+		if (pMesh->IsTrash())
+		{
+			if (TouchesBoundary(pMesh->GetWorldAABB(), m_SceneBounds))
+				m_bSceneBoundsInvalid = true;
 
-		pMesh = m_pMeshes->GetNext(itMesh);
+			m_pMeshes->Release(&pMesh);
+			return;
+		}
+
+		if (pMesh->IsWorldAABBInvalid())
+		{
+			if (TouchesBoundary(pMesh->GetWorldAABB(), m_SceneBounds))
+				m_bSceneBoundsInvalid = true;
+
+			changed.push_back((unsigned int)meshes.size());
+			changedAABBs.push_back(pMesh->GetAABB());
+			changedTransforms.push_back(&pMesh->GetRenderDesc()->transform);
+		}
+
+		meshes.push_back(pMesh);
+		aabbs.push_back(pMesh->GetWorldAABB());
+	});
+
+	if (!changed.empty())
+	{
+		TransformAABBs(&changedTransforms[0], &changedAABBs[0], &changedAABBs[0], (unsigned int)changedAABBs.size());
+		for (size_t i = 0; i < changed.size(); ++i)
+		{
+			meshes[changed[i]]->SetWorldAABB(changedAABBs[i]);
+			aabbs[changed[i]] = changedAABBs[i];
+			if (!m_bSceneBoundsInvalid)
+				m_SceneBounds.AddAABB(changedAABBs[i]);
+		}
+	}
+
+	if (m_bSceneBoundsInvalid)
+	{
+		m_SceneBounds.Reset();
+		for (auto itAABB = aabbs.begin(); itAABB != aabbs.end(); ++itAABB)
+			m_SceneBounds.AddAABB(*itAABB);
+
+		m_bSceneBoundsInvalid = false;
+	}
+
+	// Cull against the camera view frustum
+	IViewport* pViewport = m_pRenderer->GetTargetViewport();
+	pViewport->RecalculateCameraViewMatrix();
+	ViewFrustum frustum(pViewport->GetCameraViewMatrix(), pViewport->GetProjectionMatrix());
+
+	unsigned int nVisible = 0;
+	if (!aabbs.empty())
+	{
+		FrameVector<unsigned int> visible((aabbs.size() + 31) / 32);
+		nVisible = frustum.CullAABBs(&aabbs[0], (unsigned int)aabbs.size(), &visible[0]);
+
+		for (size_t i = 0; i < meshes.size(); ++i)
+			meshes[i]->SetVisible(((visible[i >> 5] >> (i & 31)) & 1) != 0);
 	}
 
 	ProfilingSystem::EndSection(budgetTimer);
-	return 0;
+	return nVisible;
+}
+
+S_API void C3DEngine::RebaseOrigin(const Vec3d& origin)
+{
+	Vec3f shift = Vec3f(origin - m_Origin);
+	m_Origin = origin;
+
+	// Meshes and lights of entities are overwritten in OnRender() anyway, so translate all of them.
+	// The world transforms are affine, so translating them only changes the last column.
+	if (m_pMeshes)
+	{
+		m_pMeshes->ForEach([&shift](CRenderMesh* pMesh)
+		{
+			SRenderDesc* pDesc = pMesh->GetRenderDesc();
+			if (pDesc->bCustomViewProjMtx)
+				return;
+
+			pDesc->transform._14 -= shift.x;
+			pDesc->transform._24 -= shift.y;
+			pDesc->transform._34 -= shift.z;
+		});
+	}
+
+	if (m_pLights)
+		m_pLights->ForEach([&shift](CRenderLight* pLight) { pLight->GetParams().position -= shift; });
+
+	m_ParticleSystem.RebaseOrigin(shift);
+
+	if (IS_VALID_PTR(m_pTerrain))
+		m_pTerrain->SetOrigin(Vec3f(origin));
+
+	m_bSceneBoundsInvalid = true;
 }
 
 
@@ -414,6 +557,7 @@ S_API ITerrain* C3DEngine::CreateTerrain(const STerrainParams& params)
 	ClearTerrain();
 	m_pTerrain = new Terrain();
 	m_pTerrain->Init(m_pRenderer, params);
+	m_pTerrain->SetOrigin(Vec3f(m_Origin));
 	return m_pTerrain;
 }
 
@@ -510,68 +654,113 @@ S_API void C3DEngine::SetEnvironmentSettings(const SEnvironmentSettings& env)
 
 //////////////////////////////////////////////////////////////////////////////////////////////
 
-S_API void C3DEngine::UpdateSunViewProj()
+// Practical split scheme (F. Zhang et al.): blends the logarithmic and the uniform split distance
+static inline float CalculateShadowCascadeSplit(float nearZ, float farZ, unsigned int i, unsigned int numCascades, float lambda)
 {
-	// Calculate the minimum orthogonal view frustum for the sun that fits the camera view frustum
+	float t = (float)i / (float)numCascades;
+	float logSplit = nearZ * powf(farZ / nearZ, t);
+	float uniformSplit = nearZ + (farZ - nearZ) * t;
+	return lambda * logSplit + (1.0f - lambda) * uniformSplit;
+}
 
-	SSceneConstants* pSceneConstants = m_pRenderer->GetSceneConstants();
+S_API void C3DEngine::UpdateShadowCascades()
+{
+	// Each cascade encloses the bounding sphere of its slice of the camera view frustum, so its size does
+	// not change when the camera rotates. Its position is snapped to shadow map texels, so the shadow
+	// edges do not shimmer when the camera moves. Only the scene bounds are used to pull the near plane
+	// towards the sun for casters outside the view frustum, so the cost does not depend on the mesh count.
 
-	m_pRenderer->GetTargetViewport()->RecalculateCameraViewMatrix();
-	const Mat44& mtxView = m_pRenderer->GetTargetViewport()->GetCameraViewMatrix();
-	const Mat44& mtxProj = m_pRenderer->GetTargetViewport()->GetProjectionMatrix();
+	SSceneConstants* pSceneConstants = m_pRenderer->GetSceneConstants();
+	const SEnvironmentSettings& env = m_EnvironmentSettings;
 
-	const float maxCamZ = -35.0f;
-	const Vec3f dirToSunNormalized = Vec3Normalize(pSceneConstants->sunPosition.xyz());
+	IViewport* pViewport = m_pRenderer->GetTargetViewport();
+	pViewport->RecalculateCameraViewMatrix();
+	const Mat44& mtxView = pViewport->GetCameraViewMatrix();
+	const Mat44& mtxProj = pViewport->GetProjectionMatrix();
 
-	ViewFrustum frustum(mtxView, mtxProj); // camera view frustum
-	Vec3f camFrustumCorners[8]; // in view-space of camera
+	ViewFrustum frustum(mtxView, mtxProj);
+	Vec3f camFrustumCorners[8]; // in view-space of camera, looking down -z
 	frustum.GetCorners(camFrustumCorners, true);
-	float nearZ = camFrustumCorners[0].z;
-	float farZ = camFrustumCorners[4].z;	
-	float farZScale = (farZ < maxCamZ) ? (maxCamZ / (farZ - nearZ)) : 1.0f; // Limit maximum z
-
-	Vec3f globalAABBCorners[8];
-	m_GlobalAABB.GetCorners(globalAABBCorners);
+	float nearZ = -camFrustumCorners[0].z;
+	float farZ = min(-camFrustumCorners[4].z, env.shadowDistance);
 
-	Mat44 mtxViewInv = SMatrixInvert(mtxView);
-	SMatrixTranspose(&mtxViewInv);
+	// View matrices are rigid. mtxView is used with row vectors, so transpose it first.
+	Mat44 mtxViewInv = SMatrixInvertRigid(SMatrixTranspose(mtxView));
 
-	Mat44 mtxSunView;
-	SPMatrixLookAtRH(&mtxSunView, dirToSunNormalized, Vec3f(0), Vec3f(0, 1.0f, 0));
-	SMatrixTranspose(&mtxSunView);
+	// Sun basis, same as the one built by SPMatrixLookAtRH()
+	const Vec3f sunZ = Vec3Normalize(pSceneConstants->sunPosition.xyz());
+	const Vec3f up = (fabsf(sunZ.y) > 0.99f) ? Vec3f(0, 0, 1.0f) : Vec3f(0, 1.0f, 0);
+	const Vec3f sunX = Vec3Normalize(Vec3Cross(up, sunZ));
+	const Vec3f sunY = Vec3Cross(sunZ, sunX);
 
-	AABB aabb; // in view-space of light
-	aabb.Reset();
-	for (int i = 0; i < 8; ++i)
+	// Most sun-ward point of the scene
+	float sceneTopZ = -FLT_MAX;
+	if (m_SceneBounds.vMin.x <= m_SceneBounds.vMax.x)
 	{
-		// Cam frustum corner
-		if (i >= 4)
-			camFrustumCorners[i] = camFrustumCorners[i - 4] + farZScale * (camFrustumCorners[i] - camFrustumCorners[i - 4]);
-
-		aabb.AddPoint((mtxSunView * (mtxViewInv * Vec4f(camFrustumCorners[i], 1.0f))).xyz());
-
-		// Global aabb corner
-		float z =
-			mtxSunView._31 * globalAABBCorners[i].x +
-			mtxSunView._32 * globalAABBCorners[i].y +
-			mtxSunView._33 * globalAABBCorners[i].z +
-			mtxSunView._34;
-		Vec3f p = (mtxSunView * Vec4f(globalAABBCorners[i], 1.0f)).xyz();
-
-		if (z > aabb.vMax.z)
-			aabb.vMax.z = z;
+		Vec3f sceneCorners[8];
+		m_SceneBounds.GetCorners(sceneCorners);
+		for (int i = 0; i < 8; ++i)
+			sceneTopZ = max(sceneTopZ, Vec3Dot(sunZ, sceneCorners[i]));
 	}
 
-	Mat44 mtxSunViewInv = SMatrixInvert(mtxSunView);
-	Vec3f fittedSunPosVS = (Vec3f(aabb.vMin.x, aabb.vMin.y, aabb.vMax.z) + Vec3f(aabb.vMax.x, aabb.vMax.y, aabb.vMax.z)) * 0.5f;
-	Vec3f fittedSunPos = (mtxSunViewInv * Vec4f(fittedSunPosVS, 1.0f)).xyz();
+	float shadowMapRes = (float)max(pSceneConstants->shadowMapRes[0], 1u);
+
+	m_NumShadowCascades = max(min(env.numShadowCascades, (unsigned int)SP_MAX_SHADOW_CASCADES), 1u);
+	for (unsigned int iCascade = 0; iCascade < m_NumShadowCascades; ++iCascade)
+	{
+		SShadowCascade& cascade = m_ShadowCascades[iCascade];
+		cascade.splitNear = CalculateShadowCascadeSplit(nearZ, farZ, iCascade, m_NumShadowCascades, env.shadowSplitLambda);
+		cascade.splitFar = CalculateShadowCascadeSplit(nearZ, farZ, iCascade + 1, m_NumShadowCascades, env.shadowSplitLambda);
+
+		// Slice corners lie on the rays through the near plane corners
+		Vec3f sliceCorners[8];
+		Vec3f sliceCenter(0);
+		for (int i = 0; i < 4; ++i)
+		{
+			sliceCorners[i] = camFrustumCorners[i] * (cascade.splitNear / nearZ);
+			sliceCorners[i + 4] = camFrustumCorners[i] * (cascade.splitFar / nearZ);
+			sliceCenter += sliceCorners[i] + sliceCorners[i + 4];
+		}
 
-	SPMatrixLookAtRH(&mtxSunView, fittedSunPos, fittedSunPos - dirToSunNormalized, Vec3f(0, 1.0f, 0));
+		sliceCenter *= 0.125f;
 
-	Mat44 mtxSunProj;
-	SPMatrixOrthoRH(&mtxSunProj, aabb.vMax.x - aabb.vMin.x, aabb.vMax.y - aabb.vMin.y, 0, (aabb.vMax.z - aabb.vMin.z));
+		float radius = 0;
+		for (int i = 0; i < 8; ++i)
+			radius = max(radius, (sliceCorners[i] - sliceCenter).LengthSq());
 
-	pSceneConstants->mtxSunViewProj = mtxSunView * mtxSunProj;
+		radius = sqrtf(radius);
+
+		// Snap the center to texels in sun space
+		Vec3f center = (mtxViewInv * Vec4f(sliceCenter, 1.0f)).xyz();
+		float texelSz = (2.0f * radius) / shadowMapRes;
+		float x = floorf(Vec3Dot(sunX, center) / texelSz) * texelSz;
+		float y = floorf(Vec3Dot(sunY, center) / texelSz) * texelSz;
+		float z = Vec3Dot(sunZ, center);
+		float topZ = max(z + radius, sceneTopZ);
+
+		// Same as SPMatrixLookAtRH() with eye = sunX * x + sunY * y + sunZ * topZ, but without recalculating
+		// the basis from the eye position, which would lose the snapping to rounding errors.
+		Mat44 mtxSunView(
+			SVector4(sunX.x, sunY.x, sunZ.x, 0),
+			SVector4(sunX.y, sunY.y, sunZ.y, 0),
+			SVector4(sunX.z, sunY.z, sunZ.z, 0),
+			SVector4(-x, -y, -topZ, 1.0f));
+
+		Mat44 mtxSunProj;
+		SPMatrixOrthoRH(&mtxSunProj, 2.0f * radius, 2.0f * radius, 0, topZ - (z - radius));
+
+		cascade.mtxViewProj = mtxSunView * mtxSunProj;
+	}
+
+	pSceneConstants->mtxSunViewProj = m_ShadowCascades[0].mtxViewProj;
+}
+
+S_API const SShadowCascade* C3DEngine::GetShadowCascades(unsigned int* pNumCascades) const
+{
+	if (pNumCascades)
+		*pNumCascades = m_NumShadowCascades;
+
+	return m_ShadowCascades;
 }
 
 //////////////////////////////////////////////////////////////////////////////////////////////
@@ -580,14 +769,14 @@ S_API void C3DEngine::RenderCollected()
 {
 	unsigned int budgetTimer = ProfilingSystem::StartSection("C3DEngine::RenderCollected()");
 	{
-		UpdateSunViewProj();
+		UpdateShadowCascades();
 		m_pRenderer->UpdateSceneConstants();
 		
 		// Shadowmap Prepass
-		// TODO: Only render objects that are inside the ViewFrustum !!!!!
+		// Objects outside the camera view frustum may still cast shadows into it
 		m_pRenderer->StartDebugSection("Sun Shadowmap Pass");
 		m_pRenderer->BindShaderPass(eSHADERPASS_SHADOWMAP);
-		RenderMeshes(RENDERFLAG_RENDER_OPAQUE);
+		RenderMeshes(RENDERFLAG_RENDER_OPAQUE, false);
 
 		// Skybox
 		if (IS_VALID_PTR(m_pSkyBox))
@@ -652,20 +841,21 @@ S_API void C3DEngine::RenderCollected()
 
 //////////////////////////////////////////////////////////////////////////////////////////////
 
-S_API void C3DEngine::RenderMeshes(unsigned int flags)
+S_API void C3DEngine::RenderMeshes(unsigned int flags, bool visibleOnly /*= true*/)
 {
 	if (!m_pMeshes)
 		return;
 
-	stringstream objectsTimerName;
-	objectsTimerName << "C3DEngine::RenderCollected() - Render RenderObjects (" << m_pMeshes->GetNumObjects() << ")";
+	const size_t objectsTimerNameSz = 96;
+	char* objectsTimerName = (char*)FrameMemory::Allocate(objectsTimerNameSz);
+	sprintf_s(objectsTimerName, objectsTimerNameSz, "C3DEngine::RenderCollected() - Render RenderObjects (%u)", m_pMeshes->GetNumObjects());
 
-	unsigned int renderObjectsTimer = ProfilingSystem::StartSection(objectsTimerName.str().c_str());
+	unsigned int renderObjectsTimer = ProfilingSystem::StartSection(objectsTimerName);
 	{
-		unsigned int itMesh;
-		CRenderMesh* pMesh = m_pMeshes->GetFirst(itMesh);
-		while (pMesh)
+		m_pMeshes->ForEach([this, flags, visibleOnly](CRenderMesh* pMesh)
 		{
+			if (visibleOnly && !pMesh->IsVisible())
+				return;
 
 #ifdef _DEBUG		
 			if (m_pRenderer->DumpingThisFrame())
@@ -680,10 +870,7 @@ S_API void C3DEngine::RenderMeshes(unsigned int flags)
 				DrawNormalsForMesh(rd);
 
 			m_pRenderer->Render(*rd, flags);
-
-			pMesh = m_pMeshes->GetNext(itMesh);
-
-		}
+		});
 
 		ProfilingSystem::EndSection(renderObjectsTimer);
 	}
@@ -29,7 +29,15 @@ private:
 	IComponentPool<CRenderMesh>* m_pMeshes;
 	IComponentPool<CRenderLight>* m_pLights;
 
-	AABB m_GlobalAABB;
+	// Bounds of all meshes. Grown by meshes whose world AABB changed and only rebuilt from the
+	// cached world AABBs if the bounds may have shrunk: a mesh was removed, a mesh moved away from
+	// the boundary, or the origin was rebased.
+	AABB m_SceneBounds;
+	bool m_bSceneBoundsInvalid;
+
+	SShadowCascade m_ShadowCascades[SP_MAX_SHADOW_CASCADES];
+	unsigned int m_NumShadowCascades;
+	Vec3d m_Origin;
 
 	ChunkedObjectPool<SHelperRenderObject> m_HelperPool;
 	map<unsigned int, SRenderDesc> m_HelperPrefabs; // index = (uint)type * 2 + (uint)bOutline
@@ -55,9 +63,10 @@ private:
 
 	void ClearHelperPrefabs();
 	void CreateHUDRenderDesc();
-	void UpdateSunViewProj();
+	void UpdateShadowCascades();
 
-	void RenderMeshes(unsigned int flags);
+	// visibleOnly - If true, skips meshes outside the camera view frustum
+	void RenderMeshes(unsigned int flags, bool visibleOnly = true);
 	void DrawNormalsForMesh(const SRenderDesc* rd);
 	void RenderHelpers();
 	void RenderDeferredLights();
@@ -91,9 +100,13 @@ public:
 
 	ILINE virtual CRenderMesh* CreateMesh(const SInitialGeometryDesc* pGeomDesc = 0);
 	ILINE virtual void ClearRenderMeshes();
+	ILINE virtual ObjectPoolHandle GetMeshHandle(const CRenderMesh* pMesh) const;
+	ILINE virtual CRenderMesh* ResolveMesh(const ObjectPoolHandle& handle) const;
 
 	ILINE virtual CRenderLight* CreateLight();
 	ILINE virtual void ClearRenderLights();
+	ILINE virtual ObjectPoolHandle GetLightHandle(const CRenderLight* pLight) const;
+	ILINE virtual CRenderLight* ResolveLight(const ObjectPoolHandle& handle) const;
 
 
 	ILINE virtual void ClearHelperRenderObjects();
@@ -102,10 +115,14 @@ public:
 
 	ILINE virtual void SetEnvironmentSettings(const SEnvironmentSettings& settings);
 	ILINE const SEnvironmentSettings& GetEnvironmentSettings() const { return m_EnvironmentSettings; };
+	ILINE virtual const SShadowCascade* GetShadowCascades(unsigned int* pNumCascades) const;
 
 	// Render lastly collected visible objects
 	ILINE virtual void RenderCollected();
 
+	ILINE virtual void RebaseOrigin(const Vec3d& origin);
+	ILINE virtual const Vec3d& GetOrigin() const { return m_Origin; }
+
 	ILINE virtual ITerrain* CreateTerrain(const STerrainParams& info);
 	ILINE virtual ITerrain* GetTerrain();
 	ILINE virtual void ClearTerrain();
@@ -510,7 +510,7 @@ const SHelperGeometryDesc* CVectorHelper::GetBaseGeometry(bool outline)
 	if (!geomInited)
 	{
 		geom.topology = PRIMITIVE_TYPE_LINES;
-		Vec3f n = Vec3f(0);
+		constexpr Vec3f n(0);
 		geom.vertices =
 		{
 			SVertex(0, 0, 0, n.x, n.y, n.z, 0, 0, 0, 0, 0, 1.0f, 1.0f, 1.0f),
@@ -546,7 +546,7 @@ const SHelperGeometryDesc* CLineHelper::GetBaseGeometry(bool outline)
 	if (!geomInited)
 	{
 		geom.topology = PRIMITIVE_TYPE_LINES;
-		Vec3f n = Vec3f(0);
+		constexpr Vec3f n(0);
 		geom.vertices =
 		{
 			SVertex(0, 0, 0, n.x, n.y, n.z, 0, 0, 0, 0, 0, 1.0f, 1.0f, 1.0f),
@@ -618,8 +618,9 @@ const SHelperGeometryDesc* CCylinderHelper::GetBaseGeometry(bool outline)
 
 	if (!geomInited)
 	{
-		const Vec3f bottom(0, 0, 0);
-		const Vec3f top(0, 1.0f, 0);
+		constexpr Vec3f bottom(0, 0, 0);
+		constexpr Vec3f top(0, 1.0f, 0);
+		constexpr Vec3f axis = top - bottom;
 		const float radius = 1.0f;
 		const unsigned int segments = 35;
 
@@ -640,7 +641,6 @@ const SHelperGeometryDesc* CCylinderHelper::GetBaseGeometry(bool outline)
 		geom.vertices[numMantleVerts] = SVertex(bottom.x, bottom.y, bottom.z);
 		geom.vertices[numMantleVerts + numCapVerts] = SVertex(top.x, top.y, top.z);
 
-		Vec3f axis = top - bottom;
 		Vec3f naxis = axis.Normalized();
 		Vec3f perp = ((Vec3f(-naxis.y, -naxis.z, naxis.x) ^ naxis) ^ naxis).Normalized() * radius;
 
@@ -902,6 +902,39 @@ CHelper* CreateHelperForShape(const geo::shape* pshape, const SColor& color, boo
 			pHelper = C3DEngine::Get()->AddHelper<CDynamicMeshHelper>(params);
 			pHelper->SetColor(color);
 
+			delete[] params.pVertices;
+			delete[] params.pIndices;
+			break;
+		}
+	case geo::eSHAPE_CONVEX_HULL:
+		{
+			const geo::convex_hull* phull = dynamic_cast<const geo::convex_hull*>(pshape);
+			if (!phull || !phull->data)
+				return 0;
+
+			// Flatten out triangles so we have sharp edges. The hull is drawn in local space with its transform.
+			const geo::convex_hull_data* pdata = phull->data;
+			CDynamicMeshHelper::Params params;
+			params.topology = PRIMITIVE_TYPE_TRIANGLELIST;
+			params.pVertices = new SVertex[params.numVertices = pdata->num_faces * 3];
+			params.pIndices = new SLargeIndex[params.numIndices = pdata->num_faces * 3];
+
+			for (unsigned int iface = 0; iface < pdata->num_faces; ++iface)
+			{
+				const Vec3f& n = pdata->normals[iface];
+				for (unsigned int i = iface * 3; i < iface * 3 + 3; ++i)
+				{
+					const Vec3f& p = pdata->points[pdata->indices[i]];
+					params.pVertices[i] = SVertex(p.x, p.y, p.z, n.x, n.y, n.z, 0, 0, 0);
+					params.pIndices[i] = (SLargeIndex)i;
+				}
+			}
+
+			CDynamicMeshHelper* pMeshHelper = C3DEngine::Get()->AddHelper<CDynamicMeshHelper>(params);
+			pMeshHelper->SetTransform(phull->transform);
+			pMeshHelper->SetColor(color);
+			pHelper = pMeshHelper;
+
 			delete[] params.pVertices;
 			delete[] params.pIndices;
 			break;
@@ -20,6 +20,7 @@
 #include <Renderer\IVertexBuffer.h>
 #include <Renderer\IIndexBuffer.h>
 #include <Common\BoundBox.h>
+#include <Common\MemoryTracker.h>
 #include <Common\FileUtils.h>
 #include <FileSPM.h>
 
@@ -109,6 +110,7 @@ S_API CGeometry::CGeometry()
 m_pVertexBuffer(0),
 m_pSubsets(0),
 m_nSubsets(0),
+m_DataBytes(0),
 m_RefCount(0)
 {
 }
@@ -147,12 +149,18 @@ S_API void CGeometry::Clear()
 			for (unsigned short iSubset = 0; iSubset < m_nSubsets; ++iSubset)
 				SP_SAFE_RELEASE(m_pSubsets[iSubset].pIndexBuffer);
 
-			delete[] m_pSubsets;
+			MemoryTracker::DeleteArray(eMEMTAG_GEOMETRY, m_pSubsets, m_nSubsets);
 		}
 	
 		m_pSubsets = 0;
 		m_nSubsets = 0;
 
+		if (m_DataBytes > 0)
+		{
+			MemoryTracker::OnFree(eMEMTAG_GEOMETRY, m_DataBytes);
+			m_DataBytes = 0;
+		}
+
 		SP_SAFE_RELEASE(m_pVertexBuffer);
 		m_pRenderer = nullptr;
 	}
@@ -290,6 +298,13 @@ S_API SResult CGeometry::Init(IRenderer* pRenderer, const SInitialGeometryDesc*
 		}
 
 		RETURN_ON_ERR(m_pVertexBuffer->Fill(pInitialGeom->pVertices, pInitialGeom->nVertices));
+
+		// The vertex and index buffers keep a shadow copy of the data
+		m_DataBytes = pInitialGeom->nVertices * sizeof(SVertex);
+		for (unsigned short iSubset = 0; IS_VALID_PTR(pInitialGeom->pSubsets) && iSubset < pInitialGeom->nSubsets; ++iSubset)
+			m_DataBytes += pInitialGeom->pSubsets[iSubset].nIndices * sizeof(SIndex);
+
+		MemoryTracker::OnAlloc(eMEMTAG_GEOMETRY, m_DataBytes);
 	}	
 
 
@@ -301,7 +316,7 @@ S_API SResult CGeometry::Init(IRenderer* pRenderer, const SInitialGeometryDesc*
 	{
 		// No material assigns given.
 		// init standard geometry with single (fallback) subset
-		m_pSubsets = new SGeomSubset[1];
+		m_pSubsets = MemoryTracker::NewArray<SGeomSubset>(eMEMTAG_GEOMETRY, 1);
 		m_nSubsets = 1;
 		SGeomSubset* pDefSubset = &m_pSubsets[0];
 
@@ -335,7 +350,7 @@ S_API SResult CGeometry::Init(IRenderer* pRenderer, const SInitialGeometryDesc*
 	{
 		// create and fill one subset per material
 		m_nSubsets = pInitialGeom->nSubsets;
-		m_pSubsets = new SGeomSubset[m_nSubsets];
+		m_pSubsets = MemoryTracker::NewArray<SGeomSubset>(eMEMTAG_GEOMETRY, m_nSubsets);
 		unsigned long indexOffset = 0;
 		for (unsigned short iSubset = 0; iSubset < m_nSubsets; ++iSubset)
 		{
@@ -357,19 +372,17 @@ S_API SResult CGeometry::Init(IRenderer* pRenderer, const SInitialGeometryDesc*
 			subset.indexOffset = indexOffset;
 
 			// fill index buffer with according indices
-			SIndex* pIndices = new SIndex[subsetGeom.nIndices];
+			SIndex* pIndices = MemoryTracker::NewArray<SIndex>(eMEMTAG_GEOMETRY, subsetGeom.nIndices);
 			indexOffset += subsetGeom.nIndices;
 
 			for (unsigned int iIndex = 0; iIndex < subsetGeom.nIndices; ++iIndex)
 				pIndices[iIndex] = subsetGeom.pIndices[iIndex];
 
-			if (Failure(subset.pIndexBuffer->Fill(pIndices, subsetGeom.nIndices, false)))
-			{
-				delete[] pIndices;
-				return S_ERROR;
-			}
+			SResult fillRes = subset.pIndexBuffer->Fill(pIndices, subsetGeom.nIndices, false);
+			MemoryTracker::DeleteArray(eMEMTAG_GEOMETRY, pIndices, subsetGeom.nIndices);
 
-			delete[] pIndices;
+			if (Failure(fillRes))
+				return S_ERROR;
 		}
 	}	
 
@@ -39,6 +39,7 @@ protected:
 	unsigned short m_nSubsets;
 	IVertexBuffer* m_pVertexBuffer;
 	EPrimitiveType m_PrimitiveType;
+	size_t m_DataBytes; // vertex and index data reported to the MemoryTracker
 
 private:
 	inline static void CalculateInitialNormalsOrTangents(const SInitialGeometryDesc* pInitialGeom);
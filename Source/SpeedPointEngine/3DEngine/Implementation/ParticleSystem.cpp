@@ -213,6 +213,12 @@ S_API void CParticleSystem::Update(float fTime)
 	}
 }
 
+S_API void CParticleSystem::RebaseOrigin(const Vec3f& shift)
+{
+	if (m_pEmitters)
+		m_pEmitters->ForEach([&shift](CParticleEmitter* pEmitter) { pEmitter->RebaseOrigin(shift); });
+}
+
 S_API void CParticleSystem::Render()
 {
 	if (!m_pEmitters)
@@ -291,6 +297,22 @@ S_API void CParticleSystem::ClearEmitters()
 	}
 }
 
+S_API ObjectPoolHandle CParticleSystem::GetEmitterHandle(const CParticleEmitter* pEmitter) const
+{
+	if (!m_pEmitters)
+		return ObjectPoolHandle();
+
+	return m_pEmitters->GetHandle(pEmitter);
+}
+
+S_API CParticleEmitter* CParticleSystem::ResolveEmitter(const ObjectPoolHandle& handle) const
+{
+	if (!m_pEmitters)
+		return 0;
+
+	return m_pEmitters->Resolve(handle);
+}
+
 S_API void CParticleSystem::Clear()
 {
 	ClearEmitters();
@@ -27,10 +27,15 @@ public:
 	void Update(float fTime);
 	void Render();
 
+	// Translates all emitters by -shift
+	void RebaseOrigin(const Vec3f& shift);
+
 public: // IParticleSystem
 	virtual SResult Init(IRenderer* pRenderer);
 	virtual CParticleEmitter* CreateEmitter(const SParticleEmitterParams& params = SParticleEmitterParams());
 	virtual void ClearEmitters();
+	virtual ObjectPoolHandle GetEmitterHandle(const CParticleEmitter* pEmitter) const;
+	virtual CParticleEmitter* ResolveEmitter(const ObjectPoolHandle& handle) const;
 	virtual void Clear();
 };
 
@@ -9,8 +9,11 @@ SP_NMSPACE_BEG
 
 S_API CRenderMesh::CRenderMesh()
 	: m_pGeometry(0),
-	m_bBoundBoxInvalid(true)
+	m_bBoundBoxInvalid(true),
+	m_bWorldAABBInvalid(true),
+	m_bVisible(true)
 {
+	m_WorldAABB.Reset();
 }
 
 S_API void CRenderMesh::Clear()
@@ -52,6 +55,15 @@ S_API SResult CRenderMesh::Init(IGeometry* pGeometry)
 {
 	Clear();
 
+	// The pool hands out released meshes again without constructing them, so drop the cached state
+	// of the previous mesh here. Not done in Clear(), as the 3DEngine still needs the world AABB of a
+	// released mesh to update the scene bounds.
+	m_bBoundBoxInvalid = true;
+	m_WorldAABB.Reset();
+	m_WorldAABBTransform = Mat44::Identity;
+	m_bWorldAABBInvalid = true;
+	m_bVisible = true;
+
 	if (!pGeometry)
 	{
 		// Do not initialize yet
@@ -9,6 +9,7 @@
 #include <Renderer\IResourcePool.h>
 #include <Renderer\ITexture.h>
 #include <Common\SVertex.h>
+#include <Common\MemoryTracker.h>
 
 SP_NMSPACE_BEG
 
@@ -349,7 +350,7 @@ S_API SResult Terrain::Init(IRenderer* pRenderer, const STerrainParams& params)
 		lodLvl.quadSegs = max(PowerOfTwo(iLodLvl), 1);
 		lodLvl.chunkQuads = params.chunkSegments / lodLvl.quadSegs;
 		lodLvl.nChunkVertices = pow2(lodLvl.chunkQuads + 1);
-		lodLvl.pChunkVertices = new SVertex[lodLvl.nChunkVertices];		
+		lodLvl.pChunkVertices = MemoryTracker::NewArray<SVertex>(eMEMTAG_TERRAIN, lodLvl.nChunkVertices);		
 		float fQuadSz = lodLvl.quadSegs * m_fSegSz;
 
 		/*
@@ -373,7 +374,8 @@ S_API SResult Terrain::Init(IRenderer* pRenderer, const STerrainParams& params)
 
 	// Initialize chunk array
 	unsigned long nChunks = pow2(params.segments / params.chunkSegments);
-	m_pChunks = new STerrainChunk[nChunks];
+	m_pChunks = MemoryTracker::NewArray<STerrainChunk>(eMEMTAG_TERRAIN, nChunks);
+	m_nChunks = nChunks;
 
 	// Initialize empty layer textures
 	IResourcePool* pResourcePool = m_pRenderer->GetResourcePool();
@@ -435,7 +437,7 @@ S_API void Terrain::GenLodLevelChunks(SCamera* pCamera)
 	printf("Ter: nChunks per side: %u, which makes %u overall chunks\n", nChunks, nChunks * nChunks);
 	*/
 
-	Vec3f camPos = pCamera->position;
+	Vec3f camPos = pCamera->position + m_Origin;
 	if (m_Params.center)
 		camPos += Vec3f(m_Params.size * 0.5f, 0, m_Params.size * 0.5f);
 
@@ -475,8 +477,8 @@ S_API void Terrain::GenLodLevelChunks(SCamera* pCamera)
 		*/
 
 		// Clear previous vertices and indices
-		SP_SAFE_DELETE_ARR(lodLvl.pVertices, 1);
-		SP_SAFE_DELETE_ARR(lodLvl.pIndices, 1);
+		MemoryTracker::DeleteArray(eMEMTAG_TERRAIN, lodLvl.pVertices, lodLvl.nVertices);
+		MemoryTracker::DeleteArray(eMEMTAG_TERRAIN, lodLvl.pIndices, lodLvl.nIndices);
 
 		// Release old hardware vb and ib
 		SP_SAFE_RELEASE(lodLvl.pVB);
@@ -493,8 +495,8 @@ g_MaxIdxAccum = lodLvl.nIndices;
 
 		if (lodLvl.nIndices > 0 && lodLvl.nVertices > 0)
 		{
-			lodLvl.pIndices = new SLargeIndex[lodLvl.nIndices];						
-			lodLvl.pVertices = new SVertex[lodLvl.nVertices];			
+			lodLvl.pIndices = MemoryTracker::NewArray<SLargeIndex>(eMEMTAG_TERRAIN, lodLvl.nIndices);
+			lodLvl.pVertices = MemoryTracker::NewArray<SVertex>(eMEMTAG_TERRAIN, lodLvl.nVertices);
 		}
 		else
 		{
@@ -930,6 +932,7 @@ S_API void Terrain::UpdateRenderDesc(STerrainRenderDesc* pTerrainRenderDesc)
 
 		pTerrainRenderDesc->constants.segmentSize = m_fSegSz;
 		pTerrainRenderDesc->constants.numLayers = m_nLayers;
+		pTerrainRenderDesc->constants.origin = m_Origin;
 
 		for (unsigned int i = 0; i < min(m_nLayers, MAX_TERRAIN_LAYERS_IN_SHADER); ++i)
 		{
@@ -1186,9 +1189,9 @@ S_API void Terrain::Clear(void)
 			SP_SAFE_RELEASE(lodLvl.pVB);
 			SP_SAFE_RELEASE(lodLvl.pIB);
 
-			SP_SAFE_DELETE_ARR(lodLvl.pChunkVertices, 1);
-			SP_SAFE_DELETE_ARR(lodLvl.pIndices, 1);
-			SP_SAFE_DELETE_ARR(lodLvl.pVertices, 1);
+			MemoryTracker::DeleteArray(eMEMTAG_TERRAIN, lodLvl.pChunkVertices, lodLvl.nChunkVertices);
+			MemoryTracker::DeleteArray(eMEMTAG_TERRAIN, lodLvl.pIndices, lodLvl.nIndices);
+			MemoryTracker::DeleteArray(eMEMTAG_TERRAIN, lodLvl.pVertices, lodLvl.nVertices);
 		}
 
 		delete[] m_pLodLevels;		
@@ -1196,7 +1199,7 @@ S_API void Terrain::Clear(void)
 	m_pLodLevels = 0;
 
 	// Delete chunk array
-	SP_SAFE_DELETE_ARR(m_pChunks, 1);
+	MemoryTracker::DeleteArray(eMEMTAG_TERRAIN, m_pChunks, m_nChunks);
 		
 	m_Params.nLodLevels = 0;
 	m_nChunks = 0;
@@ -54,6 +54,8 @@ private:
 	float m_fMaxHeight; // cached calculated, w/o height scale
 	float m_fMinHeight; // cached calculated, w/o height scale
 
+	Vec3f m_Origin;
+
 	// ------
 
 	SResult GenerateFlatVertexHeightmap(float baseHeight);
@@ -119,6 +121,9 @@ public:
 	ILINE virtual STerrainLayerDesc GetLayerDesc(unsigned int i) const;
 
 	virtual void RequireCBUpdate() { m_bRequireCBUpdate = true; }
+
+	virtual void SetOrigin(const Vec3f& origin) { m_Origin = origin; m_bRequireCBUpdate = true; }
+	virtual const Vec3f& GetOrigin() const { return m_Origin; }
 	virtual void RequireRender() { m_bRequireRender = true; }
 	
 	virtual void Clear(void);
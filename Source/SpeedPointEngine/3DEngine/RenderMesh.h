@@ -5,6 +5,7 @@
 #include <Renderer\IRenderer.h>
 #include <Renderer\IIndexBuffer.h>
 #include <Common\SVertex.h>
+#include <cstring>
 
 SP_NMSPACE_BEG
 
@@ -19,6 +20,12 @@ protected:
 	AABB m_AABB;
 	bool m_bBoundBoxInvalid;
 
+	AABB m_WorldAABB; // empty until the first SetWorldAABB()
+	Mat44 m_WorldAABBTransform; // transform that m_WorldAABB was calculated with
+	bool m_bWorldAABBInvalid;
+
+	bool m_bVisible;
+
 	virtual void Clear();
 
 public:
@@ -33,6 +40,27 @@ public:
 	IVertexBuffer* GetVertexBuffer();
 	IIndexBuffer* GetIndexBuffer(unsigned int subset = 0);
 
+	// Set by the 3DEngine when collecting the objects inside the camera view frustum
+	void SetVisible(bool visible) { m_bVisible = visible; }
+	bool IsVisible() const { return m_bVisible; }
+
+	// The world-space AABB is cached by the 3DEngine and only recalculated if the transform or the geometry
+	// changed since the last SetWorldAABB(), so static meshes are not transformed again each frame.
+	bool IsWorldAABBInvalid() const
+	{
+		return m_bWorldAABBInvalid || m_bBoundBoxInvalid
+			|| memcmp(&m_WorldAABBTransform, &m_RenderDesc.transform, sizeof(Mat44)) != 0;
+	}
+
+	void SetWorldAABB(const AABB& aabb)
+	{
+		m_WorldAABB = aabb;
+		m_WorldAABBTransform = m_RenderDesc.transform;
+		m_bWorldAABBInvalid = false;
+	}
+
+	const AABB& GetWorldAABB() const { return m_WorldAABB; }
+
 	// IRenderObject
 public:
 	virtual AABB GetAABB();
@@ -7,6 +7,7 @@
 #pragma once
 #include "Vector3.h"
 #include "Mat44.h"
+#include "TransformBatch.h"
 #include "SPrerequisites.h"
 
 
@@ -135,13 +136,12 @@ struct S_API AABB
 		vMax += v;
 	}
 
+	// Sets this AABB to the AABB that encloses the transformed box.
+	// Use TransformAABBs() for many AABBs at once.
 	inline AABB& Transform(const Mat44& transform)
 	{
-		Vec3f sz = (transform * Vec4f((vMax - vMin) * 0.5f, 0.0f)).xyz();
-		Vec3f pos = (transform * Vec4f((vMax + vMin) * 0.5f, 1.0f)).xyz();
-		vMin = pos - sz;
-		vMax = pos + sz;
-
+		const Mat44* pTransform = &transform;
+		TransformAABBs(&pTransform, this, this, 1);
 		return *this;
 	}
 
@@ -168,12 +168,134 @@ struct S_API AABB
 			return;
 
 		GetCorners(corners);
-		for (int i = 0; i < 8; ++i)
-			corners[i] = (mtx * Vec4f(corners[i], 1.0f)).xyz();
+		TransformPoints(mtx, corners, corners, 8);
 	}
 };
 typedef struct S_API AABB SAxisAlignedBoundBox;
 
+struct S_API BoundSphere
+{
+	Vec3f c;
+	float r;
+
+	BoundSphere() : r(0) {}
+	BoundSphere(const Vec3f& center, float radius) : c(center), r(radius) {}
+
+	inline bool ContainsPoint(const Vec3f& p) const
+	{
+		return (p - c).LengthSq() <= r * r;
+	}
+
+	inline bool Intersects(const BoundSphere& sphere) const
+	{
+		float rsum = r + sphere.r;
+		return (sphere.c - c).LengthSq() <= rsum * rsum;
+	}
+
+	// Grows the sphere just enough to enclose p, moving the center towards p (J. Ritter)
+	inline void AddPoint(const Vec3f& p)
+	{
+		Vec3f d = p - c;
+		float distSq = d.LengthSq();
+		if (distSq <= r * r)
+			return;
+
+		float dist = sqrtf(distSq);
+		float rnew = (r + dist) * 0.5f;
+		c += d * ((rnew - r) / dist);
+		r = rnew;
+	}
+};
+
+// Discrete oriented polytope, bounded by K/2 pairs of parallel slabs.
+// Supported are K = 14 (box + corners), 18 (box + edges) and 26 (box + edges + corners).
+// The slab normals are not normalized, so dmin[i] / dmax[i] are the raw projections onto GetAxis(i).
+// The first three slabs are always the coordinate axes, i.e. the AABB of the k-DOP.
+template<unsigned int K>
+struct KDOP
+{
+	static_assert(K == 14 || K == 18 || K == 26, "Only 14-, 18- and 26-DOPs are supported");
+	static const unsigned int NUM_AXES = K / 2;
+
+	float dmin[K / 2], dmax[K / 2];
+
+	KDOP()
+	{
+		Reset();
+	}
+
+	// Returns the K/2 slab normals. The 18- and 26-DOP share the same table.
+	static const Vec3f* GetAxes()
+	{
+		static const Vec3f axes14[7] = {
+			Vec3f(1.0f, 0, 0), Vec3f(0, 1.0f, 0), Vec3f(0, 0, 1.0f),
+			Vec3f(1.0f, 1.0f, 1.0f), Vec3f(1.0f, 1.0f, -1.0f), Vec3f(1.0f, -1.0f, 1.0f), Vec3f(1.0f, -1.0f, -1.0f)
+		};
+		static const Vec3f axes26[13] = {
+			Vec3f(1.0f, 0, 0), Vec3f(0, 1.0f, 0), Vec3f(0, 0, 1.0f),
+			Vec3f(1.0f, 1.0f, 0), Vec3f(1.0f, 0, 1.0f), Vec3f(0, 1.0f, 1.0f),
+			Vec3f(1.0f, -1.0f, 0), Vec3f(1.0f, 0, -1.0f), Vec3f(0, 1.0f, -1.0f),
+			Vec3f(1.0f, 1.0f, 1.0f), Vec3f(1.0f, 1.0f, -1.0f), Vec3f(1.0f, -1.0f, 1.0f), Vec3f(1.0f, -1.0f, -1.0f)
+		};
+		return (K == 14) ? axes14 : axes26;
+	}
+
+	static const Vec3f& GetAxis(unsigned int i)
+	{
+		return GetAxes()[i];
+	}
+
+	void Reset()
+	{
+		for (unsigned int i = 0; i < NUM_AXES; ++i)
+		{
+			dmin[i] = FLT_MAX;
+			dmax[i] = -FLT_MAX;
+		}
+	}
+
+	void AddPoint(const Vec3f& p)
+	{
+		const Vec3f* axes = GetAxes();
+		for (unsigned int i = 0; i < NUM_AXES; ++i)
+		{
+			float d = Vec3Dot(axes[i], p);
+			if (d < dmin[i]) dmin[i] = d;
+			if (d > dmax[i]) dmax[i] = d;
+		}
+	}
+
+	// Separating axis test on the K/2 shared slab normals
+	bool Intersects(const KDOP<K>& dop) const
+	{
+		for (unsigned int i = 0; i < NUM_AXES; ++i)
+		{
+			if (dmin[i] > dop.dmax[i] || dop.dmin[i] > dmax[i])
+				return false;
+		}
+
+		return true;
+	}
+
+	bool ContainsPoint(const Vec3f& p) const
+	{
+		const Vec3f* axes = GetAxes();
+		for (unsigned int i = 0; i < NUM_AXES; ++i)
+		{
+			float d = Vec3Dot(axes[i], p);
+			if (d < dmin[i] || d > dmax[i])
+				return false;
+		}
+
+		return true;
+	}
+
+	AABB GetAABB() const
+	{
+		return AABB(Vec3f(dmin[0], dmin[1], dmin[2]), Vec3f(dmax[0], dmax[1], dmax[2]));
+	}
+};
+
 struct S_API OBB
 {
 	Vec3f directions[3];	// rotated basis vectors, normalized
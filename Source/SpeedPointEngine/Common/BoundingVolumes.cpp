@@ -0,0 +1,416 @@
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+//	SpeedPoint Game Engine
+//	Copyright (c) 2011-2018 Pascal Rosenkranz, All rights reserved.
+//
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#include "BoundingVolumes.h"
+#include "QHull.h"
+#include <vector>
+#include <cstring>
+#include <algorithm>
+
+using std::vector;
+
+SP_NMSPACE_BEG
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+//	Bounding spheres
+//
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+S_API BoundSphere ComputeBoundSphereRitter(const Vec3f* points, unsigned int n)
+{
+	if (!points || n == 0)
+		return BoundSphere();
+
+	// Extreme points on each axis
+	unsigned int ep[3][2] = { { 0, 0 }, { 0, 0 }, { 0, 0 } };
+	for (unsigned int i = 1; i < n; ++i)
+	{
+		for (unsigned int j = 0; j < 3; ++j)
+		{
+			if (points[i][j] < points[ep[j][0]][j]) ep[j][0] = i;
+			if (points[i][j] > points[ep[j][1]][j]) ep[j][1] = i;
+		}
+	}
+
+	// Start with the pair that is farthest apart
+	unsigned int axis = 0;
+	float distSq, distSqMax = -1.0f;
+	for (unsigned int j = 0; j < 3; ++j)
+	{
+		distSq = (points[ep[j][1]] - points[ep[j][0]]).LengthSq();
+		if (distSq > distSqMax)
+		{
+			distSqMax = distSq;
+			axis = j;
+		}
+	}
+
+	const Vec3f& a = points[ep[axis][0]];
+	const Vec3f& b = points[ep[axis][1]];
+	BoundSphere sphere((a + b) * 0.5f, sqrtf(distSqMax) * 0.5f);
+
+	for (unsigned int i = 0; i < n; ++i)
+		sphere.AddPoint(points[i]);
+
+	return sphere;
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// Relative tolerance of the containment test. Without it, the circumsphere of the support points
+// would classify the support points themselves as outside due to rounding.
+#define WELZL_EPSILON 1e-5f
+
+static inline bool WelzlContains(const BoundSphere& sphere, const Vec3f& p)
+{
+	return (p - sphere.c).LengthSq() <= sphere.r * sphere.r * (1.0f + WELZL_EPSILON) + 1e-12f;
+}
+
+// Smallest sphere through the 2 points
+static inline BoundSphere WelzlSphere2(const Vec3f& a, const Vec3f& b)
+{
+	return BoundSphere((a + b) * 0.5f, (b - a).Length() * 0.5f);
+}
+
+// Smallest sphere with a, b and c on its boundary. Falls back to the
+// sphere around the longest edge if the points are collinear.
+static BoundSphere WelzlSphere3(const Vec3f& a, const Vec3f& b, const Vec3f& c)
+{
+	Vec3f u = b - a, v = c - a;
+	Vec3f n = u ^ v;
+	float nn = Vec3Dot(n, n);
+	float uu = Vec3Dot(u, u), vv = Vec3Dot(v, v);
+	if (nn <= 1e-12f * uu * vv)
+	{
+		BoundSphere s = WelzlSphere2(a, b);
+		if (s.r < WelzlSphere2(a, c).r) s = WelzlSphere2(a, c);
+		if (s.r < WelzlSphere2(b, c).r) s = WelzlSphere2(b, c);
+		return s;
+	}
+
+	Vec3f o = ((v * uu - u * vv) ^ n) / (2.0f * nn);
+	return BoundSphere(a + o, o.Length());
+}
+
+// Sphere with a, b, c and d on its boundary. Falls back to the smallest sphere
+// through three of them that encloses the fourth if the points are coplanar.
+static BoundSphere WelzlSphere4(const Vec3f& a, const Vec3f& b, const Vec3f& c, const Vec3f& d)
+{
+	Vec3f u = b - a, v = c - a, w = d - a;
+	float det = Vec3Dot(u, v ^ w);
+	float uu = Vec3Dot(u, u), vv = Vec3Dot(v, v), ww = Vec3Dot(w, w);
+	if (det * det <= 1e-12f * uu * vv * ww)
+	{
+		const Vec3f* pts[4] = { &a, &b, &c, &d };
+		BoundSphere best(a, FLT_MAX);
+		for (unsigned int skip = 0; skip < 4; ++skip)
+		{
+			const Vec3f* tri[3];
+			for (unsigned int i = 0, j = 0; i < 4; ++i)
+				if (i != skip) tri[j++] = pts[i];
+
+			BoundSphere s = WelzlSphere3(*tri[0], *tri[1], *tri[2]);
+			if (s.r < best.r && WelzlContains(s, *pts[skip]))
+				best = s;
+		}
+
+		return best;
+	}
+
+	Vec3f o = ((v ^ w) * uu + (w ^ u) * vv + (u ^ v) * ww) / (2.0f * det);
+	return BoundSphere(a + o, o.Length());
+}
+
+static BoundSphere WelzlSphereFromSupport(const Vec3f* support, unsigned int nsupport)
+{
+	switch (nsupport)
+	{
+	case 0: return BoundSphere(Vec3f(0), -1.0f);
+	case 1: return BoundSphere(support[0], 0);
+	case 2: return WelzlSphere2(support[0], support[1]);
+	case 3: return WelzlSphere3(support[0], support[1], support[2]);
+	default: return WelzlSphere4(support[0], support[1], support[2], support[3]);
+	}
+}
+
+// Minimal sphere of points[0, n) with support[0, nsupport) on its boundary.
+// Points that end up on the boundary are moved to the front of the list, so they are tested
+// first in subsequent iterations. The recursion depth is bounded by the support size (4).
+static BoundSphere WelzlMTF(Vec3f* points, unsigned int n, Vec3f support[4], unsigned int nsupport)
+{
+	BoundSphere sphere = WelzlSphereFromSupport(support, nsupport);
+	if (nsupport == 4)
+		return sphere;
+
+	for (unsigned int i = 0; i < n; ++i)
+	{
+		if (sphere.r >= 0 && WelzlContains(sphere, points[i]))
+			continue;
+
+		Vec3f p = points[i];
+		support[nsupport] = p;
+		sphere = WelzlMTF(points, i, support, nsupport + 1);
+
+		std::copy_backward(points, points + i, points + i + 1);
+		points[0] = p;
+	}
+
+	return sphere;
+}
+
+S_API BoundSphere ComputeBoundSphereWelzl(const Vec3f* points, unsigned int n)
+{
+	if (!points || n == 0)
+		return BoundSphere();
+
+	// The expected linear run time requires a random order. Use a fixed seed, so the result is reproducible.
+	vector<Vec3f> shuffled(points, points + n);
+	unsigned int seed = 0x9E3779B9u;
+	for (unsigned int i = n - 1; i > 0; --i)
+	{
+		seed = seed * 1664525u + 1013904223u;
+		std::swap(shuffled[i], shuffled[(seed >> 8) % (i + 1)]);
+	}
+
+	Vec3f support[4];
+	return WelzlMTF(shuffled.data(), n, support, 0);
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+//	Oriented bound boxes
+//
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// Diagonalizes the symmetric matrix a with cyclic Jacobi rotations.
+// The columns of v are set to the (orthonormal) eigenvectors.
+static void JacobiEigenvectors(double a[3][3], double v[3][3])
+{
+	for (int i = 0; i < 3; ++i)
+		for (int j = 0; j < 3; ++j)
+			v[i][j] = (i == j) ? 1.0 : 0;
+
+	for (int sweep = 0; sweep < 32; ++sweep)
+	{
+		double off = a[0][1] * a[0][1] + a[0][2] * a[0][2] + a[1][2] * a[1][2];
+		double diag = a[0][0] * a[0][0] + a[1][1] * a[1][1] + a[2][2] * a[2][2];
+		if (off <= 1e-24 * diag)
+			break;
+
+		for (int p = 0; p < 2; ++p)
+			for (int q = p + 1; q < 3; ++q)
+			{
+				if (a[p][q] == 0)
+					continue;
+
+				double theta = (a[q][q] - a[p][p]) / (2.0 * a[p][q]);
+				double t = (theta >= 0 ? 1.0 : -1.0) / (fabs(theta) + sqrt(theta * theta + 1.0));
+				double c = 1.0 / sqrt(t * t + 1.0), s = t * c;
+
+				for (int k = 0; k < 3; ++k)
+				{
+					double akp = a[k][p], akq = a[k][q];
+					a[k][p] = c * akp - s * akq;
+					a[k][q] = s * akp + c * akq;
+				}
+
+				for (int k = 0; k < 3; ++k)
+				{
+					double apk = a[p][k], aqk = a[q][k];
+					a[p][k] = c * apk - s * aqk;
+					a[q][k] = s * apk + c * aqk;
+				}
+
+				for (int k = 0; k < 3; ++k)
+				{
+					double vkp = v[k][p], vkq = v[k][q];
+					v[k][p] = c * vkp - s * vkq;
+					v[k][q] = s * vkp + c * vkq;
+				}
+			}
+	}
+}
+
+// Covariance of the point set
+static void PointCovariance(const Vec3f* points, unsigned int n, double cov[3][3])
+{
+	double mean[3] = { 0, 0, 0 };
+	for (unsigned int i = 0; i < n; ++i)
+		for (int j = 0; j < 3; ++j)
+			mean[j] += points[i][j];
+
+	for (int j = 0; j < 3; ++j)
+		mean[j] /= n;
+
+	memset(cov, 0, sizeof(double) * 9);
+	for (unsigned int i = 0; i < n; ++i)
+	{
+		double d[3] = { points[i].x - mean[0], points[i].y - mean[1], points[i].z - mean[2] };
+		for (int j = 0; j < 3; ++j)
+			for (int k = j; k < 3; ++k)
+				cov[j][k] += d[j] * d[k];
+	}
+
+	for (int j = 0; j < 3; ++j)
+		for (int k = j; k < 3; ++k)
+			cov[k][j] = (cov[j][k] /= n);
+}
+
+// Covariance of the surface of a triangle soup, weighted by area.
+// Returns false if the surface has no area.
+static bool SurfaceCovariance(const Vec3f* tris, unsigned int ntris, double cov[3][3])
+{
+	double areaSum = 0, mean[3] = { 0, 0, 0 };
+	double sum[3][3] = { { 0, 0, 0 }, { 0, 0, 0 }, { 0, 0, 0 } };
+	for (unsigned int t = 0; t < ntris; ++t)
+	{
+		const Vec3f& p = tris[t * 3], &q = tris[t * 3 + 1], &r = tris[t * 3 + 2];
+		double area = 0.5 * (double)((q - p) ^ (r - p)).Length();
+		Vec3f m = (p + q + r) / 3.0f;
+
+		areaSum += area;
+		for (int j = 0; j < 3; ++j)
+		{
+			mean[j] += area * m[j];
+			for (int k = j; k < 3; ++k)
+				sum[j][k] += (area / 12.0) * (9.0 * m[j] * m[k] + p[j] * p[k] + q[j] * q[k] + r[j] * r[k]);
+		}
+	}
+
+	if (areaSum <= 0)
+		return false;
+
+	for (int j = 0; j < 3; ++j)
+		mean[j] /= areaSum;
+
+	for (int j = 0; j < 3; ++j)
+		for (int k = j; k < 3; ++k)
+			cov[k][j] = cov[j][k] = sum[j][k] / areaSum - mean[j] * mean[k];
+
+	return true;
+}
+
+// Writes the points with the smallest and largest projection onto each 26-DOP slab normal
+// to extremal, without duplicates. Returns the number of written points.
+static unsigned int ComputeExtremalPoints(const Vec3f* points, unsigned int n, Vec3f extremal[26])
+{
+	const Vec3f* axes = KDOP<26>::GetAxes();
+	unsigned int imin[13], imax[13];
+	float dmin[13], dmax[13];
+	for (unsigned int j = 0; j < 13; ++j)
+	{
+		imin[j] = imax[j] = 0;
+		dmin[j] = dmax[j] = Vec3Dot(axes[j], points[0]);
+	}
+
+	for (unsigned int i = 1; i < n; ++i)
+	{
+		for (unsigned int j = 0; j < 13; ++j)
+		{
+			float d = Vec3Dot(axes[j], points[i]);
+			if (d < dmin[j]) { dmin[j] = d; imin[j] = i; }
+			if (d > dmax[j]) { dmax[j] = d; imax[j] = i; }
+		}
+	}
+
+	unsigned int indices[26], nextremal = 0;
+	for (unsigned int j = 0; j < 26; ++j)
+	{
+		unsigned int index = (j < 13) ? imin[j] : imax[j - 13];
+
+		bool duplicate = false;
+		for (unsigned int k = 0; k < nextremal && !duplicate; ++k)
+			duplicate = (indices[k] == index);
+
+		if (!duplicate)
+		{
+			indices[nextremal] = index;
+			extremal[nextremal++] = points[index];
+		}
+	}
+
+	return nextremal;
+}
+
+S_API OBB ComputeOBB(const Vec3f* points, unsigned int n, EOBBFitMethod method /*= eOBB_FIT_PCA_HULL*/)
+{
+	OBB obb;
+	obb.dimensions[0] = obb.dimensions[1] = obb.dimensions[2] = 0;
+	if (!points || n == 0)
+		return obb;
+
+	double cov[3][3];
+	Vec3f* hull = 0;
+	unsigned int nhullverts = 0, nhullfaces = 0;
+	bool hasCovariance = false;
+	if (method == eOBB_FIT_PCA_HULL && n >= 4)
+	{
+		// QuickHull2() is quadratic in the worst case and not robust against large sets of nearly coplanar
+		// points, e.g. a finely tessellated sphere. So only the extremal points along the 26-DOP slab
+		// normals are hulled (C. Larsson, L. Kallberg), which is enough to find the principal axes.
+		Vec3f extremal[26];
+		unsigned int nextremal = ComputeExtremalPoints(points, n, extremal);
+		if (nextremal >= 4)
+		{
+			QuickHull2(extremal, nextremal, &hull, &nhullverts, 0, &nhullfaces);
+			if (hull)
+				hasCovariance = SurfaceCovariance(hull, nhullfaces, cov);
+
+			delete[] hull;
+		}
+	}
+
+	if (!hasCovariance)
+		PointCovariance(points, n, cov);
+
+	double v[3][3];
+	JacobiEigenvectors(cov, v);
+
+	Vec3f axes[3];
+	axes[0] = Vec3f((float)v[0][0], (float)v[1][0], (float)v[2][0]).Normalized();
+	axes[1] = Vec3f((float)v[0][1], (float)v[1][1], (float)v[2][1]);
+	axes[1] = (axes[1] - axes[0] * Vec3Dot(axes[0], axes[1])).Normalized();
+	axes[2] = axes[0] ^ axes[1];
+
+	float pmin[3] = { FLT_MAX, FLT_MAX, FLT_MAX }, pmax[3] = { -FLT_MAX, -FLT_MAX, -FLT_MAX };
+	AABB aabb;
+	aabb.Reset();
+	for (unsigned int i = 0; i < n; ++i)
+	{
+		// Project all points, not only the hull vertices, so a degenerate (e.g. flat) hull can't cut off points
+		const Vec3f& p = points[i];
+		aabb.AddPoint(p);
+		for (int j = 0; j < 3; ++j)
+		{
+			float d = Vec3Dot(axes[j], p);
+			if (d < pmin[j]) pmin[j] = d;
+			if (d > pmax[j]) pmax[j] = d;
+		}
+	}
+
+	Vec3f aabbDim = aabb.vMax - aabb.vMin;
+	float aabbVolume = aabbDim.x * aabbDim.y * aabbDim.z;
+	float obbVolume = (pmax[0] - pmin[0]) * (pmax[1] - pmin[1]) * (pmax[2] - pmin[2]);
+	if (aabbVolume <= obbVolume)
+	{
+		obb = OBB(aabb);
+		return obb;
+	}
+
+	obb.center = Vec3f(0);
+	for (int j = 0; j < 3; ++j)
+	{
+		obb.directions[j] = axes[j];
+		obb.dimensions[j] = (pmax[j] - pmin[j]) * 0.5f;
+		obb.center += axes[j] * ((pmin[j] + pmax[j]) * 0.5f);
+	}
+
+	return obb;
+}
+
+SP_NMSPACE_END
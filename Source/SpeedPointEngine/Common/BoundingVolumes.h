@@ -0,0 +1,52 @@
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+//	SpeedPoint Game Engine
+//	Copyright (c) 2011-2018 Pascal Rosenkranz, All rights reserved.
+//
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include "SPrerequisites.h"
+#include "BoundBox.h"
+
+SP_NMSPACE_BEG
+
+// Bounding volume fitting for point sets, e.g. the vertices of a static mesh.
+// The sphere and OBB fitters return an empty volume (radius / dimensions 0 at the origin) if n == 0.
+
+// Summary:
+//	Approximate bounding sphere in two passes over the points (J. Ritter).
+//	Usually 5-20% larger than the minimal sphere.
+S_API BoundSphere ComputeBoundSphereRitter(const Vec3f* points, unsigned int n);
+
+// Summary:
+//	Minimal bounding sphere (E. Welzl, move-to-front variant). Expected linear time, but
+//	slower than ComputeBoundSphereRitter() by a constant factor.
+S_API BoundSphere ComputeBoundSphereWelzl(const Vec3f* points, unsigned int n);
+
+enum EOBBFitMethod
+{
+	eOBB_FIT_PCA_POINTS,	// Principal axes of the points. Fast, but biased by the vertex distribution.
+	eOBB_FIT_PCA_HULL		// Principal axes of the convex hull surface (S. Gottschalk). Tighter, but builds the hull first.
+};
+
+// Summary:
+//	Fits an oriented bound box to the points using principal component analysis.
+//	The result is never larger than the AABB of the points: if the PCA box has a larger volume,
+//	the axis aligned box is returned instead.
+S_API OBB ComputeOBB(const Vec3f* points, unsigned int n, EOBBFitMethod method = eOBB_FIT_PCA_HULL);
+
+// Summary:
+//	Computes the k-DOP of the points
+template<unsigned int K>
+inline KDOP<K> ComputeKDOP(const Vec3f* points, unsigned int n)
+{
+	KDOP<K> dop;
+	for (unsigned int i = 0; i < n; ++i)
+		dop.AddPoint(points[i]);
+
+	return dop;
+}
+
+SP_NMSPACE_END
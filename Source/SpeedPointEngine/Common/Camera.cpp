@@ -12,6 +12,7 @@ S_API ViewFrustum::ViewFrustum(const Mat44& _mtxView, const Mat44& _mtxProj)
 	bEnclosingPlanesCalculated(false),
 	bCornersCalculated(false)
 {
+	CalculateClipPlanes();
 }
 
 S_API Vec3f ViewFrustum::GetViewDirection()
@@ -113,6 +114,303 @@ S_API void ViewFrustum::GetCorners(Vec3f _corners[8], bool viewSpace /*= false*/
 }
 
 
+S_API void ViewFrustum::CalculateClipPlanes()
+{
+	// Matrices are used with row vectors: clip = (p, 1) * mtxView * mtxProj.
+	// So clip.x, clip.y, clip.z, clip.w are the dot products of (p, 1) with the columns of mtxViewProj.
+	Mat44 mtxViewProj = mtxView * mtxProj;
+
+	Vec4f col[4];
+	for (int j = 0; j < 4; ++j)
+		col[j] = Vec4f(mtxViewProj.m[0][j], mtxViewProj.m[1][j], mtxViewProj.m[2][j], mtxViewProj.m[3][j]);
+
+	clipPlanes[0] = col[3] + col[0]; // Left:	-w <= x
+	clipPlanes[1] = col[3] - col[0]; // Right:	x <= w
+	clipPlanes[2] = col[3] + col[1]; // Bottom:	-w <= y
+	clipPlanes[3] = col[3] - col[1]; // Top:	y <= w
+	clipPlanes[4] = col[2];          // Near:	0 <= z
+	clipPlanes[5] = col[3] - col[2]; // Far:	z <= w
+
+	// Normalize, so that the sphere test can compare distances with the radius
+	for (int i = 0; i < 6; ++i)
+	{
+		float ln = clipPlanes[i].xyz().Length();
+		if (ln > 0.0f)
+			clipPlanes[i] = clipPlanes[i] / ln;
+	}
+}
+
+S_API void ViewFrustum::GetClipPlanes(geo::plane _clipPlanes[6]) const
+{
+	for (int i = 0; i < 6; ++i)
+		_clipPlanes[i] = geo::plane(clipPlanes[i].xyz(), -clipPlanes[i].w);
+}
+
+// Returns true if the box with center c and half extents e is completely behind the plane
+static inline bool IsBehindPlane(const Vec4f& plane, const Vec3f& c, const Vec3f& e)
+{
+	float dist = plane.x * c.x + plane.y * c.y + plane.z * c.z + plane.w;
+	float r = fabsf(plane.x) * e.x + fabsf(plane.y) * e.y + fabsf(plane.z) * e.z;
+	return dist + r < 0;
+}
+
+static inline bool IsBehindPlane(const Vec4f& plane, const Vec3f& c, float r)
+{
+	float dist = plane.x * c.x + plane.y * c.y + plane.z * c.z + plane.w;
+	return dist + r < 0;
+}
+
+S_API bool ViewFrustum::IsVisible(const AABB& aabb) const
+{
+	Vec3f c = (aabb.vMax + aabb.vMin) * 0.5f;
+	Vec3f e = (aabb.vMax - aabb.vMin) * 0.5f;
+	for (int i = 0; i < 6; ++i)
+	{
+		if (IsBehindPlane(clipPlanes[i], c, e))
+			return false;
+	}
+
+	return true;
+}
+
+S_API bool ViewFrustum::IsVisible(const BoundSphere& sphere) const
+{
+	for (int i = 0; i < 6; ++i)
+	{
+		if (IsBehindPlane(clipPlanes[i], sphere.c, sphere.r))
+			return false;
+	}
+
+	return true;
+}
+
+// Writes the visibility bits of the objects [i, i + number of bits in mask).
+// The objects are visited in order, so a word is cleared when its first bit is written.
+static inline void SetVisibilityBits(unsigned int* pVisible, unsigned int i, unsigned int mask)
+{
+	if ((i & 31) == 0)
+		pVisible[i >> 5] = 0;
+
+	pVisible[i >> 5] |= mask << (i & 31);
+}
+
+#ifdef SP_MATH_SSE
+
+// Number of set bits in a 4-bit mask
+static const unsigned int g_nMaskBits[16] = { 0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4 };
+
+// Plane coefficients, each splatted to all lanes
+struct SSplatPlanes
+{
+	__m128 nx[6], ny[6], nz[6], d[6];
+	__m128 absNx[6], absNy[6], absNz[6];
+
+	SSplatPlanes(const Vec4f planes[6])
+	{
+		for (int i = 0; i < 6; ++i)
+		{
+			nx[i] = _mm_set1_ps(planes[i].x); absNx[i] = _mm_set1_ps(fabsf(planes[i].x));
+			ny[i] = _mm_set1_ps(planes[i].y); absNy[i] = _mm_set1_ps(fabsf(planes[i].y));
+			nz[i] = _mm_set1_ps(planes[i].z); absNz[i] = _mm_set1_ps(fabsf(planes[i].z));
+			d[i] = _mm_set1_ps(planes[i].w);
+		}
+	}
+
+	// Returns the visibility bits of the 4 boxes with centers c and half extents e
+	inline unsigned int TestAABBs(__m128 cx, __m128 cy, __m128 cz, __m128 ex, __m128 ey, __m128 ez) const
+	{
+		__m128 outside = _mm_setzero_ps();
+		for (int i = 0; i < 6; ++i)
+		{
+			__m128 dist = _mm_add_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(nx[i], cx), _mm_mul_ps(ny[i], cy)), _mm_mul_ps(nz[i], cz)), d[i]);
+			__m128 r = _mm_add_ps(_mm_add_ps(_mm_mul_ps(absNx[i], ex), _mm_mul_ps(absNy[i], ey)), _mm_mul_ps(absNz[i], ez));
+			outside = _mm_or_ps(outside, _mm_cmplt_ps(_mm_add_ps(dist, r), _mm_setzero_ps()));
+		}
+
+		return ~(unsigned int)_mm_movemask_ps(outside) & 0xf;
+	}
+
+	inline unsigned int TestSpheres(__m128 cx, __m128 cy, __m128 cz, __m128 r) const
+	{
+		__m128 outside = _mm_setzero_ps();
+		for (int i = 0; i < 6; ++i)
+		{
+			__m128 dist = _mm_add_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(nx[i], cx), _mm_mul_ps(ny[i], cy)), _mm_mul_ps(nz[i], cz)), d[i]);
+			outside = _mm_or_ps(outside, _mm_cmplt_ps(_mm_add_ps(dist, r), _mm_setzero_ps()));
+		}
+
+		return ~(unsigned int)_mm_movemask_ps(outside) & 0xf;
+	}
+};
+
+// Loads 4 AABBs and converts them to centers and half extents in SoA layout
+static inline void LoadAABBs(const AABB* p, __m128& cx, __m128& cy, __m128& cz, __m128& ex, __m128& ey, __m128& ez)
+{
+	static_assert(sizeof(AABB) == 6 * sizeof(float), "Frustum culling expects AABB to be packed");
+
+	// Each load yields (min, max, min, max) of two AABBs
+	__m128 x01, y01, z01, x23, y23, z23;
+	SIMDLoadSoA3(&p[0].vMin.x, x01, y01, z01);
+	SIMDLoadSoA3(&p[2].vMin.x, x23, y23, z23);
+
+	__m128 minX = _mm_shuffle_ps(x01, x23, _MM_SHUFFLE(2, 0, 2, 0)), maxX = _mm_shuffle_ps(x01, x23, _MM_SHUFFLE(3, 1, 3, 1));
+	__m128 minY = _mm_shuffle_ps(y01, y23, _MM_SHUFFLE(2, 0, 2, 0)), maxY = _mm_shuffle_ps(y01, y23, _MM_SHUFFLE(3, 1, 3, 1));
+	__m128 minZ = _mm_shuffle_ps(z01, z23, _MM_SHUFFLE(2, 0, 2, 0)), maxZ = _mm_shuffle_ps(z01, z23, _MM_SHUFFLE(3, 1, 3, 1));
+
+	const __m128 half = _mm_set1_ps(0.5f);
+	cx = _mm_mul_ps(_mm_add_ps(maxX, minX), half); ex = _mm_mul_ps(_mm_sub_ps(maxX, minX), half);
+	cy = _mm_mul_ps(_mm_add_ps(maxY, minY), half); ey = _mm_mul_ps(_mm_sub_ps(maxY, minY), half);
+	cz = _mm_mul_ps(_mm_add_ps(maxZ, minZ), half); ez = _mm_mul_ps(_mm_sub_ps(maxZ, minZ), half);
+}
+
+// Loads 4 spheres in SoA layout
+static inline void LoadSpheres(const BoundSphere* p, __m128& cx, __m128& cy, __m128& cz, __m128& r)
+{
+	static_assert(sizeof(BoundSphere) == 4 * sizeof(float), "Frustum culling expects BoundSphere to be packed");
+
+	cx = _mm_loadu_ps(&p[0].c.x); cy = _mm_loadu_ps(&p[1].c.x); cz = _mm_loadu_ps(&p[2].c.x); r = _mm_loadu_ps(&p[3].c.x);
+	_MM_TRANSPOSE4_PS(cx, cy, cz, r);
+}
+
+#endif
+
+#ifdef SP_MATH_AVX
+
+// 8-wide version of SSplatPlanes
+struct SSplatPlanes8
+{
+	__m256 nx[6], ny[6], nz[6], d[6];
+	__m256 absNx[6], absNy[6], absNz[6];
+
+	SSplatPlanes8(const Vec4f planes[6])
+	{
+		for (int i = 0; i < 6; ++i)
+		{
+			nx[i] = _mm256_set1_ps(planes[i].x); absNx[i] = _mm256_set1_ps(fabsf(planes[i].x));
+			ny[i] = _mm256_set1_ps(planes[i].y); absNy[i] = _mm256_set1_ps(fabsf(planes[i].y));
+			nz[i] = _mm256_set1_ps(planes[i].z); absNz[i] = _mm256_set1_ps(fabsf(planes[i].z));
+			d[i] = _mm256_set1_ps(planes[i].w);
+		}
+	}
+
+	inline unsigned int TestAABBs(__m256 cx, __m256 cy, __m256 cz, __m256 ex, __m256 ey, __m256 ez) const
+	{
+		__m256 outside = _mm256_setzero_ps();
+		for (int i = 0; i < 6; ++i)
+		{
+			__m256 dist = _mm256_add_ps(_mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(nx[i], cx), _mm256_mul_ps(ny[i], cy)), _mm256_mul_ps(nz[i], cz)), d[i]);
+			__m256 r = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(absNx[i], ex), _mm256_mul_ps(absNy[i], ey)), _mm256_mul_ps(absNz[i], ez));
+			outside = _mm256_or_ps(outside, _mm256_cmp_ps(_mm256_add_ps(dist, r), _mm256_setzero_ps(), _CMP_LT_OQ));
+		}
+
+		return ~(unsigned int)_mm256_movemask_ps(outside) & 0xff;
+	}
+
+	inline unsigned int TestSpheres(__m256 cx, __m256 cy, __m256 cz, __m256 r) const
+	{
+		__m256 outside = _mm256_setzero_ps();
+		for (int i = 0; i < 6; ++i)
+		{
+			__m256 dist = _mm256_add_ps(_mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(nx[i], cx), _mm256_mul_ps(ny[i], cy)), _mm256_mul_ps(nz[i], cz)), d[i]);
+			outside = _mm256_or_ps(outside, _mm256_cmp_ps(_mm256_add_ps(dist, r), _mm256_setzero_ps(), _CMP_LT_OQ));
+		}
+
+		return ~(unsigned int)_mm256_movemask_ps(outside) & 0xff;
+	}
+};
+
+// Lanes 0-3 from lo, lanes 4-7 from hi
+#define SP_SIMD_COMBINE256(lo, hi) _mm256_insertf128_ps(_mm256_castps128_ps256(lo), (hi), 1)
+
+#endif
+
+S_API unsigned int ViewFrustum::CullAABBs(const AABB* pAABBs, unsigned int n, unsigned int* pVisible) const
+{
+	unsigned int i = 0, nVisible = 0;
+
+#ifdef SP_MATH_AVX
+	SSplatPlanes8 planes8(clipPlanes);
+	for (; i + 8 <= n; i += 8)
+	{
+		__m128 cx0, cy0, cz0, ex0, ey0, ez0, cx1, cy1, cz1, ex1, ey1, ez1;
+		LoadAABBs(pAABBs + i, cx0, cy0, cz0, ex0, ey0, ez0);
+		LoadAABBs(pAABBs + i + 4, cx1, cy1, cz1, ex1, ey1, ez1);
+
+		unsigned int mask = planes8.TestAABBs(
+			SP_SIMD_COMBINE256(cx0, cx1), SP_SIMD_COMBINE256(cy0, cy1), SP_SIMD_COMBINE256(cz0, cz1),
+			SP_SIMD_COMBINE256(ex0, ex1), SP_SIMD_COMBINE256(ey0, ey1), SP_SIMD_COMBINE256(ez0, ez1));
+
+		SetVisibilityBits(pVisible, i, mask);
+		nVisible += g_nMaskBits[mask & 0xf] + g_nMaskBits[mask >> 4];
+	}
+#endif
+
+#ifdef SP_MATH_SSE
+	SSplatPlanes planes(clipPlanes);
+	for (; i + 4 <= n; i += 4)
+	{
+		__m128 cx, cy, cz, ex, ey, ez;
+		LoadAABBs(pAABBs + i, cx, cy, cz, ex, ey, ez);
+
+		unsigned int mask = planes.TestAABBs(cx, cy, cz, ex, ey, ez);
+		SetVisibilityBits(pVisible, i, mask);
+		nVisible += g_nMaskBits[mask];
+	}
+#endif
+
+	for (; i < n; ++i)
+	{
+		bool visible = IsVisible(pAABBs[i]);
+		SetVisibilityBits(pVisible, i, visible ? 1 : 0);
+		nVisible += (visible ? 1 : 0);
+	}
+
+	return nVisible;
+}
+
+S_API unsigned int ViewFrustum::CullSpheres(const BoundSphere* pSpheres, unsigned int n, unsigned int* pVisible) const
+{
+	unsigned int i = 0, nVisible = 0;
+
+#ifdef SP_MATH_AVX
+	SSplatPlanes8 planes8(clipPlanes);
+	for (; i + 8 <= n; i += 8)
+	{
+		__m128 cx0, cy0, cz0, r0, cx1, cy1, cz1, r1;
+		LoadSpheres(pSpheres + i, cx0, cy0, cz0, r0);
+		LoadSpheres(pSpheres + i + 4, cx1, cy1, cz1, r1);
+
+		unsigned int mask = planes8.TestSpheres(
+			SP_SIMD_COMBINE256(cx0, cx1), SP_SIMD_COMBINE256(cy0, cy1), SP_SIMD_COMBINE256(cz0, cz1), SP_SIMD_COMBINE256(r0, r1));
+
+		SetVisibilityBits(pVisible, i, mask);
+		nVisible += g_nMaskBits[mask & 0xf] + g_nMaskBits[mask >> 4];
+	}
+#endif
+
+#ifdef SP_MATH_SSE
+	SSplatPlanes planes(clipPlanes);
+	for (; i + 4 <= n; i += 4)
+	{
+		__m128 cx, cy, cz, r;
+		LoadSpheres(pSpheres + i, cx, cy, cz, r);
+
+		unsigned int mask = planes.TestSpheres(cx, cy, cz, r);
+		SetVisibilityBits(pVisible, i, mask);
+		nVisible += g_nMaskBits[mask];
+	}
+#endif
+
+	for (; i < n; ++i)
+	{
+		bool visible = IsVisible(pSpheres[i]);
+		SetVisibilityBits(pVisible, i, visible ? 1 : 0);
+		nVisible += (visible ? 1 : 0);
+	}
+
+	return nVisible;
+}
+
 ///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 
 S_API void SCamera::Turn(float yaw, float pitch)
@@ -28,7 +28,12 @@ private:
 	bool bCornersCalculated;
 	Vec3f corners[8]; // in view-space
 
+	// World-space planes, extracted from the view-projection matrix. Normals point inwards.
+	// (x, y, z) = n, w = d, a point p is inside if dot(n, p) + d >= 0.
+	Vec4f clipPlanes[6];
+
 	void CalculateCorners();
+	void CalculateClipPlanes();
 
 public:
 	ViewFrustum(const Mat44& _mtxView, const Mat44& _mtxProj);
@@ -51,6 +56,28 @@ public:
 
 	float GetNearZ();
 	float GetFarZ();
+
+	// Summary:
+	//	Returns the six world-space planes of the frustum: Left, Right, Bottom, Top, Near, Far.
+	//	Normals point into the frustum, so geo::plane::GetDistance() is positive inside.
+	void GetClipPlanes(geo::plane clipPlanes[6]) const;
+
+	// Summary:
+	//	Conservative visibility tests. Objects that intersect or are inside the frustum
+	//	are visible. Some objects near the corners of the frustum may be reported visible although they are not.
+	bool IsVisible(const AABB& aabb) const;
+	bool IsVisible(const BoundSphere& sphere) const;
+
+	// Summary:
+	//	Tests n world-space AABBs (or spheres) against the frustum.
+	//	With SP_MATH_SSE four objects are tested per iteration, with SP_MATH_AVX eight.
+	// Arguments:
+	//	pVisible - Visibility bitmask with at least (n + 31) / 32 elements.
+	//		Bit (i % 32) of pVisible[i / 32] is set if object i is visible.
+	// Returns:
+	//	The number of visible objects
+	unsigned int CullAABBs(const AABB* pAABBs, unsigned int n, unsigned int* pVisible) const;
+	unsigned int CullSpheres(const BoundSphere* pSpheres, unsigned int n, unsigned int* pVisible) const;
 };
 
 
@@ -13,7 +13,31 @@
 
 #pragma once
 
+#include "MemoryTracker.h"
 #include <memory>
+#include <utility>
+
+// Summary:
+//	Generational handle to an object in a ChunkedObjectPool.
+// Description:
+//	The index addresses the slot of the object in the pool, the generation is
+//	incremented whenever the slot is released. Thus, a handle to a released object
+//	can be detected in O(1) and will never resolve to an object that reused the slot.
+//	A default constructed handle is invalid.
+struct ObjectPoolHandle
+{
+	unsigned int index;
+	unsigned int generation;
+
+	ObjectPoolHandle() : index(0), generation(0) {}
+	ObjectPoolHandle(unsigned int _index, unsigned int _generation) : index(_index), generation(_generation) {}
+
+	// Returns false if this handle never referred to an object. Does not check if the object is still alive.
+	bool IsSet() const { return generation != 0; }
+
+	bool operator ==(const ObjectPoolHandle& h) const { return index == h.index && generation == h.generation; }
+	bool operator !=(const ObjectPoolHandle& h) const { return index != h.index || generation != h.generation; }
+};
 
 // Summary:
 // 	Object pool that is able to recycle allocated objects and
@@ -25,14 +49,28 @@
 // 	unused memory, but avoids frequent resize and thereby the chunks
 // 	lying distributed over the memory. However, with a lower value,
 // 	consumption of unused memory might be much lower.
+//
+// 	Used objects are additionally tracked in a packed (dense) array of object
+// 	pointers. Each object stores its index into this array, so that GetAt(),
+// 	GetFirstUsedObject() and GetNextUsedObject() run in O(1). Releasing an object
+// 	moves the last dense entry into its place. GetFirstUsedObject() and
+// 	GetNextUsedObject() walk the dense array from back to front, so the current
+// 	object may be released during such an iteration, but no other object.
+// 	ForEach() may release any object, see there.
+//
+// 	Chunks with free slots are linked in a free chunk list, so Get() is O(1).
+//
+// 	Compact() is the only operation that moves objects, see there.
 template<typename T, const unsigned int chunk_size = 20>
 class ChunkedObjectPool
 {
 private:
 	struct Object {
-		typename T instance;
+		T instance;
 		bool used;
-		Object() : used(false) {}
+		unsigned int dense_index; // index into dense array, only valid if used
+		unsigned int generation; // incremented on release, never 0
+		Object() : used(false), dense_index(0), generation(1) {}
 	};
 	struct Chunk {
 		typename ChunkedObjectPool<T, chunk_size>::Object* objects;
@@ -40,6 +78,7 @@ private:
 		unsigned int first_used_object, last_used_object;
 		unsigned int* frees;	// stack
 		unsigned int num_frees;
+		unsigned int next_free_chunk; // index of the next chunk in the free chunk list, only valid if num_frees > 0
 
 		Chunk()
 			: objects(0),
@@ -47,7 +86,8 @@ private:
 			first_used_object(0),
 			last_used_object(0),
 			frees(0),
-			num_frees(0) {}
+			num_frees(0),
+			next_free_chunk(UINT_MAX) {}
 
 		~Chunk()
 		{
@@ -72,129 +112,315 @@ private:
 	}** chunks;
 	unsigned int num_chunks;
 	unsigned int num_used_objects;
-public:
-	ChunkedObjectPool()
-		: chunks(0), num_chunks(0), num_used_objects(0) {}
+	unsigned int first_free_chunk; // head of the free chunk list, UINT_MAX if all chunks are full
 
-	unsigned int GetUsedObjectCount() const { return num_used_objects; }
-	unsigned int GetFreeCount() const { return num_chunks * chunk_size - num_used_objects; }
+	// Generation of the objects of new chunks. Raised above the generations of chunks freed
+	// by Compact() or Clear(), so that stale handles into a freed chunk never resolve to a new object.
+	unsigned int first_generation;
 
-	// Returns the object with the given index from the pool or 0 if not found
-	T* GetAt(unsigned int idx) const
+	// Packed array of pointers to all used objects. num_dense is the number of entries.
+	// While ForEach() runs, released objects leave a 0 entry (hole), so num_dense may be greater
+	// than num_used_objects. Otherwise, both are equal.
+	Object** dense;
+	unsigned int num_dense;
+	unsigned int dense_capacity;
+
+	unsigned int iteration_depth; // number of running ForEach() calls
+
+	void PushDense(Object* obj)
 	{
-		unsigned int ic = 0;
-		for (; ic < num_chunks; ++ic)
+		if (num_dense >= dense_capacity)
 		{
-			if (idx >= chunks[ic]->num_used_objects)
-				idx -= chunks[ic]->num_used_objects;
-			else
-				break;
+			unsigned int newCapacity = (dense_capacity > 0 ? dense_capacity * 2 : chunk_size);
+			Object** oldDense = dense;
+			dense = new Object*[newCapacity];
+			if (oldDense)
+			{
+				memcpy(dense, oldDense, sizeof(Object*) * num_dense);
+				delete[] oldDense;
+			}
+
+			dense_capacity = newCapacity;
 		}
 
-		if (ic == num_chunks)
-			return 0;
+		obj->dense_index = num_dense;
+		dense[num_dense++] = obj;
+	}
 
-		Chunk& chunk = *chunks[ic];
-		for (unsigned int i = chunk.first_used_object; i < chunk.num_used_objects; ++i)
+	// Removes the object from the dense array by moving the last object into its place.
+	// While ForEach() runs, only leaves a hole, so that no object is moved to an already visited index.
+	void RemoveDense(Object* obj)
+	{
+		if (iteration_depth > 0)
 		{
-			if (!chunk.objects[i].used)
+			dense[obj->dense_index] = 0;
+			obj->dense_index = 0;
+			return;
+		}
+
+		unsigned int last = num_dense - 1;
+		if (obj->dense_index != last)
+		{
+			dense[obj->dense_index] = dense[last];
+			dense[obj->dense_index]->dense_index = obj->dense_index;
+		}
+
+		dense[last] = 0;
+		obj->dense_index = 0;
+		num_dense--;
+	}
+
+	// Closes the holes left by objects released during ForEach(). Keeps the order of the remaining objects.
+	void RemoveDenseHoles()
+	{
+		unsigned int numKept = 0;
+		for (unsigned int i = 0; i < num_dense; ++i)
+		{
+			if (!dense[i])
 				continue;
-			
-			if (idx == 0)
-				return &chunk.objects[i].instance;
-			
-			idx--;
+
+			dense[numKept] = dense[i];
+			dense[numKept]->dense_index = numKept;
+			++numKept;
 		}
 
-		return 0;
+		num_dense = numKept;
 	}
 
-	// objindex is set to the index of the first object, regardless of its previous value
-	// Returns:
-	//	0 if no object is in the pool, pointer to the instance of the first used object otherwise
-	T* GetFirstUsedObject(unsigned int& objindex) const
+	// Raises first_generation above the generations of all objects in the chunk, before it is deleted
+	void RaiseFirstGeneration(const Chunk* pChunk)
 	{
-		if (!chunks || num_chunks == 0 || num_used_objects == 0)
-			return 0;
+		if (!pChunk || !pChunk->objects)
+			return;
 
-		for (unsigned int ic = 0; ic < num_chunks; ++ic)
+		for (unsigned int i = 0; i < chunk_size; ++i)
 		{
-			Chunk& chunk = *chunks[ic];
-			if (chunk.num_used_objects == 0)
+			if (pChunk->objects[i].generation >= first_generation)
+				first_generation = pChunk->objects[i].generation + 1;
+		}
+
+		if (first_generation == 0)
+			first_generation = 1;
+	}
+
+	// Rebuilds the free chunk list from scratch, lower chunk indices first
+	void RebuildFreeChunkList()
+	{
+		first_free_chunk = UINT_MAX;
+		for (unsigned int ic = num_chunks; ic-- > 0;)
+		{
+			if (!chunks[ic] || chunks[ic]->num_frees == 0)
 				continue;
 
-			objindex = ic * chunk_size + chunk.first_used_object;
-			return &chunk.objects[chunk.first_used_object].instance;
+			chunks[ic]->next_free_chunk = first_free_chunk;
+			first_free_chunk = ic;
 		}
-
-		return 0;
 	}
 
-	// Summary:
-	//	Returns a used object with object index > objindex. 0 if no more used object
-	T* GetNextUsedObject(unsigned int& objindex) const
+	// Updates the chunk after the free object iObj was flagged used
+	void OnObjectUsed(Chunk& chunk, unsigned int iObj)
 	{
-		if (!chunks || num_chunks == 0 || num_used_objects == 0)
-			return 0;
+		chunk.num_used_objects++;
 
-		if (objindex >= num_chunks * chunk_size - 1)
-			return 0; // end of pool
+		if (iObj < chunk.first_used_object || chunk.num_used_objects == 1)
+			chunk.first_used_object = iObj;
 
-		++objindex;
+		if (iObj > chunk.last_used_object || chunk.num_used_objects == 1)
+			chunk.last_used_object = iObj;
+	}
 
-		unsigned int chunkobjindex = objindex % chunk_size; // objindex relative to chunk start
-		unsigned int ic = (unsigned int)((objindex - chunkobjindex) / chunk_size);
+	// Finds the chunk and the object index inside this chunk of the object pointed to by instance
+	// Returns false if the pointer does not point into any chunk of this pool.
+	bool FindObject(const T* instance, unsigned int& ic, unsigned int& iObj) const
+	{
+		if (!instance)
+			return false;
 
-		for (; ic < num_chunks; ++ic)
+		for (ic = 0; ic < num_chunks; ++ic)
 		{
-			if (!chunks[ic])
-			{
-				// chunk array damage. try to skip.
-				chunkobjindex = 0;
+			const Chunk& chunk = *chunks[ic];
+			if ((const char*)instance < (const char*)chunk.objects || (const char*)instance >= (const char*)chunk.objects + chunk.GetObjectsByteSize())
 				continue;
-			}
 
-			Chunk& chunk = *chunks[ic];
-			if (chunk.num_used_objects == 0 || chunkobjindex > chunk.last_used_object)
+			size_t ptrOffs = (size_t)((const char*)instance - (const char*)chunk.objects);
+			iObj = (unsigned int)(ptrOffs / sizeof(Object));
+			return true;
+		}
+
+		return false;
+	}
+
+	// Releases the used object iObj in chunk ic
+	void ReleaseObject(unsigned int ic, unsigned int iObj)
+	{
+		Chunk& chunk = *chunks[ic];
+		Object& obj = chunk.objects[iObj];
+		if (!obj.used)
+			return;
+
+		obj.used = false;
+		if (++obj.generation == 0)
+			obj.generation = 1;
+
+		RemoveDense(&obj);
+		num_used_objects--;
+		chunk.num_used_objects--;
+		chunk.frees[chunk.num_frees] = iObj;
+		if (chunk.num_frees++ == 0)
+		{
+			chunk.next_free_chunk = first_free_chunk;
+			first_free_chunk = ic;
+		}
+
+		if (chunk.num_used_objects == 0)
+		{
+			chunk.first_used_object = 0;
+			chunk.last_used_object = 0;
+		}
+		else if (iObj == chunk.first_used_object)
+		{
+			// find new first used object
+			for (; chunk.first_used_object < chunk.last_used_object; ++chunk.first_used_object)
 			{
-				chunkobjindex = 0;
-				continue; // go to next chunk
+				if (chunk.objects[chunk.first_used_object].used)
+					break;
 			}
-
-			// skip free objects at chunk start
-			if (chunkobjindex < chunk.first_used_object)
+		}
+		else if (iObj == chunk.last_used_object)
+		{
+			// find new last used object
+			for (; chunk.last_used_object > chunk.first_used_object; --chunk.last_used_object)
 			{
-				chunkobjindex = chunk.first_used_object;
-				objindex = ic * chunk_size + chunkobjindex;
-				return &chunk.objects[chunkobjindex].instance;
+				if (chunk.objects[chunk.last_used_object].used)
+					break;
 			}
+		}
+	}
 
-			for (unsigned int i = chunkobjindex; i <= chunk.last_used_object; ++i)
-			{
-				if (!chunk.objects[i].used)
-					continue;
+public:
+	ChunkedObjectPool()
+		: chunks(0), num_chunks(0), num_used_objects(0), first_free_chunk(UINT_MAX), first_generation(1),
+		dense(0), num_dense(0), dense_capacity(0), iteration_depth(0) {}
 
-				objindex = ic * chunk_size + i;
-				return &chunk.objects[i].instance;
-			}
+	unsigned int GetUsedObjectCount() const { return num_used_objects; }
+	unsigned int GetFreeCount() const { return num_chunks * chunk_size - num_used_objects; }
+
+	// Returns:
+	//	The fraction of allocated chunks that Compact() would free, in [0, 1).
+	//	0 if the used objects already occupy as few chunks as possible.
+	float GetFragmentation() const
+	{
+		if (num_chunks == 0)
+			return 0.0f;
+
+		unsigned int numRequiredChunks = (num_used_objects + chunk_size - 1) / chunk_size;
+		return 1.0f - (float)numRequiredChunks / (float)num_chunks;
+	}
+
+	// Returns the object with the given index from the pool or 0 if not found
+	// The index is the dense index, i.e. 0 <= idx < GetUsedObjectCount()
+	// While ForEach() runs, indices of released objects return 0 and the count is not updated until ForEach() returns.
+	T* GetAt(unsigned int idx) const
+	{
+		if (idx >= num_dense || !dense[idx])
+			return 0;
+
+		return &dense[idx]->instance;
+	}
+
+	// Summary:
+	//	Writes the objects with indices [first, first + count) to ppObjects, converted to U*
+	//	While ForEach() runs, 0 is written for objects released during ForEach().
+	// Returns:
+	//	The number of objects written
+	template<typename U>
+	unsigned int GetRange(unsigned int first, unsigned int count, U** ppObjects) const
+	{
+		if (first >= num_dense)
+			return 0;
+
+		if (count > num_dense - first)
+			count = num_dense - first;
+
+		for (unsigned int i = 0; i < count; ++i)
+			ppObjects[i] = (dense[first + i] ? static_cast<U*>(&dense[first + i]->instance) : 0);
+
+		return count;
+	}
 
-			// not found, next chunks start search at chunk start
-			chunkobjindex = 0;
+	// objindex is set to the index of the first object, regardless of its previous value
+	// Returns:
+	//	0 if no object is in the pool, pointer to the instance of the first used object otherwise
+	T* GetFirstUsedObject(unsigned int& objindex) const
+	{
+		objindex = num_dense;
+		return GetNextUsedObject(objindex);
+	}
+
+	// Summary:
+	//	Returns the next used object after objindex and sets objindex to its index. 0 if no more used object
+	//	It is safe to release the object at objindex before calling this method. Releasing any other
+	//	object moves the last object to its index, which is then visited twice. Use ForEach() in that case.
+	T* GetNextUsedObject(unsigned int& objindex) const
+	{
+		if (objindex > num_dense)
+			objindex = num_dense;
+
+		while (objindex > 0)
+		{
+			--objindex;
+			if (dense[objindex])
+				return &dense[objindex]->instance;
 		}
 
-		// nothing more found
-		return 0;
+		return 0; // end of pool
+	}
+
+	// Summary:
+	//	Calls fn(T*) for each used object in dense order.
+	//	fn may release any object of this pool. Released objects that have not been visited yet are
+	//	skipped, no object is visited twice. Objects created by fn are visited as well.
+	//	The dense array is only compacted after the outermost ForEach() returns, so do not use
+	//	indices (GetAt(), GetRange(), GetUsedObjectCount()) inside fn. Compact() must not be called inside fn.
+	template<typename F>
+	void ForEach(F fn)
+	{
+		BeginIteration();
+		for (unsigned int i = 0; i < num_dense; ++i)
+		{
+			if (dense[i])
+				fn(&dense[i]->instance);
+		}
+
+		EndIteration();
+	}
+
+	// Summary:
+	//	Defers moving dense entries on Release() until the matching EndIteration(), see ForEach().
+	//	Calls may be nested.
+	void BeginIteration()
+	{
+		++iteration_depth;
+	}
+
+	void EndIteration()
+	{
+		if (iteration_depth > 0 && --iteration_depth == 0 && num_dense != num_used_objects)
+			RemoveDenseHoles();
 	}
 
 	// Summary:
 	//	Finds unused slot, flags it used and returns pointer to instance
-	T* Get()
+	// Arguments:
+	//	pHandle - if not 0, set to the handle of the returned object
+	T* Get(ObjectPoolHandle* pHandle = 0)
 	{
 		Object* freeobj = 0;
 		unsigned int freeobjindex = 0;
 		Chunk* freeobjchunk = 0;
+		unsigned int freeobjchunkindex = 0;
 
-		if (GetFreeCount() == 0)
+		if (first_free_chunk == UINT_MAX)
 		{
 			// add new chunk
 			Chunk* newChunk = new Chunk();
@@ -203,11 +429,16 @@ public:
 
 			newChunk->frees = new unsigned int[chunk_size];
 			newChunk->num_frees = chunk_size;
+			SpeedPoint::MemoryTracker::OnAlloc(SpeedPoint::eMEMTAG_OBJECT_POOLS, (sizeof(Object) + sizeof(unsigned int)) * chunk_size);
 			for (unsigned int i = 0; i < chunk_size; ++i)
+			{
 				newChunk->frees[i] = (chunk_size - 1 - i);
+				newChunk->objects[i].generation = first_generation;
+			}
 
 			newChunk->first_used_object = 0;
 			newChunk->last_used_object = 0;
+			newChunk->next_free_chunk = UINT_MAX;
 
 			Chunk** oldChunks = chunks;
 			chunks = new Chunk*[++num_chunks];
@@ -219,37 +450,27 @@ public:
 				delete[] oldChunks;
 			}
 			
-			freeobjindex = newChunk->frees[chunk_size - 1];
-			freeobj = &newChunk->objects[freeobjindex];
-			freeobjchunk = newChunk;
+			first_free_chunk = num_chunks - 1;
 		}
-		else
-		{
-			for (unsigned int ic = 0; ic < num_chunks; ++ic)
-			{
-				Chunk& chunk = *chunks[ic];
-				if (chunk.num_frees == 0)
-					continue;
 
-				freeobjindex = chunk.frees[chunk.num_frees - 1];
-				freeobj = &chunk.objects[freeobjindex];
-				freeobjchunk = chunks[ic];
-				break;
-			}
-		}
-
-		if (!freeobj || !freeobjchunk)
+		freeobjchunkindex = first_free_chunk;
+		freeobjchunk = chunks[freeobjchunkindex];
+		if (!freeobjchunk || freeobjchunk->num_frees == 0)
 			return 0; // unexpected
 
+		freeobjindex = freeobjchunk->frees[freeobjchunk->num_frees - 1];
+		freeobj = &freeobjchunk->objects[freeobjindex];
+
 		freeobj->used = true;
-		freeobjchunk->num_used_objects++;
-		freeobjchunk->num_frees--;
+		PushDense(freeobj);
+
+		if (pHandle)
+			*pHandle = ObjectPoolHandle(freeobjchunkindex * chunk_size + freeobjindex, freeobj->generation);
 
-		if (freeobjindex < freeobjchunk->first_used_object || freeobjchunk->num_used_objects == 1)
-			freeobjchunk->first_used_object = freeobjindex;
+		if (--freeobjchunk->num_frees == 0)
+			first_free_chunk = freeobjchunk->next_free_chunk;
 
-		if (freeobjindex > freeobjchunk->last_used_object || freeobjchunk->num_used_objects == 1)
-			freeobjchunk->last_used_object = freeobjindex;
+		OnObjectUsed(*freeobjchunk, freeobjindex);
 
 		num_used_objects++;
 
@@ -257,78 +478,77 @@ public:
 	}
 
 	// Returns true if this pointer points to a used object in any chunk of this pool.
-	bool IsValidPtr(const T* ptr)
+	bool IsValidPtr(const T* ptr) const
 	{
-		if (ptr)
-		{
-			long ptrOffs;
-			for (unsigned int ic = 0; ic < num_chunks; ++ic)
-			{
-				const Chunk& chunk = *chunks[ic];
-				ptrOffs = (long)ptr - (long)chunk.objects;
-				if (ptrOffs >= 0 && ptrOffs < (long)chunk_size)
-					return chunk.objects[ptrOffs].used;
-			}
-		}
+		unsigned int ic, iObj;
+		if (!FindObject(ptr, ic, iObj))
+			return false;
 
-		return false;
+		return chunks[ic]->objects[iObj].used;
+	}
+
+	// Returns:
+	//	The dense index of the given used object, such that GetAt(index) == instance, or UINT_MAX if the pointer is invalid.
+	unsigned int GetIndex(const T* instance) const
+	{
+		unsigned int ic, iObj;
+		if (!FindObject(instance, ic, iObj) || !chunks[ic]->objects[iObj].used)
+			return UINT_MAX;
+
+		return chunks[ic]->objects[iObj].dense_index;
+	}
+
+	// Returns:
+	//	The handle of the given used object or an unset handle if the pointer is invalid.
+	ObjectPoolHandle GetHandle(const T* instance) const
+	{
+		unsigned int ic, iObj;
+		if (!FindObject(instance, ic, iObj) || !chunks[ic]->objects[iObj].used)
+			return ObjectPoolHandle();
+
+		return ObjectPoolHandle(ic * chunk_size + iObj, chunks[ic]->objects[iObj].generation);
+	}
+
+	// Returns:
+	//	The object referred to by the handle or 0 if the handle is stale or invalid. O(1).
+	T* Resolve(const ObjectPoolHandle& handle) const
+	{
+		unsigned int ic = handle.index / chunk_size;
+		if (ic >= num_chunks || !chunks[ic])
+			return 0;
+
+		Object& obj = chunks[ic]->objects[handle.index % chunk_size];
+		if (!obj.used || obj.generation != handle.generation)
+			return 0;
+
+		return &obj.instance;
 	}
 
 	// Summary:
 	//	Releases this object und flags it unused. Instance is not destructed.
 	void Release(T** pInstance)
 	{
-		T* instance = 0;
-		if (num_chunks == 0 || !pInstance || !(instance = *pInstance))
+		unsigned int ic, iObj;
+		if (!pInstance || !FindObject(*pInstance, ic, iObj))
 			return;
 
-		for (unsigned int ic = 0; ic < num_chunks; ++ic)
-		{
-			Chunk& chunk = *chunks[ic];
-			if ((unsigned long)instance < (unsigned long)chunk.objects || (unsigned long)instance > (unsigned long)chunk.objects + (unsigned long)chunk.GetObjectsByteSize())
-				continue;
-
-			unsigned int ptrOffs = (unsigned int)((unsigned long)instance - (unsigned long)chunk.objects);
-			unsigned int iObj = (ptrOffs - (ptrOffs % sizeof(Object))) / sizeof(Object);
-			Object& obj = chunk.objects[iObj];
-			if (!obj.used)
-				return;
-
-			obj.used = false;
-			*pInstance = 0;
-			instance = 0;
+		if (!chunks[ic]->objects[iObj].used)
+			return;
 
-			num_used_objects--;
-			chunk.num_used_objects--;
-			chunk.frees[chunk.num_frees] = iObj;
-			chunk.num_frees++;
+		ReleaseObject(ic, iObj);
+		*pInstance = 0;
+	}
 
-			if (chunk.num_used_objects == 0)
-			{
-				chunk.first_used_object = 0;
-				chunk.last_used_object = 0;
-			}
-			else if (iObj == chunk.first_used_object)
-			{
-				// find new first used object
-				for (; chunk.first_used_object < chunk.last_used_object; ++chunk.first_used_object)
-				{
-					if (chunk.objects[chunk.first_used_object].used)
-						break;
-				}
-			}
-			else if (iObj == chunk.last_used_object)
-			{
-				// find new last used object
-				for (; chunk.last_used_object > chunk.first_used_object; --chunk.last_used_object)
-				{
-					if (chunk.objects[chunk.last_used_object].used)
-						break;
-				}
-			}
+	// Summary:
+	//	Releases the object referred to by the handle and resets the handle. Instance is not destructed.
+	//	Does nothing if the handle is stale.
+	void Release(ObjectPoolHandle& handle)
+	{
+		if (!Resolve(handle))
+			return;
 
-			break; // found according obj in chunk
-		}
+		ReleaseObject(handle.index / chunk_size, handle.index % chunk_size);
+		handle = ObjectPoolHandle();
 	}
 
 	// Releases all objects in the pool.
@@ -348,6 +568,9 @@ public:
 			for (unsigned int i = 0; i < chunk_size; ++i)
 			{
 				chunk.frees[i] = i;
+				if (chunk.objects[i].used && ++chunk.objects[i].generation == 0)
+					chunk.objects[i].generation = 1;
+
 				chunk.objects[i].used = false;
 			}
 
@@ -356,21 +579,120 @@ public:
 		}
 
 		num_used_objects = 0;
+		num_dense = 0;
+		RebuildFreeChunkList();
+	}
+
+	// Summary:
+	//	Moves the used objects into as few chunks as possible and deletes the chunks that become empty.
+	// Description:
+	//	The objects of the chunks behind the first ceil(GetUsedObjectCount() / chunk_size) chunks are
+	//	move-assigned into free slots of these first chunks. Objects in the first chunks are not touched,
+	//	so their pointers and handles stay valid. The dense order is kept, so GetAt() indices do not change.
+	//
+	//	For each moved object, onMove(T* pOld, T* pNew, const ObjectPoolHandle& oldHandle, const ObjectPoolHandle& newHandle)
+	//	is called, so that the owner can fix up pointers and handles. After Compact() returns, pOld is
+	//	destructed and oldHandle is stale.
+	//	Do not call this while any pointer to a moved object is held that onMove does not fix up,
+	//	or during ForEach().
+	// Returns:
+	//	The number of deleted chunks
+	template<typename F>
+	unsigned int Compact(F onMove)
+	{
+		unsigned int numKeptChunks = (num_used_objects + chunk_size - 1) / chunk_size;
+		if (numKeptChunks >= num_chunks)
+			return 0;
+
+		// The kept chunks have at least as many free slots as there are objects in the other chunks
+		unsigned int icTarget = 0;
+		for (unsigned int ic = numKeptChunks; ic < num_chunks; ++ic)
+		{
+			Chunk& chunk = *chunks[ic];
+			for (unsigned int iObj = chunk.first_used_object; chunk.num_used_objects > 0 && iObj <= chunk.last_used_object; ++iObj)
+			{
+				Object& obj = chunk.objects[iObj];
+				if (!obj.used)
+					continue;
+
+				while (chunks[icTarget]->num_frees == 0)
+					++icTarget;
+
+				Chunk& targetChunk = *chunks[icTarget];
+				unsigned int iTarget = targetChunk.frees[--targetChunk.num_frees];
+				Object& target = targetChunk.objects[iTarget];
+
+				target.instance = std::move(obj.instance);
+				target.used = true;
+				target.dense_index = obj.dense_index;
+				dense[target.dense_index] = &target;
+				OnObjectUsed(targetChunk, iTarget);
+
+				onMove(&obj.instance, &target.instance,
+					ObjectPoolHandle(ic * chunk_size + iObj, obj.generation),
+					ObjectPoolHandle(icTarget * chunk_size + iTarget, target.generation));
+
+				obj.used = false;
+				chunk.num_used_objects--;
+			}
+		}
+
+		for (unsigned int ic = numKeptChunks; ic < num_chunks; ++ic)
+		{
+			Chunk* pChunk = chunks[ic];
+			RaiseFirstGeneration(pChunk);
+
+			SpeedPoint::MemoryTracker::OnFree(SpeedPoint::eMEMTAG_OBJECT_POOLS, (sizeof(Object) + sizeof(unsigned int)) * chunk_size);
+			delete pChunk;
+			chunks[ic] = 0;
+		}
+
+		unsigned int numDeletedChunks = num_chunks - numKeptChunks;
+		num_chunks = numKeptChunks;
+		if (num_chunks == 0)
+		{
+			delete[] chunks;
+			chunks = 0;
+		}
+
+		RebuildFreeChunkList();
+		return numDeletedChunks;
+	}
+
+	// Summary:
+	//	Same as Compact(onMove), for pools whose objects are not referenced from outside the pool.
+	unsigned int Compact()
+	{
+		return Compact([](T*, T*, const ObjectPoolHandle&, const ObjectPoolHandle&) {});
 	}
 
 	// Deletes the chunk memory.
-	// All pointers are invalidated.
+	// All pointers are invalidated. Handles become stale, also for the objects of chunks allocated later.
 	// To avoid deallocating all already allocated memory, use ReleaseAll()
 	void Clear()
 	{
 		for (unsigned int ic = 0; ic < num_chunks; ++ic)
+		{
+			RaiseFirstGeneration(chunks[ic]);
+			if (chunks[ic] && chunks[ic]->objects)
+				SpeedPoint::MemoryTracker::OnFree(SpeedPoint::eMEMTAG_OBJECT_POOLS, (sizeof(Object) + sizeof(unsigned int)) * chunk_size);
+
 			delete chunks[ic];
+		}
 
 		delete[] chunks;
 		chunks = 0;
 
+		if (dense)
+			delete[] dense;
+
+		dense = 0;
+		num_dense = 0;
+		dense_capacity = 0;
+
 		num_chunks = 0;
 		num_used_objects = 0;
+		first_free_chunk = UINT_MAX;
 	}
 
 	~ChunkedObjectPool()
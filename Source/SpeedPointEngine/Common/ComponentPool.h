@@ -1,12 +1,18 @@
 #pragma once
 
 #include "ChunkedObjectPool.h"
+#include "ConcurrentObjectPool.h"
+#include <type_traits>
 
 template<typename ICmp>
 struct IComponentPool
 {
 	virtual ICmp* Get() = 0;
 
+	// Summary:
+	//	Same as Get(), but additionally returns the handle of the new component
+	virtual ICmp* Get(ObjectPoolHandle* pHandle) = 0;
+
 	// Returns:
 	//	The first used component object in the pool or 0 if there is none in the pool
 	// Arguments:
@@ -27,37 +33,82 @@ struct IComponentPool
 	//	The number of used objects in the pool
 	virtual unsigned int GetNumObjects() const = 0;
 
+	// Summary:
+	//	Writes the components with indices [first, first + count) to ppObjects
+	// Returns:
+	//	The number of components written
+	virtual unsigned int GetRange(unsigned int first, unsigned int count, ICmp** ppObjects) const = 0;
+
+	// Summary:
+	//	Calls fn(pUser, pComponent) for each used component in the pool, see ForEach()
+	virtual void ForEachCallback(void (*fn)(void* pUser, ICmp* pComponent), void* pUser) = 0;
+
+	// Summary:
+	//	Calls fn(ICmp*) for each used component in the pool, with one indirect call per component.
+	//	fn may release any component and create new ones. Released components are not visited anymore,
+	//	no component is visited twice. Do not use indices (GetAt(), GetRange(), GetNumObjects()) inside fn.
+	template<typename F>
+	void ForEach(F fn)
+	{
+		ForEachCallback([](void* pUser, ICmp* pComponent) { (*static_cast<F*>(pUser))(pComponent); }, &fn);
+	}
+
+	// Returns:
+	//	The component referred to by the handle or 0 if the handle is stale or invalid
+	virtual ICmp* Resolve(const ObjectPoolHandle& handle) const = 0;
+
+	// Returns:
+	//	The handle of the given component or an unset handle if it is not a used object of this pool
+	virtual ObjectPoolHandle GetHandle(const ICmp* pObject) const = 0;
+
 	// Returns true if the object was released, false if parameter is invalid
 	virtual bool Release(ICmp** pObject) = 0;
+
+	// Returns true if the object was released and the handle reset, false if the handle is stale
+	virtual bool Release(ObjectPoolHandle& handle) = 0;
 	virtual void ReleaseAll() = 0;
+
+	// Returns:
+	//	The fraction of allocated memory of the pool that is not required to hold the used components, in [0, 1)
+	virtual float GetFragmentation() const = 0;
 };
 
 // CmpObjImpl must be an implementation of ICmp
-template<typename ICmp, class CmpObjImpl>
+// ObjectPool is the underlying storage, either ChunkedObjectPool or ConcurrentObjectPool
+template<typename ICmp, class CmpObjImpl, class ObjectPool = ChunkedObjectPool<CmpObjImpl>>
 class ComponentPool : public IComponentPool<ICmp>
 {
+	static_assert(std::is_base_of<ICmp, CmpObjImpl>::value, "CmpObjImpl must be derived from ICmp");
+
 private:
-	ChunkedObjectPool<CmpObjImpl> m_Pool;
+	ObjectPool m_Pool;
 
 public:
+	typedef typename ObjectPool::Iterator Iterator;
+
 	virtual ICmp* Get()
 	{
-		return dynamic_cast<ICmp*>(m_Pool.Get());
+		return static_cast<ICmp*>(m_Pool.Get());
+	}
+
+	virtual ICmp* Get(ObjectPoolHandle* pHandle)
+	{
+		return static_cast<ICmp*>(m_Pool.Get(pHandle));
 	}
 
 	virtual ICmp* GetFirst(unsigned int& id) const
 	{
-		return dynamic_cast<ICmp*>(m_Pool.GetFirstUsedObject(id));
+		return static_cast<ICmp*>(m_Pool.GetFirstUsedObject(id));
 	}
 
 	virtual ICmp* GetNext(unsigned int& id) const
 	{
-		return dynamic_cast<ICmp*>(m_Pool.GetNextUsedObject(id));
+		return static_cast<ICmp*>(m_Pool.GetNextUsedObject(id));
 	}
 
 	virtual ICmp* GetAt(unsigned int idx) const
 	{
-		return dynamic_cast<ICmp*>(m_Pool.GetAt(idx));
+		return static_cast<ICmp*>(m_Pool.GetAt(idx));
 	}
 
 	virtual unsigned int GetNumObjects() const
@@ -65,6 +116,34 @@ public:
 		return m_Pool.GetUsedObjectCount();
 	}
 
+	virtual unsigned int GetRange(unsigned int first, unsigned int count, ICmp** ppObjects) const
+	{
+		return m_Pool.GetRange(first, count, ppObjects);
+	}
+
+	virtual void ForEachCallback(void (*fn)(void* pUser, ICmp* pComponent), void* pUser)
+	{
+		m_Pool.ForEach([fn, pUser](CmpObjImpl* pObject) { fn(pUser, static_cast<ICmp*>(pObject)); });
+	}
+
+	// Summary:
+	//	Same as IComponentPool::ForEach(), but fn(CmpObjImpl*) is called directly and can be inlined.
+	template<typename F>
+	void ForEach(F fn)
+	{
+		m_Pool.ForEach(fn);
+	}
+
+	virtual ICmp* Resolve(const ObjectPoolHandle& handle) const
+	{
+		return static_cast<ICmp*>(m_Pool.Resolve(handle));
+	}
+
+	virtual ObjectPoolHandle GetHandle(const ICmp* pObject) const
+	{
+		return m_Pool.GetHandle(dynamic_cast<const CmpObjImpl*>(pObject));
+	}
+
 	virtual bool Release(ICmp** ppObject)
 	{
 		if (!ppObject)
@@ -81,13 +160,54 @@ public:
 		return true;
 	}
 
+	virtual bool Release(ObjectPoolHandle& handle)
+	{
+		if (!m_Pool.Resolve(handle))
+			return false;
+
+		m_Pool.Release(handle);
+		return true;
+	}
+
 	virtual void ReleaseAll()
 	{
 		m_Pool.ReleaseAll();
 	}
 
-	ChunkedObjectPool<CmpObjImpl>* GetPool() const
+	virtual float GetFragmentation() const
+	{
+		return m_Pool.GetFragmentation();
+	}
+
+	// Summary:
+	//	Moves components into as few chunks as possible, see ChunkedObjectPool::Compact().
+	//	onMove(CmpObjImpl* pOld, CmpObjImpl* pNew, oldHandle, newHandle) must fix up all references
+	//	to the moved component, e.g. the component pointer of its entity.
+	//	Only available if the underlying storage is a ChunkedObjectPool.
+	// Returns:
+	//	The number of freed chunks
+	template<typename F>
+	unsigned int Compact(F onMove)
+	{
+		return m_Pool.Compact(onMove);
+	}
+
+	ObjectPool* GetPool()
 	{
 		return &m_Pool;
 	}
+
+	const ObjectPool* GetPool() const
+	{
+		return &m_Pool;
+	}
+
+	// Typed iteration without virtual calls, e.g. for (CmpObjImpl* pObj : pool)
+	Iterator begin() { return m_Pool.begin(); }
+	Iterator end() { return m_Pool.end(); }
 };
+
+// Component pool that allows to create and release components from multiple threads at the same time.
+// Indexed access (GetAt(), GetRange()) is O(n) per call.
+template<typename ICmp, class CmpObjImpl>
+using ConcurrentComponentPool = ComponentPool<ICmp, CmpObjImpl, ConcurrentObjectPool<CmpObjImpl>>;
@@ -0,0 +1,470 @@
+//////////////////////////////////////////////////////////////////////////////////////////////////
+//
+//	SpeedPoint Game Engine
+//	Copyright (c) 2011-2018 Pascal Rosenkranz, All rights reserved.
+//
+//////////////////////////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include "ChunkedObjectPool.h"
+#include <atomic>
+#include <climits>
+
+// Summary:
+//	Thread-safe variant of the ChunkedObjectPool. Get() and Release() may be called
+//	from any thread at the same time. Pointers to objects are never invalidated.
+// Description:
+//	Free slots are kept in a lock-free stack (tagged head to avoid ABA). Chunks are
+//	registered in a fixed-size chunk table, so the table itself never moves. At most
+//	max_chunks * chunk_size objects can be allocated.
+//
+//	Iteration (GetFirstUsedObject(), GetNextUsedObject(), GetAt()) walks the slots and
+//	does not use a dense index. It is safe while other threads allocate, but objects
+//	allocated during iteration may or may not be visited. ReleaseAll() and Clear() must
+//	not be called concurrently with any other method.
+template<typename T, const unsigned int chunk_size = 64, const unsigned int max_chunks = 4096>
+class ConcurrentObjectPool
+{
+private:
+	struct Slot
+	{
+		T instance;
+		std::atomic<unsigned int> state; // (generation << 1) | used
+		std::atomic<unsigned int> next_free; // slot index + 1 of next free slot, 0 = none
+
+		Slot() : state(1 << 1), next_free(0) {}
+	};
+
+	std::atomic<Slot*> chunks[max_chunks];
+	std::atomic<unsigned int> num_chunks; // number of reserved chunk table entries
+	std::atomic<unsigned int> num_used_objects;
+	std::atomic<unsigned long long> free_head; // (tag << 32) | (slot index + 1)
+
+	// Generation of the slots of new chunks. Raised above the generations of the chunks deleted
+	// by Clear(), so that stale handles never resolve to a new object. Only written by Clear().
+	unsigned int first_generation;
+
+	static unsigned int NextGeneration(unsigned int state)
+	{
+		unsigned int generation = (state >> 1) + 1;
+		if ((generation & (UINT_MAX >> 1)) == 0)
+			generation = 1;
+
+		return generation << 1;
+	}
+
+	Slot* GetSlot(unsigned int index) const
+	{
+		unsigned int ic = index / chunk_size;
+		if (ic >= max_chunks)
+			return 0;
+
+		Slot* chunk = chunks[ic].load(std::memory_order_acquire);
+		return (chunk ? &chunk[index % chunk_size] : 0);
+	}
+
+	// Pushes the linked list of free slots [first, last] onto the free stack
+	void PushFree(unsigned int first, Slot* pLast)
+	{
+		unsigned long long head = free_head.load(std::memory_order_relaxed);
+		unsigned long long newHead;
+		do
+		{
+			pLast->next_free.store((unsigned int)head, std::memory_order_relaxed);
+			newHead = (((head >> 32) + 1) << 32) | (unsigned long long)(first + 1);
+		} while (!free_head.compare_exchange_weak(head, newHead, std::memory_order_release, std::memory_order_relaxed));
+	}
+
+	// Returns UINT_MAX if there is no free slot
+	unsigned int PopFree()
+	{
+		unsigned long long head = free_head.load(std::memory_order_acquire);
+		while (true)
+		{
+			unsigned int first = (unsigned int)head;
+			if (first == 0)
+				return UINT_MAX;
+
+			unsigned int next = GetSlot(first - 1)->next_free.load(std::memory_order_relaxed);
+			unsigned long long newHead = (((head >> 32) + 1) << 32) | (unsigned long long)next;
+			if (free_head.compare_exchange_weak(head, newHead, std::memory_order_acquire, std::memory_order_acquire))
+				return first - 1;
+		}
+	}
+
+	// Allocates a new chunk, pushes all but the first slot onto the free stack and returns the index
+	// of the first slot. Returns UINT_MAX if the chunk table is full.
+	unsigned int AddChunk()
+	{
+		unsigned int ic = num_chunks.fetch_add(1);
+		if (ic >= max_chunks)
+		{
+			num_chunks.fetch_sub(1);
+			return UINT_MAX;
+		}
+
+		Slot* chunk = new Slot[chunk_size];
+		SpeedPoint::MemoryTracker::OnAlloc(SpeedPoint::eMEMTAG_OBJECT_POOLS, sizeof(Slot) * chunk_size);
+		unsigned int first = ic * chunk_size;
+		for (unsigned int i = 1; i < chunk_size - 1; ++i)
+			chunk[i].next_free.store(first + i + 2, std::memory_order_relaxed);
+
+		if (first_generation != 1)
+		{
+			for (unsigned int i = 0; i < chunk_size; ++i)
+				chunk[i].state.store(first_generation << 1, std::memory_order_relaxed);
+		}
+
+		chunks[ic].store(chunk, std::memory_order_release);
+
+		if (chunk_size > 1)
+			PushFree(first + 1, &chunk[chunk_size - 1]);
+
+		return first;
+	}
+
+	// Returns the slot index of the object or UINT_MAX if the pointer does not point into this pool
+	unsigned int FindSlot(const T* instance) const
+	{
+		if (!instance)
+			return UINT_MAX;
+
+		unsigned int numChunks = num_chunks.load(std::memory_order_acquire);
+		for (unsigned int ic = 0; ic < numChunks && ic < max_chunks; ++ic)
+		{
+			Slot* chunk = chunks[ic].load(std::memory_order_acquire);
+			if (!chunk)
+				continue;
+
+			if ((const char*)instance < (const char*)chunk || (const char*)instance >= (const char*)(chunk + chunk_size))
+				continue;
+
+			size_t ptrOffs = (size_t)((const char*)instance - (const char*)chunk);
+			return ic * chunk_size + (unsigned int)(ptrOffs / sizeof(Slot));
+		}
+
+		return UINT_MAX;
+	}
+
+	// Flags the slot unused if it is used and pushes it onto the free stack
+	bool ReleaseSlot(unsigned int index, unsigned int expectedGeneration = 0)
+	{
+		Slot* pSlot = GetSlot(index);
+		if (!pSlot)
+			return false;
+
+		unsigned int state = pSlot->state.load(std::memory_order_acquire);
+		do
+		{
+			if ((state & 1) == 0)
+				return false; // not used
+
+			if (expectedGeneration != 0 && (state >> 1) != expectedGeneration)
+				return false; // stale handle
+		} while (!pSlot->state.compare_exchange_weak(state, NextGeneration(state), std::memory_order_acq_rel, std::memory_order_acquire));
+
+		num_used_objects.fetch_sub(1);
+		PushFree(index, pSlot);
+		return true;
+	}
+
+public:
+	ConcurrentObjectPool()
+		: num_chunks(0), num_used_objects(0), free_head(0), first_generation(1)
+	{
+		for (unsigned int i = 0; i < max_chunks; ++i)
+			chunks[i].store(0, std::memory_order_relaxed);
+	}
+
+	~ConcurrentObjectPool()
+	{
+		Clear();
+	}
+
+	unsigned int GetUsedObjectCount() const { return num_used_objects.load(); }
+
+	// Returns:
+	//	The fraction of allocated chunks that are not required to hold the used objects, in [0, 1).
+	//	Approximation, as other threads may get or release objects at the same time.
+	//	Objects of this pool are never moved, so this can only be reduced by releasing objects.
+	float GetFragmentation() const
+	{
+		unsigned int numChunks = num_chunks.load();
+		if (numChunks > max_chunks)
+			numChunks = max_chunks;
+
+		if (numChunks == 0)
+			return 0.0f;
+
+		unsigned int numRequiredChunks = (num_used_objects.load() + chunk_size - 1) / chunk_size;
+		if (numRequiredChunks > numChunks)
+			numRequiredChunks = numChunks;
+
+		return 1.0f - (float)numRequiredChunks / (float)numChunks;
+	}
+
+	// Summary:
+	//	Finds unused slot, flags it used and returns pointer to instance. Thread-safe.
+	// Arguments:
+	//	pHandle - if not 0, set to the handle of the returned object
+	T* Get(ObjectPoolHandle* pHandle = 0)
+	{
+		unsigned int index = PopFree();
+		if (index == UINT_MAX)
+		{
+			index = AddChunk();
+			if (index == UINT_MAX)
+				return 0; // pool is full
+		}
+
+		Slot* pSlot = GetSlot(index);
+		unsigned int state = pSlot->state.load(std::memory_order_relaxed) | 1;
+		pSlot->state.store(state, std::memory_order_release);
+		num_used_objects.fetch_add(1);
+
+		if (pHandle)
+			*pHandle = ObjectPoolHandle(index, state >> 1);
+
+		return &pSlot->instance;
+	}
+
+	// Summary:
+	//	Releases this object und flags it unused. Instance is not destructed. Thread-safe.
+	void Release(T** pInstance)
+	{
+		if (!pInstance)
+			return;
+
+		unsigned int index = FindSlot(*pInstance);
+		if (index != UINT_MAX && ReleaseSlot(index))
+			*pInstance = 0;
+	}
+
+	// Summary:
+	//	Releases the object referred to by the handle and resets the handle. Thread-safe.
+	//	Does nothing if the handle is stale.
+	void Release(ObjectPoolHandle& handle)
+	{
+		if (handle.IsSet() && ReleaseSlot(handle.index, handle.generation))
+			handle = ObjectPoolHandle();
+	}
+
+	// Returns true if this pointer points to a used object in this pool.
+	bool IsValidPtr(const T* ptr) const
+	{
+		unsigned int index = FindSlot(ptr);
+		return (index != UINT_MAX && (GetSlot(index)->state.load(std::memory_order_acquire) & 1) != 0);
+	}
+
+	// Returns:
+	//	The handle of the given used object or an unset handle if the pointer is invalid.
+	ObjectPoolHandle GetHandle(const T* instance) const
+	{
+		unsigned int index = FindSlot(instance);
+		if (index == UINT_MAX)
+			return ObjectPoolHandle();
+
+		unsigned int state = GetSlot(index)->state.load(std::memory_order_acquire);
+		if ((state & 1) == 0)
+			return ObjectPoolHandle();
+
+		return ObjectPoolHandle(index, state >> 1);
+	}
+
+	// Returns:
+	//	The object referred to by the handle or 0 if the handle is stale or invalid. O(1).
+	T* Resolve(const ObjectPoolHandle& handle) const
+	{
+		Slot* pSlot = GetSlot(handle.index);
+		if (!pSlot)
+			return 0;
+
+		unsigned int state = pSlot->state.load(std::memory_order_acquire);
+		if ((state & 1) == 0 || (state >> 1) != handle.generation)
+			return 0;
+
+		return &pSlot->instance;
+	}
+
+	// Returns:
+	//	The idx-th used object or 0 if there is no such object. O(n).
+	T* GetAt(unsigned int idx) const
+	{
+		unsigned int objindex;
+		T* pObject = GetFirstUsedObject(objindex);
+		while (pObject && idx-- > 0)
+			pObject = GetNextUsedObject(objindex);
+
+		return pObject;
+	}
+
+	// Summary:
+	//	Writes the used objects [first, first + count) in slot order to ppObjects, converted to U*. O(n).
+	// Returns:
+	//	The number of objects written
+	template<typename U>
+	unsigned int GetRange(unsigned int first, unsigned int count, U** ppObjects) const
+	{
+		unsigned int objindex, num = 0;
+		T* pObject = GetFirstUsedObject(objindex);
+		for (; pObject && first > 0; --first)
+			pObject = GetNextUsedObject(objindex);
+
+		for (; pObject && num < count; ++num)
+		{
+			ppObjects[num] = static_cast<U*>(pObject);
+			pObject = GetNextUsedObject(objindex);
+		}
+
+		return num;
+	}
+
+	// objindex is set to the slot index of the first object, regardless of its previous value
+	// Returns:
+	//	0 if no object is in the pool, pointer to the instance of the first used object otherwise
+	T* GetFirstUsedObject(unsigned int& objindex) const
+	{
+		objindex = UINT_MAX;
+		return GetNextUsedObject(objindex);
+	}
+
+	// Summary:
+	//	Returns a used object with slot index > objindex. 0 if no more used object
+	//	objindex == UINT_MAX starts at the first slot.
+	T* GetNextUsedObject(unsigned int& objindex) const
+	{
+		unsigned int numSlots = num_chunks.load(std::memory_order_acquire) * chunk_size;
+		for (unsigned int i = (objindex == UINT_MAX ? 0 : objindex + 1); i < numSlots; ++i)
+		{
+			Slot* pSlot = GetSlot(i);
+			if (!pSlot)
+			{
+				i += chunk_size - 1 - (i % chunk_size); // chunk not yet published
+				continue;
+			}
+
+			if ((pSlot->state.load(std::memory_order_acquire) & 1) != 0)
+			{
+				objindex = i;
+				return &pSlot->instance;
+			}
+		}
+
+		return 0;
+	}
+
+	// Summary:
+	//	Calls fn(T*) for each used object in slot order. fn may release any object, as objects are never moved.
+	template<typename F>
+	void ForEach(F fn)
+	{
+		unsigned int objindex;
+		for (T* pObject = GetFirstUsedObject(objindex); pObject; pObject = GetNextUsedObject(objindex))
+			fn(pObject);
+	}
+
+	// Releases all objects in the pool. Not thread-safe.
+	// WARNING: All pointers to any object in the pool are invalidated, but still point to a correct address!
+	void ReleaseAll()
+	{
+		free_head.store(0);
+		unsigned int numChunks = num_chunks.load();
+		for (unsigned int ic = numChunks; ic-- > 0;)
+		{
+			Slot* chunk = chunks[ic].load();
+			if (!chunk)
+				continue;
+
+			for (unsigned int i = chunk_size; i-- > 0;)
+			{
+				unsigned int state = chunk[i].state.load();
+				if (state & 1)
+					chunk[i].state.store(NextGeneration(state));
+
+				PushFree(ic * chunk_size + i, &chunk[i]);
+			}
+		}
+
+		num_used_objects.store(0);
+	}
+
+	// Deletes the chunk memory. Not thread-safe.
+	// All pointers are invalidated. Handles become stale, also for the slots of chunks allocated later.
+	void Clear()
+	{
+		unsigned int numChunks = num_chunks.load();
+		for (unsigned int ic = 0; ic < numChunks && ic < max_chunks; ++ic)
+		{
+			Slot* chunk = chunks[ic].load();
+			if (chunk)
+			{
+				for (unsigned int i = 0; i < chunk_size; ++i)
+				{
+					unsigned int generation = chunk[i].state.load() >> 1;
+					if (generation >= first_generation)
+						first_generation = NextGeneration(generation << 1) >> 1;
+				}
+
+				SpeedPoint::MemoryTracker::OnFree(SpeedPoint::eMEMTAG_OBJECT_POOLS, sizeof(Slot) * chunk_size);
+				delete[] chunk;
+			}
+
+			chunks[ic].store(0);
+		}
+
+		num_chunks.store(0);
+		num_used_objects.store(0);
+		free_head.store(0);
+	}
+
+public:
+	class Iterator
+	{
+	private:
+		ConcurrentObjectPool<T, chunk_size, max_chunks>* pool;
+		T* ptr;
+		unsigned int i;
+	public:
+		Iterator(ConcurrentObjectPool<T, chunk_size, max_chunks>* _pool)
+			: pool(_pool)
+		{
+			ptr = 0;
+			if (pool)
+				ptr = pool->GetFirstUsedObject(i);
+			if (!ptr)
+				i = UINT_MAX;
+		}
+
+		Iterator(ConcurrentObjectPool<T, chunk_size, max_chunks>* _pool, T* _ptr, unsigned int _i)
+			: pool(_pool), ptr(_ptr), i(_i)
+		{
+			if (!pool)
+				ptr = 0;
+			else if (!pool->IsValidPtr(ptr))
+				ptr = 0;
+			if (!ptr)
+				i = UINT_MAX;
+		}
+
+		T* operator ->() const { return ptr; }
+		T* operator *() const { return ptr; }
+		operator bool() const { return pool && ptr && i < UINT_MAX; }
+		bool operator ==(const Iterator& it) const { return (pool == it.pool) && (ptr == it.ptr) && (i == it.i); }
+		bool operator !=(const Iterator& it) const
+		{
+			return (pool != it.pool) || (ptr != it.ptr) || (i != it.i);
+		}
+		Iterator& operator ++()
+		{
+			if (pool)
+				ptr = pool->GetNextUsedObject(i);
+			if (!ptr)
+				i = UINT_MAX;
+			return *this;
+		}
+	};
+
+	inline Iterator begin() { return Iterator(this); }
+	inline Iterator end() { return Iterator(this, 0, UINT_MAX); }
+};
@@ -0,0 +1,492 @@
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+//	SpeedPoint Game Engine
+//	Copyright (c) 2011-2018 Pascal Rosenkranz, All rights reserved.
+//
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#include "ContactManifold.h"
+
+GEO_NMSPACE_BEG
+
+// A face of box2 (or an edge-edge axis) is only chosen over a face of box1 if its separation is larger than
+// BOXBOX_RELATIVE_TOLERANCE * separation + BOXBOX_ABSOLUTE_TOLERANCE * box size. Preferring one feature over
+// an almost equal one keeps the manifold (and its ids) from flipping between frames for resting boxes.
+#define BOXBOX_RELATIVE_TOLERANCE 0.98f
+#define BOXBOX_ABSOLUTE_TOLERANCE 0.001f
+
+// Box-box ids:
+//	face contact: bits 0-5 clip point, bits 6-8 incident face, bits 9-11 reference face, BOXBOX_ID_REFERENCE_BOX2
+//	edge contact: BOXBOX_ID_EDGE, bits 0-1 edge axis and 2-3 edge position of box1, bits 4-5 and 6-7 of box2
+#define BOXBOX_ID_REFERENCE_BOX2 (1u << 12)
+#define BOXBOX_ID_EDGE (1u << 13)
+
+// Size of the clip polygon buffers. Clipping a convex quad against 4 planes yields at most 8 vertices.
+#define MAX_CLIP_VERTICES 16
+
+int SContactManifold::FindPoint(unsigned int id) const
+{
+	for (unsigned int i = 0; i < num_points; ++i)
+	{
+		if (points[i].id == id)
+			return (int)i;
+	}
+
+	return -1;
+}
+
+void SContactManifold::GetDeepestIntersection(SIntersection* pinters) const
+{
+	unsigned int ideepest = 0;
+	for (unsigned int i = 1; i < num_points; ++i)
+	{
+		if (points[i].dist < points[ideepest].dist)
+			ideepest = i;
+	}
+
+	pinters->p = points[ideepest].p;
+	pinters->n = n;
+	pinters->dist = points[ideepest].dist;
+	pinters->feature = feature;
+}
+
+static void SetSinglePointManifold(const SIntersection& inters, SContactManifold* pmanifold)
+{
+	pmanifold->n = inters.n;
+	pmanifold->feature = inters.feature;
+	pmanifold->points[0].p = inters.p;
+	pmanifold->points[0].dist = inters.dist;
+	pmanifold->points[0].id = 0;
+	pmanifold->num_points = 1;
+}
+
+// Swaps shape1 and shape2: reverses the normal and moves the points onto the surface of the former shape2
+static void FlipManifold(SContactManifold* pmanifold)
+{
+	for (unsigned int i = 0; i < pmanifold->num_points; ++i)
+		pmanifold->points[i].p += pmanifold->n * pmanifold->points[i].dist;
+
+	pmanifold->n = -pmanifold->n;
+}
+
+// Reduces the points to MAX_CONTACT_POINTS points in-place. Keeps the deepest point and
+// chooses the others to span the largest area perpendicular to n.
+// Returns the new number of points.
+static unsigned int ReduceContactPoints(SContactPoint* points, unsigned int num_points, const Vec3f& n)
+{
+	if (num_points <= MAX_CONTACT_POINTS)
+		return num_points;
+
+	unsigned int sel[MAX_CONTACT_POINTS], num_sel = 0;
+	float best, a;
+
+	// Deepest point
+	sel[0] = 0;
+	for (unsigned int i = 1; i < num_points; ++i)
+	{
+		if (points[i].dist < points[sel[0]].dist)
+			sel[0] = i;
+	}
+
+	// Farthest point from the deepest one
+	best = -1.0f;
+	for (unsigned int i = 0; i < num_points; ++i)
+	{
+		if ((a = (points[i].p - points[sel[0]].p).LengthSq()) > best)
+		{
+			best = a;
+			sel[1] = i;
+		}
+	}
+
+	// Largest triangle
+	Vec3f e = points[sel[1]].p - points[sel[0]].p;
+	float area = 0;
+	best = -1.0f;
+	for (unsigned int i = 0; i < num_points; ++i)
+	{
+		a = Vec3Dot(e ^ (points[i].p - points[sel[0]].p), n);
+		if (fabsf(a) > best)
+		{
+			best = fabsf(a);
+			area = a;
+			sel[2] = i;
+		}
+	}
+
+	num_sel = 3;
+
+	// Point that adds the most area outside of the triangle
+	Vec3f tn = (area < 0) ? -n : n;
+	best = 0;
+	for (unsigned int i = 0; i < num_points; ++i)
+	{
+		for (unsigned int iedge = 0; iedge < 3; ++iedge)
+		{
+			const Vec3f& e0 = points[sel[iedge]].p;
+			const Vec3f& e1 = points[sel[(iedge + 1) % 3]].p;
+			if ((a = -Vec3Dot((e1 - e0) ^ (points[i].p - e0), tn)) > best)
+			{
+				best = a;
+				sel[3] = i;
+				num_sel = 4;
+			}
+		}
+	}
+
+	SContactPoint selected[MAX_CONTACT_POINTS];
+	for (unsigned int i = 0; i < num_sel; ++i)
+		selected[i] = points[sel[i]];
+
+	for (unsigned int i = 0; i < num_sel; ++i)
+		points[i] = selected[i];
+
+	return num_sel;
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+bool _PlaneCapsuleManifold(const plane* pplane, const capsule* pcapsule, SContactManifold* pmanifold)
+{
+	// Contacts are generated on the side of the plane where the center of the capsule is
+	float side = (Vec3Dot(pcapsule->c, pplane->n) - pplane->d >= 0) ? 1.0f : -1.0f;
+	Vec3f n = pplane->n * side;
+
+	unsigned int num_points = 0;
+	for (unsigned int iend = 0; iend < 2; ++iend)
+	{
+		Vec3f q = pcapsule->c + pcapsule->axis * (iend ? pcapsule->hh : -pcapsule->hh);
+		float h = (Vec3Dot(q, pplane->n) - pplane->d) * side;
+		if (h - pcapsule->r > 0)
+			continue;
+
+		SContactPoint& pt = pmanifold->points[num_points++];
+		pt.p = q - n * h;
+		pt.dist = h - pcapsule->r;
+		pt.id = iend;
+	}
+
+	pmanifold->num_points = num_points;
+	if (num_points == 0)
+		return false;
+
+	pmanifold->n = n;
+	pmanifold->feature = (num_points == 2) ? eINTERSECTION_FEATURE_BASE_SHAPE : eINTERSECTION_FEATURE_CAP;
+	return true;
+}
+
+bool _CapsulePlaneManifold(const capsule* pcapsule, const plane* pplane, SContactManifold* pmanifold)
+{
+	if (!_PlaneCapsuleManifold(pplane, pcapsule, pmanifold))
+		return false;
+
+	FlipManifold(pmanifold);
+	return true;
+}
+
+bool _PlaneBoxManifold(const plane* pplane, const box* pbox, SContactManifold* pmanifold)
+{
+	SContactPoint points[8];
+	unsigned int num_points = 0, num_above = 0;
+	for (unsigned int icorner = 0; icorner < 8; ++icorner)
+	{
+		Vec3f corner = pbox->c;
+		for (int k = 0; k < 3; ++k)
+			corner += pbox->axis[k] * ((icorner & (1u << k)) ? pbox->dim[k] : -pbox->dim[k]);
+
+		float dist = Vec3Dot(corner, pplane->n) - pplane->d;
+		if (dist > 0)
+		{
+			++num_above;
+			continue;
+		}
+
+		SContactPoint& pt = points[num_points++];
+		pt.p = corner - pplane->n * dist;
+		pt.dist = dist;
+		pt.id = icorner;
+	}
+
+	// Same as _PlaneBox(): the box has to cross the plane
+	if (num_points == 0 || num_above == 0)
+	{
+		pmanifold->num_points = 0;
+		return false;
+	}
+
+	pmanifold->num_points = ReduceContactPoints(points, num_points, pplane->n);
+	for (unsigned int i = 0; i < pmanifold->num_points; ++i)
+		pmanifold->points[i] = points[i];
+
+	pmanifold->n = pplane->n;
+	pmanifold->feature = eINTERSECTION_FEATURE_BASE_SHAPE;
+	return true;
+}
+
+bool _BoxPlaneManifold(const box* pbox, const plane* pplane, SContactManifold* pmanifold)
+{
+	if (!_PlaneBoxManifold(pplane, pbox, pmanifold))
+		return false;
+
+	FlipManifold(pmanifold);
+	return true;
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+struct clip_vertex
+{
+	Vec3f p;
+	unsigned int id; // incident face vertex (0-3) or intersection of a line with a side plane (8 + 4 * line + plane)
+	unsigned int line; // line of the edge to the next vertex: incident face edge (0-3) or side plane (4 + plane)
+};
+
+// Clips the convex polygon against the half-space dot(p, n) <= d (Sutherland-Hodgman).
+// Returns the number of vertices written to out.
+static unsigned int ClipPolygon(const clip_vertex* in, unsigned int num_in, const Vec3f& n, float d, unsigned int iplane, clip_vertex* out)
+{
+	unsigned int num_out = 0;
+	for (unsigned int i = 0; i < num_in; ++i)
+	{
+		const clip_vertex& a = in[i];
+		const clip_vertex& b = in[(i + 1) % num_in];
+		float da = Vec3Dot(a.p, n) - d;
+		float db = Vec3Dot(b.p, n) - d;
+
+		if (da <= 0)
+			out[num_out++] = a;
+
+		if ((da <= 0) != (db <= 0) && num_out < MAX_CLIP_VERTICES)
+		{
+			clip_vertex& x = out[num_out++];
+			x.p = a.p + (b.p - a.p) * (da / (da - db));
+			x.id = 8 + 4 * a.line + iplane;
+			x.line = (da <= 0) ? 4 + iplane : a.line; // leaving: continue along the plane
+		}
+	}
+
+	return num_out;
+}
+
+bool _BoxBoxManifold(const box* pbox1, const box* pbox2, SContactManifold* pmanifold)
+{
+	const box* boxes[2] = { pbox1, pbox2 };
+	Vec3f dc = pbox2->c - pbox1->c;
+	float s;
+
+	pmanifold->num_points = 0;
+
+	float absR[3][3];
+	for (int i = 0; i < 3; ++i)
+		for (int j = 0; j < 3; ++j)
+			absR[i][j] = fabsf(Vec3Dot(pbox1->axis[i], pbox2->axis[j])) + FLT_EPSILON;
+
+	// Face axes
+	float sepFace[2] = { -FLT_MAX, -FLT_MAX };
+	int iface[2] = { 0, 0 };
+	for (int i = 0; i < 3; ++i)
+	{
+		s = fabsf(Vec3Dot(dc, pbox1->axis[i])) - pbox1->dim[i]
+			- (pbox2->dim[0] * absR[i][0] + pbox2->dim[1] * absR[i][1] + pbox2->dim[2] * absR[i][2]);
+		if (s > 0)
+			return false;
+		if (s > sepFace[0]) { sepFace[0] = s; iface[0] = i; }
+	}
+
+	for (int j = 0; j < 3; ++j)
+	{
+		s = fabsf(Vec3Dot(dc, pbox2->axis[j])) - pbox2->dim[j]
+			- (pbox1->dim[0] * absR[0][j] + pbox1->dim[1] * absR[1][j] + pbox1->dim[2] * absR[2][j]);
+		if (s > 0)
+			return false;
+		if (s > sepFace[1]) { sepFace[1] = s; iface[1] = j; }
+	}
+
+	// Edge-edge axes
+	float sepEdge = -FLT_MAX;
+	int iedge[2] = { 0, 0 };
+	Vec3f Ledge;
+	for (int i = 0; i < 3; ++i)
+		for (int j = 0; j < 3; ++j)
+		{
+			Vec3f L = pbox1->axis[i] ^ pbox2->axis[j];
+			float len = L.Length();
+			if (len < 1e-3f)
+				continue; // (almost) parallel edges, covered by the face axes
+
+			L /= len;
+			float ra = pbox1->dim[0] * fabsf(Vec3Dot(pbox1->axis[0], L)) + pbox1->dim[1] * fabsf(Vec3Dot(pbox1->axis[1], L)) + pbox1->dim[2] * fabsf(Vec3Dot(pbox1->axis[2], L));
+			float rb = pbox2->dim[0] * fabsf(Vec3Dot(pbox2->axis[0], L)) + pbox2->dim[1] * fabsf(Vec3Dot(pbox2->axis[1], L)) + pbox2->dim[2] * fabsf(Vec3Dot(pbox2->axis[2], L));
+			s = fabsf(Vec3Dot(dc, L)) - ra - rb;
+			if (s > 0)
+				return false;
+			if (s > sepEdge) { sepEdge = s; iedge[0] = i; iedge[1] = j; Ledge = L; }
+		}
+
+	float size = max(max(max(pbox1->dim[0], pbox1->dim[1]), pbox1->dim[2]), max(max(pbox2->dim[0], pbox2->dim[1]), pbox2->dim[2]));
+	float tolerance = BOXBOX_ABSOLUTE_TOLERANCE * size;
+	int ref = (sepFace[1] > BOXBOX_RELATIVE_TOLERANCE * sepFace[0] + tolerance) ? 1 : 0;
+
+	if (sepEdge > BOXBOX_RELATIVE_TOLERANCE * sepFace[ref] + tolerance)
+	{
+		// Edge-Edge: single point at the closest points of both edges
+		int i = iedge[0], j = iedge[1];
+		Vec3f L = Ledge * ((Vec3Dot(dc, Ledge) >= 0) ? 1.0f : -1.0f);
+
+		Vec3f p1 = pbox1->c, p2 = pbox2->c;
+		unsigned int pos1 = 0, pos2 = 0;
+		for (int m = 0; m < 2; ++m)
+		{
+			int k = (i + 1 + m) % 3;
+			bool positive = Vec3Dot(pbox1->axis[k], L) >= 0;
+			p1 += pbox1->axis[k] * (positive ? pbox1->dim[k] : -pbox1->dim[k]);
+			pos1 |= (positive ? 1u : 0) << m;
+
+			k = (j + 1 + m) % 3;
+			positive = Vec3Dot(pbox2->axis[k], L) < 0;
+			p2 += pbox2->axis[k] * (positive ? pbox2->dim[k] : -pbox2->dim[k]);
+			pos2 |= (positive ? 1u : 0) << m;
+		}
+
+		// Closest points of p1 + s * axis1[i] and p2 + t * axis2[j]
+		const Vec3f &d1 = pbox1->axis[i], &d2 = pbox2->axis[j];
+		Vec3f r = p1 - p2;
+		float b = Vec3Dot(d1, d2), c = Vec3Dot(d1, r), f = Vec3Dot(d2, r);
+		float t1 = (b * f - c) / (1.0f - b * b);
+		t1 = min(max(t1, -pbox1->dim[i]), pbox1->dim[i]);
+		float t2 = min(max(b * t1 + f, -pbox2->dim[j]), pbox2->dim[j]);
+		t1 = min(max(b * t2 - c, -pbox1->dim[i]), pbox1->dim[i]);
+
+		SContactPoint& pt = pmanifold->points[0];
+		pt.p = p1 + d1 * t1;
+		pt.dist = sepEdge;
+		pt.id = BOXBOX_ID_EDGE | (unsigned int)i | (pos1 << 2) | ((unsigned int)j << 4) | (pos2 << 6);
+
+		pmanifold->n = L;
+		pmanifold->num_points = 1;
+		pmanifold->feature = eINTERSECTION_FEATURE_BASE_SHAPE;
+		return true;
+	}
+
+	// Face contact: clip the incident face of the other box against the side planes of the reference face
+	const box* pref = boxes[ref];
+	const box* pinc = boxes[ref ^ 1];
+	int i = iface[ref];
+	float sgref = (Vec3Dot(ref ? -dc : dc, pref->axis[i]) >= 0) ? 1.0f : -1.0f;
+	Vec3f nref = pref->axis[i] * sgref; // points towards incident box
+
+	// Incident face is the face of the other box most anti-parallel to the reference face
+	int k = 0;
+	float best = -1.0f, a;
+	for (int kk = 0; kk < 3; ++kk)
+	{
+		if ((a = fabsf(Vec3Dot(pinc->axis[kk], nref))) > best)
+		{
+			best = a;
+			k = kk;
+		}
+	}
+
+	float sginc = (Vec3Dot(pinc->axis[k], nref) > 0) ? -1.0f : 1.0f;
+	Vec3f cinc = pinc->c + pinc->axis[k] * (pinc->dim[k] * sginc);
+	Vec3f u = pinc->axis[(k + 1) % 3] * pinc->dim[(k + 1) % 3];
+	Vec3f v = pinc->axis[(k + 2) % 3] * pinc->dim[(k + 2) % 3];
+
+	clip_vertex poly[2][MAX_CLIP_VERTICES];
+	poly[0][0].p = cinc + u + v;
+	poly[0][1].p = cinc - u + v;
+	poly[0][2].p = cinc - u - v;
+	poly[0][3].p = cinc + u - v;
+	for (unsigned int ivtx = 0; ivtx < 4; ++ivtx)
+		poly[0][ivtx].id = poly[0][ivtx].line = ivtx;
+
+	unsigned int num_vertices = 4;
+	int cur = 0;
+	for (unsigned int iplane = 0; iplane < 4 && num_vertices > 0; ++iplane)
+	{
+		int j = (i + 1 + (int)(iplane >> 1)) % 3;
+		Vec3f pn = pref->axis[j] * ((iplane & 1) ? -1.0f : 1.0f);
+		num_vertices = ClipPolygon(poly[cur], num_vertices, pn, Vec3Dot(pref->c, pn) + pref->dim[j], iplane, poly[cur ^ 1]);
+		cur ^= 1;
+	}
+
+	// Keep the points below the reference face
+	float dref = Vec3Dot(pref->c, nref) + pref->dim[i];
+	unsigned int faceIds = (ref ? BOXBOX_ID_REFERENCE_BOX2 : 0)
+		| ((unsigned int)(2 * i + (sgref > 0 ? 1 : 0)) << 9)
+		| ((unsigned int)(2 * k + (sginc > 0 ? 1 : 0)) << 6);
+
+	SContactPoint points[MAX_CLIP_VERTICES];
+	unsigned int num_points = 0;
+	for (unsigned int ivtx = 0; ivtx < num_vertices; ++ivtx)
+	{
+		const clip_vertex& cv = poly[cur][ivtx];
+		float depth = Vec3Dot(cv.p, nref) - dref;
+		if (depth > 0)
+			continue;
+
+		SContactPoint& pt = points[num_points++];
+		pt.p = ref ? cv.p : cv.p - nref * depth; // incident points lie on box2 if box1 is the reference
+		pt.dist = depth;
+		pt.id = faceIds | cv.id;
+	}
+
+	if (num_points == 0)
+	{
+		// Numerically degenerate clipping (e.g. touching within float precision)
+		SIntersection inters;
+		if (!_BoxBox(pbox1, pbox2, &inters))
+			return false;
+
+		SetSinglePointManifold(inters, pmanifold);
+		return true;
+	}
+
+	pmanifold->num_points = ReduceContactPoints(points, num_points, nref);
+	for (unsigned int ipt = 0; ipt < pmanifold->num_points; ++ipt)
+		pmanifold->points[ipt] = points[ipt];
+
+	pmanifold->n = ref ? -nref : nref;
+	pmanifold->feature = eINTERSECTION_FEATURE_BASE_SHAPE;
+	return true;
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+bool _ContactManifold(const shape* pshape1, const shape* pshape2, SContactManifold* pmanifold)
+{
+	EShapeType ty1 = pshape1->GetType(), ty2 = pshape2->GetType();
+	switch (ty1)
+	{
+	case eSHAPE_PLANE:
+		if (ty2 == eSHAPE_BOX)
+			return _PlaneBoxManifold(static_cast<const plane*>(pshape1), static_cast<const box*>(pshape2), pmanifold);
+		if (ty2 == eSHAPE_CAPSULE)
+			return _PlaneCapsuleManifold(static_cast<const plane*>(pshape1), static_cast<const capsule*>(pshape2), pmanifold);
+		break;
+	case eSHAPE_BOX:
+		if (ty2 == eSHAPE_BOX)
+			return _BoxBoxManifold(static_cast<const box*>(pshape1), static_cast<const box*>(pshape2), pmanifold);
+		if (ty2 == eSHAPE_PLANE)
+			return _BoxPlaneManifold(static_cast<const box*>(pshape1), static_cast<const plane*>(pshape2), pmanifold);
+		break;
+	case eSHAPE_CAPSULE:
+		if (ty2 == eSHAPE_PLANE)
+			return _CapsulePlaneManifold(static_cast<const capsule*>(pshape1), static_cast<const plane*>(pshape2), pmanifold);
+		break;
+	default:
+		break;
+	}
+
+	SIntersection inters;
+	if (!_Intersection(pshape1, pshape2, &inters))
+	{
+		pmanifold->num_points = 0;
+		return false;
+	}
+
+	SetSinglePointManifold(inters, pmanifold);
+	return true;
+}
+
+GEO_NMSPACE_END
@@ -0,0 +1,61 @@
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+//	SpeedPoint Game Engine
+//	Copyright (c) 2011-2018 Pascal Rosenkranz, All rights reserved.
+//
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include "geo.h"
+
+// Maximum number of points of a contact manifold. Four points are enough to support a box resting on a face.
+#define MAX_CONTACT_POINTS 4
+
+GEO_NMSPACE_BEG
+
+struct SContactPoint
+{
+	Vec3f p; // lies on the surface of shape1
+	float dist; // negative if interpenetrating
+
+	// Identifies the pair of features (vertices, edges, faces) that generated this point.
+	// Ids stay the same over frames as long as the same features are in contact, so contacts can be matched.
+	// Ids are only unique within one manifold of the same pair of shapes.
+	unsigned int id;
+};
+
+// Contact region of two shapes. All points share the same normal.
+struct SContactManifold
+{
+	Vec3f n; // points from shape1 to shape2
+	SContactPoint points[MAX_CONTACT_POINTS];
+	unsigned int num_points;
+	EIntersectionFeature feature;
+
+	SContactManifold() : num_points(0), feature(eINTERSECTION_FEATURE_BASE_SHAPE) {}
+
+	// Summary:
+	//	Returns the index of the point with the given id or -1 if there is none.
+	int FindPoint(unsigned int id) const;
+
+	// Summary:
+	//	Fills pinters with the deepest point of this manifold
+	void GetDeepestIntersection(SIntersection* pinters) const;
+};
+
+bool _PlaneCapsuleManifold(const plane* pplane, const capsule* pcapsule, SContactManifold* pmanifold);
+bool _PlaneBoxManifold(const plane* pplane, const box* pbox, SContactManifold* pmanifold);
+bool _CapsulePlaneManifold(const capsule* pcapsule, const plane* pplane, SContactManifold* pmanifold);
+bool _BoxPlaneManifold(const box* pbox, const plane* pplane, SContactManifold* pmanifold);
+bool _BoxBoxManifold(const box* pbox1, const box* pbox2, SContactManifold* pmanifold);
+
+// Summary:
+//	Computes the contact manifold of two shapes. Box-box, box-plane and capsule-plane contacts are clipped
+//	against each other and yield up to MAX_CONTACT_POINTS points. All other pairs fall back to _Intersection()
+//	and yield a single point with id 0.
+// Returns:
+//	true if the shapes intersect
+bool _ContactManifold(const shape* pshape1, const shape* pshape2, SContactManifold* pmanifold);
+
+GEO_NMSPACE_END
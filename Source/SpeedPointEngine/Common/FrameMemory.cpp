@@ -0,0 +1,191 @@
+//////////////////////////////////////////////////////////////////////////////////////////////////
+//
+//	SpeedPoint Game Engine
+//	Copyright (c) 2011-2018 Pascal Rosenkranz, All rights reserved.
+//
+//////////////////////////////////////////////////////////////////////////////////////////////////
+
+#include "FrameMemory.h"
+#include "MemoryTracker.h"
+#include <malloc.h>
+
+#ifdef _DEBUG
+#include <crtdbg.h>
+#endif
+
+SP_NMSPACE_BEG
+
+#define FRAME_MEMORY_DEFAULT_CAPACITY (1024 * 1024)
+
+#ifdef _DEBUG
+static volatile long g_NumHeapAllocations = 0;
+static _CRT_ALLOC_HOOK g_PrevAllocHook = 0;
+
+static int __cdecl CountHeapAllocationsHook(int allocType, void* userData, size_t size, int blockType,
+	long requestNumber, const unsigned char* filename, int lineNumber)
+{
+	if (allocType == _HOOK_ALLOC || allocType == _HOOK_REALLOC)
+		_InterlockedIncrement(&g_NumHeapAllocations);
+
+	if (g_PrevAllocHook)
+		return g_PrevAllocHook(allocType, userData, size, blockType, requestNumber, filename, lineNumber);
+
+	return TRUE;
+}
+#endif
+
+S_API FrameMemoryIntrnl::FrameMemoryIntrnl()
+	: m_CurrentBuffer(0),
+	m_NumAllocations(0),
+	m_LastFrameAllocations(0),
+	m_LastFrameOverflows(0),
+	m_LastFrameBytes(0),
+	m_PeakFrameBytes(0),
+	m_bCountHeapAllocations(false),
+	m_LastFrameHeapAllocations(UINT_MAX)
+{
+	SetCapacity(FRAME_MEMORY_DEFAULT_CAPACITY);
+}
+
+S_API FrameMemoryIntrnl::~FrameMemoryIntrnl()
+{
+	EnableHeapAllocationCounting(false);
+
+	for (int i = 0; i < 2; ++i)
+	{
+		ResetBuffer(m_Buffers[i]);
+		if (m_Buffers[i].pMemory)
+		{
+			MemoryTracker::OnFree(eMEMTAG_FRAME_MEMORY, m_Buffers[i].capacity);
+			_aligned_free(m_Buffers[i].pMemory);
+		}
+
+		m_Buffers[i].pMemory = 0;
+		m_Buffers[i].capacity = 0;
+	}
+}
+
+S_API void FrameMemoryIntrnl::ResetBuffer(SBuffer& buffer)
+{
+	for (auto itOverflow = buffer.overflow.begin(); itOverflow != buffer.overflow.end(); ++itOverflow)
+		_aligned_free(*itOverflow);
+
+	buffer.overflow.clear();
+	buffer.overflowBytes = 0;
+	buffer.used = 0;
+}
+
+S_API void FrameMemoryIntrnl::SetCapacity(size_t bytes)
+{
+	for (int i = 0; i < 2; ++i)
+	{
+		SBuffer& buffer = m_Buffers[i];
+		ResetBuffer(buffer);
+
+		if (buffer.pMemory)
+		{
+			MemoryTracker::OnFree(eMEMTAG_FRAME_MEMORY, buffer.capacity);
+			_aligned_free(buffer.pMemory);
+		}
+
+		buffer.pMemory = (char*)_aligned_malloc(bytes, 16);
+		buffer.capacity = (buffer.pMemory ? bytes : 0);
+		if (buffer.pMemory)
+			MemoryTracker::OnAlloc(eMEMTAG_FRAME_MEMORY, buffer.capacity);
+	}
+}
+
+S_API void* FrameMemoryIntrnl::Allocate(size_t bytes, size_t alignment /*= 16*/)
+{
+	SBuffer& buffer = m_Buffers[m_CurrentBuffer];
+	++m_NumAllocations;
+
+	size_t start = (buffer.used + alignment - 1) & ~(alignment - 1);
+	if (buffer.pMemory && start + bytes <= buffer.capacity)
+	{
+		buffer.used = start + bytes;
+		return buffer.pMemory + start;
+	}
+
+	// Buffer is full. Fall back to heap until the buffer is grown on the next reset.
+	void* pMemory = _aligned_malloc(bytes > 0 ? bytes : 1, alignment);
+	buffer.overflow.push_back(pMemory);
+	buffer.overflowBytes += bytes;
+	return pMemory;
+}
+
+S_API void FrameMemoryIntrnl::NextFrame()
+{
+	SBuffer& buffer = m_Buffers[m_CurrentBuffer];
+
+	m_LastFrameBytes = buffer.used + buffer.overflowBytes;
+	if (m_LastFrameBytes > m_PeakFrameBytes)
+		m_PeakFrameBytes = m_LastFrameBytes;
+
+	m_LastFrameAllocations = m_NumAllocations;
+	m_LastFrameOverflows = (unsigned int)buffer.overflow.size();
+	m_NumAllocations = 0;
+
+#ifdef _DEBUG
+	if (m_bCountHeapAllocations)
+		m_LastFrameHeapAllocations = (unsigned int)_InterlockedExchange(&g_NumHeapAllocations, 0);
+#endif
+
+	// Switch to the buffer of the previous frame, which is not referenced anymore
+	m_CurrentBuffer ^= 0x1;
+	SBuffer& nextBuffer = m_Buffers[m_CurrentBuffer];
+	ResetBuffer(nextBuffer);
+
+	// Grow the buffer, so that the peak usage fits without overflow
+	if (m_PeakFrameBytes > nextBuffer.capacity)
+	{
+		size_t newCapacity = nextBuffer.capacity;
+		while (newCapacity < m_PeakFrameBytes)
+			newCapacity = (newCapacity > 0 ? newCapacity * 2 : FRAME_MEMORY_DEFAULT_CAPACITY);
+
+		if (nextBuffer.pMemory)
+		{
+			MemoryTracker::OnFree(eMEMTAG_FRAME_MEMORY, nextBuffer.capacity);
+			_aligned_free(nextBuffer.pMemory);
+		}
+
+		nextBuffer.pMemory = (char*)_aligned_malloc(newCapacity, 16);
+		nextBuffer.capacity = (nextBuffer.pMemory ? newCapacity : 0);
+		if (nextBuffer.pMemory)
+			MemoryTracker::OnAlloc(eMEMTAG_FRAME_MEMORY, nextBuffer.capacity);
+	}
+}
+
+#ifdef _DEBUG
+S_API void FrameMemoryIntrnl::EnableHeapAllocationCounting(bool enable /*= true*/)
+{
+	if (enable == m_bCountHeapAllocations)
+		return;
+
+	if (enable)
+	{
+		g_NumHeapAllocations = 0;
+		g_PrevAllocHook = _CrtSetAllocHook(CountHeapAllocationsHook);
+	}
+	else
+	{
+		_CrtSetAllocHook(g_PrevAllocHook);
+		g_PrevAllocHook = 0;
+		m_LastFrameHeapAllocations = UINT_MAX;
+	}
+
+	m_bCountHeapAllocations = enable;
+}
+#else
+S_API void FrameMemoryIntrnl::EnableHeapAllocationCounting(bool /*enable = true*/)
+{
+	// Requires the allocation hook of the debug CRT
+}
+#endif
+
+S_API unsigned int FrameMemoryIntrnl::GetLastFrameHeapAllocations() const
+{
+	return (m_bCountHeapAllocations ? m_LastFrameHeapAllocations : UINT_MAX);
+}
+
+SP_NMSPACE_END
@@ -0,0 +1,155 @@
+//////////////////////////////////////////////////////////////////////////////////////////////////
+//
+//	SpeedPoint Game Engine
+//	Copyright (c) 2011-2018 Pascal Rosenkranz, All rights reserved.
+//
+//////////////////////////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include "SPrerequisites.h"
+#include <new>
+#include <limits>
+
+SP_NMSPACE_BEG
+
+// Linear (bump) allocator for transient per-frame data.
+// There are two buffers that are used alternately, so memory allocated in one frame stays
+// valid until the end of the next frame. Memory is never freed individually.
+// If a buffer runs full, the allocator falls back to the heap and grows the buffer on the next reset.
+//
+// Not thread-safe: Allocate() and NextFrame() must only be called from the frame thread, i.e. the
+// thread that runs SpeedPointEngine::DoFrame(). Memory allocated there may be passed to worker
+// threads, as long as they are done with it before the end of the next frame.
+class S_API FrameMemoryIntrnl
+{
+private:
+	struct SBuffer
+	{
+		char* pMemory;
+		size_t capacity;
+		size_t used;
+		vector<void*> overflow; // heap allocations, freed on reset
+		size_t overflowBytes;
+
+		SBuffer() : pMemory(0), capacity(0), used(0), overflowBytes(0) {}
+	};
+
+	SBuffer m_Buffers[2];
+	unsigned char m_CurrentBuffer;
+
+	unsigned int m_NumAllocations; // in the current frame
+	unsigned int m_LastFrameAllocations;
+	unsigned int m_LastFrameOverflows;
+	size_t m_LastFrameBytes;
+	size_t m_PeakFrameBytes;
+
+	bool m_bCountHeapAllocations;
+	unsigned int m_LastFrameHeapAllocations;
+
+	void ResetBuffer(SBuffer& buffer);
+
+public:
+	FrameMemoryIntrnl();
+	~FrameMemoryIntrnl();
+
+	// Returns aligned memory that is valid until the end of the next frame. Never returns 0.
+	void* Allocate(size_t bytes, size_t alignment = 16);
+
+	// Must be called at the end of each frame. Resets the buffer of the previous frame.
+	void NextFrame();
+
+	// Sets the size of each of the two buffers in bytes. Resets both buffers.
+	void SetCapacity(size_t bytes);
+
+	// Counts all heap allocations (malloc/new) of the process per frame. Only available
+	// in debug builds, as this uses the allocation hook of the debug CRT.
+	void EnableHeapAllocationCounting(bool enable = true);
+
+	size_t GetLastFrameBytes() const { return m_LastFrameBytes; }
+	size_t GetPeakFrameBytes() const { return m_PeakFrameBytes; }
+	unsigned int GetLastFrameAllocations() const { return m_LastFrameAllocations; }
+
+	// Number of frame allocations that did not fit into the buffer and went to the heap
+	unsigned int GetLastFrameOverflows() const { return m_LastFrameOverflows; }
+
+	// Returns UINT_MAX if heap allocation counting is not enabled or not available
+	unsigned int GetLastFrameHeapAllocations() const;
+};
+
+class S_API FrameMemory
+{
+public:
+	static FrameMemoryIntrnl* Get()
+	{
+		static FrameMemoryIntrnl* frameMemory = 0;
+
+		if (!frameMemory)
+			frameMemory = new FrameMemoryIntrnl();
+
+		return frameMemory;
+	}
+
+	inline static void* Allocate(size_t bytes, size_t alignment = 16)
+	{
+		return Get()->Allocate(bytes, alignment);
+	}
+
+	// Default constructs n objects of type T in frame memory. Their destructor is never called.
+	template<typename T>
+	inline static T* NewArray(size_t n)
+	{
+		T* p = (T*)Get()->Allocate(sizeof(T) * n, __alignof(T) > 16 ? __alignof(T) : 16);
+		for (size_t i = 0; i < n; ++i)
+			new (&p[i]) T();
+
+		return p;
+	}
+};
+
+// STL allocator adapter for the frame memory.
+// Containers using this allocator must not live longer than the end of the next frame.
+template<typename T>
+class FrameAllocator
+{
+public:
+	typedef T value_type;
+	typedef T* pointer;
+	typedef const T* const_pointer;
+	typedef T& reference;
+	typedef const T& const_reference;
+	typedef size_t size_type;
+	typedef ptrdiff_t difference_type;
+
+	template<typename U> struct rebind { typedef FrameAllocator<U> other; };
+
+	FrameAllocator() {}
+	FrameAllocator(const FrameAllocator<T>&) {}
+	template<typename U> FrameAllocator(const FrameAllocator<U>&) {}
+
+	pointer address(reference x) const { return &x; }
+	const_pointer address(const_reference x) const { return &x; }
+
+	pointer allocate(size_type n, const void* hint = 0)
+	{
+		return (pointer)FrameMemory::Allocate(sizeof(T) * n, __alignof(T) > 16 ? __alignof(T) : 16);
+	}
+
+	void deallocate(pointer p, size_type n) {}
+
+	size_type max_size() const { return (std::numeric_limits<size_type>::max)() / sizeof(T); }
+
+	template<typename U, typename... Args>
+	void construct(U* p, Args&&... args) { new ((void*)p) U(std::forward<Args>(args)...); }
+
+	template<typename U>
+	void destroy(U* p) { p->~U(); }
+
+	template<typename U> bool operator ==(const FrameAllocator<U>&) const { return true; }
+	template<typename U> bool operator !=(const FrameAllocator<U>&) const { return false; }
+};
+
+template<typename T>
+using FrameVector = std::vector<T, FrameAllocator<T>>;
+
+SP_NMSPACE_END
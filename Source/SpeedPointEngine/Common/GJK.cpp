@@ -0,0 +1,838 @@
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+//	SpeedPoint Game Engine
+//	Copyright (c) 2011-2018 Pascal Rosenkranz, All rights reserved.
+//
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#include "GJK.h"
+#include <string.h>
+
+GEO_NMSPACE_BEG
+
+// GJK stops when the distance cannot be reduced by more than this fraction of the size of the Minkowski difference
+#define GJK_TOLERANCE 1e-5f
+
+// GJK reports an intersection if the squared distance is smaller than this fraction of the squared size of the simplex.
+// Larger distances are reported as disjoint, even if the shapes only touch.
+#define GJK_INTERSECT_TOLERANCE 1e-10f
+
+// EPA stops when the support point in the direction of the closest face is less than this (world units) farther away
+#define EPA_TOLERANCE 1e-4f
+
+// Faces of the polytope only see a new point that is farther in front of them than this. Treating almost coplanar faces
+// (e.g. on flat sides of boxes and triangles) as visible can make the hole in the polytope non-simple.
+#define EPA_VISIBILITY_TOLERANCE 1e-6f
+
+#define EPA_MAX_VERTICES (4 + EPA_MAX_ITERATIONS)
+#define EPA_MAX_FACES (2 * EPA_MAX_VERTICES) // closed triangle mesh: F = 2V - 4
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+//	Support mappings
+//
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+bool _IsConvexShape(EShapeType type)
+{
+	switch (type)
+	{
+	case eSHAPE_SPHERE:
+	case eSHAPE_CYLINDER:
+	case eSHAPE_CAPSULE:
+	case eSHAPE_BOX:
+	case eSHAPE_TRIANGLE:
+	case eSHAPE_CIRCLE:
+	case eSHAPE_CONVEX_HULL:
+		return true;
+	default:
+		return false;
+	}
+}
+
+bool _GetConvexSupport(const shape* pshape, convex_support* psupport)
+{
+	psupport->pshape = pshape;
+	psupport->points = 0;
+	psupport->num_points = 0;
+	psupport->hint = 0;
+	switch (pshape->GetType())
+	{
+	case eSHAPE_SPHERE: psupport->margin = static_cast<const sphere*>(pshape)->r; return true;
+	case eSHAPE_CAPSULE: psupport->margin = static_cast<const capsule*>(pshape)->r; return true;
+	case eSHAPE_CONVEX_HULL: psupport->margin = 0; return static_cast<const convex_hull*>(pshape)->data != 0;
+	default:
+		psupport->margin = 0;
+		return _IsConvexShape(pshape->GetType());
+	}
+}
+
+void _GetConvexSupport(const Vec3f* points, unsigned int num_points, convex_support* psupport)
+{
+	psupport->pshape = 0;
+	psupport->points = points;
+	psupport->num_points = num_points;
+	psupport->margin = 0;
+	psupport->hint = 0;
+}
+
+// Farthest point of the disk with center c, normal n (normalized) and radius r in direction d
+static inline Vec3f DiskSupport(const Vec3f& c, const Vec3f& n, float r, const Vec3f& d)
+{
+	Vec3f dp = d - n * Vec3Dot(d, n);
+	float dplnsq = dp.LengthSq();
+	return (dplnsq > FLT_EPSILON * d.LengthSq()) ? c + dp * (r / sqrtf(dplnsq)) : c;
+}
+
+Vec3f convex_support::Support(const Vec3f& d) const
+{
+	if (!pshape)
+	{
+		unsigned int best = 0;
+		float dot, bestdot = Vec3Dot(points[0], d);
+		for (unsigned int i = 1; i < num_points; ++i)
+		{
+			if ((dot = Vec3Dot(points[i], d)) > bestdot)
+			{
+				bestdot = dot;
+				best = i;
+			}
+		}
+		return points[best];
+	}
+
+	switch (pshape->GetType())
+	{
+	case eSHAPE_SPHERE:
+		return static_cast<const sphere*>(pshape)->c;
+
+	case eSHAPE_CAPSULE:
+		{
+			const capsule* pcapsule = static_cast<const capsule*>(pshape);
+			return pcapsule->c + pcapsule->axis * (Vec3Dot(d, pcapsule->axis) >= 0 ? pcapsule->hh : -pcapsule->hh);
+		}
+
+	case eSHAPE_CYLINDER:
+		{
+			const cylinder* pcyl = static_cast<const cylinder*>(pshape);
+			Vec3f a = pcyl->p[1] - pcyl->p[0];
+			float dn = Vec3Dot(d, a);
+			Vec3f dp = d - a * (dn / a.LengthSq());
+			float dplnsq = dp.LengthSq();
+			Vec3f p = pcyl->p[dn >= 0 ? 1 : 0];
+			return (dplnsq > FLT_EPSILON * d.LengthSq()) ? p + dp * (pcyl->r / sqrtf(dplnsq)) : p;
+		}
+
+	case eSHAPE_BOX:
+		{
+			const box* pbox = static_cast<const box*>(pshape);
+			Vec3f p = pbox->c;
+			for (int i = 0; i < 3; ++i)
+				p += pbox->axis[i] * (Vec3Dot(d, pbox->axis[i]) >= 0 ? pbox->dim[i] : -pbox->dim[i]);
+			return p;
+		}
+
+	case eSHAPE_TRIANGLE:
+		{
+			const triangle* ptri = static_cast<const triangle*>(pshape);
+			float d0 = Vec3Dot(ptri->p[0], d), d1 = Vec3Dot(ptri->p[1], d), d2 = Vec3Dot(ptri->p[2], d);
+			if (d0 >= d1)
+				return ptri->p[d0 >= d2 ? 0 : 2];
+			else
+				return ptri->p[d1 >= d2 ? 1 : 2];
+		}
+
+	case eSHAPE_CIRCLE:
+		{
+			const circle* pcircle = static_cast<const circle*>(pshape);
+			return DiskSupport(pcircle->c, pcircle->n, pcircle->r, d);
+		}
+
+	case eSHAPE_CONVEX_HULL:
+		return static_cast<const convex_hull*>(pshape)->Support(d, &hint);
+
+	default:
+		return Vec3f(0);
+	}
+}
+
+Vec3f convex_support::GetCenter() const
+{
+	if (!pshape)
+		return points[0];
+
+	switch (pshape->GetType())
+	{
+	case eSHAPE_SPHERE: return static_cast<const sphere*>(pshape)->c;
+	case eSHAPE_CAPSULE: return static_cast<const capsule*>(pshape)->c;
+	case eSHAPE_CIRCLE: return static_cast<const circle*>(pshape)->c;
+	case eSHAPE_BOX: return static_cast<const box*>(pshape)->c;
+	case eSHAPE_CONVEX_HULL:
+		{
+			const convex_hull* phull = static_cast<const convex_hull*>(pshape);
+			return (phull->transform * Vec4f(phull->data->center, 1.0f)).xyz();
+		}
+	case eSHAPE_CYLINDER:
+		{
+			const cylinder* pcyl = static_cast<const cylinder*>(pshape);
+			return (pcyl->p[0] + pcyl->p[1]) * 0.5f;
+		}
+	case eSHAPE_TRIANGLE:
+		{
+			const triangle* ptri = static_cast<const triangle*>(pshape);
+			return (ptri->p[0] + ptri->p[1] + ptri->p[2]) * (1.0f / 3.0f);
+		}
+	default:
+		return Vec3f(0);
+	}
+}
+
+// Support point of the shape including its margin
+static inline Vec3f SupportWithMargin(const convex_support* pshape, const Vec3f& d)
+{
+	Vec3f p = pshape->Support(d);
+	if (pshape->margin > 0)
+		p += d * (pshape->margin / d.Length());
+
+	return p;
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+//	GJK
+//
+//	The simplex consists of points w = a - b of the Minkowski difference of both shapes, together with the
+//	support points a and b they were made of. Each iteration finds the point v of the simplex closest to the origin,
+//	reduces the simplex to the smallest sub-simplex containing v (Voronoi regions, C. Ericson, "Real-Time Collision
+//	Detection", 2005) and adds the support point of the Minkowski difference in direction -v.
+//	The closest points of the shapes are the barycentric combinations of the a's and b's.
+//
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+struct gjk_vertex
+{
+	Vec3f w; // a - b
+	Vec3f a;
+	Vec3f b;
+};
+
+struct gjk_simplex
+{
+	gjk_vertex v[4];
+	float bc[4]; // barycentric coordinates of the closest point
+	unsigned int n;
+};
+
+enum EGJKResult
+{
+	eGJK_SEPARATED, // separated by more than the given distance
+	eGJK_DISJOINT, // cores are disjoint, the simplex contains the closest points
+	eGJK_INTERSECT // cores intersect
+};
+
+static inline void SetSimplex1(gjk_simplex& s, const gjk_vertex& a)
+{
+	s.v[0] = a;
+	s.bc[0] = 1.0f;
+	s.n = 1;
+}
+
+static inline void SetSimplex2(gjk_simplex& s, const gjk_vertex& a, const gjk_vertex& b, float t)
+{
+	s.v[0] = a; s.v[1] = b;
+	s.bc[0] = 1.0f - t; s.bc[1] = t;
+	s.n = 2;
+}
+
+static inline Vec3f SimplexPoint(const gjk_simplex& s)
+{
+	Vec3f v = s.v[0].w * s.bc[0];
+	for (unsigned int i = 1; i < s.n; ++i)
+		v += s.v[i].w * s.bc[i];
+
+	return v;
+}
+
+// Closest point of segment ab to the origin
+static void ClosestSegment(const gjk_vertex& a, const gjk_vertex& b, gjk_simplex& s)
+{
+	Vec3f ab = b.w - a.w;
+	float num = -Vec3Dot(a.w, ab), den = ab.LengthSq();
+	if (num <= 0)
+		SetSimplex1(s, a);
+	else if (num >= den)
+		SetSimplex1(s, b);
+	else
+		SetSimplex2(s, a, b, num / den);
+}
+
+// Closest point of triangle abc to the origin
+static void ClosestTriangle(const gjk_vertex& a, const gjk_vertex& b, const gjk_vertex& c, gjk_simplex& s)
+{
+	Vec3f ab = b.w - a.w, ac = c.w - a.w;
+	float d1 = -Vec3Dot(ab, a.w), d2 = -Vec3Dot(ac, a.w);
+	if (d1 <= 0 && d2 <= 0)
+		return SetSimplex1(s, a);
+
+	float d3 = -Vec3Dot(ab, b.w), d4 = -Vec3Dot(ac, b.w);
+	if (d3 >= 0 && d4 <= d3)
+		return SetSimplex1(s, b);
+
+	float vc = d1 * d4 - d3 * d2;
+	if (vc <= 0 && d1 >= 0 && d3 <= 0)
+		return SetSimplex2(s, a, b, d1 / (d1 - d3));
+
+	float d5 = -Vec3Dot(ab, c.w), d6 = -Vec3Dot(ac, c.w);
+	if (d6 >= 0 && d5 <= d6)
+		return SetSimplex1(s, c);
+
+	float vb = d5 * d2 - d1 * d6;
+	if (vb <= 0 && d2 >= 0 && d6 <= 0)
+		return SetSimplex2(s, a, c, d2 / (d2 - d6));
+
+	float va = d3 * d6 - d5 * d4;
+	if (va <= 0 && (d4 - d3) >= 0 && (d5 - d6) >= 0)
+		return SetSimplex2(s, b, c, (d4 - d3) / ((d4 - d3) + (d5 - d6)));
+
+	float den = va + vb + vc;
+	if (den <= FLT_MIN)
+	{
+		// Degenerate (collinear) triangle - use the closest of its edges
+		gjk_simplex tmp;
+		ClosestSegment(a, b, s);
+		ClosestSegment(a, c, tmp);
+		if (SimplexPoint(tmp).LengthSq() < SimplexPoint(s).LengthSq()) s = tmp;
+		ClosestSegment(b, c, tmp);
+		if (SimplexPoint(tmp).LengthSq() < SimplexPoint(s).LengthSq()) s = tmp;
+		return;
+	}
+
+	s.v[0] = a; s.v[1] = b; s.v[2] = c;
+	s.bc[1] = vb / den;
+	s.bc[2] = vc / den;
+	s.bc[0] = 1.0f - s.bc[1] - s.bc[2];
+	s.n = 3;
+}
+
+// Closest point of tetrahedron abcd to the origin.
+// Returns false if the origin lies inside the tetrahedron.
+static bool ClosestTetrahedron(const gjk_simplex& tet, gjk_simplex& s)
+{
+	const gjk_vertex* v = tet.v;
+	static const int faces[4][4] = { { 0, 1, 2, 3 }, { 0, 2, 3, 1 }, { 0, 3, 1, 2 }, { 1, 3, 2, 0 } }; // face, opposite vertex
+
+	// The origin is outside of a face, if it lies on the other side of the face plane than the opposite vertex.
+	// Faces that are closer to the origin than the tolerance are tested as well, so rounding errors in thin
+	// tetrahedra do not move an origin just outside to the inside. Flat tetrahedra have no inside, all faces are tested then.
+	float det = Vec3Dot(v[3].w - v[0].w, (v[1].w - v[0].w) ^ (v[2].w - v[0].w));
+	bool flat = fabsf(det) <= FLT_EPSILON * (v[1].w - v[0].w).Length() * (v[2].w - v[0].w).Length() * (v[3].w - v[0].w).Length();
+
+	float maxwlnsq = 0;
+	for (int i = 0; i < 4; ++i)
+		maxwlnsq = max(maxwlnsq, v[i].w.LengthSq());
+
+	float tolerance = GJK_TOLERANCE * sqrtf(maxwlnsq);
+
+	bool outside = false;
+	float bestDistSq = FLT_MAX, distSq;
+	gjk_simplex tmp;
+	for (int i = 0; i < 4; ++i)
+	{
+		const gjk_vertex &a = v[faces[i][0]], &b = v[faces[i][1]], &c = v[faces[i][2]], &d = v[faces[i][3]];
+		if (!flat)
+		{
+			// Signed distance of the origin to the face plane, positive towards the opposite vertex
+			Vec3f n = (b.w - a.w) ^ (c.w - a.w);
+			float dist = -Vec3Dot(a.w, n) / n.Length();
+			if (Vec3Dot(d.w - a.w, n) < 0)
+				dist = -dist;
+
+			if (dist > tolerance)
+				continue;
+		}
+
+		outside = true;
+		ClosestTriangle(a, b, c, tmp);
+		if ((distSq = SimplexPoint(tmp).LengthSq()) < bestDistSq)
+		{
+			bestDistSq = distSq;
+			s = tmp;
+		}
+	}
+
+	return outside;
+}
+
+// Runs GJK on the cores of both shapes. Stops early with eGJK_SEPARATED if the cores are more than sepDist apart.
+// v is the closest point of the Minkowski difference to the origin.
+static EGJKResult GJK(const convex_support* pshape1, const convex_support* pshape2, float sepDist, gjk_simplex& s, Vec3f& v)
+{
+	v = pshape1->GetCenter() - pshape2->GetCenter();
+	if (v.LengthSq() < FLT_EPSILON)
+		v = Vec3f(1.0f, 0, 0);
+
+	float sepDistSq = sepDist * sepDist;
+	float vlnsq = v.LengthSq(), vw, maxwlnsq = 0;
+	gjk_vertex p;
+	gjk_simplex grown, next;
+	s.n = 0;
+	for (int iteration = 0; iteration < GJK_MAX_ITERATIONS; ++iteration)
+	{
+		p.a = pshape1->Support(-v);
+		p.b = pshape2->Support(v);
+		p.w = p.a - p.b;
+
+		// v is a separating axis
+		vw = Vec3Dot(v, p.w);
+		if (vw > 0 && vw * vw > vlnsq * sepDistSq)
+			return eGJK_SEPARATED;
+
+		// The distance |v| can be reduced by (|v|^2 - v.w) / |v| at most
+		if (s.n > 0 && vlnsq - vw <= GJK_TOLERANCE * sqrtf(vlnsq * maxwlnsq))
+			return eGJK_DISJOINT;
+
+		bool duplicate = false;
+		for (unsigned int i = 0; i < s.n; ++i)
+			duplicate |= (s.v[i].w.x == p.w.x && s.v[i].w.y == p.w.y && s.v[i].w.z == p.w.z);
+
+		if (duplicate)
+			return eGJK_DISJOINT;
+
+		grown = s;
+		grown.v[grown.n++] = p;
+		switch (grown.n)
+		{
+		case 1: SetSimplex1(next, grown.v[0]); break;
+		case 2: ClosestSegment(grown.v[0], grown.v[1], next); break;
+		case 3: ClosestTriangle(grown.v[0], grown.v[1], grown.v[2], next); break;
+		default:
+			if (!ClosestTetrahedron(grown, next))
+			{
+				// If v separates the shapes (v.w > 0), the origin can only be inside due to rounding errors in a thin tetrahedron
+				if (vw > 0)
+					return eGJK_DISJOINT;
+
+				s = grown;
+				return eGJK_INTERSECT;
+			}
+			break;
+		}
+
+		// Rounding errors close to the boundary can make the new simplex worse than the last one. Keep the last one then.
+		Vec3f nextv = SimplexPoint(next);
+		float newvlnsq = nextv.LengthSq();
+		if (iteration > 0 && newvlnsq >= vlnsq)
+			return eGJK_DISJOINT;
+
+		s = next;
+		v = nextv;
+
+		maxwlnsq = 0;
+		for (unsigned int i = 0; i < s.n; ++i)
+			maxwlnsq = max(maxwlnsq, s.v[i].w.LengthSq());
+
+		if (newvlnsq <= GJK_INTERSECT_TOLERANCE * maxwlnsq)
+			return eGJK_INTERSECT;
+
+		vlnsq = newvlnsq;
+	}
+
+	return eGJK_DISJOINT;
+}
+
+static inline void ClosestPoints(const gjk_simplex& s, Vec3f& p1, Vec3f& p2)
+{
+	p1 = s.v[0].a * s.bc[0];
+	p2 = s.v[0].b * s.bc[0];
+	for (unsigned int i = 1; i < s.n; ++i)
+	{
+		p1 += s.v[i].a * s.bc[i];
+		p2 += s.v[i].b * s.bc[i];
+	}
+}
+
+float _GJKDistance(const convex_support* pshape1, const convex_support* pshape2, Vec3f* pclosest1, Vec3f* pclosest2)
+{
+	gjk_simplex s;
+	Vec3f v;
+	if (GJK(pshape1, pshape2, FLT_MAX, s, v) == eGJK_INTERSECT)
+		return 0;
+
+	float margin = pshape1->margin + pshape2->margin;
+	float dist = v.Length();
+	if (dist <= margin)
+		return 0;
+
+	if (pclosest1 || pclosest2)
+	{
+		Vec3f p1, p2, n = v / dist;
+		ClosestPoints(s, p1, p2);
+		if (pclosest1) *pclosest1 = p1 - n * pshape1->margin;
+		if (pclosest2) *pclosest2 = p2 + n * pshape2->margin;
+	}
+
+	return dist - margin;
+}
+
+bool _GJKIntersects(const convex_support* pshape1, const convex_support* pshape2)
+{
+	gjk_simplex s;
+	Vec3f v;
+	float margin = pshape1->margin + pshape2->margin;
+	switch (GJK(pshape1, pshape2, margin, s, v))
+	{
+	case eGJK_SEPARATED: return false;
+	case eGJK_INTERSECT: return true;
+	default:
+		return v.LengthSq() <= margin * margin;
+	}
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+//	EPA
+//
+//	Expands a polytope inside the Minkowski difference that contains the origin, until its face closest to
+//	the origin lies on the boundary of the Minkowski difference (G. van den Bergen, "Proximity Queries and Penetration
+//	Depth Computation on 3D Game Objects", 2001). That face gives the penetration depth and normal.
+//	Works on the shapes including their margins, starting from the last GJK simplex.
+//
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+struct epa_face
+{
+	unsigned char v[3]; // counter-clockwise seen from outside
+	unsigned char adj[3]; // adj[i] is the face on the other side of the edge v[i] -> v[i + 1]
+	Vec3f n; // outward normal
+	float dist; // distance of the face plane to the origin, FLT_MAX for removed and degenerate faces
+	bool removed;
+};
+
+// Faces are never moved, so that the adjacency stays valid. Removed faces are reused by new faces.
+struct epa_polytope
+{
+	gjk_vertex verts[EPA_MAX_VERTICES];
+	unsigned int num_verts;
+	epa_face faces[EPA_MAX_FACES];
+	unsigned int num_faces; // including removed faces
+	unsigned char free_faces[EPA_MAX_FACES];
+	unsigned int num_free_faces;
+
+	unsigned char AddFace(unsigned char a, unsigned char b, unsigned char c)
+	{
+		unsigned char iface = (unsigned char)(num_free_faces > 0 ? free_faces[--num_free_faces] : num_faces++);
+		epa_face& f = faces[iface];
+		f.v[0] = a; f.v[1] = b; f.v[2] = c;
+		f.removed = false;
+		f.n = (verts[b].w - verts[a].w) ^ (verts[c].w - verts[a].w);
+		float nln = f.n.Length();
+		if (nln > FLT_MIN)
+		{
+			f.n /= nln;
+			f.dist = Vec3Dot(f.n, verts[a].w);
+		}
+		else
+		{
+			// Degenerate faces are never expanded and never visible
+			f.n = Vec3f(0);
+			f.dist = FLT_MAX;
+		}
+
+		return iface;
+	}
+
+	void RemoveFace(unsigned char iface)
+	{
+		faces[iface].removed = true;
+		faces[iface].dist = FLT_MAX;
+		free_faces[num_free_faces++] = iface;
+	}
+
+	unsigned int FindClosestFace() const
+	{
+		unsigned int iclosest = 0;
+		for (unsigned int i = 1; i < num_faces; ++i)
+		{
+			if (faces[i].dist < faces[iclosest].dist)
+				iclosest = i;
+		}
+
+		return iclosest;
+	}
+};
+
+static inline gjk_vertex MinkowskiSupport(const convex_support* pshape1, const convex_support* pshape2, const Vec3f& d)
+{
+	gjk_vertex p;
+	p.a = SupportWithMargin(pshape1, d);
+	p.b = SupportWithMargin(pshape2, -d);
+	p.w = p.a - p.b;
+	return p;
+}
+
+// Adds support points to the GJK simplex until it is a tetrahedron. GJK ends with a smaller simplex if the origin
+// lies on the boundary of the Minkowski difference of the cores.
+// Returns false if the Minkowski difference is flat.
+static bool BlowUpSimplex(const convex_support* pshape1, const convex_support* pshape2, gjk_simplex& s)
+{
+	static const Vec3f axes[3] = { Vec3f(1.0f, 0, 0), Vec3f(0, 1.0f, 0), Vec3f(0, 0, 1.0f) };
+
+	Vec3f dirs[6];
+	unsigned int ndirs;
+	while (s.n < 4)
+	{
+		ndirs = 0;
+		if (s.n == 1)
+		{
+			for (int i = 0; i < 3; ++i)
+			{
+				dirs[ndirs++] = axes[i];
+				dirs[ndirs++] = -axes[i];
+			}
+		}
+		else if (s.n == 2)
+		{
+			Vec3f d = s.v[1].w - s.v[0].w;
+			int iaxis = (fabsf(d.x) < fabsf(d.y)) ? (fabsf(d.x) < fabsf(d.z) ? 0 : 2) : (fabsf(d.y) < fabsf(d.z) ? 1 : 2);
+			dirs[0] = d ^ axes[iaxis];
+			dirs[1] = -dirs[0];
+			dirs[2] = d ^ dirs[0];
+			dirs[3] = -dirs[2];
+			ndirs = 4;
+		}
+		else
+		{
+			dirs[0] = (s.v[1].w - s.v[0].w) ^ (s.v[2].w - s.v[0].w);
+			dirs[1] = -dirs[0];
+			ndirs = 2;
+		}
+
+		bool added = false;
+		for (unsigned int i = 0; i < ndirs && !added; ++i)
+		{
+			gjk_vertex p = MinkowskiSupport(pshape1, pshape2, dirs[i]);
+
+			// The new point must extend the simplex by a dimension
+			float ext;
+			if (s.n == 1)
+				ext = (p.w - s.v[0].w).LengthSq();
+			else if (s.n == 2)
+				ext = ((p.w - s.v[0].w) ^ (s.v[1].w - s.v[0].w)).LengthSq();
+			else
+				ext = fabsf(Vec3Dot(p.w - s.v[0].w, dirs[0]));
+
+			if (ext > FLT_EPSILON * max(p.w.LengthSq(), s.v[0].w.LengthSq()))
+			{
+				s.v[s.n++] = p;
+				added = true;
+			}
+		}
+
+		if (!added)
+			return false;
+	}
+
+	return true;
+}
+
+// Links the edge e of face f with the edge of the adjacent face g
+static inline void LinkFaces(epa_polytope& poly, unsigned char f, int e, unsigned char g)
+{
+	poly.faces[f].adj[e] = g;
+	const unsigned char* v = poly.faces[g].v;
+	unsigned char a = poly.faces[f].v[e];
+	poly.faces[g].adj[(v[1] == a) ? 0 : ((v[2] == a) ? 1 : 2)] = f;
+}
+
+// Returns false if EPA failed on a flat Minkowski difference
+static bool EPA(const convex_support* pshape1, const convex_support* pshape2, gjk_simplex& s, SIntersection* pinters)
+{
+	if (!BlowUpSimplex(pshape1, pshape2, s))
+		return false;
+
+	epa_polytope poly;
+	poly.num_verts = 4;
+	poly.num_faces = 0;
+	poly.num_free_faces = 0;
+	for (int i = 0; i < 4; ++i)
+		poly.verts[i] = s.v[i];
+
+	// Wind the faces of the tetrahedron outwards
+	if (Vec3Dot(s.v[3].w - s.v[0].w, (s.v[1].w - s.v[0].w) ^ (s.v[2].w - s.v[0].w)) > 0)
+		std::swap(poly.verts[1], poly.verts[2]);
+
+	static const unsigned char tetfaces[4][3] = { { 0, 1, 2 }, { 0, 3, 1 }, { 0, 2, 3 }, { 1, 3, 2 } };
+	static const unsigned char tetadj[4][3] = { { 1, 3, 2 }, { 2, 3, 0 }, { 0, 3, 1 }, { 1, 2, 0 } };
+	for (int i = 0; i < 4; ++i)
+	{
+		poly.AddFace(tetfaces[i][0], tetfaces[i][1], tetfaces[i][2]);
+		for (int e = 0; e < 3; ++e)
+			poly.faces[i].adj[e] = tetadj[i][e];
+	}
+
+	struct horizon_edge
+	{
+		unsigned char a, b; // a -> b as seen from the removed face
+		unsigned char neighbor; // face behind the edge that stays
+	};
+
+	horizon_edge horizon[EPA_MAX_FACES];
+	unsigned char stack[EPA_MAX_FACES];
+	unsigned char visible[EPA_MAX_FACES];
+	unsigned char newFaceFrom[EPA_MAX_VERTICES], newFaceTo[EPA_MAX_VERTICES];
+	unsigned int num_horizon, num_visible, nstack;
+	for (int iteration = 0; iteration < EPA_MAX_ITERATIONS && poly.num_verts < EPA_MAX_VERTICES; ++iteration)
+	{
+		unsigned char iclosest = (unsigned char)poly.FindClosestFace();
+		const epa_face& closest = poly.faces[iclosest];
+		if (closest.dist == FLT_MAX)
+			return false;
+
+		gjk_vertex p = MinkowskiSupport(pshape1, pshape2, closest.n);
+		if (Vec3Dot(p.w, closest.n) - closest.dist <= EPA_TOLERANCE)
+			break;
+
+		// Flood fill the faces that see the new point, starting at the closest face, and collect the edges of the
+		// hole they leave (horizon). Growing one connected region keeps the polytope closed, even if rounding errors
+		// make faces elsewhere look visible.
+		unsigned char ip = (unsigned char)poly.num_verts;
+		for (unsigned int i = 0; i < poly.num_verts; ++i)
+			newFaceFrom[i] = newFaceTo[i] = 0xff;
+
+		memset(visible, 0, sizeof(unsigned char) * poly.num_faces);
+		visible[iclosest] = 1;
+		num_visible = 1;
+		stack[0] = iclosest;
+		nstack = 1;
+		num_horizon = 0;
+		bool pinched = false;
+		while (nstack > 0 && !pinched)
+		{
+			const epa_face& f = poly.faces[stack[--nstack]];
+			for (int e = 0; e < 3; ++e)
+			{
+				unsigned char ineighbor = f.adj[e];
+				if (visible[ineighbor])
+					continue;
+
+				const epa_face& neighbor = poly.faces[ineighbor];
+				if (Vec3Dot(neighbor.n, p.w - poly.verts[neighbor.v[0]].w) > EPA_VISIBILITY_TOLERANCE)
+				{
+					visible[ineighbor] = 1;
+					++num_visible;
+					stack[nstack++] = ineighbor;
+					continue;
+				}
+
+				// Each vertex of the horizon must start and end exactly one edge, otherwise the hole is not simple
+				horizon_edge& h = horizon[num_horizon];
+				h.a = f.v[e];
+				h.b = f.v[(e + 1) % 3];
+				h.neighbor = ineighbor;
+				if (newFaceFrom[h.a] != 0xff || newFaceTo[h.b] != 0xff)
+				{
+					pinched = true;
+					break;
+				}
+
+				newFaceFrom[h.a] = newFaceTo[h.b] = (unsigned char)num_horizon++;
+			}
+		}
+
+		if (pinched || poly.num_faces - poly.num_free_faces - num_visible + num_horizon > EPA_MAX_FACES)
+			break;
+
+		for (unsigned int i = 0; i < poly.num_faces; ++i)
+		{
+			if (visible[i])
+				poly.RemoveFace((unsigned char)i);
+		}
+
+		poly.verts[poly.num_verts++] = p;
+		for (unsigned int i = 0; i < num_horizon; ++i)
+		{
+			unsigned char iface = poly.AddFace(horizon[i].a, horizon[i].b, ip);
+			LinkFaces(poly, iface, 0, horizon[i].neighbor);
+			newFaceFrom[horizon[i].a] = iface;
+		}
+
+		// Edge b -> p of a new face is shared with the new face of the horizon edge starting at b
+		for (unsigned int i = 0; i < num_horizon; ++i)
+		{
+			unsigned char iface = newFaceFrom[horizon[i].a], inext = newFaceFrom[horizon[i].b];
+			poly.faces[iface].adj[1] = inext;
+			poly.faces[inext].adj[2] = iface;
+		}
+	}
+
+	const epa_face& f = poly.faces[poly.FindClosestFace()];
+	if (f.dist == FLT_MAX)
+		return false;
+
+	// Barycentric coordinates of the projection of the origin onto the face
+	const gjk_vertex &a = poly.verts[f.v[0]], &b = poly.verts[f.v[1]], &c = poly.verts[f.v[2]];
+	Vec3f q = f.n * f.dist;
+	Vec3f v0 = b.w - a.w, v1 = c.w - a.w, v2 = q - a.w;
+	float d00 = Vec3Dot(v0, v0), d01 = Vec3Dot(v0, v1), d11 = Vec3Dot(v1, v1);
+	float d20 = Vec3Dot(v2, v0), d21 = Vec3Dot(v2, v1);
+	float den = d00 * d11 - d01 * d01;
+	float bcb = (den > FLT_MIN) ? (d11 * d20 - d01 * d21) / den : 0;
+	float bcc = (den > FLT_MIN) ? (d00 * d21 - d01 * d20) / den : 0;
+
+	pinters->p = a.a * (1.0f - bcb - bcc) + b.a * bcb + c.a * bcc;
+	pinters->n = f.n;
+	pinters->dist = -f.dist;
+	pinters->feature = eINTERSECTION_FEATURE_BASE_SHAPE;
+	return true;
+}
+
+bool _GJKIntersection(const convex_support* pshape1, const convex_support* pshape2, SIntersection* pinters)
+{
+	gjk_simplex s;
+	Vec3f v;
+	float margin = pshape1->margin + pshape2->margin;
+	EGJKResult res = GJK(pshape1, pshape2, margin, s, v);
+	if (res == eGJK_SEPARATED)
+		return false;
+
+	if (res == eGJK_DISJOINT)
+	{
+		float dist = v.Length();
+		if (dist > margin)
+			return false;
+
+		// Shallow contact: only the margins intersect. The normal of almost touching cores is unreliable, use EPA then.
+		if (dist > EPA_TOLERANCE)
+		{
+			Vec3f p1, p2;
+			ClosestPoints(s, p1, p2);
+			pinters->n = v / -dist;
+			pinters->p = p1 + pinters->n * pshape1->margin;
+			pinters->dist = dist - margin;
+			pinters->feature = eINTERSECTION_FEATURE_BASE_SHAPE;
+			return true;
+		}
+	}
+
+	if (EPA(pshape1, pshape2, s, pinters))
+		return pinters->dist <= 0;
+
+	// Flat Minkowski difference (e.g. coplanar triangles) - touching contact
+	pinters->n = pshape2->GetCenter() - pshape1->GetCenter();
+	pinters->n = (pinters->n.LengthSq() > FLT_EPSILON) ? pinters->n.Normalized() : Vec3f(0, 1.0f, 0);
+	pinters->p = SupportWithMargin(pshape1, pinters->n);
+	pinters->dist = 0;
+	pinters->feature = eINTERSECTION_FEATURE_BASE_SHAPE;
+	return true;
+}
+
+bool _ConvexConvex(const shape* pshape1, const shape* pshape2, SIntersection* pinters)
+{
+	convex_support support1, support2;
+	if (!_GetConvexSupport(pshape1, &support1) || !_GetConvexSupport(pshape2, &support2))
+		return false;
+
+	return _GJKIntersection(&support1, &support2, pinters);
+}
+
+GEO_NMSPACE_END
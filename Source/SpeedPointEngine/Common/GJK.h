@@ -0,0 +1,85 @@
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+//	SpeedPoint Game Engine
+//	Copyright (c) 2011-2018 Pascal Rosenkranz, All rights reserved.
+//
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include "geo.h"
+
+// Maximum number of GJK iterations. GJK converges in a few iterations for polytopes, curved shapes
+// (cylinder) need more the tighter the tolerance is.
+#define GJK_MAX_ITERATIONS 64
+
+// Maximum number of EPA iterations. Each iteration adds one vertex to the expanding polytope.
+#define EPA_MAX_ITERATIONS 64
+
+GEO_NMSPACE_BEG
+
+// Convex shape as seen by GJK: the support mapping of a core shape, inflated by a margin.
+// Spheres and capsules are a point and a segment with their radius as margin, so GJK works on the
+// cores and adds the radii afterwards. This is exact and converges much faster than sampling the round surface.
+// Points are given in world space, just as the shapes.
+struct convex_support
+{
+	const shape* pshape;
+	const Vec3f* points; // point cloud (e.g. a hull of QuickHull2()) if pshape is 0
+	unsigned int num_points;
+	float margin;
+	mutable unsigned int hint; // last support point of a convex hull, start of the next hill climbing
+
+	convex_support() : pshape(0), points(0), num_points(0), margin(0), hint(0) {}
+
+	// Summary:
+	//	Returns the point of the core shape that is farthest in direction d. d does not have to be normalized.
+	Vec3f Support(const Vec3f& d) const;
+
+	// Summary:
+	//	Returns any point inside the core shape. Used as initial search direction.
+	Vec3f GetCenter() const;
+};
+
+// Summary:
+//	Returns true if GJK can handle the shape type: sphere, cylinder, capsule, box, triangle, circle and convex hull.
+//	Rays, planes and meshes are not (bounded) convex shapes and need their own tests.
+bool _IsConvexShape(EShapeType type);
+
+// Summary:
+//	Initializes the support mapping of a convex shape, see _IsConvexShape().
+// Returns:
+//	false if the shape is not convex
+bool _GetConvexSupport(const shape* pshape, convex_support* psupport);
+
+// Summary:
+//	Initializes the support mapping of the convex hull of the given points,
+//	e.g. the hull vertices returned by QuickHull2(). The points are not copied.
+void _GetConvexSupport(const Vec3f* points, unsigned int num_points, convex_support* psupport);
+
+// Summary:
+//	Computes the closest points of two convex shapes (including their margins) with GJK.
+// Returns:
+//	The distance between both shapes or 0 if they intersect. pclosest1/2 are only written if the shapes are disjoint.
+float _GJKDistance(const convex_support* pshape1, const convex_support* pshape2, Vec3f* pclosest1 = 0, Vec3f* pclosest2 = 0);
+
+// Summary:
+//	Boolean GJK test. Faster than _GJKDistance() as it stops as soon as a separating axis
+//	or a simplex enclosing the origin is found.
+bool _GJKIntersects(const convex_support* pshape1, const convex_support* pshape2);
+
+// Summary:
+//	Intersection test of two convex shapes. Finds the contact with GJK if the shapes only intersect
+//	within their margins and with EPA (expanding polytope algorithm) if the cores intersect.
+//	The intersection is the same as with the specialized tests: n points from shape1 to shape2,
+//	p lies on the surface of shape1 and dist is the negative penetration depth along n.
+// Returns:
+//	true if the shapes intersect
+bool _GJKIntersection(const convex_support* pshape1, const convex_support* pshape2, SIntersection* pinters);
+
+// Summary:
+//	Same as above for geo shapes. Has the signature of the _intersectionTestTable entries and is used
+//	for all pairs of convex shapes without specialized test.
+bool _ConvexConvex(const shape* pshape1, const shape* pshape2, SIntersection* pinters);
+
+GEO_NMSPACE_END
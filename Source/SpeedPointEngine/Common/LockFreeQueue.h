@@ -0,0 +1,291 @@
+//////////////////////////////////////////////////////////////////////////////////////////////////
+//
+//	SpeedPoint Game Engine
+//	Copyright (c) 2011-2018 Pascal Rosenkranz, All rights reserved.
+//
+//////////////////////////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <atomic>
+#include <utility>
+#include <cstddef>
+
+#define LOCKFREE_QUEUE_CACHE_LINE 64
+
+// Rounds up to the next power of two, at least 2
+inline size_t LockFreeQueueCapacity(size_t capacity)
+{
+	size_t sz = 2;
+	while (sz < capacity)
+		sz <<= 1;
+
+	return sz;
+}
+
+// Summary:
+//	Bounded lock-free ring buffer for exactly one producer thread and one consumer thread.
+// Description:
+//	The capacity is rounded up to a power of two and never changes, so pushing never allocates.
+//	Push fails if the queue is full, pop fails if it is empty. Head and tail are padded to
+//	separate cache lines and each side caches the last seen index of the other side, so the shared
+//	indices are only read if the cached value says full or empty.
+//	T must be default constructible and move assignable.
+template<typename T>
+class SPSCQueue
+{
+private:
+	T* m_pItems;
+	size_t m_Mask;
+	char m_Pad0[LOCKFREE_QUEUE_CACHE_LINE - sizeof(T*) - sizeof(size_t)];
+
+	// Consumer side
+	std::atomic<size_t> m_Head;
+	size_t m_CachedTail;
+	char m_Pad1[LOCKFREE_QUEUE_CACHE_LINE - sizeof(std::atomic<size_t>) - sizeof(size_t)];
+
+	// Producer side
+	std::atomic<size_t> m_Tail;
+	size_t m_CachedHead;
+	char m_Pad2[LOCKFREE_QUEUE_CACHE_LINE - sizeof(std::atomic<size_t>) - sizeof(size_t)];
+
+	SPSCQueue(const SPSCQueue&);
+	SPSCQueue& operator =(const SPSCQueue&);
+
+public:
+	SPSCQueue(size_t capacity = 1024)
+		: m_Head(0), m_CachedTail(0), m_Tail(0), m_CachedHead(0)
+	{
+		capacity = LockFreeQueueCapacity(capacity);
+		m_pItems = new T[capacity];
+		m_Mask = capacity - 1;
+	}
+
+	~SPSCQueue()
+	{
+		delete[] m_pItems;
+	}
+
+	size_t GetCapacity() const { return m_Mask + 1; }
+
+	// Only exact if called while neither side is active
+	size_t GetSize() const { return m_Tail.load(std::memory_order_acquire) - m_Head.load(std::memory_order_acquire); }
+	bool IsEmpty() const { return GetSize() == 0; }
+
+	// Producer only
+	template<typename U>
+	bool Push(U&& item)
+	{
+		size_t tail = m_Tail.load(std::memory_order_relaxed);
+		if (tail - m_CachedHead > m_Mask)
+		{
+			m_CachedHead = m_Head.load(std::memory_order_acquire);
+			if (tail - m_CachedHead > m_Mask)
+				return false;
+		}
+
+		m_pItems[tail & m_Mask] = std::forward<U>(item);
+		m_Tail.store(tail + 1, std::memory_order_release);
+		return true;
+	}
+
+	// Producer only. Pushes as many items as fit and publishes them at once.
+	// Returns the number of pushed items.
+	size_t PushBatch(const T* pItems, size_t n)
+	{
+		size_t tail = m_Tail.load(std::memory_order_relaxed);
+		size_t space = GetCapacity() - (tail - m_CachedHead);
+		if (space < n)
+		{
+			m_CachedHead = m_Head.load(std::memory_order_acquire);
+			space = GetCapacity() - (tail - m_CachedHead);
+		}
+
+		if (n > space)
+			n = space;
+
+		for (size_t i = 0; i < n; ++i)
+			m_pItems[(tail + i) & m_Mask] = pItems[i];
+
+		m_Tail.store(tail + n, std::memory_order_release);
+		return n;
+	}
+
+	// Consumer only
+	bool Pop(T& item)
+	{
+		size_t head = m_Head.load(std::memory_order_relaxed);
+		if (head == m_CachedTail)
+		{
+			m_CachedTail = m_Tail.load(std::memory_order_acquire);
+			if (head == m_CachedTail)
+				return false;
+		}
+
+		item = std::move(m_pItems[head & m_Mask]);
+		m_Head.store(head + 1, std::memory_order_release);
+		return true;
+	}
+
+	// Consumer only. Pops up to maxItems items and releases their slots at once.
+	// Returns the number of popped items.
+	size_t PopBatch(T* pItems, size_t maxItems)
+	{
+		size_t head = m_Head.load(std::memory_order_relaxed);
+		size_t avail = m_CachedTail - head;
+		if (avail < maxItems)
+		{
+			m_CachedTail = m_Tail.load(std::memory_order_acquire);
+			avail = m_CachedTail - head;
+		}
+
+		size_t n = (maxItems < avail ? maxItems : avail);
+		for (size_t i = 0; i < n; ++i)
+			pItems[i] = std::move(m_pItems[(head + i) & m_Mask]);
+
+		m_Head.store(head + n, std::memory_order_release);
+		return n;
+	}
+};
+
+
+// Summary:
+//	Bounded lock-free ring buffer for any number of producer and consumer threads.
+// Description:
+//	Each cell carries a sequence number that tells whether it is ready to be written or
+//	read in the current lap (D. Vyukov's bounded MPMC queue). Producers and consumers only
+//	contend on their own index with a single CAS per item. The capacity is rounded up to a
+//	power of two and never changes.
+//	Batch operations claim items one by one, so a batch may interleave with other threads.
+//	T must be default constructible and move assignable.
+template<typename T>
+class MPMCQueue
+{
+private:
+	struct Cell
+	{
+		std::atomic<size_t> sequence;
+		T item;
+	};
+
+	Cell* m_pCells;
+	size_t m_Mask;
+	char m_Pad0[LOCKFREE_QUEUE_CACHE_LINE - sizeof(Cell*) - sizeof(size_t)];
+
+	std::atomic<size_t> m_EnqueuePos;
+	char m_Pad1[LOCKFREE_QUEUE_CACHE_LINE - sizeof(std::atomic<size_t>)];
+
+	std::atomic<size_t> m_DequeuePos;
+	char m_Pad2[LOCKFREE_QUEUE_CACHE_LINE - sizeof(std::atomic<size_t>)];
+
+	MPMCQueue(const MPMCQueue&);
+	MPMCQueue& operator =(const MPMCQueue&);
+
+public:
+	MPMCQueue(size_t capacity = 1024)
+		: m_EnqueuePos(0), m_DequeuePos(0)
+	{
+		capacity = LockFreeQueueCapacity(capacity);
+		m_pCells = new Cell[capacity];
+		m_Mask = capacity - 1;
+
+		for (size_t i = 0; i < capacity; ++i)
+			m_pCells[i].sequence.store(i, std::memory_order_relaxed);
+	}
+
+	~MPMCQueue()
+	{
+		delete[] m_pCells;
+	}
+
+	size_t GetCapacity() const { return m_Mask + 1; }
+
+	// Approximation, as other threads may push or pop at the same time
+	size_t GetSize() const
+	{
+		size_t enqueuePos = m_EnqueuePos.load(std::memory_order_acquire);
+		size_t dequeuePos = m_DequeuePos.load(std::memory_order_acquire);
+		return (enqueuePos > dequeuePos ? enqueuePos - dequeuePos : 0);
+	}
+
+	bool IsEmpty() const { return GetSize() == 0; }
+
+	template<typename U>
+	bool Push(U&& item)
+	{
+		Cell* pCell;
+		size_t pos = m_EnqueuePos.load(std::memory_order_relaxed);
+		while (true)
+		{
+			pCell = &m_pCells[pos & m_Mask];
+			size_t seq = pCell->sequence.load(std::memory_order_acquire);
+			ptrdiff_t dif = (ptrdiff_t)seq - (ptrdiff_t)pos;
+			if (dif == 0)
+			{
+				if (m_EnqueuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+					break;
+			}
+			else if (dif < 0)
+			{
+				return false; // full
+			}
+			else
+			{
+				pos = m_EnqueuePos.load(std::memory_order_relaxed);
+			}
+		}
+
+		pCell->item = std::forward<U>(item);
+		pCell->sequence.store(pos + 1, std::memory_order_release);
+		return true;
+	}
+
+	bool Pop(T& item)
+	{
+		Cell* pCell;
+		size_t pos = m_DequeuePos.load(std::memory_order_relaxed);
+		while (true)
+		{
+			pCell = &m_pCells[pos & m_Mask];
+			size_t seq = pCell->sequence.load(std::memory_order_acquire);
+			ptrdiff_t dif = (ptrdiff_t)seq - (ptrdiff_t)(pos + 1);
+			if (dif == 0)
+			{
+				if (m_DequeuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+					break;
+			}
+			else if (dif < 0)
+			{
+				return false; // empty
+			}
+			else
+			{
+				pos = m_DequeuePos.load(std::memory_order_relaxed);
+			}
+		}
+
+		item = std::move(pCell->item);
+		pCell->sequence.store(pos + m_Mask + 1, std::memory_order_release);
+		return true;
+	}
+
+	// Returns the number of pushed items. Stops at the first item that does not fit.
+	size_t PushBatch(const T* pItems, size_t n)
+	{
+		size_t i = 0;
+		while (i < n && Push(pItems[i]))
+			++i;
+
+		return i;
+	}
+
+	// Returns the number of popped items
+	size_t PopBatch(T* pItems, size_t maxItems)
+	{
+		size_t i = 0;
+		while (i < maxItems && Pop(pItems[i]))
+			++i;
+
+		return i;
+	}
+};
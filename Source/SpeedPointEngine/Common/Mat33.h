@@ -1,10 +1,15 @@
 #pragma once
 #include "SAPI.h"
+#include "MathTypes.h"
 #include "Vector3.h"
 
 namespace SpeedPoint
 {
-	struct S_API Mat33
+	typedef struct Mat<3, 3, float> Mat33;
+
+	// The operators are defined for all sizes in MathTypes.h
+	template<>
+	struct S_API Mat<3, 3, float>
 	{
 		union
 		{
@@ -20,29 +25,29 @@ namespace SpeedPoint
 		static const Mat33 Identity;
 
 		// Identity
-		Mat33() :
+		constexpr Mat() :
 			_11(1.0f), _12(0), _13(0),
 			_21(0), _22(1.0f), _23(0),
 			_31(0), _32(0), _33(1.0f) {}
 
-		Mat33(const Mat33& m) :
+		constexpr Mat(const Mat33& m) :
 			_11(m._11), _12(m._12), _13(m._13),
 			_21(m._21), _22(m._22), _23(m._23),
 			_31(m._31), _32(m._32), _33(m._33) {}
 
-		Mat33(float f) :
+		constexpr Mat(float f) :
 			_11(f), _12(f), _13(f),
 			_21(f), _22(f), _23(f),
 			_31(f), _32(f), _33(f) {}
 
-		Mat33(float m11, float m12, float m13,
+		constexpr Mat(float m11, float m12, float m13,
 			float m21, float m22, float m23,
 			float m31, float m32, float m33)
 			: _11(m11), _12(m12), _13(m13),
 			_21(m21), _22(m22), _23(m23),
 			_31(m31), _32(m32), _33(m33) {}
 
-		inline static Mat33 FromColumns(const Vec3f& c1, const Vec3f& c2, const Vec3f& c3)
+		constexpr static Mat33 FromColumns(const Vec3f& c1, const Vec3f& c2, const Vec3f& c3)
 		{
 			return Mat33(
 				c1.x, c2.x, c3.x,
@@ -51,7 +56,7 @@ namespace SpeedPoint
 			);
 		}
 
-		inline static Mat33 FromRows(const Vec3f& c1, const Vec3f& c2, const Vec3f& c3)
+		constexpr static Mat33 FromRows(const Vec3f& c1, const Vec3f& c2, const Vec3f& c3)
 		{
 			return Mat33(
 				c1.x, c1.y, c1.z,
@@ -60,76 +65,12 @@ namespace SpeedPoint
 			);
 		}
 
-		Mat33 operator + (const Mat33& m) const
-		{
-			return Mat33(
-				_11 + m._11, _12 + m._12, _13 + m._13,
-				_21 + m._21, _22 + m._22, _23 + m._23,
-				_31 + m._31, _32 + m._32, _33 + m._33
-			);
-		}
-
-		Mat33& operator += (const Mat33& m)
+		template<unsigned int I, unsigned int J> constexpr const float& Get() const
 		{
-			_11 += m._11; _12 += m._12; _13 += m._13;
-			_21 += m._21; _22 += m._22; _23 += m._23;
-			_31 += m._31; _32 += m._32; _33 += m._33;
-			return *this;
+			return MathCore::SSelect<I * 3 + J>::Get(_11, _12, _13, _21, _22, _23, _31, _32, _33);
 		}
 
-		Mat33 operator - (const Mat33& m) const
-		{
-			return Mat33(
-				_11 - m._11, _12 - m._12, _13 - m._13,
-				_21 - m._21, _22 - m._22, _23 - m._23,
-				_31 - m._31, _32 - m._32, _33 - m._33
-			);
-		}
-
-		Mat33& operator -= (const Mat33& m)
-		{
-			_11 -= m._11; _12 -= m._12; _13 -= m._13;
-			_21 -= m._21; _22 -= m._22; _23 -= m._23;
-			_31 -= m._31; _32 -= m._32; _33 -= m._33;
-			return *this;
-		}
-
-		Mat33 operator * (float f) const
-		{
-			return Mat33(
-				_11 * f, _12 * f, _13 * f,
-				_21 * f, _22 * f, _23 * f,
-				_31 * f, _32 * f, _33 * f
-			);
-		}
-
-		Vec3f operator * (const Vec3f& v) const
-		{
-			return Vec3f(
-				_11 * v.x + _12 * v.y + _13 * v.z,
-				_21 * v.x + _22 * v.y + _23 * v.z,
-				_31 * v.x + _32 * v.y + _33 * v.z
-			);
-		}
-
-		Mat33 operator * (const Mat33& m) const
-		{
-			Mat33 out;
-			out._11 = _11 * m._11 + _12 * m._21 + _13 * m._31;
-			out._12 = _11 * m._12 + _12 * m._22 + _13 * m._32;
-			out._13 = _11 * m._13 + _12 * m._23 + _13 * m._33;
-
-			out._21 = _21 * m._11 + _22 * m._21 + _23 * m._31;
-			out._22 = _21 * m._12 + _22 * m._22 + _23 * m._32;
-			out._23 = _21 * m._13 + _22 * m._23 + _23 * m._33;
-
-			out._31 = _31 * m._11 + _32 * m._21 + _33 * m._31;
-			out._32 = _31 * m._12 + _32 * m._22 + _33 * m._32;
-			out._33 = _31 * m._13 + _32 * m._23 + _33 * m._33;
-			return out;
-		}
-
-		Mat33 Transposed() const
+		constexpr Mat33 Transposed() const
 		{
 			return Mat33(
 				_11, _21, _31,
@@ -165,24 +106,49 @@ namespace SpeedPoint
 			return C;
 		}
 
-		float Determinant() const
+		constexpr float Determinant() const
 		{
 			return _11 * _22 * _33 + _12 * _23 * _31 + _13 * _21 * _32 - _13 * _22 * _31 - _12 * _21 * _33 - _11 * _23 * _32;
 		}
 
-		float Trace() const
+		constexpr float Trace() const
 		{
 			return _11 + _22 + _33;
 		}
 	};
 
-	inline Mat33 operator *(float f, const Mat33& m)
+	// Returns R * S * R^T for a symmetric S, e.g. to rotate an inertia tensor into world space.
+	// Only the upper triangle of the second product is calculated and mirrored (45 instead of 54 multiplications).
+	inline Mat33 Mat33RotateSymmetric(const Mat33& R, const Mat33& S)
 	{
-		return m * f;
+		// A = R * S
+		float a11 = R._11 * S._11 + R._12 * S._12 + R._13 * S._13;
+		float a12 = R._11 * S._12 + R._12 * S._22 + R._13 * S._23;
+		float a13 = R._11 * S._13 + R._12 * S._23 + R._13 * S._33;
+		float a21 = R._21 * S._11 + R._22 * S._12 + R._23 * S._13;
+		float a22 = R._21 * S._12 + R._22 * S._22 + R._23 * S._23;
+		float a23 = R._21 * S._13 + R._22 * S._23 + R._23 * S._33;
+		float a31 = R._31 * S._11 + R._32 * S._12 + R._33 * S._13;
+		float a32 = R._31 * S._12 + R._32 * S._22 + R._33 * S._23;
+		float a33 = R._31 * S._13 + R._32 * S._23 + R._33 * S._33;
+
+		// A * R^T, (i,j) = dot(row i of A, row j of R)
+		float m11 = a11 * R._11 + a12 * R._12 + a13 * R._13;
+		float m12 = a11 * R._21 + a12 * R._22 + a13 * R._23;
+		float m13 = a11 * R._31 + a12 * R._32 + a13 * R._33;
+		float m22 = a21 * R._21 + a22 * R._22 + a23 * R._23;
+		float m23 = a21 * R._31 + a22 * R._32 + a23 * R._33;
+		float m33 = a31 * R._31 + a32 * R._32 + a33 * R._33;
+
+		return Mat33(
+			m11, m12, m13,
+			m12, m22, m23,
+			m13, m23, m33
+		);
 	}
 
 	// a * b^T
-	static inline Mat33 Vec3MulT(const Vec3f& a, const Vec3f& b)
+	static constexpr Mat33 Vec3MulT(const Vec3f& a, const Vec3f& b)
 	{
 		return Mat33(
 			a.x * b.x, a.y * b.x, a.z * b.x,
@@ -7,16 +7,21 @@
 #pragma once
 #include "SAPI.h"
 #include "SPrerequisites.h"
+#include "MathTypes.h"
 #include "Mat33.h"
 #include "Vector3.h"
 #include "Vector4.h"
 
-#include <xmmintrin.h>
+#include "SIMD.h"
 
 SP_NMSPACE_BEG
 
+typedef struct Mat<4, 4, float> Mat44;
+
 // SpeedPoint 4x4 Matrix
-struct S_API Mat44
+// The generic operators are in MathTypes.h, Mat44 * Mat44 and Mat44 * Vec4f are overloaded with SIMD versions below
+template<>
+struct S_API Mat<4, 4, float>
 {
 	union
 	{
@@ -32,33 +37,31 @@ struct S_API Mat44
 	};
 
 	// Default Matrix constructor = Identity Matrix
-	Mat44() :
+	constexpr Mat() :
 		_11( 1 ), _12( 0 ), _13( 0 ), _14( 0 ),
 		_21( 0 ), _22( 1 ), _23( 0 ), _24( 0 ),
 		_31( 0 ), _32( 0 ), _33( 1 ), _34( 0 ),
 		_41( 0 ), _42( 0 ), _43( 0 ), _44( 1 ) {};
 
-	Mat44(const Mat44& o) :
+	constexpr Mat(const Mat44& o) :
 		_11(o._11), _12(o._12), _13(o._13), _14(o._14),
 		_21(o._21), _22(o._22), _23(o._23), _24(o._24),
 		_31(o._31), _32(o._32), _33(o._33), _34(o._34),
 		_41(o._41), _42(o._42), _43(o._43), _44(o._44) {};
 
-	Mat44(const Mat33& o) :
+	constexpr Mat(const Mat33& o) :
 		_11(o._11), _12(o._12), _13(o._13), _14(0),
 		_21(o._21), _22(o._22), _23(o._23), _24(0),
 		_31(o._31), _32(o._32), _33(o._33), _34(0),
 		_41(0), _42(0), _43(0), _44(1.0f) {}
 
-	Mat44(const SVector4& v1, const SVector4& v2, const SVector4& v3, const SVector4& v4)
-	{
-		m[0][0] = v1.x; m[0][1] = v1.y; m[0][2] = v1.z; m[0][3] = v1.w;
-		m[1][0] = v2.x; m[1][1] = v2.y; m[1][2] = v2.z; m[1][3] = v2.w;
-		m[2][0] = v3.x; m[2][1] = v3.y; m[2][2] = v3.z; m[2][3] = v3.w;
-		m[3][0] = v4.x; m[3][1] = v4.y; m[3][2] = v4.z; m[3][3] = v4.w;
-	}
+	constexpr Mat(const SVector4& v1, const SVector4& v2, const SVector4& v3, const SVector4& v4) :
+		_11(v1.x), _12(v1.y), _13(v1.z), _14(v1.w),
+		_21(v2.x), _22(v2.y), _23(v2.z), _24(v2.w),
+		_31(v3.x), _32(v3.y), _33(v3.z), _34(v3.w),
+		_41(v4.x), _42(v4.y), _43(v4.z), _44(v4.w) {}
 
-	Mat44(float m11, float m12, float m13, float m14,
+	constexpr Mat(float m11, float m12, float m13, float m14,
 		float m21, float m22, float m23, float m24,
 		float m31, float m32, float m33, float m34,
 		float m41, float m42, float m43, float m44)
@@ -79,14 +82,35 @@ struct S_API Mat44
 		return *this;
 	}
 
+	template<unsigned int I, unsigned int J> constexpr const float& Get() const
+	{
+		return MathCore::SSelect<I * 4 + J>::Get(_11, _12, _13, _14, _21, _22, _23, _24, _31, _32, _33, _34, _41, _42, _43, _44);
+	}
+
 	SVector4 operator * (const SVector4& v) const
 	{
-		return SVector4(
-			m[0][0] * v.x + m[0][1] * v.y + m[0][2] * v.z + m[0][3] * v.w,
-			m[1][0] * v.x + m[1][1] * v.y + m[1][2] * v.z + m[1][3] * v.w,
-			m[2][0] * v.x + m[2][1] * v.y + m[2][2] * v.z + m[2][3] * v.w,
-			m[3][0] * v.x + m[3][1] * v.y + m[3][2] * v.z + m[3][3] * v.w
-			);
+#ifdef SP_MATH_SSE
+		// Sum up the columns, weighted by the components of v
+		__m128 c0 = _mm_loadu_ps(m[0]), c1 = _mm_loadu_ps(m[1]), c2 = _mm_loadu_ps(m[2]), c3 = _mm_loadu_ps(m[3]);
+		_MM_TRANSPOSE4_PS(c0, c1, c2, c3);
+
+		__m128 r = _mm_mul_ps(c0, _mm_set1_ps(v.x));
+		r = _mm_add_ps(r, _mm_mul_ps(c1, _mm_set1_ps(v.y)));
+		r = _mm_add_ps(r, _mm_mul_ps(c2, _mm_set1_ps(v.z)));
+		r = _mm_add_ps(r, _mm_mul_ps(c3, _mm_set1_ps(v.w)));
+
+		SVector4 out;
+		_mm_storeu_ps(&out.x, r);
+		return out;
+#else
+		return MultiplyScalar(v);
+#endif
+	}
+
+	// Scalar reference implementation of operator *(const SVector4&)
+	constexpr SVector4 MultiplyScalar(const SVector4& v) const
+	{
+		return MatMul(*this, v);
 	}
 
 	inline void GetColumnVectors(Vec3f vectors[3]) const
@@ -107,7 +131,7 @@ struct S_API Mat44
 
 	static const Mat44 Identity;
 
-	static Mat44 MakeTranslationMatrix(const SVector3& translation)
+	constexpr static Mat44 MakeTranslationMatrix(const SVector3& translation)
 	{
 		return Mat44(
 			1, 0, 0, translation.x,
@@ -117,7 +141,7 @@ struct S_API Mat44
 			);
 	}
 
-	static Mat44 MakeScaleMatrix(const SVector3& scale)
+	constexpr static Mat44 MakeScaleMatrix(const SVector3& scale)
 	{
 		return Mat44(
 			scale.x, 0, 0, 0,
@@ -149,33 +173,67 @@ struct S_API Mat44
 	}
 };
 
+// Scalar reference implementation of operator *(const Mat44&, const Mat44&)
+static inline Mat44 SMatrixMultiplyScalar(const Mat44& a, const Mat44& b)
+{
+	return MatMul(a, b);
+}
+
+// Each row of the result is the sum of the rows of b, weighted by the corresponding row of a.
+// The summation order is the same as in the scalar implementation, so the results are bit-exact.
 static inline Mat44 operator * (const Mat44& a, const Mat44& b)
 {
+#if defined(SP_MATH_AVX)
 	Mat44 out;
-	out._11 = a._11*b._11 + a._12*b._21 + a._13*b._31 + a._14*b._41;
-	out._12 = a._11*b._12 + a._12*b._22 + a._13*b._32 + a._14*b._42;
-	out._13 = a._11*b._13 + a._12*b._23 + a._13*b._33 + a._14*b._43;
-	out._14 = a._11*b._14 + a._12*b._24 + a._13*b._34 + a._14*b._44;
-
-	out._21 = a._21*b._11 + a._22*b._21 + a._23*b._31 + a._24*b._41;
-	out._22 = a._21*b._12 + a._22*b._22 + a._23*b._32 + a._24*b._42;
-	out._23 = a._21*b._13 + a._22*b._23 + a._23*b._33 + a._24*b._43;
-	out._24 = a._21*b._14 + a._22*b._24 + a._23*b._34 + a._24*b._44;
-
-	out._31 = a._31*b._11 + a._32*b._21 + a._33*b._31 + a._34*b._41;
-	out._32 = a._31*b._12 + a._32*b._22 + a._33*b._32 + a._34*b._42;
-	out._33 = a._31*b._13 + a._32*b._23 + a._33*b._33 + a._34*b._43;
-	out._34 = a._31*b._14 + a._32*b._24 + a._33*b._34 + a._34*b._44;
-
-	out._41 = a._41*b._11 + a._42*b._21 + a._43*b._31 + a._44*b._41;
-	out._42 = a._41*b._12 + a._42*b._22 + a._43*b._32 + a._44*b._42;
-	out._43 = a._41*b._13 + a._42*b._23 + a._43*b._33 + a._44*b._43;
-	out._44 = a._41*b._14 + a._42*b._24 + a._43*b._34 + a._44*b._44;
-	
+	__m256 b0 = _mm256_broadcast_ps((const __m128*)b.m[0]);
+	__m256 b1 = _mm256_broadcast_ps((const __m128*)b.m[1]);
+	__m256 b2 = _mm256_broadcast_ps((const __m128*)b.m[2]);
+	__m256 b3 = _mm256_broadcast_ps((const __m128*)b.m[3]);
+
+	// Two rows of a per register
+	for (int i = 0; i < 4; i += 2)
+	{
+		__m256 a2 = _mm256_loadu_ps(a.m[i]);
+		__m256 r = _mm256_mul_ps(_mm256_shuffle_ps(a2, a2, 0x00), b0);
+		r = _mm256_add_ps(r, _mm256_mul_ps(_mm256_shuffle_ps(a2, a2, 0x55), b1));
+		r = _mm256_add_ps(r, _mm256_mul_ps(_mm256_shuffle_ps(a2, a2, 0xAA), b2));
+		r = _mm256_add_ps(r, _mm256_mul_ps(_mm256_shuffle_ps(a2, a2, 0xFF), b3));
+		_mm256_storeu_ps(out.m[i], r);
+	}
+
 	return out;
+#elif defined(SP_MATH_SSE)
+	Mat44 out;
+	__m128 b0 = _mm_loadu_ps(b.m[0]), b1 = _mm_loadu_ps(b.m[1]), b2 = _mm_loadu_ps(b.m[2]), b3 = _mm_loadu_ps(b.m[3]);
+	for (int i = 0; i < 4; ++i)
+	{
+		__m128 r = _mm_mul_ps(_mm_set1_ps(a.m[i][0]), b0);
+		r = _mm_add_ps(r, _mm_mul_ps(_mm_set1_ps(a.m[i][1]), b1));
+		r = _mm_add_ps(r, _mm_mul_ps(_mm_set1_ps(a.m[i][2]), b2));
+		r = _mm_add_ps(r, _mm_mul_ps(_mm_set1_ps(a.m[i][3]), b3));
+		_mm_storeu_ps(out.m[i], r);
+	}
+
+	return out;
+#else
+	return SMatrixMultiplyScalar(a, b);
+#endif
 }
 
 
+// Summary:
+//	16-byte aligned Mat44, e.g. for arrays that are loaded with aligned SIMD loads.
+//	Same size and layout, the operators of Mat44 apply and return Mat44.
+struct alignas(16) Mat44A : Mat44
+{
+	using Mat44::Mat44;
+	constexpr Mat44A() {}
+	constexpr Mat44A(const Mat44& m) : Mat44(m) {}
+};
+
+static_assert(sizeof(Mat44A) == sizeof(Mat44), "Mat44A must not add padding");
+
+
 static inline void SMatrixIdentity(Mat44& pMtx)
 {	
 	pMtx._11 = 1; pMtx._12 = 0; pMtx._13 = 0; pMtx._14 = 0;
@@ -197,6 +255,14 @@ static void SMatrixTranspose( Mat44* pMtx )
 {
 	if (pMtx != 0)
 	{
+#ifdef SP_MATH_SSE
+		__m128 r0 = _mm_loadu_ps(pMtx->m[0]), r1 = _mm_loadu_ps(pMtx->m[1]), r2 = _mm_loadu_ps(pMtx->m[2]), r3 = _mm_loadu_ps(pMtx->m[3]);
+		_MM_TRANSPOSE4_PS(r0, r1, r2, r3);
+		_mm_storeu_ps(pMtx->m[0], r0);
+		_mm_storeu_ps(pMtx->m[1], r1);
+		_mm_storeu_ps(pMtx->m[2], r2);
+		_mm_storeu_ps(pMtx->m[3], r3);
+#else
 		float t;
 		__Mat44Transpose_SwapFloat(pMtx->_21, pMtx->_12);
 		__Mat44Transpose_SwapFloat(pMtx->_31, pMtx->_13);
@@ -210,6 +276,7 @@ static void SMatrixTranspose( Mat44* pMtx )
 		SSwapFloat(pMtx->_42, pMtx->_24);
 		SSwapFloat(pMtx->_43, pMtx->_34);
 		SSwapFloat(pMtx->_32, pMtx->_23);*/
+#endif
 	}
 }
 
@@ -220,8 +287,9 @@ static Mat44 SMatrixTranspose(const Mat44& mtx)
 	return res;
 }
 
+// Scalar reference implementation of SMatrixInvert()
 // Source: CryCommon Cry_Matrix.h
-static Mat44 SMatrixInvert(const Mat44& m) {
+static Mat44 SMatrixInvertScalar(const Mat44& m) {
 	float	tmp[12];
 	Mat44 res;
 
@@ -303,6 +371,165 @@ static Mat44 SMatrixInvert(const Mat44& m) {
 	return res;
 }
 
+// Inverse by Cramer's rule. Does not check for a singular matrix.
+static Mat44 SMatrixInvert(const Mat44& m)
+{
+#ifdef SP_MATH_SSE
+	// Source: Intel AP-928, "Streaming SIMD Extensions - Inverse of 4x4 Matrix".
+	// Works on the transposed matrix, which yields the transposed inverse, i.e. the rows
+	// of the inverse are stored from minor0..3 directly.
+	const float* src = &m.m[0][0];
+	__m128 minor0, minor1, minor2, minor3;
+	__m128 row0, row1, row2, row3;
+	__m128 det, tmp1;
+
+	tmp1 = _mm_loadh_pi(_mm_loadl_pi(_mm_setzero_ps(), (const __m64*)(src)), (const __m64*)(src + 4));
+	row1 = _mm_loadh_pi(_mm_loadl_pi(_mm_setzero_ps(), (const __m64*)(src + 8)), (const __m64*)(src + 12));
+	row0 = _mm_shuffle_ps(tmp1, row1, 0x88);
+	row1 = _mm_shuffle_ps(row1, tmp1, 0xDD);
+	tmp1 = _mm_loadh_pi(_mm_loadl_pi(_mm_setzero_ps(), (const __m64*)(src + 2)), (const __m64*)(src + 6));
+	row3 = _mm_loadh_pi(_mm_loadl_pi(_mm_setzero_ps(), (const __m64*)(src + 10)), (const __m64*)(src + 14));
+	row2 = _mm_shuffle_ps(tmp1, row3, 0x88);
+	row3 = _mm_shuffle_ps(row3, tmp1, 0xDD);
+
+	tmp1 = _mm_mul_ps(row2, row3);
+	tmp1 = _mm_shuffle_ps(tmp1, tmp1, 0xB1);
+	minor0 = _mm_mul_ps(row1, tmp1);
+	minor1 = _mm_mul_ps(row0, tmp1);
+	tmp1 = _mm_shuffle_ps(tmp1, tmp1, 0x4E);
+	minor0 = _mm_sub_ps(_mm_mul_ps(row1, tmp1), minor0);
+	minor1 = _mm_sub_ps(_mm_mul_ps(row0, tmp1), minor1);
+	minor1 = _mm_shuffle_ps(minor1, minor1, 0x4E);
+
+	tmp1 = _mm_mul_ps(row1, row2);
+	tmp1 = _mm_shuffle_ps(tmp1, tmp1, 0xB1);
+	minor0 = _mm_add_ps(_mm_mul_ps(row3, tmp1), minor0);
+	minor3 = _mm_mul_ps(row0, tmp1);
+	tmp1 = _mm_shuffle_ps(tmp1, tmp1, 0x4E);
+	minor0 = _mm_sub_ps(minor0, _mm_mul_ps(row3, tmp1));
+	minor3 = _mm_sub_ps(_mm_mul_ps(row0, tmp1), minor3);
+	minor3 = _mm_shuffle_ps(minor3, minor3, 0x4E);
+
+	tmp1 = _mm_mul_ps(_mm_shuffle_ps(row1, row1, 0x4E), row3);
+	tmp1 = _mm_shuffle_ps(tmp1, tmp1, 0xB1);
+	row2 = _mm_shuffle_ps(row2, row2, 0x4E);
+	minor0 = _mm_add_ps(_mm_mul_ps(row2, tmp1), minor0);
+	minor2 = _mm_mul_ps(row0, tmp1);
+	tmp1 = _mm_shuffle_ps(tmp1, tmp1, 0x4E);
+	minor0 = _mm_sub_ps(minor0, _mm_mul_ps(row2, tmp1));
+	minor2 = _mm_sub_ps(_mm_mul_ps(row0, tmp1), minor2);
+	minor2 = _mm_shuffle_ps(minor2, minor2, 0x4E);
+
+	tmp1 = _mm_mul_ps(row0, row1);
+	tmp1 = _mm_shuffle_ps(tmp1, tmp1, 0xB1);
+	minor2 = _mm_add_ps(_mm_mul_ps(row3, tmp1), minor2);
+	minor3 = _mm_sub_ps(_mm_mul_ps(row2, tmp1), minor3);
+	tmp1 = _mm_shuffle_ps(tmp1, tmp1, 0x4E);
+	minor2 = _mm_sub_ps(_mm_mul_ps(row3, tmp1), minor2);
+	minor3 = _mm_sub_ps(minor3, _mm_mul_ps(row2, tmp1));
+
+	tmp1 = _mm_mul_ps(row0, row3);
+	tmp1 = _mm_shuffle_ps(tmp1, tmp1, 0xB1);
+	minor1 = _mm_sub_ps(minor1, _mm_mul_ps(row2, tmp1));
+	minor2 = _mm_add_ps(_mm_mul_ps(row1, tmp1), minor2);
+	tmp1 = _mm_shuffle_ps(tmp1, tmp1, 0x4E);
+	minor1 = _mm_add_ps(_mm_mul_ps(row2, tmp1), minor1);
+	minor2 = _mm_sub_ps(minor2, _mm_mul_ps(row1, tmp1));
+
+	tmp1 = _mm_mul_ps(row0, row2);
+	tmp1 = _mm_shuffle_ps(tmp1, tmp1, 0xB1);
+	minor1 = _mm_add_ps(_mm_mul_ps(row3, tmp1), minor1);
+	minor3 = _mm_sub_ps(minor3, _mm_mul_ps(row1, tmp1));
+	tmp1 = _mm_shuffle_ps(tmp1, tmp1, 0x4E);
+	minor1 = _mm_sub_ps(minor1, _mm_mul_ps(row3, tmp1));
+	minor3 = _mm_add_ps(_mm_mul_ps(row1, tmp1), minor3);
+
+	// Exact division instead of the reciprocal estimate of the original, to stay close to the scalar path
+	det = _mm_mul_ps(row0, minor0);
+	det = _mm_add_ps(_mm_shuffle_ps(det, det, 0x4E), det);
+	det = _mm_add_ss(_mm_shuffle_ps(det, det, 0xB1), det);
+	det = _mm_div_ss(_mm_set_ss(1.0f), det);
+	det = _mm_shuffle_ps(det, det, 0x00);
+
+	Mat44 res;
+	_mm_storeu_ps(res.m[0], _mm_mul_ps(det, minor0));
+	_mm_storeu_ps(res.m[1], _mm_mul_ps(det, minor1));
+	_mm_storeu_ps(res.m[2], _mm_mul_ps(det, minor2));
+	_mm_storeu_ps(res.m[3], _mm_mul_ps(det, minor3));
+	return res;
+#else
+	return SMatrixInvertScalar(m);
+#endif
+}
+
+// Scalar reference implementation of SMatrixInvertAffine()
+static Mat44 SMatrixInvertAffineScalar(const Mat44& m)
+{
+	// Columns of the adjugate of the upper 3x3 part are the cross products of its rows
+	Vec3f r0(m._11, m._12, m._13), r1(m._21, m._22, m._23), r2(m._31, m._32, m._33);
+	Vec3f c0 = Vec3Cross(r1, r2), c1 = Vec3Cross(r2, r0), c2 = Vec3Cross(r0, r1);
+
+	float idet = 1.0f / Vec3Dot(r0, c0);
+	c0 *= idet;
+	c1 *= idet;
+	c2 *= idet;
+
+	Vec3f t = -(c0 * m._14 + c1 * m._24 + c2 * m._34);
+	return Mat44(
+		c0.x, c1.x, c2.x, t.x,
+		c0.y, c1.y, c2.y, t.y,
+		c0.z, c1.z, c2.z, t.z,
+		0, 0, 0, 1.0f);
+}
+
+// Summary:
+//	Inverse of an affine transformation (last row is (0, 0, 0, 1)), e.g. as built by STransformationDesc::BuildTRS().
+//	The upper 3x3 part is inverted by its adjugate, so non-uniform scale and shear are fine.
+//	Matrices used with row vectors (translation in _41, _42, _43) have to be transposed first.
+//	Does not check for a singular matrix.
+static Mat44 SMatrixInvertAffine(const Mat44& m)
+{
+#ifdef SP_MATH_SSE
+	__m128 r0 = _mm_loadu_ps(m.m[0]), r1 = _mm_loadu_ps(m.m[1]), r2 = _mm_loadu_ps(m.m[2]);
+
+	// The w lanes (translation) cancel out in the cross products
+	__m128 c0 = SIMDCross3(r1, r2), c1 = SIMDCross3(r2, r0), c2 = SIMDCross3(r0, r1);
+
+	__m128 idet = _mm_div_ps(_mm_set1_ps(1.0f), SIMDDot3(r0, c0));
+	c0 = _mm_mul_ps(c0, idet);
+	c1 = _mm_mul_ps(c1, idet);
+	c2 = _mm_mul_ps(c2, idet);
+
+	__m128 t = _mm_add_ps(_mm_add_ps(_mm_mul_ps(c0, SP_SIMD_SPLAT(r0, 3)), _mm_mul_ps(c1, SP_SIMD_SPLAT(r1, 3))), _mm_mul_ps(c2, SP_SIMD_SPLAT(r2, 3)));
+	t = _mm_sub_ps(_mm_set_ps(1.0f, 0, 0, 0), t);
+
+	// Columns -> rows. The last row becomes (0, 0, 0, 1)
+	_MM_TRANSPOSE4_PS(c0, c1, c2, t);
+
+	Mat44 res;
+	_mm_storeu_ps(res.m[0], c0);
+	_mm_storeu_ps(res.m[1], c1);
+	_mm_storeu_ps(res.m[2], c2);
+	_mm_storeu_ps(res.m[3], t);
+	return res;
+#else
+	return SMatrixInvertAffineScalar(m);
+#endif
+}
+
+// Summary:
+//	Inverse of a rigid transformation (rotation and translation only, last row is (0, 0, 0, 1)):
+//	Transposes the rotation and rotates the negated translation back.
+//	Returns garbage if the upper 3x3 part is not orthonormal, use SMatrixInvertAffine() for scaled transforms.
+static Mat44 SMatrixInvertRigid(const Mat44& m)
+{
+	return Mat44(
+		m._11, m._21, m._31, -(m._11 * m._14 + m._21 * m._24 + m._31 * m._34),
+		m._12, m._22, m._32, -(m._12 * m._14 + m._22 * m._24 + m._32 * m._34),
+		m._13, m._23, m._33, -(m._13 * m._14 + m._23 * m._24 + m._33 * m._34),
+		0, 0, 0, 1.0f);
+}
+
 template<typename F>
 static inline void Vec3TransformCoord(Vec3<F> *pout, const Vec3f &pv, const Mat44 &pm)
 {
@@ -507,12 +734,12 @@ struct S_API STransformationDesc
 	// Scale -> Pre-Rotation-Transform -> Rotate -> Undo Pre-Rotation Transform -> Translate
 	Mat44 BuildTRS() const
 	{
-		return translation * SMatrixInvert(preRotation) * rotation * preRotation * scale;
+		return translation * SMatrixInvertAffine(preRotation) * rotation * preRotation * scale;
 	}
 
 	Mat44 BuildSRT() const
 	{
-		return scale * preRotation * rotation * SMatrixInvert(preRotation) * translation;
+		return scale * preRotation * rotation * SMatrixInvertAffine(preRotation) * translation;
 	}
 };
 
@@ -0,0 +1,312 @@
+//////////////////////////////////////////////////////////////////////////////////////////////////
+//
+//	SpeedPoint Game Engine
+//	Copyright (c) 2011-2018 Pascal Rosenkranz, All rights reserved.
+//
+//////////////////////////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+#include "SAPI.h"
+#include <cmath>
+#include <utility>
+
+namespace SpeedPoint
+{
+	// Templated core of the math types:
+	//	Vec<N, T>		Vec2<T>, Vec3<T>, Vec4<T> are aliases of Vec<2, T>, Vec<3, T>, Vec<4, T>
+	//	Mat<R, C, T>	Mat33 and Mat44 are Mat<3, 3, float> and Mat<4, 4, float>
+	//
+	// The sizes that are used by the engine are specialized in Vector2.h, Vector3.h, Vector4.h, Mat33.h
+	// and Mat44.h, so that components keep their names (v.x, m._11) and Mat44 keeps its SIMD paths.
+	// The component-wise operators are defined once in here, for all sizes.
+	//
+	// Every type provides:
+	//	- a constexpr constructor from all of its components (in row-major order for matrices)
+	//	- constexpr Get<I>() / Get<I, J>() to read a component at a compile-time index
+	//
+	// The operators expand to one expression per component (via std::integer_sequence) instead of loops,
+	// so they stay constant expressions and compile to the same code as hand-written ones.
+
+	template<unsigned int N, typename T> struct Vec;
+	template<unsigned int R, unsigned int C, typename T> struct Mat;
+
+
+	// template math functions:
+
+	constexpr float finv(const float& f) { return 1.0f / f; }
+	constexpr double finv(const double& d) { return 1.0 / d; }
+	inline float sqrt_t(const float& f) { return sqrtf(f); }
+	inline double sqrt_t(const double& d) { return sqrt(d); }
+
+
+	namespace MathCore
+	{
+		template<unsigned int N>
+		using Indices = std::make_integer_sequence<unsigned int, N>;
+
+		// Scalar argument of the vector-scalar operators. Not deduced, so that v * 2 or v * 0.5 converts
+		// to the component type like the member operators of the hand-written types did.
+		template<typename T> struct SScalar { typedef T type; };
+
+		// Returns the I-th argument, for Get<I>() of the types with named components
+		template<unsigned int I> struct SSelect
+		{
+			template<typename T, typename... Rest>
+			static constexpr const T& Get(const T&, const Rest&... rest) { return SSelect<I - 1>::Get(rest...); }
+		};
+
+		template<> struct SSelect<0>
+		{
+			template<typename T, typename... Rest>
+			static constexpr const T& Get(const T& t, const Rest&...) { return t; }
+		};
+
+		struct SAdd { template<typename T> constexpr T operator ()(const T& a, const T& b) const { return a + b; } };
+		struct SSub { template<typename T> constexpr T operator ()(const T& a, const T& b) const { return a - b; } };
+		struct SMul { template<typename T> constexpr T operator ()(const T& a, const T& b) const { return a * b; } };
+		struct SDiv { template<typename T> constexpr T operator ()(const T& a, const T& b) const { return a / b; } };
+		struct SMin { template<typename T> constexpr T operator ()(const T& a, const T& b) const { return a < b ? a : b; } };
+		struct SMax { template<typename T> constexpr T operator ()(const T& a, const T& b) const { return a > b ? a : b; } };
+
+		// Vector-vector, vector-scalar and scalar-vector
+		template<unsigned int N, typename T, typename Op, unsigned int... I>
+		constexpr Vec<N, T> Apply(const Vec<N, T>& a, const Vec<N, T>& b, Op op, std::integer_sequence<unsigned int, I...>)
+		{
+			return Vec<N, T>(op(a.template Get<I>(), b.template Get<I>())...);
+		}
+
+		template<unsigned int N, typename T, typename Op, unsigned int... I>
+		constexpr Vec<N, T> Apply(const Vec<N, T>& a, const T& k, Op op, std::integer_sequence<unsigned int, I...>)
+		{
+			return Vec<N, T>(op(a.template Get<I>(), k)...);
+		}
+
+		template<unsigned int N, typename T, typename Op, unsigned int... I>
+		constexpr Vec<N, T> Apply(const T& k, const Vec<N, T>& a, Op op, std::integer_sequence<unsigned int, I...>)
+		{
+			return Vec<N, T>(op(k, a.template Get<I>())...);
+		}
+
+		template<unsigned int N, typename T, unsigned int... I>
+		constexpr Vec<N, T> Negate(const Vec<N, T>& v, std::integer_sequence<unsigned int, I...>)
+		{
+			return Vec<N, T>(-v.template Get<I>()...);
+		}
+
+		// Sums up from the first to the last component, i.e. ((x * x + y * y) + z * z)
+		template<unsigned int N, typename T>
+		constexpr T Dot(const Vec<N, T>&, const Vec<N, T>&, const T& sum, std::integral_constant<unsigned int, N>)
+		{
+			return sum;
+		}
+
+		template<unsigned int N, typename T, unsigned int I>
+		constexpr T Dot(const Vec<N, T>& a, const Vec<N, T>& b, const T& sum, std::integral_constant<unsigned int, I>)
+		{
+			return Dot(a, b, sum + a.template Get<I>() * b.template Get<I>(), std::integral_constant<unsigned int, I + 1>());
+		}
+
+		template<unsigned int N, typename T>
+		constexpr bool Equal(const Vec<N, T>&, const Vec<N, T>&, std::integral_constant<unsigned int, N>)
+		{
+			return true;
+		}
+
+		template<unsigned int N, typename T, unsigned int I>
+		constexpr bool Equal(const Vec<N, T>& a, const Vec<N, T>& b, std::integral_constant<unsigned int, I>)
+		{
+			return a.template Get<I>() == b.template Get<I>() && Equal(a, b, std::integral_constant<unsigned int, I + 1>());
+		}
+
+		// Component-wise matrix operators, K = I * C + J
+		template<unsigned int R, unsigned int C, typename T, typename Op, unsigned int... K>
+		constexpr Mat<R, C, T> Apply(const Mat<R, C, T>& a, const Mat<R, C, T>& b, Op op, std::integer_sequence<unsigned int, K...>)
+		{
+			return Mat<R, C, T>(op(a.template Get<K / C, K % C>(), b.template Get<K / C, K % C>())...);
+		}
+
+		template<unsigned int R, unsigned int C, typename T, typename Op, unsigned int... K>
+		constexpr Mat<R, C, T> Apply(const Mat<R, C, T>& a, const T& k, Op op, std::integer_sequence<unsigned int, K...>)
+		{
+			return Mat<R, C, T>(op(a.template Get<K / C, K % C>(), k)...);
+		}
+
+		// Dot product of row I of a and column J of b
+		template<unsigned int R, unsigned int M, unsigned int C, typename T, unsigned int I, unsigned int J>
+		constexpr T RowColumn(const Mat<R, M, T>&, const Mat<M, C, T>&, const T& sum, std::integral_constant<unsigned int, M>)
+		{
+			return sum;
+		}
+
+		template<unsigned int R, unsigned int M, unsigned int C, typename T, unsigned int I, unsigned int J, unsigned int K>
+		constexpr T RowColumn(const Mat<R, M, T>& a, const Mat<M, C, T>& b, const T& sum, std::integral_constant<unsigned int, K>)
+		{
+			return RowColumn<R, M, C, T, I, J>(a, b, sum + a.template Get<I, K>() * b.template Get<K, J>(), std::integral_constant<unsigned int, K + 1>());
+		}
+
+		template<unsigned int R, unsigned int M, unsigned int C, typename T, unsigned int... K>
+		constexpr Mat<R, C, T> Multiply(const Mat<R, M, T>& a, const Mat<M, C, T>& b, std::integer_sequence<unsigned int, K...>)
+		{
+			return Mat<R, C, T>(RowColumn<R, M, C, T, K / C, K % C>(a, b, a.template Get<K / C, 0>() * b.template Get<0, K % C>(), std::integral_constant<unsigned int, 1>())...);
+		}
+
+		// Dot product of row I of m and v
+		template<unsigned int R, unsigned int C, typename T, unsigned int I>
+		constexpr T RowDot(const Mat<R, C, T>&, const Vec<C, T>&, const T& sum, std::integral_constant<unsigned int, C>)
+		{
+			return sum;
+		}
+
+		template<unsigned int R, unsigned int C, typename T, unsigned int I, unsigned int K>
+		constexpr T RowDot(const Mat<R, C, T>& m, const Vec<C, T>& v, const T& sum, std::integral_constant<unsigned int, K>)
+		{
+			return RowDot<R, C, T, I>(m, v, sum + m.template Get<I, K>() * v.template Get<K>(), std::integral_constant<unsigned int, K + 1>());
+		}
+
+		template<unsigned int R, unsigned int C, typename T, unsigned int... I>
+		constexpr Vec<R, T> Multiply(const Mat<R, C, T>& m, const Vec<C, T>& v, std::integer_sequence<unsigned int, I...>)
+		{
+			return Vec<R, T>(RowDot<R, C, T, I>(m, v, m.template Get<I, 0>() * v.template Get<0>(), std::integral_constant<unsigned int, 1>())...);
+		}
+
+		template<unsigned int R, unsigned int C, typename T, unsigned int... K>
+		constexpr Mat<C, R, T> Transpose(const Mat<R, C, T>& m, std::integer_sequence<unsigned int, K...>)
+		{
+			return Mat<C, R, T>(m.template Get<K % R, K / R>()...);
+		}
+	}
+
+
+	// Summary:
+	//	Vector of any size, for the sizes that are not specialized
+	template<unsigned int N, typename T>
+	struct Vec
+	{
+		T e[N];
+
+		constexpr Vec() : e{} {}
+
+		template<typename... Args, typename = typename std::enable_if<sizeof...(Args) == N>::type>
+		constexpr Vec(Args... args) : e{ T(args)... } {}
+
+		template<unsigned int I> constexpr const T& Get() const { return e[I]; }
+
+		inline T& operator [](unsigned int i) { return e[i]; }
+		inline const T& operator [](unsigned int i) const { return e[i]; }
+	};
+
+	// Summary:
+	//	Matrix of any size, for the sizes that are not specialized
+	template<unsigned int R, unsigned int C, typename T>
+	struct Mat
+	{
+		T m[R][C];
+
+		constexpr Mat() : m{} {}
+
+		template<typename... Args, typename = typename std::enable_if<sizeof...(Args) == R * C>::type>
+		constexpr Mat(Args... args) : m{ T(args)... } {}
+
+		template<unsigned int I, unsigned int J> constexpr const T& Get() const { return m[I][J]; }
+	};
+
+
+
+	// Vector operators
+
+	template<unsigned int N, typename T> constexpr Vec<N, T> operator -(const Vec<N, T>& v) { return MathCore::Negate(v, MathCore::Indices<N>()); }
+
+	template<unsigned int N, typename T> constexpr Vec<N, T> operator +(const Vec<N, T>& a, const Vec<N, T>& b) { return MathCore::Apply(a, b, MathCore::SAdd(), MathCore::Indices<N>()); }
+	template<unsigned int N, typename T> constexpr Vec<N, T> operator -(const Vec<N, T>& a, const Vec<N, T>& b) { return MathCore::Apply(a, b, MathCore::SSub(), MathCore::Indices<N>()); }
+	template<unsigned int N, typename T> constexpr Vec<N, T> operator *(const Vec<N, T>& a, const Vec<N, T>& b) { return MathCore::Apply(a, b, MathCore::SMul(), MathCore::Indices<N>()); }
+	template<unsigned int N, typename T> constexpr Vec<N, T> operator /(const Vec<N, T>& a, const Vec<N, T>& b) { return MathCore::Apply(a, b, MathCore::SDiv(), MathCore::Indices<N>()); }
+
+	template<unsigned int N, typename T> constexpr Vec<N, T> operator +(const Vec<N, T>& a, const typename MathCore::SScalar<T>::type& k) { return MathCore::Apply(a, k, MathCore::SAdd(), MathCore::Indices<N>()); }
+	template<unsigned int N, typename T> constexpr Vec<N, T> operator -(const Vec<N, T>& a, const typename MathCore::SScalar<T>::type& k) { return MathCore::Apply(a, k, MathCore::SSub(), MathCore::Indices<N>()); }
+	template<unsigned int N, typename T> constexpr Vec<N, T> operator *(const Vec<N, T>& a, const typename MathCore::SScalar<T>::type& k) { return MathCore::Apply(a, k, MathCore::SMul(), MathCore::Indices<N>()); }
+
+	// Multiplies by the inverse of k
+	template<unsigned int N, typename T> constexpr Vec<N, T> operator /(const Vec<N, T>& a, const typename MathCore::SScalar<T>::type& k) { return MathCore::Apply(a, finv(k), MathCore::SMul(), MathCore::Indices<N>()); }
+
+	template<unsigned int N, typename T> constexpr Vec<N, T> operator +(const typename MathCore::SScalar<T>::type& k, const Vec<N, T>& a) { return MathCore::Apply(a, k, MathCore::SAdd(), MathCore::Indices<N>()); }
+	template<unsigned int N, typename T> constexpr Vec<N, T> operator -(const typename MathCore::SScalar<T>::type& k, const Vec<N, T>& a) { return MathCore::Apply(k, a, MathCore::SSub(), MathCore::Indices<N>()); }
+	template<unsigned int N, typename T> constexpr Vec<N, T> operator *(const typename MathCore::SScalar<T>::type& k, const Vec<N, T>& a) { return MathCore::Apply(a, k, MathCore::SMul(), MathCore::Indices<N>()); }
+	template<unsigned int N, typename T> constexpr Vec<N, T> operator /(const typename MathCore::SScalar<T>::type& k, const Vec<N, T>& a) { return MathCore::Apply(k, a, MathCore::SDiv(), MathCore::Indices<N>()); }
+
+	template<unsigned int N, typename T> inline Vec<N, T>& operator +=(Vec<N, T>& a, const Vec<N, T>& b) { return a = a + b; }
+	template<unsigned int N, typename T> inline Vec<N, T>& operator -=(Vec<N, T>& a, const Vec<N, T>& b) { return a = a - b; }
+	template<unsigned int N, typename T> inline Vec<N, T>& operator *=(Vec<N, T>& a, const Vec<N, T>& b) { return a = a * b; }
+	template<unsigned int N, typename T> inline Vec<N, T>& operator /=(Vec<N, T>& a, const Vec<N, T>& b) { return a = a / b; }
+
+	template<unsigned int N, typename T> inline Vec<N, T>& operator +=(Vec<N, T>& a, const typename MathCore::SScalar<T>::type& k) { return a = a + k; }
+	template<unsigned int N, typename T> inline Vec<N, T>& operator -=(Vec<N, T>& a, const typename MathCore::SScalar<T>::type& k) { return a = a - k; }
+	template<unsigned int N, typename T> inline Vec<N, T>& operator *=(Vec<N, T>& a, const typename MathCore::SScalar<T>::type& k) { return a = a * k; }
+	template<unsigned int N, typename T> inline Vec<N, T>& operator /=(Vec<N, T>& a, const typename MathCore::SScalar<T>::type& k) { return a = a / k; }
+
+	template<unsigned int N, typename T> constexpr bool operator ==(const Vec<N, T>& a, const Vec<N, T>& b) { return MathCore::Equal(a, b, std::integral_constant<unsigned int, 0>()); }
+	template<unsigned int N, typename T> constexpr bool operator !=(const Vec<N, T>& a, const Vec<N, T>& b) { return !(a == b); }
+
+	template<unsigned int N, typename T>
+	constexpr T Dot(const Vec<N, T>& a, const Vec<N, T>& b)
+	{
+		return MathCore::Dot(a, b, a.template Get<0>() * b.template Get<0>(), std::integral_constant<unsigned int, 1>());
+	}
+
+	template<unsigned int N, typename T>
+	constexpr T LengthSq(const Vec<N, T>& v)
+	{
+		return Dot(v, v);
+	}
+
+	template<unsigned int N, typename T>
+	inline T Length(const Vec<N, T>& v)
+	{
+		return sqrt_t(Dot(v, v));
+	}
+
+	template<unsigned int N, typename T>
+	inline Vec<N, T> Normalize(const Vec<N, T>& v)
+	{
+		return v * finv(Length(v));
+	}
+
+	// Component-wise minimum and maximum
+	template<unsigned int N, typename T> constexpr Vec<N, T> VecMin(const Vec<N, T>& a, const Vec<N, T>& b) { return MathCore::Apply(a, b, MathCore::SMin(), MathCore::Indices<N>()); }
+	template<unsigned int N, typename T> constexpr Vec<N, T> VecMax(const Vec<N, T>& a, const Vec<N, T>& b) { return MathCore::Apply(a, b, MathCore::SMax(), MathCore::Indices<N>()); }
+
+
+
+	// Matrix operators. Mat44 * Mat44 and Mat44 * Vec4f are overloaded with the SIMD versions in Mat44.h
+
+	template<unsigned int R, unsigned int C, typename T> constexpr Mat<R, C, T> operator +(const Mat<R, C, T>& a, const Mat<R, C, T>& b) { return MathCore::Apply(a, b, MathCore::SAdd(), MathCore::Indices<R * C>()); }
+	template<unsigned int R, unsigned int C, typename T> constexpr Mat<R, C, T> operator -(const Mat<R, C, T>& a, const Mat<R, C, T>& b) { return MathCore::Apply(a, b, MathCore::SSub(), MathCore::Indices<R * C>()); }
+	template<unsigned int R, unsigned int C, typename T> constexpr Mat<R, C, T> operator *(const Mat<R, C, T>& a, const typename MathCore::SScalar<T>::type& k) { return MathCore::Apply(a, k, MathCore::SMul(), MathCore::Indices<R * C>()); }
+	template<unsigned int R, unsigned int C, typename T> constexpr Mat<R, C, T> operator *(const typename MathCore::SScalar<T>::type& k, const Mat<R, C, T>& a) { return MathCore::Apply(a, k, MathCore::SMul(), MathCore::Indices<R * C>()); }
+
+	template<unsigned int R, unsigned int C, typename T> inline Mat<R, C, T>& operator +=(Mat<R, C, T>& a, const Mat<R, C, T>& b) { return a = a + b; }
+	template<unsigned int R, unsigned int C, typename T> inline Mat<R, C, T>& operator -=(Mat<R, C, T>& a, const Mat<R, C, T>& b) { return a = a - b; }
+	template<unsigned int R, unsigned int C, typename T> inline Mat<R, C, T>& operator *=(Mat<R, C, T>& a, const typename MathCore::SScalar<T>::type& k) { return a = a * k; }
+
+	// Summary:
+	//	Matrix product. Sums up from the first to the last column of a, like the hand-written products.
+	template<unsigned int R, unsigned int M, unsigned int C, typename T>
+	constexpr Mat<R, C, T> MatMul(const Mat<R, M, T>& a, const Mat<M, C, T>& b)
+	{
+		return MathCore::Multiply(a, b, MathCore::Indices<R * C>());
+	}
+
+	template<unsigned int R, unsigned int C, typename T>
+	constexpr Vec<R, T> MatMul(const Mat<R, C, T>& m, const Vec<C, T>& v)
+	{
+		return MathCore::Multiply(m, v, MathCore::Indices<R>());
+	}
+
+	template<unsigned int R, unsigned int M, unsigned int C, typename T> constexpr Mat<R, C, T> operator *(const Mat<R, M, T>& a, const Mat<M, C, T>& b) { return MatMul(a, b); }
+	template<unsigned int R, unsigned int C, typename T> constexpr Vec<R, T> operator *(const Mat<R, C, T>& m, const Vec<C, T>& v) { return MatMul(m, v); }
+
+	template<unsigned int R, unsigned int C, typename T>
+	constexpr Mat<C, R, T> Transpose(const Mat<R, C, T>& m)
+	{
+		return MathCore::Transpose(m, MathCore::Indices<R * C>());
+	}
+}
@@ -0,0 +1,97 @@
+//////////////////////////////////////////////////////////////////////////////////////////////////
+//
+//	SpeedPoint Game Engine
+//	Copyright (c) 2011-2018 Pascal Rosenkranz, All rights reserved.
+//
+//////////////////////////////////////////////////////////////////////////////////////////////////
+
+#include "MemoryTracker.h"
+#include <atomic>
+#include <cstdio>
+
+namespace SpeedPoint
+{
+	struct SMemoryTagCounters
+	{
+		std::atomic<size_t> liveBytes;
+		std::atomic<size_t> peakBytes;
+		std::atomic<unsigned int> numAllocations;
+		std::atomic<unsigned int> numLiveAllocations;
+	};
+
+	// Zero-initialized before any dynamic initialization, so allocations of
+	// other static objects can be tracked as well
+	static SMemoryTagCounters g_MemoryTagCounters[eMEMTAG_NUM];
+
+	S_API const char* GetMemoryTagName(EMemoryTag tag)
+	{
+		switch (tag)
+		{
+		case eMEMTAG_GEOMETRY: return "Geometry";
+		case eMEMTAG_TERRAIN: return "Terrain";
+		case eMEMTAG_PHYSICS_MESH: return "PhysicsMesh";
+		case eMEMTAG_TEXTURE_STAGING: return "TextureStaging";
+		case eMEMTAG_OBJECT_POOLS: return "ObjectPools";
+		case eMEMTAG_SMALL_OBJECTS: return "SmallObjects";
+		case eMEMTAG_FRAME_MEMORY: return "FrameMemory";
+		default:
+			return "???";
+		}
+	}
+
+	S_API void MemoryTracker::OnAlloc(EMemoryTag tag, size_t bytes)
+	{
+		if ((unsigned int)tag >= eMEMTAG_NUM)
+			return;
+
+		SMemoryTagCounters& counters = g_MemoryTagCounters[tag];
+		size_t live = counters.liveBytes.fetch_add(bytes, std::memory_order_relaxed) + bytes;
+		counters.numAllocations.fetch_add(1, std::memory_order_relaxed);
+		counters.numLiveAllocations.fetch_add(1, std::memory_order_relaxed);
+
+		size_t peak = counters.peakBytes.load(std::memory_order_relaxed);
+		while (live > peak && !counters.peakBytes.compare_exchange_weak(peak, live, std::memory_order_relaxed)) {}
+	}
+
+	S_API void MemoryTracker::OnFree(EMemoryTag tag, size_t bytes)
+	{
+		if ((unsigned int)tag >= eMEMTAG_NUM)
+			return;
+
+		SMemoryTagCounters& counters = g_MemoryTagCounters[tag];
+		counters.liveBytes.fetch_sub(bytes, std::memory_order_relaxed);
+		counters.numLiveAllocations.fetch_sub(1, std::memory_order_relaxed);
+	}
+
+	S_API SMemoryTagStats MemoryTracker::GetStats(EMemoryTag tag)
+	{
+		SMemoryTagStats stats;
+		if ((unsigned int)tag >= eMEMTAG_NUM)
+			return stats;
+
+		const SMemoryTagCounters& counters = g_MemoryTagCounters[tag];
+		stats.liveBytes = counters.liveBytes.load(std::memory_order_relaxed);
+		stats.peakBytes = counters.peakBytes.load(std::memory_order_relaxed);
+		stats.numAllocations = counters.numAllocations.load(std::memory_order_relaxed);
+		stats.numLiveAllocations = counters.numLiveAllocations.load(std::memory_order_relaxed);
+		return stats;
+	}
+
+	S_API bool MemoryTracker::DumpStats(const char* filename)
+	{
+		FILE* pFile = 0;
+		if (fopen_s(&pFile, filename, "w") != 0 || !pFile)
+			return false;
+
+		fprintf(pFile, "tag;liveBytes;peakBytes;numAllocations;numLiveAllocations\n");
+		for (unsigned int i = 0; i < eMEMTAG_NUM; ++i)
+		{
+			SMemoryTagStats stats = GetStats((EMemoryTag)i);
+			fprintf(pFile, "%s;%zu;%zu;%u;%u\n", GetMemoryTagName((EMemoryTag)i),
+				stats.liveBytes, stats.peakBytes, stats.numAllocations, stats.numLiveAllocations);
+		}
+
+		fclose(pFile);
+		return true;
+	}
+}
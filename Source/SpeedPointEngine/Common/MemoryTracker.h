@@ -0,0 +1,80 @@
+//////////////////////////////////////////////////////////////////////////////////////////////////
+//
+//	SpeedPoint Game Engine
+//	Copyright (c) 2011-2018 Pascal Rosenkranz, All rights reserved.
+//
+//////////////////////////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include "SAPI.h"
+#include <cstddef>
+
+namespace SpeedPoint
+{
+	// Subsystems that report their memory usage to the MemoryTracker
+	enum S_API EMemoryTag
+	{
+		eMEMTAG_GEOMETRY = 0,		// CGeometry subsets and vertex/index data
+		eMEMTAG_TERRAIN,		// Terrain LOD level vertices/indices and chunks
+		eMEMTAG_PHYSICS_MESH,		// geo::mesh BVH nodes
+		eMEMTAG_TEXTURE_STAGING,	// CPU and staging copies of textures
+		eMEMTAG_OBJECT_POOLS,		// ChunkedObjectPool / ConcurrentObjectPool chunks
+		eMEMTAG_SMALL_OBJECTS,		// SlabAllocator slabs
+		eMEMTAG_FRAME_MEMORY,		// FrameMemory buffers
+
+		eMEMTAG_NUM
+	};
+
+	S_API const char* GetMemoryTagName(EMemoryTag tag);
+
+	struct S_API SMemoryTagStats
+	{
+		size_t liveBytes;
+		size_t peakBytes;
+		unsigned int numAllocations; // total since start
+		unsigned int numLiveAllocations;
+
+		SMemoryTagStats()
+			: liveBytes(0), peakBytes(0), numAllocations(0), numLiveAllocations(0) {}
+	};
+
+	// Summary:
+	//	Counts live bytes, peak bytes and allocations per subsystem tag.
+	// Description:
+	//	The tracker does not allocate memory itself. Allocation sites report the size of
+	//	each allocation and the size of each free with the same tag. All methods are thread-safe.
+	class S_API MemoryTracker
+	{
+	public:
+		static void OnAlloc(EMemoryTag tag, size_t bytes);
+		static void OnFree(EMemoryTag tag, size_t bytes);
+
+		static SMemoryTagStats GetStats(EMemoryTag tag);
+
+		// Writes one line per tag (name;liveBytes;peakBytes;numAllocations;numLiveAllocations)
+		// to the given file. Returns false if the file could not be opened.
+		static bool DumpStats(const char* filename);
+
+		// Calls new T[n] and reports the allocation
+		template<typename T>
+		static T* NewArray(EMemoryTag tag, size_t n)
+		{
+			OnAlloc(tag, sizeof(T) * n);
+			return new T[n];
+		}
+
+		// Calls delete[] p, reports the free and sets p to 0. Does nothing if p is 0.
+		// n must be the number of elements passed to NewArray().
+		template<typename T>
+		static void DeleteArray(EMemoryTag tag, T*& p, size_t n)
+		{
+			if (!p)
+				return;
+
+			OnFree(tag, sizeof(T) * n);
+			delete[] p;
+			p = 0;
+		}
+	};
+}
@@ -0,0 +1,460 @@
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+//	SpeedPoint Game Engine
+//	Copyright (c) 2011-2018 Pascal Rosenkranz, All rights reserved.
+//
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#include "Narrowphase.h"
+#include "SIMD.h"
+#include <cstring>
+
+GEO_NMSPACE_BEG
+
+enum ENarrowphaseBucket
+{
+	eNARROWPHASE_BUCKET_SPHERE_SPHERE = 0,
+	eNARROWPHASE_BUCKET_SPHERE_CAPSULE,
+	eNARROWPHASE_BUCKET_CAPSULE_SPHERE, // tested as sphere-capsule, then flipped
+	eNARROWPHASE_BUCKET_CAPSULE_CAPSULE,
+	eNARROWPHASE_BUCKET_OTHER,
+
+	eNARROWPHASE_NUM_BUCKETS
+};
+
+// Bucket of each combination of shape types, looked up without branching on the types
+struct SNarrowphaseBucketTable
+{
+	unsigned char buckets[NUM_SHAPE_TYPES][NUM_SHAPE_TYPES];
+
+	SNarrowphaseBucketTable()
+	{
+		memset(buckets, eNARROWPHASE_BUCKET_OTHER, sizeof(buckets));
+		buckets[eSHAPE_SPHERE][eSHAPE_SPHERE] = eNARROWPHASE_BUCKET_SPHERE_SPHERE;
+		buckets[eSHAPE_SPHERE][eSHAPE_CAPSULE] = eNARROWPHASE_BUCKET_SPHERE_CAPSULE;
+		buckets[eSHAPE_CAPSULE][eSHAPE_SPHERE] = eNARROWPHASE_BUCKET_CAPSULE_SPHERE;
+		buckets[eSHAPE_CAPSULE][eSHAPE_CAPSULE] = eNARROWPHASE_BUCKET_CAPSULE_CAPSULE;
+	}
+};
+
+// Tests the pair with _ContactManifold(). Used for unbatched buckets and the remainders of batched buckets.
+static inline void AddContactManifold(const shape_pair* pairs, unsigned int ipair, narrowphase_batch* pbatch)
+{
+	SContactManifold manifold;
+	if (!_ContactManifold(pairs[ipair].pshape1, pairs[ipair].pshape2, &manifold))
+		return;
+
+	pbatch->contacts.emplace_back();
+	narrowphase_contact& contact = pbatch->contacts.back();
+	contact.pair = ipair;
+	contact.manifold = manifold;
+}
+
+// Adds the single point contacts of the lanes set in mask
+static inline void AddContacts(unsigned int mask, const unsigned int* order,
+	const float* nx, const float* ny, const float* nz, const float* px, const float* py, const float* pz, const float* dist,
+	unsigned int capMask, narrowphase_batch* pbatch)
+{
+	for (unsigned int lane = 0; mask; ++lane, mask >>= 1)
+	{
+		if (!(mask & 1))
+			continue;
+
+		pbatch->contacts.emplace_back();
+		narrowphase_contact& contact = pbatch->contacts.back();
+		contact.pair = order[lane];
+
+		SContactManifold& manifold = contact.manifold;
+		manifold.n = Vec3f(nx[lane], ny[lane], nz[lane]);
+		manifold.feature = (capMask & (1u << lane)) ? eINTERSECTION_FEATURE_CAP : eINTERSECTION_FEATURE_BASE_SHAPE;
+		manifold.points[0].p = Vec3f(px[lane], py[lane], pz[lane]);
+		manifold.points[0].dist = dist[lane];
+		manifold.points[0].id = 0;
+		manifold.num_points = 1;
+	}
+}
+
+#ifdef SP_MATH_SSE
+
+// Lanes of x that have the sign bit set (isneg() of geo.cpp)
+static inline __m128 SIMDSignMask(__m128 x)
+{
+	return _mm_castsi128_ps(_mm_srai_epi32(_mm_castps_si128(x), 31));
+}
+
+// (x < 0) ? -1 : 1 per lane (sgnnz() of geo.cpp)
+static inline __m128 SIMDSignNonZero(__m128 x)
+{
+	return _mm_or_ps(_mm_set1_ps(1.0f), _mm_and_ps(x, _mm_set1_ps(-0.0f)));
+}
+
+static inline __m128 SIMDSelect(__m128 mask, __m128 a, __m128 b)
+{
+	return _mm_or_ps(_mm_and_ps(mask, a), _mm_andnot_ps(mask, b));
+}
+
+static inline __m128 SIMDAbs(__m128 x)
+{
+	return _mm_andnot_ps(_mm_set1_ps(-0.0f), x);
+}
+
+#endif
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+//	Sphere - Sphere, same as _SphereSphere()
+//
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+enum ESphereSphereStream
+{
+	eSS_C1X = 0, eSS_C1Y, eSS_C1Z, eSS_R1,
+	eSS_C2X, eSS_C2Y, eSS_C2Z, eSS_R2,
+	eSS_NUM_STREAMS
+};
+
+static void SphereSphereBucket(const shape_pair* pairs, const unsigned int* order, unsigned int n, narrowphase_batch* pbatch)
+{
+	pbatch->soa.resize(eSS_NUM_STREAMS * n);
+	float* s[eSS_NUM_STREAMS];
+	for (int k = 0; k < eSS_NUM_STREAMS; ++k)
+		s[k] = pbatch->soa.data() + k * n;
+
+	for (unsigned int i = 0; i < n; ++i)
+	{
+		const sphere* psphere1 = static_cast<const sphere*>(pairs[order[i]].pshape1);
+		const sphere* psphere2 = static_cast<const sphere*>(pairs[order[i]].pshape2);
+		s[eSS_C1X][i] = psphere1->c.x; s[eSS_C1Y][i] = psphere1->c.y; s[eSS_C1Z][i] = psphere1->c.z; s[eSS_R1][i] = psphere1->r;
+		s[eSS_C2X][i] = psphere2->c.x; s[eSS_C2Y][i] = psphere2->c.y; s[eSS_C2Z][i] = psphere2->c.z; s[eSS_R2][i] = psphere2->r;
+	}
+
+	unsigned int i = 0;
+
+#ifdef SP_MATH_SSE
+	float nx[8], ny[8], nz[8], px[8], py[8], pz[8], dist[8]; // 8 lanes for AVX, the SSE loop uses the first 4
+
+#ifdef SP_MATH_AVX
+	for (; i + 8 <= n; i += 8)
+	{
+		__m256 c1x = _mm256_loadu_ps(s[eSS_C1X] + i), c1y = _mm256_loadu_ps(s[eSS_C1Y] + i), c1z = _mm256_loadu_ps(s[eSS_C1Z] + i);
+		__m256 c2x = _mm256_loadu_ps(s[eSS_C2X] + i), c2y = _mm256_loadu_ps(s[eSS_C2Y] + i), c2z = _mm256_loadu_ps(s[eSS_C2Z] + i);
+		__m256 r1 = _mm256_loadu_ps(s[eSS_R1] + i), r2 = _mm256_loadu_ps(s[eSS_R2] + i);
+
+		__m256 dx = _mm256_sub_ps(c2x, c1x), dy = _mm256_sub_ps(c2y, c1y), dz = _mm256_sub_ps(c2z, c1z);
+		__m256 dsq = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(dx, dx), _mm256_mul_ps(dy, dy)), _mm256_mul_ps(dz, dz));
+		__m256 rs = _mm256_add_ps(r1, r2);
+
+		unsigned int mask = (unsigned int)_mm256_movemask_ps(_mm256_cmp_ps(dsq, _mm256_mul_ps(rs, rs), _CMP_LE_OQ));
+		if (!mask)
+			continue;
+
+		__m256 d = _mm256_sqrt_ps(dsq);
+		__m256 vnx = _mm256_div_ps(dx, d), vny = _mm256_div_ps(dy, d), vnz = _mm256_div_ps(dz, d);
+		_mm256_storeu_ps(nx, vnx); _mm256_storeu_ps(ny, vny); _mm256_storeu_ps(nz, vnz);
+		_mm256_storeu_ps(px, _mm256_add_ps(c1x, _mm256_mul_ps(vnx, r1)));
+		_mm256_storeu_ps(py, _mm256_add_ps(c1y, _mm256_mul_ps(vny, r1)));
+		_mm256_storeu_ps(pz, _mm256_add_ps(c1z, _mm256_mul_ps(vnz, r1)));
+		_mm256_storeu_ps(dist, _mm256_sub_ps(_mm256_sub_ps(d, r1), r2));
+
+		AddContacts(mask, order + i, nx, ny, nz, px, py, pz, dist, 0, pbatch);
+	}
+#endif
+
+	for (; i + 4 <= n; i += 4)
+	{
+		__m128 c1x = _mm_loadu_ps(s[eSS_C1X] + i), c1y = _mm_loadu_ps(s[eSS_C1Y] + i), c1z = _mm_loadu_ps(s[eSS_C1Z] + i);
+		__m128 c2x = _mm_loadu_ps(s[eSS_C2X] + i), c2y = _mm_loadu_ps(s[eSS_C2Y] + i), c2z = _mm_loadu_ps(s[eSS_C2Z] + i);
+		__m128 r1 = _mm_loadu_ps(s[eSS_R1] + i), r2 = _mm_loadu_ps(s[eSS_R2] + i);
+
+		__m128 dx = _mm_sub_ps(c2x, c1x), dy = _mm_sub_ps(c2y, c1y), dz = _mm_sub_ps(c2z, c1z);
+		__m128 dsq = _mm_add_ps(_mm_add_ps(_mm_mul_ps(dx, dx), _mm_mul_ps(dy, dy)), _mm_mul_ps(dz, dz));
+		__m128 rs = _mm_add_ps(r1, r2);
+
+		unsigned int mask = (unsigned int)_mm_movemask_ps(_mm_cmple_ps(dsq, _mm_mul_ps(rs, rs)));
+		if (!mask)
+			continue;
+
+		__m128 d = _mm_sqrt_ps(dsq);
+		__m128 vnx = _mm_div_ps(dx, d), vny = _mm_div_ps(dy, d), vnz = _mm_div_ps(dz, d);
+		_mm_storeu_ps(nx, vnx); _mm_storeu_ps(ny, vny); _mm_storeu_ps(nz, vnz);
+		_mm_storeu_ps(px, _mm_add_ps(c1x, _mm_mul_ps(vnx, r1)));
+		_mm_storeu_ps(py, _mm_add_ps(c1y, _mm_mul_ps(vny, r1)));
+		_mm_storeu_ps(pz, _mm_add_ps(c1z, _mm_mul_ps(vnz, r1)));
+		_mm_storeu_ps(dist, _mm_sub_ps(_mm_sub_ps(d, r1), r2));
+
+		AddContacts(mask, order + i, nx, ny, nz, px, py, pz, dist, 0, pbatch);
+	}
+#endif
+
+	for (; i < n; ++i)
+		AddContactManifold(pairs, order[i], pbatch);
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+//	Sphere - Capsule, same as _SphereCapsule() and _CapsuleSphere()
+//
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+enum ESphereCapsuleStream
+{
+	eSC_SX = 0, eSC_SY, eSC_SZ, eSC_SR,
+	eSC_CX, eSC_CY, eSC_CZ, eSC_AX, eSC_AY, eSC_AZ, eSC_HH, eSC_CR,
+	eSC_NUM_STREAMS
+};
+
+// flip: the capsule is shape1 of the pairs
+static void SphereCapsuleBucket(const shape_pair* pairs, const unsigned int* order, unsigned int n, bool flip, narrowphase_batch* pbatch)
+{
+	pbatch->soa.resize(eSC_NUM_STREAMS * n);
+	float* s[eSC_NUM_STREAMS];
+	for (int k = 0; k < eSC_NUM_STREAMS; ++k)
+		s[k] = pbatch->soa.data() + k * n;
+
+	for (unsigned int i = 0; i < n; ++i)
+	{
+		const shape_pair& pair = pairs[order[i]];
+		const sphere* psphere = static_cast<const sphere*>(flip ? pair.pshape2 : pair.pshape1);
+		const capsule* pcapsule = static_cast<const capsule*>(flip ? pair.pshape1 : pair.pshape2);
+		s[eSC_SX][i] = psphere->c.x; s[eSC_SY][i] = psphere->c.y; s[eSC_SZ][i] = psphere->c.z; s[eSC_SR][i] = psphere->r;
+		s[eSC_CX][i] = pcapsule->c.x; s[eSC_CY][i] = pcapsule->c.y; s[eSC_CZ][i] = pcapsule->c.z;
+		s[eSC_AX][i] = pcapsule->axis.x; s[eSC_AY][i] = pcapsule->axis.y; s[eSC_AZ][i] = pcapsule->axis.z;
+		s[eSC_HH][i] = pcapsule->hh; s[eSC_CR][i] = pcapsule->r;
+	}
+
+	unsigned int i = 0;
+
+#ifdef SP_MATH_SSE
+	float nx[4], ny[4], nz[4], px[4], py[4], pz[4], dist[4];
+	const __m128 nsign = flip ? _mm_setzero_ps() : _mm_set1_ps(-0.0f); // n = -d / |d|, reversed for capsule-sphere
+	for (; i + 4 <= n; i += 4)
+	{
+		__m128 sx = _mm_loadu_ps(s[eSC_SX] + i), sy = _mm_loadu_ps(s[eSC_SY] + i), sz = _mm_loadu_ps(s[eSC_SZ] + i), sr = _mm_loadu_ps(s[eSC_SR] + i);
+		__m128 cx = _mm_loadu_ps(s[eSC_CX] + i), cy = _mm_loadu_ps(s[eSC_CY] + i), cz = _mm_loadu_ps(s[eSC_CZ] + i);
+		__m128 ax = _mm_loadu_ps(s[eSC_AX] + i), ay = _mm_loadu_ps(s[eSC_AY] + i), az = _mm_loadu_ps(s[eSC_AZ] + i);
+		__m128 hh = _mm_loadu_ps(s[eSC_HH] + i), cr = _mm_loadu_ps(s[eSC_CR] + i);
+
+		// Closest point on the capsule segment
+		__m128 proj = _mm_add_ps(_mm_add_ps(_mm_mul_ps(_mm_sub_ps(sx, cx), ax), _mm_mul_ps(_mm_sub_ps(sy, cy), ay)), _mm_mul_ps(_mm_sub_ps(sz, cz), az));
+		__m128 t = _mm_min_ps(_mm_max_ps(proj, _mm_xor_ps(hh, _mm_set1_ps(-0.0f))), hh);
+		__m128 dx = _mm_sub_ps(sx, _mm_add_ps(cx, _mm_mul_ps(t, ax)));
+		__m128 dy = _mm_sub_ps(sy, _mm_add_ps(cy, _mm_mul_ps(t, ay)));
+		__m128 dz = _mm_sub_ps(sz, _mm_add_ps(cz, _mm_mul_ps(t, az)));
+		__m128 dsq = _mm_add_ps(_mm_add_ps(_mm_mul_ps(dx, dx), _mm_mul_ps(dy, dy)), _mm_mul_ps(dz, dz));
+		__m128 rs = _mm_add_ps(cr, sr);
+
+		unsigned int mask = (unsigned int)_mm_movemask_ps(_mm_cmplt_ps(_mm_sub_ps(dsq, _mm_mul_ps(rs, rs)), _mm_set1_ps(-FLT_EPSILON)));
+		if (!mask)
+			continue;
+
+		unsigned int capMask = (unsigned int)_mm_movemask_ps(_mm_cmpgt_ps(SIMDAbs(proj), hh));
+
+		__m128 dln = _mm_sqrt_ps(dsq);
+		__m128 vnx = _mm_div_ps(_mm_xor_ps(dx, _mm_set1_ps(-0.0f)), dln);
+		__m128 vny = _mm_div_ps(_mm_xor_ps(dy, _mm_set1_ps(-0.0f)), dln);
+		__m128 vnz = _mm_div_ps(_mm_xor_ps(dz, _mm_set1_ps(-0.0f)), dln);
+		_mm_storeu_ps(px, _mm_add_ps(sx, _mm_mul_ps(vnx, sr)));
+		_mm_storeu_ps(py, _mm_add_ps(sy, _mm_mul_ps(vny, sr)));
+		_mm_storeu_ps(pz, _mm_add_ps(sz, _mm_mul_ps(vnz, sr)));
+		_mm_storeu_ps(nx, _mm_xor_ps(_mm_xor_ps(vnx, _mm_set1_ps(-0.0f)), nsign));
+		_mm_storeu_ps(ny, _mm_xor_ps(_mm_xor_ps(vny, _mm_set1_ps(-0.0f)), nsign));
+		_mm_storeu_ps(nz, _mm_xor_ps(_mm_xor_ps(vnz, _mm_set1_ps(-0.0f)), nsign));
+		_mm_storeu_ps(dist, _mm_sub_ps(_mm_sub_ps(dln, cr), sr));
+
+		AddContacts(mask, order + i, nx, ny, nz, px, py, pz, dist, capMask, pbatch);
+	}
+#endif
+
+	for (; i < n; ++i)
+		AddContactManifold(pairs, order[i], pbatch);
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+//	Capsule - Capsule, same as _CapsuleCapsule()
+//
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+enum ECapsuleCapsuleStream
+{
+	eCC_C0X = 0, eCC_C0Y, eCC_C0Z, eCC_A0X, eCC_A0Y, eCC_A0Z, eCC_HH0, eCC_R0,
+	eCC_C1X, eCC_C1Y, eCC_C1Z, eCC_A1X, eCC_A1Y, eCC_A1Z, eCC_HH1, eCC_R1,
+	eCC_NUM_STREAMS
+};
+
+static void CapsuleCapsuleBucket(const shape_pair* pairs, const unsigned int* order, unsigned int n, narrowphase_batch* pbatch)
+{
+	pbatch->soa.resize(eCC_NUM_STREAMS * n);
+	float* s[eCC_NUM_STREAMS];
+	for (int k = 0; k < eCC_NUM_STREAMS; ++k)
+		s[k] = pbatch->soa.data() + k * n;
+
+	for (unsigned int i = 0; i < n; ++i)
+	{
+		const capsule* capsules[2] = { static_cast<const capsule*>(pairs[order[i]].pshape1), static_cast<const capsule*>(pairs[order[i]].pshape2) };
+		for (int j = 0; j < 2; ++j)
+		{
+			float** sj = s + j * eCC_C1X;
+			sj[eCC_C0X][i] = capsules[j]->c.x; sj[eCC_C0Y][i] = capsules[j]->c.y; sj[eCC_C0Z][i] = capsules[j]->c.z;
+			sj[eCC_A0X][i] = capsules[j]->axis.x; sj[eCC_A0Y][i] = capsules[j]->axis.y; sj[eCC_A0Z][i] = capsules[j]->axis.z;
+			sj[eCC_HH0][i] = capsules[j]->hh; sj[eCC_R0][i] = capsules[j]->r;
+		}
+	}
+
+	unsigned int i = 0;
+
+#ifdef SP_MATH_SSE
+	float nx[4], ny[4], nz[4], px[4], py[4], pz[4], dist[4];
+	const __m128 signbit = _mm_set1_ps(-0.0f);
+	for (; i + 4 <= n; i += 4)
+	{
+		__m128 cx[2], cy[2], cz[2], ax[2], ay[2], az[2], hh[2], r[2];
+		for (int j = 0; j < 2; ++j)
+		{
+			float** sj = s + j * eCC_C1X;
+			cx[j] = _mm_loadu_ps(sj[eCC_C0X] + i); cy[j] = _mm_loadu_ps(sj[eCC_C0Y] + i); cz[j] = _mm_loadu_ps(sj[eCC_C0Z] + i);
+			ax[j] = _mm_loadu_ps(sj[eCC_A0X] + i); ay[j] = _mm_loadu_ps(sj[eCC_A0Y] + i); az[j] = _mm_loadu_ps(sj[eCC_A0Z] + i);
+			hh[j] = _mm_loadu_ps(sj[eCC_HH0] + i); r[j] = _mm_loadu_ps(sj[eCC_R0] + i);
+		}
+
+		__m128 rs = _mm_add_ps(r[0], r[1]);
+		__m128 rsq = _mm_mul_ps(rs, rs);
+		__m128 best = _mm_set1_ps(FLT_MAX);
+		__m128 inters = _mm_setzero_ps();
+		__m128 vpx = _mm_setzero_ps(), vpy = _mm_setzero_ps(), vpz = _mm_setzero_ps();
+		__m128 vnx = _mm_setzero_ps(), vny = _mm_setzero_ps(), vnz = _mm_setzero_ps();
+
+		// Cap-Capsule
+		for (int c = 0; c < 2; ++c)
+			for (int e = -1; e < 2; e += 2)
+			{
+				int o = c ^ 1;
+				__m128 sc = _mm_mul_ps(_mm_set1_ps((float)e), hh[c]);
+				__m128 cpx = _mm_add_ps(cx[c], _mm_mul_ps(sc, ax[c]));
+				__m128 cpy = _mm_add_ps(cy[c], _mm_mul_ps(sc, ay[c]));
+				__m128 cpz = _mm_add_ps(cz[c], _mm_mul_ps(sc, az[c]));
+
+				__m128 so = _mm_add_ps(_mm_add_ps(_mm_mul_ps(_mm_sub_ps(cpx, cx[o]), ax[o]), _mm_mul_ps(_mm_sub_ps(cpy, cy[o]), ay[o])), _mm_mul_ps(_mm_sub_ps(cpz, cz[o]), az[o]));
+				so = _mm_min_ps(_mm_max_ps(so, _mm_xor_ps(hh[o], signbit)), hh[o]);
+				__m128 qx = _mm_add_ps(cx[o], _mm_mul_ps(so, ax[o]));
+				__m128 qy = _mm_add_ps(cy[o], _mm_mul_ps(so, ay[o]));
+				__m128 qz = _mm_add_ps(cz[o], _mm_mul_ps(so, az[o]));
+
+				__m128 dx = _mm_sub_ps(cpx, qx), dy = _mm_sub_ps(cpy, qy), dz = _mm_sub_ps(cpz, qz);
+				__m128 distsq = _mm_add_ps(_mm_add_ps(_mm_mul_ps(dx, dx), _mm_mul_ps(dy, dy)), _mm_mul_ps(dz, dz));
+				__m128 m = _mm_and_ps(_mm_cmple_ps(distsq, rsq), _mm_cmplt_ps(distsq, best));
+
+				// p on capsule 0, n towards capsule 1
+				__m128 p0x = c ? qx : cpx, p0y = c ? qy : cpy, p0z = c ? qz : cpz;
+				__m128 p1x = c ? cpx : qx, p1y = c ? cpy : qy, p1z = c ? cpz : qz;
+				inters = _mm_or_ps(inters, m);
+				best = SIMDSelect(m, distsq, best);
+				vpx = SIMDSelect(m, p0x, vpx); vpy = SIMDSelect(m, p0y, vpy); vpz = SIMDSelect(m, p0z, vpz);
+				vnx = SIMDSelect(m, _mm_sub_ps(p1x, p0x), vnx); vny = SIMDSelect(m, _mm_sub_ps(p1y, p0y), vny); vnz = SIMDSelect(m, _mm_sub_ps(p1z, p0z), vnz);
+			}
+
+		// Mantle-Mantle
+		__m128 dcx = _mm_sub_ps(cx[1], cx[0]), dcy = _mm_sub_ps(cy[1], cy[0]), dcz = _mm_sub_ps(cz[1], cz[0]);
+		__m128 dx = _mm_sub_ps(_mm_mul_ps(ay[0], az[1]), _mm_mul_ps(az[0], ay[1]));
+		__m128 dy = _mm_sub_ps(_mm_mul_ps(az[0], ax[1]), _mm_mul_ps(ax[0], az[1]));
+		__m128 dz = _mm_sub_ps(_mm_mul_ps(ax[0], ay[1]), _mm_mul_ps(ay[0], ax[1]));
+		__m128 dlnsq = _mm_add_ps(_mm_add_ps(_mm_mul_ps(dx, dx), _mm_mul_ps(dy, dy)), _mm_mul_ps(dz, dz));
+		__m128 dcd = _mm_add_ps(_mm_add_ps(_mm_mul_ps(dcx, dx), _mm_mul_ps(dcy, dy)), _mm_mul_ps(dcz, dz));
+		__m128 a01 = _mm_add_ps(_mm_add_ps(_mm_mul_ps(ax[0], ax[1]), _mm_mul_ps(ay[0], ay[1])), _mm_mul_ps(az[0], az[1]));
+
+		// s0 = (dc x a1) . d, s1 = (dc x a0) . d
+		__m128 s0 = _mm_add_ps(_mm_add_ps(
+			_mm_mul_ps(_mm_sub_ps(_mm_mul_ps(dcy, az[1]), _mm_mul_ps(dcz, ay[1])), dx),
+			_mm_mul_ps(_mm_sub_ps(_mm_mul_ps(dcz, ax[1]), _mm_mul_ps(dcx, az[1])), dy)),
+			_mm_mul_ps(_mm_sub_ps(_mm_mul_ps(dcx, ay[1]), _mm_mul_ps(dcy, ax[1])), dz));
+		__m128 s1 = _mm_add_ps(_mm_add_ps(
+			_mm_mul_ps(_mm_sub_ps(_mm_mul_ps(dcy, az[0]), _mm_mul_ps(dcz, ay[0])), dx),
+			_mm_mul_ps(_mm_sub_ps(_mm_mul_ps(dcz, ax[0]), _mm_mul_ps(dcx, az[0])), dy)),
+			_mm_mul_ps(_mm_sub_ps(_mm_mul_ps(dcx, ay[0]), _mm_mul_ps(dcy, ax[0])), dz));
+
+		__m128 mantle = _mm_and_ps(
+			_mm_and_ps(SIMDSignMask(_mm_sub_ps(SIMDAbs(a01), _mm_set1_ps(1.0f - FLT_EPSILON))), SIMDSignMask(_mm_sub_ps(_mm_mul_ps(dcd, dcd), _mm_mul_ps(rsq, dlnsq)))),
+			_mm_and_ps(SIMDSignMask(_mm_sub_ps(SIMDAbs(s0), _mm_mul_ps(hh[0], dlnsq))), SIMDSignMask(_mm_sub_ps(SIMDAbs(s1), _mm_mul_ps(hh[1], dlnsq)))));
+
+		unsigned int capMask = ~(unsigned int)_mm_movemask_ps(mantle) & 0xf;
+		inters = _mm_or_ps(inters, mantle);
+		unsigned int mask = (unsigned int)_mm_movemask_ps(inters);
+		if (!mask)
+			continue;
+
+		__m128 t0 = _mm_div_ps(s0, dlnsq);
+		__m128 sg = SIMDSignNonZero(dcd);
+		vpx = SIMDSelect(mantle, _mm_add_ps(cx[0], _mm_mul_ps(t0, ax[0])), vpx);
+		vpy = SIMDSelect(mantle, _mm_add_ps(cy[0], _mm_mul_ps(t0, ay[0])), vpy);
+		vpz = SIMDSelect(mantle, _mm_add_ps(cz[0], _mm_mul_ps(t0, az[0])), vpz);
+		vnx = SIMDSelect(mantle, _mm_mul_ps(dx, sg), vnx);
+		vny = SIMDSelect(mantle, _mm_mul_ps(dy, sg), vny);
+		vnz = SIMDSelect(mantle, _mm_mul_ps(dz, sg), vnz);
+		best = SIMDSelect(mantle, _mm_div_ps(_mm_mul_ps(dcd, dcd), dlnsq), best);
+
+		__m128 nln = _mm_sqrt_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(vnx, vnx), _mm_mul_ps(vny, vny)), _mm_mul_ps(vnz, vnz)));
+		vnx = _mm_div_ps(vnx, nln); vny = _mm_div_ps(vny, nln); vnz = _mm_div_ps(vnz, nln);
+
+		_mm_storeu_ps(nx, vnx); _mm_storeu_ps(ny, vny); _mm_storeu_ps(nz, vnz);
+		_mm_storeu_ps(px, _mm_add_ps(vpx, _mm_mul_ps(vnx, r[0])));
+		_mm_storeu_ps(py, _mm_add_ps(vpy, _mm_mul_ps(vny, r[0])));
+		_mm_storeu_ps(pz, _mm_add_ps(vpz, _mm_mul_ps(vnz, r[0])));
+		_mm_storeu_ps(dist, _mm_sub_ps(_mm_sub_ps(_mm_sqrt_ps(best), r[0]), r[1]));
+
+		AddContacts(mask, order + i, nx, ny, nz, px, py, pz, dist, capMask, pbatch);
+	}
+#endif
+
+	for (; i < n; ++i)
+		AddContactManifold(pairs, order[i], pbatch);
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void _NarrowphaseBatch(const shape_pair* pairs, unsigned int num_pairs, narrowphase_batch* pbatch)
+{
+	pbatch->contacts.clear();
+	if (num_pairs == 0)
+		return;
+
+	static const SNarrowphaseBucketTable table;
+
+	// Counting sort of the pairs by bucket
+	pbatch->buckets.resize(num_pairs);
+	unsigned int offsets[eNARROWPHASE_NUM_BUCKETS + 1] = { 0 };
+	for (unsigned int i = 0; i < num_pairs; ++i)
+	{
+		unsigned char bucket = table.buckets[pairs[i].pshape1->GetType()][pairs[i].pshape2->GetType()];
+		pbatch->buckets[i] = bucket;
+		++offsets[bucket + 1];
+	}
+
+	for (int bucket = 0; bucket < eNARROWPHASE_NUM_BUCKETS; ++bucket)
+		offsets[bucket + 1] += offsets[bucket];
+
+	pbatch->order.resize(num_pairs);
+	unsigned int next[eNARROWPHASE_NUM_BUCKETS];
+	for (int bucket = 0; bucket < eNARROWPHASE_NUM_BUCKETS; ++bucket)
+		next[bucket] = offsets[bucket];
+
+	for (unsigned int i = 0; i < num_pairs; ++i)
+		pbatch->order[next[pbatch->buckets[i]]++] = i;
+
+	const unsigned int* order = pbatch->order.data();
+	SphereSphereBucket(pairs, order + offsets[eNARROWPHASE_BUCKET_SPHERE_SPHERE],
+		offsets[eNARROWPHASE_BUCKET_SPHERE_SPHERE + 1] - offsets[eNARROWPHASE_BUCKET_SPHERE_SPHERE], pbatch);
+
+	SphereCapsuleBucket(pairs, order + offsets[eNARROWPHASE_BUCKET_SPHERE_CAPSULE],
+		offsets[eNARROWPHASE_BUCKET_SPHERE_CAPSULE + 1] - offsets[eNARROWPHASE_BUCKET_SPHERE_CAPSULE], false, pbatch);
+
+	SphereCapsuleBucket(pairs, order + offsets[eNARROWPHASE_BUCKET_CAPSULE_SPHERE],
+		offsets[eNARROWPHASE_BUCKET_CAPSULE_SPHERE + 1] - offsets[eNARROWPHASE_BUCKET_CAPSULE_SPHERE], true, pbatch);
+
+	CapsuleCapsuleBucket(pairs, order + offsets[eNARROWPHASE_BUCKET_CAPSULE_CAPSULE],
+		offsets[eNARROWPHASE_BUCKET_CAPSULE_CAPSULE + 1] - offsets[eNARROWPHASE_BUCKET_CAPSULE_CAPSULE], pbatch);
+
+	for (unsigned int i = offsets[eNARROWPHASE_BUCKET_OTHER]; i < offsets[eNARROWPHASE_BUCKET_OTHER + 1]; ++i)
+		AddContactManifold(pairs, order[i], pbatch);
+}
+
+GEO_NMSPACE_END
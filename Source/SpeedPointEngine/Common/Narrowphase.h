@@ -0,0 +1,50 @@
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+//	SpeedPoint Game Engine
+//	Copyright (c) 2011-2018 Pascal Rosenkranz, All rights reserved.
+//
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include "ContactManifold.h"
+#include <vector>
+
+GEO_NMSPACE_BEG
+
+// Candidate pair of the broadphase
+struct shape_pair
+{
+	const shape* pshape1;
+	const shape* pshape2;
+
+	shape_pair() : pshape1(0), pshape2(0) {}
+	shape_pair(const shape* _pshape1, const shape* _pshape2) : pshape1(_pshape1), pshape2(_pshape2) {}
+};
+
+struct narrowphase_contact
+{
+	unsigned int pair; // index of the pair in the list passed to _NarrowphaseBatch()
+	SContactManifold manifold;
+};
+
+// Contacts found by _NarrowphaseBatch() and its scratch memory.
+// Keep one instance around to reuse the allocations over multiple calls.
+struct narrowphase_batch
+{
+	std::vector<narrowphase_contact> contacts;
+
+	std::vector<unsigned char> buckets; // bucket of each pair
+	std::vector<unsigned int> order; // pair indices grouped by bucket
+	std::vector<float> soa; // shape data of the current bucket, one stream per component
+};
+
+// Summary:
+//	Tests all pairs and writes a contact manifold of each intersecting pair to pbatch->contacts.
+//	The pairs are bucketed by their shape types first. Sphere-sphere, sphere-capsule and capsule-capsule buckets
+//	are gathered into SoA streams and tested 4 pairs at a time (SSE), sphere-sphere 8 pairs at a time with AVX.
+//	All other pairs go through _ContactManifold() one by one.
+//	The manifolds are the same as with _ContactManifold(), but the contacts are grouped by bucket, not ordered by pair.
+void _NarrowphaseBatch(const shape_pair* pairs, unsigned int num_pairs, narrowphase_batch* pbatch);
+
+GEO_NMSPACE_END
@@ -147,4 +147,14 @@ S_API const vector<ProfilingSection>* ProfilingSystemIntrnl::GetLastFrameSection
 	return &m_Sections[m_CurrentSectionPool ^ 0x1];
 }
 
+S_API SMemoryTagStats ProfilingSystemIntrnl::GetMemoryStats(EMemoryTag tag) const
+{
+	return MemoryTracker::GetStats(tag);
+}
+
+S_API bool ProfilingSystemIntrnl::DumpMemoryStats(const char* filename) const
+{
+	return MemoryTracker::DumpStats(filename);
+}
+
 SP_NMSPACE_END
@@ -9,6 +9,7 @@
 
 #include "SPrerequisites.h"
 #include "ChunkedObjectPool.h"
+#include "MemoryTracker.h"
 #include <string>
 
 SP_NMSPACE_BEG
@@ -133,6 +134,13 @@ public:
 
 	// In seconds
 	const double& GetMaxRecentFrameDuration() const { return m_MaxRecentFrameDuration; }
+
+	// Returns the memory usage of the subsystem as reported to the MemoryTracker
+	SMemoryTagStats GetMemoryStats(EMemoryTag tag) const;
+
+	// Writes the memory usage of all subsystems to a file, so that budgets can be compared across builds.
+	// Returns false if the file could not be written.
+	bool DumpMemoryStats(const char* filename) const;
 };
 
 // Frame profiling system
@@ -34,6 +34,9 @@ void VisualizeTriangle(const Vec3f& p1, const Vec3f& p2, const Vec3f& p3, const
 
 #define INVALID_ID UINT_MAX
 
+// Points closer than this fraction of the size of the point set to the hull are treated as inside
+#define QHULL_RELATIVE_TOLERANCE 1e-5f
+
 struct QH2Face
 {
 	static unsigned int idCtr;
@@ -180,9 +183,11 @@ void _qh2debug_step()
 
 
 
-void QuickHull2_CreateFirstSimplex(
+// Returns false if the points do not span a volume
+bool QuickHull2_CreateFirstSimplex(
 	const Vec3f* poly,
 	const unsigned int npolyverts,
+	float tolerance,
 	unsigned int* faceIds, // assigns faceId to each point in poly
 	vector<QH2Face>& faces)
 {
@@ -248,6 +253,9 @@ void QuickHull2_CreateFirstSimplex(
 		}
 	}
 
+	if (distmax <= tolerance)
+		return false;
+
 	// Add first simplex faces
 	face0.id = QH2Face::idCtr++;
 	face0.n = n * (float)nsign;
@@ -287,17 +295,20 @@ void QuickHull2_CreateFirstSimplex(
 				continue; // already assigned
 
 			const Vec3f& p = poly[i];
-			if (Vec3Dot(p - poly[face->p[0]], face->n) > 0.001f)
+			if (Vec3Dot(p - poly[face->p[0]], face->n) > tolerance)
 			{
 				faceIds[i] = face->id;
 				numAssignedPoints++;
 			}
 		}
+
+	return true;
 }
 
 unsigned int QuickHull2_FindFarthestPoint(
 	const Vec3f* poly,
 	const unsigned int npolyverts,
+	float tolerance,
 	const unsigned int* faceIds,
 	const QH2Face& face)
 {
@@ -310,7 +321,7 @@ unsigned int QuickHull2_FindFarthestPoint(
 
 		const Vec3f& p = poly[i];
 		dist = Vec3Dot(p - poly[face.p[0]], face.n);
-		if (dist > 0.001f && dist > distMax)
+		if (dist > tolerance && dist > distMax)
 		{
 			distMax = dist;
 			farthestPt = i;
@@ -320,146 +331,125 @@ unsigned int QuickHull2_FindFarthestPoint(
 	return farthestPt;
 }
 
-// Returns count of removed faces
-// Implements a region-growing algorithm.
-// horizonFaces are those faces, that were NOT removed and close to a removed face.
-// This method will remove faces and unset ALL neighbors on removed face and neighbor on existing face.
-unsigned int QuickHull2_RemoveFacesVisibleFromPoint(
+// Finds the faces visible from pt by growing the region around startFace and determines the horizon:
+// the loop of edges between the visible and the remaining faces, ordered and oriented like the
+// edges of the visible faces, so that the new faces (p[0], p[1], pt) are wound like the removed ones.
+// Returns false if the visible region is not a disk. Due to rounding errors, this can happen if pt is almost
+// coplanar with some of the faces. The hull is not modified.
+bool QuickHull2_DetermineHorizon(
 	const Vec3f* poly,
-	vector<QH2Face>& faces,
-	unsigned int* faceIds,
-	unsigned int npolyverts,
+	const vector<QH2Face>& faces,
 	const Vec3f& pt,
 	const unsigned int startFace,
-	vector<unsigned int>& horizonFaces)
+	vector<unsigned int>& visibleFaces,
+	vector<QH2HorizonEdge>& horizon)
 {
-	unsigned int startFaceId = faces.at(startFace).id;
-
-	// Find visible faces from that point
-	unsigned int numRemoved = 0;
-	set<unsigned int> visitedFaces;
-	queue<unsigned int> openFaces;
-	openFaces.push(startFace);
-	while (!openFaces.empty())
+	vector<char> visited(faces.size(), 0);
+	vector<QH2HorizonEdge> edges; // unsorted
+	visibleFaces.clear();
+	visibleFaces.push_back(startFace);
+	visited[startFace] = 1;
+	for (size_t ivisible = 0; ivisible < visibleFaces.size(); ++ivisible)
 	{
-		unsigned int iface = openFaces.front();
-		QH2Face& face = faces.at(iface);
-		openFaces.pop();
-		visitedFaces.insert(iface);
-
-		if (Vec3Dot(pt - poly[face.p[0]], face.n) > 0.001f)
+		unsigned int iface = visibleFaces[ivisible];
+		const QH2Face& face = faces.at(iface);
+		for (int i = 0; i < 3; ++i)
 		{
-			// Unassign points from this face
-			// Here, we assign all points of all removed faces to the startFace.
-			// Later, these points will be actually unassigned or reassigned to new faces
-			for (unsigned int i = 0; i < npolyverts; ++i)
+			unsigned int ineighbor = face.neighbor[i];
+			const QH2Face& neighbor = faces.at(ineighbor);
+			if (Vec3Dot(pt - poly[neighbor.p[0]], neighbor.n) > 0)
 			{
-				if (faceIds[i] == face.id)
-					faceIds[i] = startFaceId;
-			}
+				if (!visited[ineighbor])
+				{
+					visited[ineighbor] = 1;
+					visibleFaces.push_back(ineighbor);
+				}
 
-			face.id = INVALID_ID;
-			numRemoved++;
+				continue;
+			}
 
-			// Scan neighbors of this face
-			for (int i = 0; i < 3; ++i)
+			// Edge p[i] -> p[i + 1] of the face is a horizon edge. Orient it counter-clockwise around the face normal.
+			QH2HorizonEdge edge(ineighbor, INVALID_ID, face.p[i], face.p[(i + 1) % 3]);
+			for (unsigned int j = 0; j < 3; ++j)
 			{
-				if (face.neighbor[i] == INVALID_ID)
-					continue;
-
-				QH2Face& neighbor = faces.at(face.neighbor[i]);
-				for (int j = 0; j < 3; ++j)
-					if (neighbor.neighbor[j] == iface)
-						neighbor.neighbor[j] = INVALID_ID;
+				if (neighbor.neighbor[j] == iface)
+					edge.neighbor = j;
+			}
 
-				// Only add those neighbors to queue that we haven't visited yet
-				if (visitedFaces.find(face.neighbor[i]) == visitedFaces.end())
-					openFaces.push(face.neighbor[i]);
+			const Vec3f& a = poly[face.p[i]];
+			if (Vec3Dot((poly[face.p[(i + 1) % 3]] - a) ^ (poly[face.p[(i + 2) % 3]] - a), face.n) < 0)
+				std::swap(edge.p[0], edge.p[1]);
 
-				face.neighbor[i] = INVALID_ID;
-			}
-		}
-		else
-		{
-			horizonFaces.push_back(iface);
+			edges.push_back(edge);
 		}
 	}
 
-	return numRemoved;
-}
+	// Chain the edges to a single loop. Each point of the horizon must start exactly one edge.
+	horizon.clear();
+	if (edges.empty())
+		return false;
 
-// Returns a list of ordered horizon loop points. The edges between those
-// points are the edges of the horizon edge loop.
-void QuickHull2_DetermineHorizonEdgeLoop(
-	const Vec3f* poly,
-	const vector<QH2Face>& faces,
-	const vector<unsigned int>& horizonFaces,
-	vector<QH2HorizonEdge>& horizon)
-{
-	vector<QH2HorizonEdge> edges; // unsorted
-	for (auto itHorizonFace = horizonFaces.begin(); itHorizonFace != horizonFaces.end(); ++itHorizonFace)
+	horizon.push_back(edges.front());
+	while (horizon.size() < edges.size())
 	{
-		const QH2Face& hf = faces.at(*itHorizonFace);
-
-		// Note: It can't happen that we add the same edge more than once
-		for (int i = 0; i < 3; ++i)
+		const QH2HorizonEdge* pnext = 0;
+		for (auto& edge : edges)
 		{
-			if (hf.neighbor[i] == INVALID_ID)
+			if (edge.p[0] == horizon.back().p[1])
 			{
-				QH2HorizonEdge edge;
-				edge.face = *itHorizonFace;
-				edge.neighbor = i;
-				edge.p[0] = hf.p[i];
-				edge.p[1] = hf.p[(i + 1) % 3];
+				if (pnext)
+					return false;
 
-#ifdef QHULL_DEBUG
-				if (_qh2debug())
-				{
-					VisualizeEdge2(poly, edge);
-				}
-#endif
-
-				edges.push_back(edge);
+				pnext = &edge;
 			}
 		}
+
+		if (!pnext || pnext->p[0] == horizon.front().p[0])
+			return false;
+
+		horizon.push_back(*pnext);
 	}
 
-	// Determine sorted loop over edges
-	unsigned int start = edges.begin()->p[0], cur = edges.begin()->p[1], from = start;
-	horizon.push_back(QH2HorizonEdge(edges.begin()->face, edges.begin()->neighbor, start, cur));
-	while (cur != start)
+	return horizon.back().p[1] == horizon.front().p[0];
+}
+
+// Removes the visible faces. Their points are assigned to extendedFaceId, to be reassigned to the new faces.
+void QuickHull2_RemoveFaces(
+	vector<QH2Face>& faces,
+	unsigned int* faceIds,
+	unsigned int npolyverts,
+	const vector<unsigned int>& visibleFaces,
+	const vector<QH2HorizonEdge>& horizon,
+	unsigned int extendedFaceId)
+{
+	for (auto iface : visibleFaces)
 	{
-		bool foundNext = false;
-		for (auto& he = edges.begin(); he != edges.end() && !foundNext; ++he)
-			for (int i = 0; i < 2; ++i)
-			{
-				if (he->p[i] == cur && he->p[(i + 1) % 2] != from)
-				{
-					from = cur;
-					cur = he->p[(i + 1) % 2];
-					horizon.push_back(QH2HorizonEdge(he->face, he->neighbor, from, cur));
-					foundNext = true;
-					break;
-				}
-			}
+		QH2Face& face = faces.at(iface);
+		for (unsigned int i = 0; i < npolyverts; ++i)
+		{
+			if (faceIds[i] == face.id)
+				faceIds[i] = extendedFaceId;
+		}
 
-		assert_trace(foundNext, "Could not find next edge in horizon edge loop!");
+		face.id = INVALID_ID;
+		for (int i = 0; i < 3; ++i)
+			face.neighbor[i] = INVALID_ID;
 	}
+
+	for (auto& he : horizon)
+		faces.at(he.face).neighbor[he.neighbor] = INVALID_ID;
 }
 
 void QuickHull2_CreateNewFaces(
 	const Vec3f* poly,
 	unsigned int* faceIds,
 	unsigned int npolyverts,
+	float tolerance,
 	vector<QH2Face>& faces,
-	unsigned int extendedFaceIndex,
 	unsigned int extendedFaceId,
 	const unsigned int iFarthestPt,
 	const vector<QH2HorizonEdge>& horizon)
 {
-	const QH2Face& extendedFace = faces.at(extendedFaceIndex);
-	const Vec3f extendedFaceCenter = (poly[extendedFace.p[0]] + poly[extendedFace.p[1]] + poly[extendedFace.p[2]]) / 3.0f;
-
 	unsigned int firstFace = INVALID_ID;
 	unsigned int prevFace = INVALID_ID;
 	for (auto& he = horizon.begin(); he != horizon.end(); ++he)
@@ -472,13 +462,9 @@ void QuickHull2_CreateNewFaces(
 		newFace.p[1] = he->p[1];
 		newFace.p[2] = iFarthestPt;
 
+		// The horizon edges are oriented like the edges of the removed faces, so the normal points outwards
 		newFace.n = Vec3Normalize((poly[newFace.p[1]] - poly[newFace.p[0]]) ^ (poly[newFace.p[2]] - poly[newFace.p[0]]));
 
-		// The normal of the new face must not point into the extended face plane
-		// In other words, the centroid of the extended face must be on the backside of all new faces
-		if (Vec3Dot(extendedFaceCenter - poly[newFace.p[0]], newFace.n) > 0.001f)
-			newFace.n *= -1.0f;
-
 		newFace.neighbor[0] = he->face;
 		newFace.neighbor[1] = INVALID_ID; // will be set by the next face
 		newFace.neighbor[2] = prevFace;
@@ -509,7 +495,7 @@ void QuickHull2_CreateNewFaces(
 		// Reassign points to this new face
 		for (unsigned int i = 0; i < npolyverts; ++i)
 		{
-			if (faceIds[i] == extendedFaceId && Vec3Dot(poly[i] - poly[newFace.p[0]], newFace.n) > 0.001f)
+			if (faceIds[i] == extendedFaceId && Vec3Dot(poly[i] - poly[newFace.p[0]], newFace.n) > tolerance)
 			{
 				faceIds[i] = newFace.id;
 #ifdef QHULL_DEBUG
@@ -561,6 +547,25 @@ void QuickHull2(
 	if (npolyverts == UINT_MAX)
 		CLog::Log(S_WARN, "QuickHull2: UINT_MAX polygon verts given - this is likely not correct");
 
+	*phull = 0;
+	*pnhullverts = 0;
+	if (phullindices)
+		*phullindices = 0;
+	if (pnfaces)
+		*pnfaces = 0;
+
+	// The tolerance is relative to the size of the point set, so that small and large objects are hulled equally well
+	Vec3f vmin = poly[0], vmax = poly[0];
+	for (unsigned int i = 1; i < npolyverts; ++i)
+	{
+		for (int j = 0; j < 3; ++j)
+		{
+			vmin[j] = min(vmin[j], poly[i][j]);
+			vmax[j] = max(vmax[j], poly[i][j]);
+		}
+	}
+
+	const float tolerance = QHULL_RELATIVE_TOLERANCE * ((vmax.x - vmin.x) + (vmax.y - vmin.y) + (vmax.z - vmin.z));
 
 	unsigned int* faceIds = new unsigned int[npolyverts];
 	for (unsigned int i = 0; i < npolyverts; ++i)
@@ -569,10 +574,15 @@ void QuickHull2(
 	vector<QH2Face> faces;
 
 	// Determine and add first simplex
-	QuickHull2_CreateFirstSimplex(poly, npolyverts, faceIds, faces);
+	if (npolyverts < 4 || !QuickHull2_CreateFirstSimplex(poly, npolyverts, tolerance, faceIds, faces))
+	{
+		CLog::Log(S_WARN, "QuickHull2: Points do not span a volume");
+		delete[] faceIds;
+		return;
+	}
 
 	// Iterate through faces stack
-	vector<unsigned int> horizonFaces;
+	vector<unsigned int> visibleFaces;
 	vector<QH2HorizonEdge> horizon;
 	for (unsigned int iface = 0;; ++iface)
 	{
@@ -595,7 +605,7 @@ void QuickHull2(
 			continue; // face has been removed
 
 					  // Find farthest point in assigned point set
-		unsigned int iFarthestPt = QuickHull2_FindFarthestPoint(poly, npolyverts, faceIds, face);
+		unsigned int iFarthestPt = QuickHull2_FindFarthestPoint(poly, npolyverts, tolerance, faceIds, face);
 		if (iFarthestPt == INVALID_ID) {
 #ifdef QHULL_DEBUG
 			if (_qh2debug())
@@ -613,26 +623,22 @@ void QuickHull2(
 		}
 #endif
 
-		// Find visible faces from that point and remove them
-		horizonFaces.clear();
-		unsigned int numRemoved = QuickHull2_RemoveFacesVisibleFromPoint(poly, faces, faceIds, npolyverts, poly[iFarthestPt], iface, horizonFaces);
-		if (horizonFaces.empty()) {
+		// Find visible faces from that point and the horizon edge loop around them
+		if (!QuickHull2_DetermineHorizon(poly, faces, poly[iFarthestPt], iface, visibleFaces, horizon))
+		{
 #ifdef QHULL_DEBUG
 			if (_qh2debug())
-				CLog::Log(S_DEBUG, "horizonFaces is empty() (numRemoved = %d)", numRemoved);
-
-			_qh2debug_step();
+				CLog::Log(S_DEBUG, "Visible faces do not form a disk");
 #endif
+			// The point is almost coplanar with some faces. Leave it out and extend the face with the next point.
+			faceIds[iFarthestPt] = INVALID_ID;
+			--iface;
 			continue;
 		}
 
-		// Determine horizon edge loop of set of removed faces
-		horizon.clear();
-		QuickHull2_DetermineHorizonEdgeLoop(poly, faces, horizonFaces, horizon);
-		assert_trace(!horizon.empty(), "Horizon loop was empty, but we removed %d faces!", numRemoved);
-
-		// Create new faces connecting edges of horizon edge loop with farthest point
-		QuickHull2_CreateNewFaces(poly, faceIds, npolyverts, faces, iface, extendedFaceId, iFarthestPt, horizon);
+		// Replace the visible faces by new faces connecting the horizon edges with the farthest point
+		QuickHull2_RemoveFaces(faces, faceIds, npolyverts, visibleFaces, horizon, extendedFaceId);
+		QuickHull2_CreateNewFaces(poly, faceIds, npolyverts, tolerance, faces, extendedFaceId, iFarthestPt, horizon);
 
 #ifdef QHULL_DEBUG
 		if (_qh2debug())
@@ -691,6 +697,8 @@ void QuickHull2(
 			++numAddedIndices;
 		}
 	}
+
+	delete[] faceIds;
 }
 
 
@@ -27,13 +27,13 @@ struct S_API Quat
 	Vec3f v;
 	float w;
 
-	Quat() : w(1.0f) {} // Identity = (0, 0, 0, w=1.0)
+	constexpr Quat() : w(1.0f) {} // Identity = (0, 0, 0, w=1.0)
 
-	Quat(const Quat& q) : v(q.v), w(q.w) {}
-	Quat(float ww, const Vec3f& vv) : v(vv), w(ww) {}
+	constexpr Quat(const Quat& q) : v(q.v), w(q.w) {}
+	constexpr Quat(float ww, const Vec3f& vv) : v(vv), w(ww) {}
 	
 	// w = q0, v = (q1, q2, q3)
-	Quat(float q0, float q1, float q2, float q3) : v(q1, q2, q3), w(q0) {}
+	constexpr Quat(float q0, float q1, float q2, float q3) : v(q1, q2, q3), w(q0) {}
 
 	static Quat Identity;
 
@@ -138,31 +138,67 @@ struct S_API Quat
 	inline float Length() const;
 	inline Quat Normalized() const;
 	inline Quat Inverted() const;
-	inline Quat operator !() const;
+	constexpr Quat operator !() const;
 
 	inline Quat operator *(const Quat& r) const;
+	inline Quat MultiplyScalar(const Quat& r) const;
 
-	inline Quat operator *(float f) const
+	constexpr Quat operator *(float f) const
 	{
 		return Quat(w * f, v.x * f, v.y * f, v.z * f);
 	}
 
+	// The quaternion does not have to be normalized. Instead of normalizing, the products are scaled
+	// by 2 / |q|^2, which gives the same matrix without a square root.
 	inline Mat33 ToRotationMatrix33() const
 	{
-		Quat n = Normalized();
-		const float &a = n.w, &b = n.v.x, &c = n.v.y, &d = n.v.z;
+		const float &a = w, &b = v.x, &c = v.y, &d = v.z;
+		float s = 2.0f / (a*a + b*b + c*c + d*d);
+		float bs = b * s, cs = c * s, ds = d * s;
+		float ab = a * bs, ac = a * cs, ad = a * ds;
+		float bb = b * bs, bc = b * cs, bd = b * ds;
+		float cc = c * cs, cd = c * ds, dd = d * ds;
 		return Mat33(
-			a*a + b*b - c*c - d*d, 2.f*(b*c - a*d), 2.f*(b*d + a*c),
-			2.f*(b*c + a*d), a*a - b*b + c*c - d*d, 2.f*(c*d - a*b),
-			2.f*(b*d - a*c), 2.f*(c*d + a*b), a*a - b*b - c*c + d*d
+			1.0f - (cc + dd), bc - ad, bd + ac,
+			bc + ad, 1.0f - (bb + dd), cd - ab,
+			bd - ac, cd + ab, 1.0f - (bb + cc)
 		);
 	}
 
+	// Same as ToRotationMatrix33(), but writes the 4x4 matrix directly
 	inline Mat44 ToRotationMatrix() const
 	{
-		return Mat44(ToRotationMatrix33());
+		const float &a = w, &b = v.x, &c = v.y, &d = v.z;
+		float s = 2.0f / (a*a + b*b + c*c + d*d);
+		float bs = b * s, cs = c * s, ds = d * s;
+		float ab = a * bs, ac = a * cs, ad = a * ds;
+		float bb = b * bs, bc = b * cs, bd = b * ds;
+		float cc = c * cs, cd = c * ds, dd = d * ds;
+		return Mat44(
+			1.0f - (cc + dd), bc - ad, bd + ac, 0,
+			bc + ad, 1.0f - (bb + dd), cd - ab, 0,
+			bd - ac, cd + ab, 1.0f - (bb + cc), 0,
+			0, 0, 0, 1.0f
+		);
+	}
+
+	// Summary:
+	//	Rotates the symmetric tensor S (e.g. an inverse inertia tensor) by this quaternion.
+	// Returns:
+	//	R * S * R^T with R being the rotation matrix of this quaternion
+	inline Mat33 RotateTensor(const Mat33& S) const
+	{
+		return Mat33RotateSymmetric(ToRotationMatrix33(), S);
 	}
 
+	// Summary:
+	//	Integrates this orientation with the angular velocity w over dt using the first order
+	//	exponential map q' = normalize((1, w * dt / 2) * q). No trigonometric functions are
+	//	required and the error is negligible for the small angles of a simulation step.
+	// Arguments:
+	//	angularVelocity - in world space (rad/s)
+	inline Quat Integrated(const Vec3f& angularVelocity, float dt) const;
+
 	inline Vec3f GetForward() const
 	{
 		Quat n = Normalized();
@@ -186,7 +222,7 @@ inline Quat Quat::Normalized() const
 	return Quat(w * invln, v.x * invln, v.y * invln, v.z * invln);
 }
 
-inline Quat Quat::operator !() const
+constexpr Quat Quat::operator !() const
 {
 	return Quat(w, -v.x, -v.y, -v.z);
 }
@@ -195,9 +231,39 @@ inline Quat Quat::Inverted() const
 	return !(*this);
 }
 
+inline Quat Quat::Integrated(const Vec3f& angularVelocity, float dt) const
+{
+	// (1, h * w) * q = q + h * (0, w) * q
+	return (Quat(1.0f, angularVelocity * (0.5f * dt)) * (*this)).Normalized();
+}
+
 // Hamilton product
+// The SIMD path sums up in the same order as the scalar path, so the results are bit-exact.
 inline Quat Quat::operator *(const Quat& r) const
-{	
+{
+#ifdef SP_MATH_SSE
+	static_assert(sizeof(Quat) == 4 * sizeof(float), "SIMD path expects Quat to be laid out as (x, y, z, w)");
+
+	__m128 q1 = _mm_loadu_ps(&v.x);
+	__m128 q2 = _mm_loadu_ps(&r.v.x);
+
+	// w1 * (x2, y2, z2, w2) + x1 * (w2, -z2, y2, -x2) + y1 * (z2, w2, -x2, -y2) + z1 * (-y2, x2, w2, -z2)
+	__m128 res = _mm_mul_ps(SP_SIMD_SPLAT(q1, 3), q2);
+	res = _mm_add_ps(res, _mm_mul_ps(SP_SIMD_SPLAT(q1, 0), _mm_xor_ps(_mm_shuffle_ps(q2, q2, _MM_SHUFFLE(0, 1, 2, 3)), SP_SIMD_SIGNMASK_PNPN)));
+	res = _mm_add_ps(res, _mm_mul_ps(SP_SIMD_SPLAT(q1, 1), _mm_xor_ps(_mm_shuffle_ps(q2, q2, _MM_SHUFFLE(1, 0, 3, 2)), SP_SIMD_SIGNMASK_PPNN)));
+	res = _mm_add_ps(res, _mm_mul_ps(SP_SIMD_SPLAT(q1, 2), _mm_xor_ps(_mm_shuffle_ps(q2, q2, _MM_SHUFFLE(2, 3, 0, 1)), SP_SIMD_SIGNMASK_NPPN)));
+
+	Quat q;
+	_mm_storeu_ps(&q.v.x, res);
+	return q;
+#else
+	return MultiplyScalar(r);
+#endif
+}
+
+// Scalar reference implementation of operator *(const Quat&)
+inline Quat Quat::MultiplyScalar(const Quat& r) const
+{
 	const float &a1 = w, &b1 = v.x, &c1 = v.y, &d1 = v.z;
 	const float &a2 = r.w, &b2 = r.v.x, &c2 = r.v.y, &d2 = r.v.z;
 	return Quat(a1*a2 - b1*b2 - c1*c2 - d1*d2,
@@ -207,12 +273,29 @@ inline Quat Quat::operator *(const Quat& r) const
 		);
 }
 
+// Rotates p by q, i.e. returns (q * (0, p) * q^*).v
+// Multiplied out: (w^2 - v.v) * p + 2 * (v.p) * v + 2 * w * (v x p). Does not require q to be normalized.
 inline Vec3f operator *(const Quat& q, const Vec3f& p)
 {
-	// TODO: multiply this out to save flops
-
-	Quat p2 = q * Quat(0, p) * q.Inverted();
-	return p2.v;
+#ifdef SP_MATH_SSE
+	__m128 qv = _mm_loadu_ps(&q.v.x);
+	__m128 w = SP_SIMD_SPLAT(qv, 3);
+	__m128 v = _mm_and_ps(qv, SP_SIMD_MASK_XYZ);
+	__m128 pv = _mm_set_ps(0, p.z, p.y, p.x);
+
+	__m128 vp = SIMDDot3(v, pv);
+
+	__m128 res = _mm_mul_ps(_mm_sub_ps(_mm_mul_ps(w, w), SIMDDot3(v, v)), pv);
+	res = _mm_add_ps(res, _mm_mul_ps(_mm_add_ps(vp, vp), v));
+	res = _mm_add_ps(res, _mm_mul_ps(_mm_add_ps(w, w), SIMDCross3(v, pv)));
+
+	float out[4];
+	_mm_storeu_ps(out, res);
+	return Vec3f(out[0], out[1], out[2]);
+#else
+	float vv = Vec3Dot(q.v, q.v), vp = Vec3Dot(q.v, p);
+	return (q.w * q.w - vv) * p + (2.0f * vp) * q.v + (2.0f * q.w) * Vec3Cross(q.v, p);
+#endif
 }
 
 // Uses quaternions to calculate the rotation of the given vector
@@ -223,9 +306,19 @@ inline Vec3f RotateVector(const Vec3f& vec, const Vec3f& axis, float rad)
 
 
 // Build TRS: Scale -> Rotation -> Translation
+// Writes [R * diag(scale) | translation] directly instead of multiplying three 4x4 matrices.
 inline static void MakeTransformationTRS(const Vec3f& translation, const Quat& rotation, const Vec3f& scale, Mat44* pMat)
 {
-	MakeTransformationTRS(translation, rotation.ToRotationMatrix(), scale, pMat);
+	if (!pMat)
+		return;
+
+	Mat33 R = rotation.ToRotationMatrix33();
+	*pMat = Mat44(
+		R._11 * scale.x, R._12 * scale.y, R._13 * scale.z, translation.x,
+		R._21 * scale.x, R._22 * scale.y, R._23 * scale.z, translation.y,
+		R._31 * scale.x, R._32 * scale.y, R._33 * scale.z, translation.z,
+		0, 0, 0, 1.0f
+	);
 }
 
 
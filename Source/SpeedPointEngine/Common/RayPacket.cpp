@@ -0,0 +1,348 @@
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+//	SpeedPoint Game Engine
+//	Copyright (c) 2011-2018 Pascal Rosenkranz, All rights reserved.
+//
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#include "RayPacket.h"
+#include "SIMD.h"
+
+GEO_NMSPACE_BEG
+
+// The packet and the single ray path use the same operations in the same order, so they find
+// bit-identical hits. Triangles parallel to a ray (det == 0) need no extra test: 1/det is inf and
+// u, v or t become inf or NaN, which fails the range tests.
+
+static inline void RayToMeshSpace(const ray* pray, const mesh* pmesh, Vec3f& p, Vec3f& v, Vec3f& invv)
+{
+	p = (pmesh->invTransform * Vec4f(pray->p, 1.0f)).xyz();
+	v = (pmesh->invTransform * Vec4f(pray->v, 0.0f)).xyz();
+
+	// Use FLT_MAX instead of inf for axis parallel rays, so that the slab test never computes 0 * inf
+	for (int i = 0; i < 3; ++i)
+		invv[i] = (v[i] != 0) ? 1.0f / v[i] : (v[i] < 0 ? -FLT_MAX : FLT_MAX);
+}
+
+// Returns true if the ray segment [0, tmax] intersects the box
+static inline bool RaySlabTest(const Vec3f& p, const Vec3f& invv, const AABB& aabb, float tmax)
+{
+	// Same min/max semantics as _mm_min_ps / _mm_max_ps
+	float t0 = 0, t1 = tmax, ta, tb, tnear, tfar;
+	for (int i = 0; i < 3; ++i)
+	{
+		ta = (aabb.vMin[i] - p[i]) * invv[i];
+		tb = (aabb.vMax[i] - p[i]) * invv[i];
+		tnear = (ta < tb) ? ta : tb;
+		tfar = (ta > tb) ? ta : tb;
+		t0 = (t0 > tnear) ? t0 : tnear;
+		t1 = (tfar < t1) ? tfar : t1;
+	}
+
+	return t0 <= t1;
+}
+
+// Pushes the children of an inner node so that the one whose center is nearer along the ray direction is popped first.
+// This only changes the visiting order - the earlier a near hit is found, the more nodes are culled by the slab test.
+static inline void PushChildrenFrontToBack(const mesh* pmesh, unsigned int inode, const Vec3f& v, unsigned int* stack, unsigned int& nstack)
+{
+	unsigned int left = inode + 1, right = pmesh->nodes[inode].first;
+	const AABB& leftAABB = pmesh->nodes[left].aabb;
+	const AABB& rightAABB = pmesh->nodes[right].aabb;
+	if (Vec3Dot(leftAABB.vMin + leftAABB.vMax, v) <= Vec3Dot(rightAABB.vMin + rightAABB.vMax, v))
+	{
+		stack[nstack++] = right;
+		stack[nstack++] = left;
+	}
+	else
+	{
+		stack[nstack++] = left;
+		stack[nstack++] = right;
+	}
+}
+
+// Moeller-Trumbore. e1 = p1 - p0, e2 = p2 - p0
+static inline bool RayTriangleMT(const Vec3f& p, const Vec3f& v, const Vec3f& p0, const Vec3f& e1, const Vec3f& e2,
+	float tmax, float& t, float& u, float& w)
+{
+	Vec3f pv = v ^ e2;
+	float invdet = 1.0f / (e1 | pv);
+	Vec3f tv = p - p0;
+	u = (tv | pv) * invdet;
+	Vec3f qv = tv ^ e1;
+	w = (v | qv) * invdet;
+	t = (e2 | qv) * invdet;
+	return u >= 0 && w >= 0 && u + w <= 1.0f && t >= 0 && t < tmax;
+}
+
+bool _RayMeshNearest(const ray* pray, const mesh* pmesh, ray_hit* phit)
+{
+	if (!pray || !pmesh || !phit)
+		return false;
+
+	*phit = ray_hit();
+	if (!pmesh->nodes)
+		return false;
+
+	Vec3f p, v, invv;
+	RayToMeshSpace(pray, pmesh, p, v, invv);
+
+	float t, u, w;
+	unsigned int stack[MESH_BVH_MAX_DEPTH], nstack = 0;
+	stack[nstack++] = 0;
+	while (nstack > 0)
+	{
+		unsigned int inode = stack[--nstack];
+		const mesh_bvh_node& node = pmesh->nodes[inode];
+		if (!RaySlabTest(p, invv, node.aabb, phit->t))
+			continue;
+
+		if (!node.IsLeaf())
+		{
+			PushChildrenFrontToBack(pmesh, inode, v, stack, nstack);
+			continue;
+		}
+
+		for (unsigned int itri = node.first * 3; itri < (node.first + node.count) * 3; itri += 3)
+		{
+			const Vec3f& p0 = pmesh->points[pmesh->indices[itri]];
+			Vec3f e1 = pmesh->points[pmesh->indices[itri + 1]] - p0;
+			Vec3f e2 = pmesh->points[pmesh->indices[itri + 2]] - p0;
+			if (RayTriangleMT(p, v, p0, e1, e2, phit->t, t, u, w))
+			{
+				phit->t = t;
+				phit->tri = itri;
+				phit->u = u;
+				phit->v = w;
+			}
+		}
+	}
+
+	return phit->hit();
+}
+
+#ifdef SP_MATH_SSE
+
+// 4 mesh space rays in structure-of-arrays layout and their nearest hits so far.
+// Unused lanes have t = -1, so they never pass the slab or triangle test.
+struct ray_group
+{
+	__m128 px, py, pz;
+	__m128 vx, vy, vz;
+	__m128 ivx, ivy, ivz;
+	__m128 t, u, v;
+	__m128 tri;
+};
+
+// Returns (mask ? a : b) per lane
+static inline __m128 SIMDSelect(__m128 mask, __m128 a, __m128 b)
+{
+	return _mm_or_ps(_mm_and_ps(mask, a), _mm_andnot_ps(mask, b));
+}
+
+// Returns the lane mask of the rays whose segment [0, t] intersects the box given by the broadcasted bounds
+static inline __m128 RayGroupSlabTest(const ray_group& g, const __m128 bmin[3], const __m128 bmax[3])
+{
+	__m128 ta, tb, t0 = _mm_setzero_ps(), t1 = g.t;
+
+	ta = _mm_mul_ps(_mm_sub_ps(bmin[0], g.px), g.ivx);
+	tb = _mm_mul_ps(_mm_sub_ps(bmax[0], g.px), g.ivx);
+	t0 = _mm_max_ps(t0, _mm_min_ps(ta, tb));
+	t1 = _mm_min_ps(_mm_max_ps(ta, tb), t1);
+
+	ta = _mm_mul_ps(_mm_sub_ps(bmin[1], g.py), g.ivy);
+	tb = _mm_mul_ps(_mm_sub_ps(bmax[1], g.py), g.ivy);
+	t0 = _mm_max_ps(t0, _mm_min_ps(ta, tb));
+	t1 = _mm_min_ps(_mm_max_ps(ta, tb), t1);
+
+	ta = _mm_mul_ps(_mm_sub_ps(bmin[2], g.pz), g.ivz);
+	tb = _mm_mul_ps(_mm_sub_ps(bmax[2], g.pz), g.ivz);
+	t0 = _mm_max_ps(t0, _mm_min_ps(ta, tb));
+	t1 = _mm_min_ps(_mm_max_ps(ta, tb), t1);
+
+	return _mm_cmple_ps(t0, t1);
+}
+
+// Moeller-Trumbore for 4 rays against one triangle given by the broadcasted p0, e1, e2. Updates the nearest hits.
+static inline void RayGroupTriangleMT(ray_group& g, const __m128 p0[3], const __m128 e1[3], const __m128 e2[3], __m128 tri)
+{
+	// pv = v ^ e2
+	__m128 pvx = _mm_sub_ps(_mm_mul_ps(g.vy, e2[2]), _mm_mul_ps(g.vz, e2[1]));
+	__m128 pvy = _mm_sub_ps(_mm_mul_ps(g.vz, e2[0]), _mm_mul_ps(g.vx, e2[2]));
+	__m128 pvz = _mm_sub_ps(_mm_mul_ps(g.vx, e2[1]), _mm_mul_ps(g.vy, e2[0]));
+
+	__m128 det = _mm_add_ps(_mm_add_ps(_mm_mul_ps(e1[0], pvx), _mm_mul_ps(e1[1], pvy)), _mm_mul_ps(e1[2], pvz));
+	__m128 invdet = _mm_div_ps(_mm_set1_ps(1.0f), det);
+
+	__m128 tvx = _mm_sub_ps(g.px, p0[0]);
+	__m128 tvy = _mm_sub_ps(g.py, p0[1]);
+	__m128 tvz = _mm_sub_ps(g.pz, p0[2]);
+	__m128 u = _mm_mul_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(tvx, pvx), _mm_mul_ps(tvy, pvy)), _mm_mul_ps(tvz, pvz)), invdet);
+
+	// qv = tv ^ e1
+	__m128 qvx = _mm_sub_ps(_mm_mul_ps(tvy, e1[2]), _mm_mul_ps(tvz, e1[1]));
+	__m128 qvy = _mm_sub_ps(_mm_mul_ps(tvz, e1[0]), _mm_mul_ps(tvx, e1[2]));
+	__m128 qvz = _mm_sub_ps(_mm_mul_ps(tvx, e1[1]), _mm_mul_ps(tvy, e1[0]));
+
+	__m128 v = _mm_mul_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(g.vx, qvx), _mm_mul_ps(g.vy, qvy)), _mm_mul_ps(g.vz, qvz)), invdet);
+	__m128 t = _mm_mul_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(e2[0], qvx), _mm_mul_ps(e2[1], qvy)), _mm_mul_ps(e2[2], qvz)), invdet);
+
+	const __m128 zero = _mm_setzero_ps();
+	__m128 hit = _mm_and_ps(_mm_cmpge_ps(u, zero), _mm_cmpge_ps(v, zero));
+	hit = _mm_and_ps(hit, _mm_cmple_ps(_mm_add_ps(u, v), _mm_set1_ps(1.0f)));
+	hit = _mm_and_ps(hit, _mm_cmpge_ps(t, zero));
+	hit = _mm_and_ps(hit, _mm_cmplt_ps(t, g.t));
+	if (!_mm_movemask_ps(hit))
+		return;
+
+	g.t = SIMDSelect(hit, t, g.t);
+	g.u = SIMDSelect(hit, u, g.u);
+	g.v = SIMDSelect(hit, v, g.v);
+	g.tri = SIMDSelect(hit, tri, g.tri);
+}
+
+static void RayPacketMeshNearest(const ray* prays, unsigned int n, const mesh* pmesh, ray_hit* phits, unsigned int ngroups)
+{
+	ray_group groups[RAY_PACKET_MAX_SIZE / 4];
+	int masks[RAY_PACKET_MAX_SIZE / 4];
+	if (ngroups * 4 > n)
+		ngroups = (n + 3) / 4;
+
+	// Transform to mesh space and transpose to SoA layout
+	float px[4], py[4], pz[4], vx[4], vy[4], vz[4], ivx[4], ivy[4], ivz[4], t[4];
+	Vec3f p, v, invv, vsum;
+	for (unsigned int ig = 0; ig < ngroups; ++ig)
+	{
+		for (unsigned int lane = 0; lane < 4; ++lane)
+		{
+			unsigned int i = ig * 4 + lane;
+			if (i < n)
+			{
+				RayToMeshSpace(&prays[i], pmesh, p, v, invv);
+				t[lane] = FLT_MAX;
+				vsum += v;
+			}
+			else
+			{
+				p = v = Vec3f(0);
+				invv = Vec3f(FLT_MAX);
+				t[lane] = -1.0f;
+			}
+
+			px[lane] = p.x; py[lane] = p.y; pz[lane] = p.z;
+			vx[lane] = v.x; vy[lane] = v.y; vz[lane] = v.z;
+			ivx[lane] = invv.x; ivy[lane] = invv.y; ivz[lane] = invv.z;
+		}
+
+		ray_group& g = groups[ig];
+		g.px = _mm_loadu_ps(px); g.py = _mm_loadu_ps(py); g.pz = _mm_loadu_ps(pz);
+		g.vx = _mm_loadu_ps(vx); g.vy = _mm_loadu_ps(vy); g.vz = _mm_loadu_ps(vz);
+		g.ivx = _mm_loadu_ps(ivx); g.ivy = _mm_loadu_ps(ivy); g.ivz = _mm_loadu_ps(ivz);
+		g.t = _mm_loadu_ps(t);
+		g.u = g.v = g.tri = _mm_setzero_ps();
+	}
+
+	// Traverse the tree once for the whole packet. The children of a node are ordered by the mean ray direction.
+	__m128 bmin[3], bmax[3], p0[3], e1[3], e2[3];
+	unsigned int stack[MESH_BVH_MAX_DEPTH], nstack = 0;
+	stack[nstack++] = 0;
+	while (nstack > 0)
+	{
+		unsigned int inode = stack[--nstack];
+		const mesh_bvh_node& node = pmesh->nodes[inode];
+
+		int anyMask = 0;
+		for (int i = 0; i < 3; ++i)
+		{
+			bmin[i] = _mm_set1_ps(node.aabb.vMin[i]);
+			bmax[i] = _mm_set1_ps(node.aabb.vMax[i]);
+		}
+
+		for (unsigned int ig = 0; ig < ngroups; ++ig)
+			anyMask |= (masks[ig] = _mm_movemask_ps(RayGroupSlabTest(groups[ig], bmin, bmax)));
+
+		if (!anyMask)
+			continue;
+
+		if (!node.IsLeaf())
+		{
+			PushChildrenFrontToBack(pmesh, inode, vsum, stack, nstack);
+			continue;
+		}
+
+		for (unsigned int itri = node.first * 3; itri < (node.first + node.count) * 3; itri += 3)
+		{
+			const Vec3f& tp0 = pmesh->points[pmesh->indices[itri]];
+			Vec3f te1 = pmesh->points[pmesh->indices[itri + 1]] - tp0;
+			Vec3f te2 = pmesh->points[pmesh->indices[itri + 2]] - tp0;
+			for (int i = 0; i < 3; ++i)
+			{
+				p0[i] = _mm_set1_ps(tp0[i]);
+				e1[i] = _mm_set1_ps(te1[i]);
+				e2[i] = _mm_set1_ps(te2[i]);
+			}
+
+			__m128 tri = _mm_castsi128_ps(_mm_set1_epi32((int)itri));
+			for (unsigned int ig = 0; ig < ngroups; ++ig)
+			{
+				if (masks[ig])
+					RayGroupTriangleMT(groups[ig], p0, e1, e2, tri);
+			}
+		}
+	}
+
+	// Write back
+	unsigned int tris[4];
+	float u[4], w[4];
+	for (unsigned int ig = 0; ig < ngroups; ++ig)
+	{
+		_mm_storeu_ps(t, groups[ig].t);
+		_mm_storeu_ps(u, groups[ig].u);
+		_mm_storeu_ps(w, groups[ig].v);
+		_mm_storeu_si128((__m128i*)tris, _mm_castps_si128(groups[ig].tri));
+		for (unsigned int lane = 0; lane < 4 && ig * 4 + lane < n; ++lane)
+		{
+			ray_hit& hit = phits[ig * 4 + lane];
+			hit.t = t[lane];
+			hit.tri = tris[lane];
+			hit.u = u[lane];
+			hit.v = w[lane];
+		}
+	}
+}
+
+#endif
+
+#ifdef SP_MATH_SSE
+void _RayPacketMeshNearest(const ray* prays, unsigned int n, const mesh* pmesh, ray_hit* phits, unsigned int packetSize)
+{
+	if (!prays || !pmesh || !phits || n == 0)
+		return;
+
+	if (!pmesh->nodes)
+	{
+		for (unsigned int i = 0; i < n; ++i)
+			phits[i] = ray_hit();
+		return;
+	}
+
+	if (packetSize < 4) packetSize = 4;
+	if (packetSize > RAY_PACKET_MAX_SIZE) packetSize = RAY_PACKET_MAX_SIZE;
+	unsigned int ngroups = (packetSize + 3) / 4;
+
+	for (unsigned int i = 0; i < n; i += ngroups * 4)
+		RayPacketMeshNearest(&prays[i], n - i, pmesh, &phits[i], ngroups);
+}
+#else
+// Without SIMD, each ray is traced on its own and the packet size does not matter
+void _RayPacketMeshNearest(const ray* prays, unsigned int n, const mesh* pmesh, ray_hit* phits, unsigned int)
+{
+	if (!prays || !pmesh || !phits || n == 0)
+		return;
+
+	for (unsigned int i = 0; i < n; ++i)
+		_RayMeshNearest(&prays[i], pmesh, &phits[i]);
+}
+#endif
+
+GEO_NMSPACE_END
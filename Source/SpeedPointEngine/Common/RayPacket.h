@@ -0,0 +1,48 @@
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+//	SpeedPoint Game Engine
+//	Copyright (c) 2011-2018 Pascal Rosenkranz, All rights reserved.
+//
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include "geo.h"
+
+// Number of rays that are traced together at most. Packets are made of groups of 4 rays (one SSE register per component).
+#define RAY_PACKET_MAX_SIZE 16
+
+GEO_NMSPACE_BEG
+
+// Nearest hit of a ray with a mesh
+struct ray_hit
+{
+	float t; // hit point = ray.p + t * ray.v. FLT_MAX if the ray missed
+	unsigned int tri; // start index of the hit triangle in the indices array of the mesh
+	float u, v; // barycentric coordinates of the hit point: (1 - u - v) * p0 + u * p1 + v * p2
+
+	ray_hit() : t(FLT_MAX), tri(0), u(0), v(0) {}
+	bool hit() const { return t < FLT_MAX; }
+};
+
+// Summary:
+//	Finds the nearest intersection of the ray p + t * v, t >= 0, with the mesh by traversing its BVH.
+//	Rays never hit meshes without a BVH, see mesh::CreateTree().
+//	The ray is given in world space and t is the same in mesh and world space.
+//	Unlike _Intersection(mesh, ray), which stops at any hit of the infinite line, this returns the nearest
+//	hit in front of the ray origin and does not clone the ray.
+// Returns:
+//	true if the ray hit the mesh
+bool _RayMeshNearest(const ray* pray, const mesh* pmesh, ray_hit* phit);
+
+// Summary:
+//	Same as _RayMeshNearest() for n rays. phits must have room for n hits.
+//	The rays are traced in packets of packetSize (4, 8 or 16) consecutive rays, which traverse the
+//	BVH together: a node is visited once for all rays of the packet that hit its bound box and its
+//	triangles are tested against 4 rays at a time (SIMD slab and Moeller-Trumbore tests).
+//	Only use this for coherent rays - similar origins and directions, e.g. picking rays of neighbouring pixels.
+//	The hits are the same as with _RayMeshNearest(), but incoherent packets visit the nodes of all their rays
+//	and are slower than tracing the rays one by one.
+void _RayPacketMeshNearest(const ray* prays, unsigned int n, const mesh* pmesh, ray_hit* phits, unsigned int packetSize = 8);
+
+GEO_NMSPACE_END
@@ -0,0 +1,79 @@
+//////////////////////////////////////////////////////////////////////////////////////////////////
+//
+//	SpeedPoint Game Engine
+//	Copyright (c) 2011-2018 Pascal Rosenkranz, All rights reserved.
+//
+//////////////////////////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+// Compile-time selection of the SIMD backend of the math library:
+//
+//	SP_MATH_SSE - SSE2 baseline. Enabled on x64 and on x86 with /arch:SSE2 or higher.
+//	SP_MATH_AVX - Additionally use AVX where it pays off. Enabled with /arch:AVX or higher.
+//
+// Define SP_MATH_NO_SIMD before including any math header (or in the project settings)
+// to force the scalar reference implementations.
+// Only use unaligned loads and stores, so that the memory layout of the math types stays untouched.
+
+#if !defined(SP_MATH_NO_SIMD) && (defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2) || defined(__SSE2__))
+#define SP_MATH_SSE 1
+#include <emmintrin.h>
+
+#if defined(__AVX__)
+#define SP_MATH_AVX 1
+#include <immintrin.h>
+#endif
+#endif
+
+#ifdef SP_MATH_SSE
+
+// Lane-wise sign flips for _mm_xor_ps: (+, -, +, -), (+, +, -, -), (-, +, +, -)
+#define SP_SIMD_SIGNMASK_PNPN _mm_castsi128_ps(_mm_set_epi32(0x80000000, 0, 0x80000000, 0))
+#define SP_SIMD_SIGNMASK_PPNN _mm_castsi128_ps(_mm_set_epi32(0x80000000, 0x80000000, 0, 0))
+#define SP_SIMD_SIGNMASK_NPPN _mm_castsi128_ps(_mm_set_epi32(0x80000000, 0, 0, 0x80000000))
+
+// Clears the w lane
+#define SP_SIMD_MASK_XYZ _mm_castsi128_ps(_mm_set_epi32(0, -1, -1, -1))
+
+// Broadcasts lane i of v to all lanes
+#define SP_SIMD_SPLAT(v, i) _mm_shuffle_ps((v), (v), _MM_SHUFFLE(i, i, i, i))
+
+// Returns (a.yzx * b.zxy - a.zxy * b.yzx). The w lane is 0 if the w lanes of a and b are finite.
+inline __m128 SIMDCross3(__m128 a, __m128 b)
+{
+	__m128 a_yzx = _mm_shuffle_ps(a, a, _MM_SHUFFLE(3, 0, 2, 1));
+	__m128 b_yzx = _mm_shuffle_ps(b, b, _MM_SHUFFLE(3, 0, 2, 1));
+	__m128 c = _mm_sub_ps(_mm_mul_ps(a, b_yzx), _mm_mul_ps(a_yzx, b));
+	return _mm_shuffle_ps(c, c, _MM_SHUFFLE(3, 0, 2, 1));
+}
+
+// Returns the dot product of the xyz lanes in all lanes
+inline __m128 SIMDDot3(__m128 a, __m128 b)
+{
+	__m128 p = _mm_mul_ps(a, b);
+	__m128 x = SP_SIMD_SPLAT(p, 0), y = SP_SIMD_SPLAT(p, 1), z = SP_SIMD_SPLAT(p, 2);
+	return _mm_add_ps(_mm_add_ps(x, y), z);
+}
+
+// Loads 4 packed 3-component vectors (12 floats) and transposes them to x0..x3, y0..y3, z0..z3
+inline void SIMDLoadSoA3(const float* pf, __m128& x, __m128& y, __m128& z)
+{
+	__m128 a = _mm_loadu_ps(pf);		// x0 y0 z0 x1
+	__m128 b = _mm_loadu_ps(pf + 4);	// y1 z1 x2 y2
+	__m128 c = _mm_loadu_ps(pf + 8);	// z2 x3 y3 z3
+
+	x = _mm_shuffle_ps(a, _mm_shuffle_ps(b, c, _MM_SHUFFLE(0, 1, 0, 2)), _MM_SHUFFLE(2, 0, 3, 0));
+	y = _mm_shuffle_ps(_mm_shuffle_ps(a, b, _MM_SHUFFLE(0, 0, 1, 1)), _mm_shuffle_ps(b, c, _MM_SHUFFLE(2, 2, 3, 3)), _MM_SHUFFLE(2, 0, 2, 0));
+	z = _mm_shuffle_ps(_mm_shuffle_ps(a, b, _MM_SHUFFLE(1, 1, 2, 2)), _mm_shuffle_ps(c, c, _MM_SHUFFLE(3, 3, 0, 0)), _MM_SHUFFLE(2, 0, 2, 0));
+}
+
+// Inverse of SIMDLoadSoA3()
+inline void SIMDStoreSoA3(float* pf, __m128 x, __m128 y, __m128 z)
+{
+	_mm_storeu_ps(pf, _mm_shuffle_ps(_mm_shuffle_ps(x, y, _MM_SHUFFLE(0, 0, 0, 0)), _mm_shuffle_ps(z, x, _MM_SHUFFLE(1, 1, 0, 0)), _MM_SHUFFLE(2, 0, 2, 0)));
+	_mm_storeu_ps(pf + 4, _mm_shuffle_ps(_mm_shuffle_ps(y, z, _MM_SHUFFLE(1, 1, 1, 1)), _mm_shuffle_ps(x, y, _MM_SHUFFLE(2, 2, 2, 2)), _MM_SHUFFLE(2, 0, 2, 0)));
+	_mm_storeu_ps(pf + 8, _mm_shuffle_ps(_mm_shuffle_ps(z, x, _MM_SHUFFLE(3, 3, 2, 2)), _mm_shuffle_ps(y, z, _MM_SHUFFLE(3, 3, 3, 3)), _MM_SHUFFLE(2, 0, 2, 0)));
+}
+
+#endif
@@ -36,8 +36,6 @@ using std::vector;
 #include "SResult.h"	// SResult, IExceptionProxy
 #include "SAssert.h"	// including IS_VALID_PTR
 
-#include "SPoolIndex.h"
-
 #include <string>
 #include "strutils.h"
 #include <sstream>
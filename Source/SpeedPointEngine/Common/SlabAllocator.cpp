@@ -0,0 +1,158 @@
+//////////////////////////////////////////////////////////////////////////////////////////////////
+//
+//	SpeedPoint Game Engine
+//	Copyright (c) 2011-2018 Pascal Rosenkranz, All rights reserved.
+//
+//////////////////////////////////////////////////////////////////////////////////////////////////
+
+#include "SlabAllocator.h"
+#include "MemoryTracker.h"
+#include <malloc.h>
+
+SP_NMSPACE_BEG
+
+S_API SlabAllocator::SlabAllocator()
+	: m_BlockSize(0),
+	m_BlocksPerSlab(0),
+	m_pFreeList(0),
+	m_NumUsedBlocks(0)
+{
+}
+
+S_API SlabAllocator::SlabAllocator(size_t blockSize, unsigned int blocksPerSlab /*= 64*/)
+	: m_pFreeList(0),
+	m_NumUsedBlocks(0)
+{
+	Init(blockSize, blocksPerSlab);
+}
+
+S_API SlabAllocator::~SlabAllocator()
+{
+	Clear();
+}
+
+S_API void SlabAllocator::Init(size_t blockSize, unsigned int blocksPerSlab /*= 64*/)
+{
+	if (blockSize < sizeof(SFreeBlock))
+		blockSize = sizeof(SFreeBlock);
+
+	m_BlockSize = (blockSize + SLAB_BLOCK_ALIGNMENT - 1) & ~(size_t)(SLAB_BLOCK_ALIGNMENT - 1);
+	m_BlocksPerSlab = (blocksPerSlab > 0 ? blocksPerSlab : 1);
+}
+
+S_API void SlabAllocator::AddSlab()
+{
+	char* pSlab = (char*)_aligned_malloc(m_BlockSize * m_BlocksPerSlab, SLAB_BLOCK_ALIGNMENT);
+	m_Slabs.push_back(pSlab);
+	MemoryTracker::OnAlloc(eMEMTAG_SMALL_OBJECTS, m_BlockSize * m_BlocksPerSlab);
+
+#if SLAB_POISON
+	memset(pSlab, 0xDD, m_BlockSize * m_BlocksPerSlab);
+#endif
+
+	// Link in reverse, so that blocks are handed out in address order
+	for (unsigned int i = m_BlocksPerSlab; i > 0; --i)
+	{
+		SFreeBlock* pBlock = (SFreeBlock*)(pSlab + (i - 1) * m_BlockSize);
+		pBlock->pNext = m_pFreeList;
+		m_pFreeList = pBlock;
+	}
+}
+
+S_API void* SlabAllocator::Allocate()
+{
+	if (!m_pFreeList)
+		AddSlab();
+
+	SFreeBlock* pBlock = m_pFreeList;
+	m_pFreeList = pBlock->pNext;
+	++m_NumUsedBlocks;
+
+#if SLAB_POISON
+	memset(pBlock, 0xCD, m_BlockSize);
+#endif
+
+	return pBlock;
+}
+
+S_API void SlabAllocator::Free(void* p)
+{
+	if (!p)
+		return;
+
+#if SLAB_POISON
+	memset(p, 0xDD, m_BlockSize);
+#endif
+
+	SFreeBlock* pBlock = (SFreeBlock*)p;
+	pBlock->pNext = m_pFreeList;
+	m_pFreeList = pBlock;
+	--m_NumUsedBlocks;
+}
+
+S_API void SlabAllocator::Clear()
+{
+	for (auto itSlab = m_Slabs.begin(); itSlab != m_Slabs.end(); ++itSlab)
+	{
+		MemoryTracker::OnFree(eMEMTAG_SMALL_OBJECTS, m_BlockSize * m_BlocksPerSlab);
+		_aligned_free(*itSlab);
+	}
+
+	m_Slabs.clear();
+	m_pFreeList = 0;
+	m_NumUsedBlocks = 0;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////
+
+S_API SmallObjectAllocator::SmallObjectAllocator()
+{
+	for (unsigned int i = 0; i < SMALL_OBJECT_NUM_SIZE_CLASSES; ++i)
+	{
+		size_t blockSize = (i + 1) * SLAB_BLOCK_ALIGNMENT;
+
+		// Roughly 4KB per slab
+		m_SizeClasses[i].Init(blockSize, (unsigned int)(4096 / blockSize));
+	}
+}
+
+S_API void* SmallObjectAllocator::Allocate(size_t sz)
+{
+	if (sz == 0 || sz > SMALL_OBJECT_MAX_SIZE)
+		return _aligned_malloc(sz > 0 ? sz : 1, SLAB_BLOCK_ALIGNMENT);
+
+	std::lock_guard<std::mutex> lock(m_Mutex);
+	return m_SizeClasses[GetSizeClass(sz)].Allocate();
+}
+
+S_API void SmallObjectAllocator::Free(void* p, size_t sz)
+{
+	if (!p)
+		return;
+
+	if (sz == 0 || sz > SMALL_OBJECT_MAX_SIZE)
+	{
+		_aligned_free(p);
+		return;
+	}
+
+	std::lock_guard<std::mutex> lock(m_Mutex);
+	m_SizeClasses[GetSizeClass(sz)].Free(p);
+}
+
+S_API unsigned int SmallObjectAllocator::GetNumUsedBlocks(size_t sz) const
+{
+	if (sz == 0 || sz > SMALL_OBJECT_MAX_SIZE)
+		return 0;
+
+	return m_SizeClasses[GetSizeClass(sz)].GetNumUsedBlocks();
+}
+
+S_API SmallObjectAllocator* SmallObjectAllocator::Get()
+{
+	// Never destroyed, so that objects freed during static destruction are still valid
+	static SmallObjectAllocator* pInstance = new SmallObjectAllocator();
+	return pInstance;
+}
+
+SP_NMSPACE_END
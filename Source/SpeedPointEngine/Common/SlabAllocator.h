@@ -0,0 +1,102 @@
+//////////////////////////////////////////////////////////////////////////////////////////////////
+//
+//	SpeedPoint Game Engine
+//	Copyright (c) 2011-2018 Pascal Rosenkranz, All rights reserved.
+//
+//////////////////////////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include "SPrerequisites.h"
+#include <mutex>
+
+SP_NMSPACE_BEG
+
+#define SLAB_BLOCK_ALIGNMENT 16
+
+// Poisoning fills freed blocks with 0xDD and newly allocated blocks with 0xCD,
+// so that use-after-free and uninitialized reads show up quickly.
+#ifndef SLAB_POISON
+#ifdef _DEBUG
+#define SLAB_POISON 1
+#else
+#define SLAB_POISON 0
+#endif
+#endif
+
+// Summary:
+//	Allocator for blocks of one fixed size.
+// Description:
+//	Blocks are carved out of slabs, which are never freed until Clear() is called.
+//	Free blocks are linked in an intrusive free list (the link is stored in the free block
+//	itself), so both Allocate() and Free() are O(1). Blocks are 16-byte aligned.
+//	Not thread-safe.
+class S_API SlabAllocator
+{
+private:
+	struct SFreeBlock
+	{
+		SFreeBlock* pNext;
+	};
+
+	size_t m_BlockSize;
+	unsigned int m_BlocksPerSlab;
+	SFreeBlock* m_pFreeList;
+	vector<char*> m_Slabs;
+	unsigned int m_NumUsedBlocks;
+
+	void AddSlab();
+
+public:
+	SlabAllocator();
+	SlabAllocator(size_t blockSize, unsigned int blocksPerSlab = 64);
+	~SlabAllocator();
+
+	// Must be called before the first allocation. The block size is rounded up to the alignment.
+	void Init(size_t blockSize, unsigned int blocksPerSlab = 64);
+
+	// Returns a block of GetBlockSize() bytes. Never returns 0.
+	void* Allocate();
+
+	// p must have been returned by Allocate() of this allocator.
+	void Free(void* p);
+
+	// Frees all slabs. All blocks are invalidated.
+	void Clear();
+
+	size_t GetBlockSize() const { return m_BlockSize; }
+	unsigned int GetNumUsedBlocks() const { return m_NumUsedBlocks; }
+	unsigned int GetNumSlabs() const { return (unsigned int)m_Slabs.size(); }
+};
+
+
+#define SMALL_OBJECT_MAX_SIZE 256
+#define SMALL_OBJECT_NUM_SIZE_CLASSES (SMALL_OBJECT_MAX_SIZE / SLAB_BLOCK_ALIGNMENT)
+
+// Summary:
+//	Small object allocator with one SlabAllocator per size class (16, 32, ..., 256 bytes).
+//	Larger requests fall back to the heap. The caller must pass the same size to Free()
+//	that it passed to Allocate(), which is what sized operator delete does.
+//	Thread-safe.
+class S_API SmallObjectAllocator
+{
+private:
+	SlabAllocator m_SizeClasses[SMALL_OBJECT_NUM_SIZE_CLASSES];
+	std::mutex m_Mutex;
+
+	static unsigned int GetSizeClass(size_t sz) { return (unsigned int)((sz + SLAB_BLOCK_ALIGNMENT - 1) / SLAB_BLOCK_ALIGNMENT) - 1; }
+
+public:
+	SmallObjectAllocator();
+
+	void* Allocate(size_t sz);
+	void Free(void* p, size_t sz);
+
+	// Returns the number of used blocks of the size class that contains sz
+	unsigned int GetNumUsedBlocks(size_t sz) const;
+
+	// Returns the engine wide instance
+	static SmallObjectAllocator* Get();
+};
+
+SP_NMSPACE_END
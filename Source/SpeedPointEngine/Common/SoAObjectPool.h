@@ -0,0 +1,230 @@
+//////////////////////////////////////////////////////////////////////////////////////////////////
+//
+//	SpeedPoint Game Engine
+//	Copyright (c) 2011-2018 Pascal Rosenkranz, All rights reserved.
+//
+//////////////////////////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include "ChunkedObjectPool.h"
+#include <malloc.h>
+#include <new>
+#include <utility>
+
+#define SOA_STREAM_ALIGNMENT 16
+
+// Summary:
+//	Recursive storage of one contiguous, aligned array (stream) per field type.
+//	Elements [0, numElements) of each stream are constructed, the rest of the capacity is raw memory.
+template<typename... Fields>
+struct SoAStreams
+{
+	void Reallocate(unsigned int numElements, unsigned int capacity) {}
+	void ConstructElement(unsigned int i) {}
+	void RemoveElement(unsigned int i, unsigned int last) {}
+	void DestroyElements(unsigned int numElements) {}
+	void Free() {}
+};
+
+template<typename F, typename... Rest>
+struct SoAStreams<F, Rest...> : public SoAStreams<Rest...>
+{
+	F* stream;
+
+	SoAStreams() : stream(0) {}
+
+	void Reallocate(unsigned int numElements, unsigned int capacity)
+	{
+		F* oldStream = stream;
+		stream = (F*)_aligned_malloc(sizeof(F) * capacity, SOA_STREAM_ALIGNMENT);
+		if (oldStream)
+		{
+			for (unsigned int i = 0; i < numElements; ++i)
+			{
+				new (&stream[i]) F(std::move(oldStream[i]));
+				oldStream[i].~F();
+			}
+
+			_aligned_free(oldStream);
+		}
+
+		SoAStreams<Rest...>::Reallocate(numElements, capacity);
+	}
+
+	// Default constructs the element at index i, which must not be constructed yet
+	void ConstructElement(unsigned int i)
+	{
+		new (&stream[i]) F();
+		SoAStreams<Rest...>::ConstructElement(i);
+	}
+
+	// Moves the last element into index i and destroys the last element
+	void RemoveElement(unsigned int i, unsigned int last)
+	{
+		if (i != last)
+			stream[i] = std::move(stream[last]);
+
+		stream[last].~F();
+		SoAStreams<Rest...>::RemoveElement(i, last);
+	}
+
+	void DestroyElements(unsigned int numElements)
+	{
+		for (unsigned int i = 0; i < numElements; ++i)
+			stream[i].~F();
+
+		SoAStreams<Rest...>::DestroyElements(numElements);
+	}
+
+	// Frees the memory. The elements must be destroyed already.
+	void Free()
+	{
+		if (stream)
+			_aligned_free(stream);
+
+		stream = 0;
+		SoAStreams<Rest...>::Free();
+	}
+};
+
+// Resolves the type and the array of the I-th field
+template<unsigned int I, typename S>
+struct SoAStreamAccess;
+
+template<typename F, typename... Rest>
+struct SoAStreamAccess<0, SoAStreams<F, Rest...>>
+{
+	typedef F Type;
+	static F* Get(const SoAStreams<F, Rest...>& streams) { return streams.stream; }
+};
+
+template<unsigned int I, typename F, typename... Rest>
+struct SoAStreamAccess<I, SoAStreams<F, Rest...>> : public SoAStreamAccess<I - 1, SoAStreams<Rest...>>
+{
+};
+
+
+// Summary:
+//	Object pool that stores declared hot fields of its objects as structure-of-arrays.
+// Description:
+//	The objects themselves (T) are stored in a ChunkedObjectPool, so pointers to them are
+//	never invalidated. For each type in Fields, the pool additionally keeps one contiguous,
+//	16-byte aligned array with one element per used object. Element i of each stream belongs
+//	to GetAt(i). Releasing an object moves the hot data of the last object into the released
+//	slot, just like the dense array of the ChunkedObjectPool, so the streams stay packed and
+//	systems can iterate them linearly with for (i = 0; i < GetUsedObjectCount(); ++i).
+//
+//	Streams are addressed by the index of their field type in Fields. Name the indices with an enum
+//	next to the pool declaration instead of using plain numbers:
+//
+//		enum EBodyStream { eBODY_STREAM_POS = 0, eBODY_STREAM_VELOCITY };
+//		SoAObjectPool<SBody, Vec3f, Vec3f> bodies;
+//		Vec3f* pos = bodies.GetStream<eBODY_STREAM_POS>();
+//		Vec3f* v = bodies.GetStream<eBODY_STREAM_VELOCITY>();
+template<typename T, typename... Fields>
+class SoAObjectPool
+{
+private:
+	ChunkedObjectPool<T> m_Objects;
+	SoAStreams<Fields...> m_Streams;
+	unsigned int m_Capacity;
+
+public:
+	SoAObjectPool()
+		: m_Capacity(0) {}
+
+	~SoAObjectPool()
+	{
+		Clear();
+	}
+
+	unsigned int GetUsedObjectCount() const { return m_Objects.GetUsedObjectCount(); }
+
+	// Returns:
+	//	The object with the given index, 0 <= idx < GetUsedObjectCount(), or 0 if idx is invalid
+	T* GetAt(unsigned int idx) const { return m_Objects.GetAt(idx); }
+
+	// Returns:
+	//	The index of the object into the streams or UINT_MAX if the pointer is invalid.
+	//	The index changes if another object is released.
+	unsigned int GetIndex(const T* pObject) const { return m_Objects.GetIndex(pObject); }
+
+	// Returns:
+	//	The array of the I-th field. Only valid until the next call to Get().
+	template<unsigned int I>
+	typename SoAStreamAccess<I, SoAStreams<Fields...>>::Type* GetStream() const
+	{
+		return SoAStreamAccess<I, SoAStreams<Fields...>>::Get(m_Streams);
+	}
+
+	// Summary:
+	//	Returns a new object. Its fields are default constructed.
+	// Arguments:
+	//	pIndex - if not 0, set to the index of the new object into the streams
+	T* Get(unsigned int* pIndex = 0)
+	{
+		unsigned int idx = m_Objects.GetUsedObjectCount();
+		if (idx >= m_Capacity)
+		{
+			unsigned int newCapacity = (m_Capacity > 0 ? m_Capacity * 2 : 32);
+			m_Streams.Reallocate(idx, newCapacity);
+			m_Capacity = newCapacity;
+		}
+
+		T* pObject = m_Objects.Get();
+		if (!pObject)
+			return 0;
+
+		m_Streams.ConstructElement(idx);
+
+		if (pIndex)
+			*pIndex = idx;
+
+		return pObject;
+	}
+
+	// Summary:
+	//	Releases the object and moves the fields of the last object into its place.
+	void Release(T** ppObject)
+	{
+		if (!ppObject)
+			return;
+
+		unsigned int idx = m_Objects.GetIndex(*ppObject);
+		if (idx == UINT_MAX)
+			return;
+
+		m_Streams.RemoveElement(idx, m_Objects.GetUsedObjectCount() - 1);
+		m_Objects.Release(ppObject);
+	}
+
+	// Summary:
+	//	Moves the objects into as few chunks as possible, see ChunkedObjectPool::Compact().
+	//	Object indices and thus the streams are not affected.
+	// Returns:
+	//	The number of freed chunks
+	template<typename F>
+	unsigned int Compact(F onMove)
+	{
+		return m_Objects.Compact(onMove);
+	}
+
+	float GetFragmentation() const { return m_Objects.GetFragmentation(); }
+
+	// Releases all objects but keeps the allocated memory
+	void ReleaseAll()
+	{
+		m_Streams.DestroyElements(m_Objects.GetUsedObjectCount());
+		m_Objects.ReleaseAll();
+	}
+
+	// Frees all memory. All pointers are invalidated.
+	void Clear()
+	{
+		m_Streams.DestroyElements(m_Objects.GetUsedObjectCount());
+		m_Objects.Clear();
+		m_Streams.Free();
+		m_Capacity = 0;
+	}
+};
@@ -0,0 +1,233 @@
+//////////////////////////////////////////////////////////////////////////////////////////////////
+//
+//	SpeedPoint Game Engine
+//	Copyright (c) 2011-2018 Pascal Rosenkranz, All rights reserved.
+//
+//////////////////////////////////////////////////////////////////////////////////////////////////
+
+#include "TransformBatch.h"
+#include "BoundBox.h"
+
+SP_NMSPACE_BEG
+
+// Returns the scale of the largest basis vector (column) of mtx
+static float GetMaxAxisScale(const Mat44& mtx)
+{
+	float sx = mtx._11 * mtx._11 + mtx._21 * mtx._21 + mtx._31 * mtx._31;
+	float sy = mtx._12 * mtx._12 + mtx._22 * mtx._22 + mtx._32 * mtx._32;
+	float sz = mtx._13 * mtx._13 + mtx._23 * mtx._23 + mtx._33 * mtx._33;
+	float s = (sx > sy ? sx : sy);
+	return sqrtf(s > sz ? s : sz);
+}
+
+#ifdef SP_MATH_SSE
+
+static_assert(sizeof(Vec3f) == 3 * sizeof(float), "Batch transforms expect Vec3f to be packed");
+static_assert(sizeof(AABB) == 2 * sizeof(Vec3f), "Batch transforms expect AABB to be packed");
+static_assert(sizeof(BoundSphere) == 4 * sizeof(float), "Batch transforms expect BoundSphere to be packed");
+
+// Loads 4 consecutive Vec3f and transposes them to x0..x3, y0..y3, z0..z3
+static inline void LoadSoA(const Vec3f* p, __m128& x, __m128& y, __m128& z)
+{
+	SIMDLoadSoA3(&p->x, x, y, z);
+}
+
+// Inverse of LoadSoA()
+static inline void StoreSoA(Vec3f* p, __m128 x, __m128 y, __m128 z)
+{
+	SIMDStoreSoA3(&p->x, x, y, z);
+}
+
+// Matrix entries of the upper 3x4 part, each splatted to all lanes
+struct SSplatMatrix
+{
+	__m128 m[3][4];
+
+	SSplatMatrix(const Mat44& mtx)
+	{
+		for (int i = 0; i < 3; ++i)
+			for (int j = 0; j < 4; ++j)
+				m[i][j] = _mm_set1_ps(mtx.m[i][j]);
+	}
+
+	// Same summation order as Mat44 * Vec4f, so the result is bit-exact
+	inline void TransformPoints(__m128& x, __m128& y, __m128& z) const
+	{
+		__m128 ox = _mm_add_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(m[0][0], x), _mm_mul_ps(m[0][1], y)), _mm_mul_ps(m[0][2], z)), m[0][3]);
+		__m128 oy = _mm_add_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(m[1][0], x), _mm_mul_ps(m[1][1], y)), _mm_mul_ps(m[1][2], z)), m[1][3]);
+		__m128 oz = _mm_add_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(m[2][0], x), _mm_mul_ps(m[2][1], y)), _mm_mul_ps(m[2][2], z)), m[2][3]);
+		x = ox; y = oy; z = oz;
+	}
+
+	inline void TransformDirections(__m128& x, __m128& y, __m128& z) const
+	{
+		__m128 ox = _mm_add_ps(_mm_add_ps(_mm_mul_ps(m[0][0], x), _mm_mul_ps(m[0][1], y)), _mm_mul_ps(m[0][2], z));
+		__m128 oy = _mm_add_ps(_mm_add_ps(_mm_mul_ps(m[1][0], x), _mm_mul_ps(m[1][1], y)), _mm_mul_ps(m[1][2], z));
+		__m128 oz = _mm_add_ps(_mm_add_ps(_mm_mul_ps(m[2][0], x), _mm_mul_ps(m[2][1], y)), _mm_mul_ps(m[2][2], z));
+		x = ox; y = oy; z = oz;
+	}
+
+	// Half extents: |M| * e
+	inline void TransformExtents(__m128& x, __m128& y, __m128& z) const
+	{
+		const __m128 absMask = _mm_castsi128_ps(_mm_set1_epi32(0x7fffffff));
+		__m128 ox = _mm_add_ps(_mm_add_ps(_mm_mul_ps(_mm_and_ps(m[0][0], absMask), x), _mm_mul_ps(_mm_and_ps(m[0][1], absMask), y)), _mm_mul_ps(_mm_and_ps(m[0][2], absMask), z));
+		__m128 oy = _mm_add_ps(_mm_add_ps(_mm_mul_ps(_mm_and_ps(m[1][0], absMask), x), _mm_mul_ps(_mm_and_ps(m[1][1], absMask), y)), _mm_mul_ps(_mm_and_ps(m[1][2], absMask), z));
+		__m128 oz = _mm_add_ps(_mm_add_ps(_mm_mul_ps(_mm_and_ps(m[2][0], absMask), x), _mm_mul_ps(_mm_and_ps(m[2][1], absMask), y)), _mm_mul_ps(_mm_and_ps(m[2][2], absMask), z));
+		x = ox; y = oy; z = oz;
+	}
+};
+
+#endif
+
+// Single AABB, also used for the remainder of the batch
+static inline void TransformAABB(const Mat44& mtx, const AABB& in, AABB& out)
+{
+	Vec3f c = (in.vMax + in.vMin) * 0.5f;
+	Vec3f e = (in.vMax - in.vMin) * 0.5f;
+
+	Vec3f tc, te;
+	for (int i = 0; i < 3; ++i)
+	{
+		tc[i] = mtx.m[i][0] * c.x + mtx.m[i][1] * c.y + mtx.m[i][2] * c.z + mtx.m[i][3];
+		te[i] = fabsf(mtx.m[i][0]) * e.x + fabsf(mtx.m[i][1]) * e.y + fabsf(mtx.m[i][2]) * e.z;
+	}
+
+	out.vMin = tc - te;
+	out.vMax = tc + te;
+}
+
+S_API void TransformPoints(const Mat44& mtx, const Vec3f* pIn, Vec3f* pOut, unsigned int n)
+{
+	unsigned int i = 0;
+#ifdef SP_MATH_SSE
+	SSplatMatrix m(mtx);
+	__m128 x, y, z;
+	for (; i + 4 <= n; i += 4)
+	{
+		LoadSoA(pIn + i, x, y, z);
+		m.TransformPoints(x, y, z);
+		StoreSoA(pOut + i, x, y, z);
+	}
+#endif
+
+	for (; i < n; ++i)
+		pOut[i] = (mtx * Vec4f(pIn[i], 1.0f)).xyz();
+}
+
+S_API void TransformDirections(const Mat44& mtx, const Vec3f* pIn, Vec3f* pOut, unsigned int n)
+{
+	unsigned int i = 0;
+#ifdef SP_MATH_SSE
+	SSplatMatrix m(mtx);
+	__m128 x, y, z;
+	for (; i + 4 <= n; i += 4)
+	{
+		LoadSoA(pIn + i, x, y, z);
+		m.TransformDirections(x, y, z);
+		StoreSoA(pOut + i, x, y, z);
+	}
+#endif
+
+	for (; i < n; ++i)
+		pOut[i] = (mtx * Vec4f(pIn[i], 0.0f)).xyz();
+}
+
+S_API void TransformAABBs(const Mat44& mtx, const AABB* pIn, AABB* pOut, unsigned int n)
+{
+	unsigned int i = 0;
+#ifdef SP_MATH_SSE
+	SSplatMatrix m(mtx);
+	const __m128 half = _mm_set1_ps(0.5f);
+	for (; i + 4 <= n; i += 4)
+	{
+		// Each load yields (min, max, min, max) of two AABBs
+		__m128 x01, y01, z01, x23, y23, z23;
+		LoadSoA(&pIn[i].vMin, x01, y01, z01);
+		LoadSoA(&pIn[i + 2].vMin, x23, y23, z23);
+
+		__m128 minX = _mm_shuffle_ps(x01, x23, _MM_SHUFFLE(2, 0, 2, 0)), maxX = _mm_shuffle_ps(x01, x23, _MM_SHUFFLE(3, 1, 3, 1));
+		__m128 minY = _mm_shuffle_ps(y01, y23, _MM_SHUFFLE(2, 0, 2, 0)), maxY = _mm_shuffle_ps(y01, y23, _MM_SHUFFLE(3, 1, 3, 1));
+		__m128 minZ = _mm_shuffle_ps(z01, z23, _MM_SHUFFLE(2, 0, 2, 0)), maxZ = _mm_shuffle_ps(z01, z23, _MM_SHUFFLE(3, 1, 3, 1));
+
+		__m128 cx = _mm_mul_ps(_mm_add_ps(maxX, minX), half), ex = _mm_mul_ps(_mm_sub_ps(maxX, minX), half);
+		__m128 cy = _mm_mul_ps(_mm_add_ps(maxY, minY), half), ey = _mm_mul_ps(_mm_sub_ps(maxY, minY), half);
+		__m128 cz = _mm_mul_ps(_mm_add_ps(maxZ, minZ), half), ez = _mm_mul_ps(_mm_sub_ps(maxZ, minZ), half);
+
+		m.TransformPoints(cx, cy, cz);
+		m.TransformExtents(ex, ey, ez);
+
+		minX = _mm_sub_ps(cx, ex); maxX = _mm_add_ps(cx, ex);
+		minY = _mm_sub_ps(cy, ey); maxY = _mm_add_ps(cy, ey);
+		minZ = _mm_sub_ps(cz, ez); maxZ = _mm_add_ps(cz, ez);
+
+		StoreSoA(&pOut[i].vMin, _mm_unpacklo_ps(minX, maxX), _mm_unpacklo_ps(minY, maxY), _mm_unpacklo_ps(minZ, maxZ));
+		StoreSoA(&pOut[i + 2].vMin, _mm_unpackhi_ps(minX, maxX), _mm_unpackhi_ps(minY, maxY), _mm_unpackhi_ps(minZ, maxZ));
+	}
+#endif
+
+	for (; i < n; ++i)
+		TransformAABB(mtx, pIn[i], pOut[i]);
+}
+
+S_API void TransformAABBs(const Mat44* const* ppTransforms, const AABB* pIn, AABB* pOut, unsigned int n)
+{
+	for (unsigned int i = 0; i < n; ++i)
+	{
+#ifdef SP_MATH_SSE
+		// One matrix per AABB, so work on the columns of the matrix instead
+		const Mat44& mtx = *ppTransforms[i];
+		__m128 c0 = _mm_loadu_ps(mtx.m[0]), c1 = _mm_loadu_ps(mtx.m[1]), c2 = _mm_loadu_ps(mtx.m[2]), c3 = _mm_loadu_ps(mtx.m[3]);
+		_MM_TRANSPOSE4_PS(c0, c1, c2, c3);
+
+		const AABB& in = pIn[i];
+		const __m128 absMask = _mm_castsi128_ps(_mm_set1_epi32(0x7fffffff));
+		Vec3f c = (in.vMax + in.vMin) * 0.5f;
+		Vec3f e = (in.vMax - in.vMin) * 0.5f;
+
+		__m128 tc = _mm_add_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(c0, _mm_set1_ps(c.x)), _mm_mul_ps(c1, _mm_set1_ps(c.y))), _mm_mul_ps(c2, _mm_set1_ps(c.z))), c3);
+		__m128 te = _mm_add_ps(_mm_add_ps(_mm_mul_ps(_mm_and_ps(c0, absMask), _mm_set1_ps(e.x)), _mm_mul_ps(_mm_and_ps(c1, absMask), _mm_set1_ps(e.y))), _mm_mul_ps(_mm_and_ps(c2, absMask), _mm_set1_ps(e.z)));
+
+		float vmin[4], vmax[4];
+		_mm_storeu_ps(vmin, _mm_sub_ps(tc, te));
+		_mm_storeu_ps(vmax, _mm_add_ps(tc, te));
+		pOut[i].vMin = Vec3f(vmin[0], vmin[1], vmin[2]);
+		pOut[i].vMax = Vec3f(vmax[0], vmax[1], vmax[2]);
+#else
+		TransformAABB(*ppTransforms[i], pIn[i], pOut[i]);
+#endif
+	}
+}
+
+S_API void TransformSpheres(const Mat44& mtx, const BoundSphere* pIn, BoundSphere* pOut, unsigned int n)
+{
+	float scale = GetMaxAxisScale(mtx);
+	unsigned int i = 0;
+#ifdef SP_MATH_SSE
+	SSplatMatrix m(mtx);
+	const __m128 vscale = _mm_set1_ps(scale);
+	for (; i + 4 <= n; i += 4)
+	{
+		// (c.x, c.y, c.z, r) per sphere, so a plain 4x4 transpose yields SoA layout
+		__m128 x = _mm_loadu_ps(&pIn[i].c.x), y = _mm_loadu_ps(&pIn[i + 1].c.x), z = _mm_loadu_ps(&pIn[i + 2].c.x), r = _mm_loadu_ps(&pIn[i + 3].c.x);
+		_MM_TRANSPOSE4_PS(x, y, z, r);
+
+		m.TransformPoints(x, y, z);
+		r = _mm_mul_ps(r, vscale);
+
+		_MM_TRANSPOSE4_PS(x, y, z, r);
+		_mm_storeu_ps(&pOut[i].c.x, x);
+		_mm_storeu_ps(&pOut[i + 1].c.x, y);
+		_mm_storeu_ps(&pOut[i + 2].c.x, z);
+		_mm_storeu_ps(&pOut[i + 3].c.x, r);
+	}
+#endif
+
+	for (; i < n; ++i)
+	{
+		pOut[i].c = (mtx * Vec4f(pIn[i].c, 1.0f)).xyz();
+		pOut[i].r = pIn[i].r * scale;
+	}
+}
+
+SP_NMSPACE_END
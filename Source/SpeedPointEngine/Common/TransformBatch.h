@@ -0,0 +1,45 @@
+//////////////////////////////////////////////////////////////////////////////////////////////////
+//
+//	SpeedPoint Game Engine
+//	Copyright (c) 2011-2018 Pascal Rosenkranz, All rights reserved.
+//
+//////////////////////////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include "SPrerequisites.h"
+#include "Mat44.h"
+
+SP_NMSPACE_BEG
+
+struct AABB;
+struct BoundSphere;
+
+// Batch transform kernels.
+// With SP_MATH_SSE, four elements are processed at a time: they are loaded, transposed to
+// structure-of-arrays layout (x0..x3, y0..y3, z0..z3), transformed and transposed back.
+// Input and output arrays may be the same, but must not overlap otherwise.
+
+// Summary:
+//	pOut[i] = (mtx * Vec4f(pIn[i], 1.0f)).xyz() for i in [0, n)
+//	Bit-exact with the single point transform.
+S_API void TransformPoints(const Mat44& mtx, const Vec3f* pIn, Vec3f* pOut, unsigned int n);
+
+// Summary:
+//	pOut[i] = (mtx * Vec4f(pIn[i], 0.0f)).xyz() for i in [0, n)
+S_API void TransformDirections(const Mat44& mtx, const Vec3f* pIn, Vec3f* pOut, unsigned int n);
+
+// Summary:
+//	Sets pOut[i] to the world-space AABB that encloses pIn[i] transformed by mtx (J. Arvo).
+S_API void TransformAABBs(const Mat44& mtx, const AABB* pIn, AABB* pOut, unsigned int n);
+
+// Summary:
+//	Same as above, but with one transformation per AABB: pOut[i] encloses pIn[i] transformed by *ppTransforms[i].
+S_API void TransformAABBs(const Mat44* const* ppTransforms, const AABB* pIn, AABB* pOut, unsigned int n);
+
+// Summary:
+//	Transforms the centers and scales the radii by the largest axis scale of mtx,
+//	so the result encloses the transformed sphere even for non-uniform scale.
+S_API void TransformSpheres(const Mat44& mtx, const BoundSphere* pIn, BoundSphere* pOut, unsigned int n);
+
+SP_NMSPACE_END
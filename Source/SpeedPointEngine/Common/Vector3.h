@@ -13,6 +13,7 @@
 
 #pragma once
 #include "SAPI.h"
+#include "MathTypes.h"
 #include <cmath>
 #include <ostream>
 
@@ -30,58 +31,36 @@ namespace SpeedPoint
 
 
 
-	// template math functions:
-
-	inline float finv(const float& f) { return 1.0f / f; }
-	inline double finv(const double& d) { return 1.0 / d; }
-	inline float sqrt_t(const float& f) { return sqrtf(f); }
-	inline double sqrt_t(const double& d) { return sqrt(d); }
+	template<typename F>
+	using Vec3 = Vec<3, F>;
 
 	// SpeedPoint 3-Dimensional Vector
+	// The operators are defined for all sizes in MathTypes.h
 	template<typename F>
-	struct S_API Vec3
+	struct S_API Vec<3, F>
 	{
 		F x, y, z;
 
-		Vec3() : x(0), y(0), z(0) {}
-		Vec3(F k) : x(k), y(k), z(k) {}
-		Vec3(F xx, F yy, F zz) : x(xx), y(yy), z(zz) {}
-		Vec3(const Vec3<F>& v) : x(v.x), y(v.y), z(v.z) {}
-
-		inline Vec3<F> operator -() const
-		{
-			return Vec3<F>(-x, -y, -z);
-		}
-
-		inline Vec3<F> operator +(const Vec3<F>& v) const { return Vec3<F>(x + v.x, y + v.y, z + v.z); }
-		inline Vec3<F> operator +(const F& k) const { return Vec3<F>(x + k, y + k, z + k); }
-		inline Vec3<F>& operator +=(const Vec3<F>& v) { x += v.x; y += v.y; z += v.z; return *this; }
-		inline Vec3<F>& operator +=(const F& k) { x += k; y += k; z += k; return *this; }
-
-		inline Vec3<F> operator -(const Vec3<F>& v) const { return Vec3<F>(x - v.x, y - v.y, z - v.z); }
-		inline Vec3<F> operator -(const F& k) const { return Vec3<F>(x - k, y - k, z - k); }
-		inline Vec3<F>& operator -=(const Vec3<F>& v) { x -= v.x; y -= v.y; z -= v.z; return *this; }
-		inline Vec3<F>& operator -=(const F& k) { x -= k; y -= k; z -= k; return *this; }
+		constexpr Vec() : x(0), y(0), z(0) {}
+		constexpr Vec(F k) : x(k), y(k), z(k) {}
+		constexpr Vec(F xx, F yy, F zz) : x(xx), y(yy), z(zz) {}
+		constexpr Vec(const Vec3<F>& v) : x(v.x), y(v.y), z(v.z) {}
 
-		inline Vec3<F> operator *(const Vec3<F>& v) const { return Vec3<F>(x * v.x, y * v.y, z * v.z); }
-		inline Vec3<F> operator *(const F& k) const { return Vec3<F>(x * k, y * k, z * k); }
-		inline Vec3<F>& operator *=(const Vec3<F>& v) { x *= v.x; y *= v.y; z *= v.z; return *this; }
-		inline Vec3<F>& operator *=(const F& k) { x *= k; y *= k; z *= k; return *this; }
+		// Converts between precisions, e.g. Vec3f(Vec3d)
+		template<typename G>
+		explicit constexpr Vec(const Vec3<G>& v) : x((F)v.x), y((F)v.y), z((F)v.z) {}
 
-		inline Vec3<F> operator /(const Vec3<F>& v) const { return Vec3<F>(x / v.x, y / v.y, z / v.z); }
-		inline Vec3<F> operator /(const F& k) const { F k_inv = finv(k); return Vec3<F>(x * k_inv, y * k_inv, z * k_inv); }
-		inline Vec3<F>& operator /=(const Vec3<F>& v) { x /= v.x; y /= v.y; z /= v.z; return *this; }
-		inline Vec3<F>& operator /=(const F& k) { F k_inv = finv(k); x *= k_inv; y *= k_inv; z *= k_inv; return *this; }
+		template<unsigned int I> constexpr const F& Get() const { return MathCore::SSelect<I>::Get(x, y, z); }
 
 		inline F& operator [](unsigned int i) { return ((F*)this)[i]; }
 		inline const F& operator [](unsigned int i) const { return ((F*)this)[i]; }
 
-		inline F Dot(const Vec3<F>& v) const
+		constexpr F Dot(const Vec3<F>& v) const
 		{
-			return x * v.x + y * v.y + z * v.z;
+			return SpeedPoint::Dot(*this, v);
 		}
 
-		inline Vec3<F> Cross(const Vec3<F>& v) const
+		constexpr Vec3<F> Cross(const Vec3<F>& v) const
 		{
 			return Vec3<F>(y * v.z - z * v.y,
 				z * v.x - x * v.z,
@@ -93,9 +72,9 @@ namespace SpeedPoint
 			return sqrt_t(x * x + y * y + z * z);
 		}
 
-		inline F LengthSq() const
+		constexpr F LengthSq() const
 		{
-			return x * x + y * y + z * z;
+			return SpeedPoint::Dot(*this, *this);
 		}
 
 		inline Vec3<F> Normalized() const
@@ -140,25 +119,25 @@ namespace SpeedPoint
 	};
 
 	template<typename F>
-	S_API inline F Vec3Dot(const Vec3<F>& v1, const Vec3<F>& v2)
+	S_API constexpr F Vec3Dot(const Vec3<F>& v1, const Vec3<F>& v2)
 	{
 		return v1.Dot(v2);
 	}
 
 	template<typename F>
-	S_API inline F operator | (const Vec3<F>& v1, const Vec3<F>& v2)
+	S_API constexpr F operator | (const Vec3<F>& v1, const Vec3<F>& v2)
 	{
 		return v1.Dot(v2);
 	}
 
 	template<typename F>
-	S_API inline Vec3<F> Vec3Cross(const Vec3<F>& v1, const Vec3<F>& v2)
+	S_API constexpr Vec3<F> Vec3Cross(const Vec3<F>& v1, const Vec3<F>& v2)
 	{
 		return v1.Cross(v2);
 	}
 
 	template<typename F>
-	S_API inline Vec3<F> operator ^(const Vec3<F>& v1, const Vec3<F>& v2)
+	S_API constexpr Vec3<F> operator ^(const Vec3<F>& v1, const Vec3<F>& v2)
 	{
 		return v1.Cross(v2);
 	}
@@ -176,26 +155,15 @@ namespace SpeedPoint
 	}
 
 	template<typename F>
-	S_API inline Vec3<F> Vec3Min(const Vec3<F>& a, const Vec3<F>& b)
+	S_API constexpr Vec3<F> Vec3Min(const Vec3<F>& a, const Vec3<F>& b)
 	{
-		return Vec3<F>(
-			a.x < b.x ? a.x : b.x,
-			a.y < b.y ? a.y : b.y,
-			a.z < b.z ? a.z : b.z);
+		return VecMin(a, b);
 	}
 
 	template<typename F>
-	S_API inline Vec3<F> Vec3Max(const Vec3<F>& a, const Vec3<F>& b)
-	{
-		return Vec3<F>(
-			a.x > b.x ? a.x : b.x,
-			a.y > b.y ? a.y : b.y,
-			a.z > b.z ? a.z : b.z);
-	}
-
-	template<typename F> S_API inline Vec3<F> operator *(F f, const Vec3<F>& v)
+	S_API constexpr Vec3<F> Vec3Max(const Vec3<F>& a, const Vec3<F>& b)
 	{
-		return v * f;
+		return VecMax(a, b);
 	}
 
 	template<typename F>
@@ -209,10 +177,10 @@ namespace SpeedPoint
 
 	// specific vectors
 
-	typedef struct Vec3<float> S_API Vec3f;
-	typedef struct Vec3<float> S_API SVector3;
-	typedef struct Vec3<float> S_API float3;
-	typedef struct Vec3<double> S_API Vec3d;
+	typedef Vec3<float> S_API Vec3f;
+	typedef Vec3<float> S_API SVector3;
+	typedef Vec3<float> S_API float3;
+	typedef Vec3<double> S_API Vec3d;
 
 
 	template<typename F>
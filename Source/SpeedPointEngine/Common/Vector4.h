@@ -13,9 +13,13 @@
 namespace SpeedPoint
 {
 
+	template<typename F>
+	using Vec4 = Vec<4, F>;
+
 	// SpeedPoint 4 Dimensional Vector
+	// The operators are defined for all sizes in MathTypes.h
 	template<typename F>
-	struct S_API Vec4
+	struct S_API Vec<4, F>
 	{		
 		struct
 		{
@@ -24,27 +28,19 @@ namespace SpeedPoint
 
 		// ---
 
-		Vec4<F>() : x(0), y(0), z(0), w(0) {}
+		constexpr Vec() : x(0), y(0), z(0), w(0) {}
 
-		Vec4<F>(const Vec3<F>& v, F ww) : x(v.x), y(v.y), z(v.z), w(ww) {}
+		constexpr Vec(const Vec3<F>& v, F ww) : x(v.x), y(v.y), z(v.z), w(ww) {}
 
-		Vec4<F>(F aa) : x(aa), y(aa), z(aa), w(aa) {}
+		constexpr Vec(F aa) : x(aa), y(aa), z(aa), w(aa) {}
 
-		Vec4<F>(F xx, F yy, F zz) : x(xx), y(yy), z(zz), w(0) {}
+		constexpr Vec(F xx, F yy, F zz) : x(xx), y(yy), z(zz), w(0) {}
 
-		Vec4<F>(F xx, F yy, F zz, F ww) : x(xx), y(yy), z(zz), w(ww) {}
+		constexpr Vec(F xx, F yy, F zz, F ww) : x(xx), y(yy), z(zz), w(ww) {}
 
 		// ---
 
-		Vec4<F>& operator += (const Vec4<F>& v) { this->x += v.x; this->y += v.y; this->z += v.z; this->w += v.w; return *this; }
-
-		Vec4<F>& operator -= (const Vec4<F>& v) { this->x -= v.x; this->y -= v.y; this->z -= v.z; this->w -= v.w; return *this; }
-
-		Vec4<F>& operator *= (const Vec4<F>& v) { this->x *= v.x; this->y *= v.y; this->z *= v.z; this->w *= v.w; return *this; }
-
-		Vec4<F>& operator /= (const Vec4<F>& v) { this->x /= v.x; this->y /= v.y; this->z /= v.z; this->w /= v.w; return *this; }
-
-		Vec4<F> operator - () { return Vec4<F>(-x, -y, -z, -w); }
+		template<unsigned int I> constexpr const F& Get() const { return MathCore::SSelect<I>::Get(x, y, z, w); }
 
 		Vec4<F>& operator = (const Vec4<F>& v)
 		{
@@ -55,57 +51,35 @@ namespace SpeedPoint
 			return *this;
 		}
 
-		Vec3<F> xyz() const
+		constexpr Vec3<F> xyz() const
 		{
 			return Vec3<F>(x, y, z);
 		}
 	};
 
-	typedef struct S_API Vec4<float> Vec4f;
-	typedef struct S_API Vec4<float> float4;
-	typedef struct S_API Vec4<float> SVector4;
-	typedef struct S_API Vec4<double> Vec4d;	
-
-	template<typename F> inline bool operator == (const Vec4<F>& v1, const Vec4<F>& v2) { return (v1.x == v2.x && v1.y == v2.y && v1.z == v2.z && v1.w == v2.w); }
-	template<typename F> inline Vec4<F> operator - (const Vec4<F>& va, const Vec4<F>& vb) { return Vec4<F>(va.x - vb.x, va.y - vb.y, va.z - vb.z, va.w - vb.w); }
-	template<typename F> inline Vec4<F> operator - (const Vec4<F>& va, const F& f) { return Vec4<F>(va.x - f, va.y - f, va.z - f, va.w - f); }
-	template<typename F> inline Vec4<F> operator - (const F& f, const Vec4<F>& va) { return Vec4<F>(f - va.x, f - va.y, f - va.z, f - va.w); }
-	template<typename F> inline Vec4<F> operator + (const Vec4<F>& va, const Vec4<F>& vb) { return Vec4<F>(va.x + vb.x, va.y + vb.y, va.z + vb.z, va.w + vb.w); }
-	template<typename F> inline Vec4<F> operator + (const Vec4<F>& va, const F& f) { return Vec4<F>(va.x + f, va.y + f, va.z + f, va.w + f); }
-	template<typename F> inline Vec4<F> operator + (const F& f, const Vec4<F>& va) { return Vec4<F>(va.x + f, va.y + f, va.z + f, va.w + f); }
-	template<typename F> inline Vec4<F> operator * (const Vec4<F>& va, const Vec4<F>& vb)
-	{
-		_mm_load_ps()
-		return Vec4<F>(va.x * vb.x, va.y * vb.y, va.z * vb.z, va.w * vb.w);
-	}
+	typedef Vec4<float> S_API Vec4f;
+	typedef Vec4<float> S_API float4;
+	typedef Vec4<float> S_API SVector4;
+	typedef Vec4<double> S_API Vec4d;
 
-	template<typename F> inline Vec4<F> operator * (const Vec4<F>& va, const F& f) { return Vec4<F>(va.x * f, va.y * f, va.z * f, va.w * f); }
-	template<typename F> inline Vec4<F> operator * (const F& f, const Vec4<F>& va) { return Vec4<F>(va.x * f, va.y * f, va.z * f, va.w * f); }
-	template<typename F> inline Vec4<F> operator / (const Vec4<F>& va, const Vec4<F>& vb) { return Vec4<F>(va.x / vb.x, va.y / vb.y, va.z / vb.z, va.w / vb.w); }
-	template<typename F> inline Vec4<F> operator / (const Vec4<F>& va, const F& f) { F finv = 1 / f; return Vec4<F>(va.x * finv, va.y * finv, va.z * finv, va.w * finv); }
-	template<typename F> inline Vec4<F> operator / (const F& f, const Vec4<F>& va) { return Vec4<F>(f / va.x, f / va.y, f / va.z, f / va.w); }	
+	// Summary:
+	//	16-byte aligned Vec4f, e.g. for arrays that are loaded with aligned SIMD loads.
+	//	Same size and layout, the operators of Vec4f apply and return Vec4f.
+	struct alignas(16) Vec4fA : Vec4f
+	{
+		using Vec4f::Vec4f;
+		constexpr Vec4fA() {}
+		constexpr Vec4fA(const Vec4f& v) : Vec4f(v) {}
+	};
 
-	template<typename F>
-	inline float Dot(const Vec4<F>& va, const Vec4<F>& vb) {
-		return va.x * vb.x + va.y * vb.y + va.z * vb.z + va.w * vb.w;
-	}
+	static_assert(sizeof(Vec4fA) == sizeof(Vec4f), "Vec4fA must not add padding");
 
 // Warning: SVector4Dot is deprecated and will be replaced by overloaded Dot()
 #define SVector4Dot SpeedPoint::Dot
 
-	template<typename F>
-	inline float Length(const Vec4<F>& v) {
-		return sqrtf(v.x * v.x + v.y * v.y + v.z * v.z + v.w * v.w);
-	}
-
 // Warning: SVector4Length is deprecated and will be replaced by overloaded Length()
 #define SVector4Length SpeedPoint::Length
 
-	template<typename F>
-	inline Vec4<F> Normalize(const Vec4<F>& v) {
-		return v / sqrtf(v.x * v.x + v.y * v.y + v.z * v.z + v.w * v.w);
-	}
-
 // Warning: SVector4Normalize is deprecated and will be replaced by overloaded Normalize()
 #define SVector4Normalize SpeedPoint::Normalize
 
@@ -118,4 +92,4 @@ namespace SpeedPoint
 
 }
 
-#define S_DEFAULT_VEC4 SpeedPoint::Vec4<float>()
\ No newline at end of file
+#define S_DEFAULT_VEC4 SpeedPoint::Vec4<float>()
@@ -1,9 +1,17 @@
 #include "geo.h"
+#include "BoundingVolumes.h"
+#include "GJK.h"
+#include "QHull.h"
 #include "ChunkedObjectPool.h"
+#include "SlabAllocator.h"
+#include "MemoryTracker.h"
 #include <Physics\Implementation\PhysDebug.h> // TODO: Get this out of here.
 #include <cstdlib>
 #include <time.h>
 #include <stack>
+#include <vector>
+#include <algorithm>
+#include <future>
 
 GEO_NMSPACE_BEG
 
@@ -58,12 +66,23 @@ const char* GetShapeTypeName(EShapeType t)
 	case eSHAPE_RAY: return "SHAPE_RAY";
 	case eSHAPE_SPHERE: return "SHAPE_SPHERE";
 	case eSHAPE_TRIANGLE: return "SHAPE_TRIANGLE";
+	case eSHAPE_CONVEX_HULL: return "SHAPE_CONVEX_HULL";
 	case eSHAPE_UNKNOWN: return "SHAPE_UNKNOWN";
 	default:
 		return "???";
 	}
 }
 
+void* shape::operator new(size_t sz)
+{
+	return SmallObjectAllocator::Get()->Allocate(sz);
+}
+
+void shape::operator delete(void* p, size_t sz)
+{
+	SmallObjectAllocator::Get()->Free(p, sz);
+}
+
 ///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 //
 //	General Intersection Test
@@ -85,6 +104,7 @@ void FillIntersectionTestTable()
 	_intersectionTestTable[eSHAPE_RAY][eSHAPE_MESH] = (_IntersectionTestFnPtr)&_ShapeMesh;
 	_intersectionTestTable[eSHAPE_RAY][eSHAPE_BOX] = (_IntersectionTestFnPtr)&_RayBox;
 	_intersectionTestTable[eSHAPE_RAY][eSHAPE_TERRAIN_MESH] = (_IntersectionTestFnPtr)&_ShapeTerrainMesh;
+	_intersectionTestTable[eSHAPE_RAY][eSHAPE_CONVEX_HULL] = (_IntersectionTestFnPtr)&_RayConvexHull;
 
 	_intersectionTestTable[eSHAPE_PLANE][eSHAPE_RAY] = (_IntersectionTestFnPtr)&_PlaneRay;
 	_intersectionTestTable[eSHAPE_PLANE][eSHAPE_PLANE] = (_IntersectionTestFnPtr)&_PlanePlane;
@@ -95,6 +115,7 @@ void FillIntersectionTestTable()
 	_intersectionTestTable[eSHAPE_PLANE][eSHAPE_MESH] = (_IntersectionTestFnPtr)&_ShapeMesh;
 	_intersectionTestTable[eSHAPE_PLANE][eSHAPE_BOX] = (_IntersectionTestFnPtr)&_PlaneBox;
 	_intersectionTestTable[eSHAPE_PLANE][eSHAPE_TERRAIN_MESH] = (_IntersectionTestFnPtr)&_ShapeTerrainMesh;
+	_intersectionTestTable[eSHAPE_PLANE][eSHAPE_CONVEX_HULL] = (_IntersectionTestFnPtr)&_PlaneConvexHull;
 
 	_intersectionTestTable[eSHAPE_SPHERE][eSHAPE_RAY] = (_IntersectionTestFnPtr)&_SphereRay;
 	_intersectionTestTable[eSHAPE_SPHERE][eSHAPE_PLANE] = (_IntersectionTestFnPtr)&_SpherePlane;
@@ -105,48 +126,60 @@ void FillIntersectionTestTable()
 	_intersectionTestTable[eSHAPE_SPHERE][eSHAPE_MESH] = (_IntersectionTestFnPtr)&_ShapeMesh;
 	_intersectionTestTable[eSHAPE_SPHERE][eSHAPE_BOX] = (_IntersectionTestFnPtr)&_SphereBox;
 	_intersectionTestTable[eSHAPE_SPHERE][eSHAPE_TERRAIN_MESH] = (_IntersectionTestFnPtr)&_ShapeTerrainMesh;
+	_intersectionTestTable[eSHAPE_SPHERE][eSHAPE_CONVEX_HULL] = (_IntersectionTestFnPtr)&_ConvexConvex;
 
 	_intersectionTestTable[eSHAPE_CYLINDER][eSHAPE_RAY] = (_IntersectionTestFnPtr)&_CylinderRay;
 	_intersectionTestTable[eSHAPE_CYLINDER][eSHAPE_PLANE] = 0;
 	_intersectionTestTable[eSHAPE_CYLINDER][eSHAPE_SPHERE] = (_IntersectionTestFnPtr)&_CylinderSphere;
 	_intersectionTestTable[eSHAPE_CYLINDER][eSHAPE_CYLINDER] = (_IntersectionTestFnPtr)&_CylinderCylinder;
-	_intersectionTestTable[eSHAPE_CYLINDER][eSHAPE_CAPSULE] = 0;
-	_intersectionTestTable[eSHAPE_CYLINDER][eSHAPE_TRIANGLE] = 0;
+	_intersectionTestTable[eSHAPE_CYLINDER][eSHAPE_CAPSULE] = (_IntersectionTestFnPtr)&_ConvexConvex;
+	_intersectionTestTable[eSHAPE_CYLINDER][eSHAPE_TRIANGLE] = (_IntersectionTestFnPtr)&_ConvexConvex;
+	_intersectionTestTable[eSHAPE_CYLINDER][eSHAPE_BOX] = (_IntersectionTestFnPtr)&_ConvexConvex;
 	_intersectionTestTable[eSHAPE_CYLINDER][eSHAPE_MESH] = (_IntersectionTestFnPtr)&_ShapeMesh;
 	_intersectionTestTable[eSHAPE_CYLINDER][eSHAPE_TERRAIN_MESH] = (_IntersectionTestFnPtr)&_ShapeTerrainMesh;
+	_intersectionTestTable[eSHAPE_CYLINDER][eSHAPE_CONVEX_HULL] = (_IntersectionTestFnPtr)&_ConvexConvex;
 
 	_intersectionTestTable[eSHAPE_CAPSULE][eSHAPE_RAY] = (_IntersectionTestFnPtr)&_CapsuleRay;
 	_intersectionTestTable[eSHAPE_CAPSULE][eSHAPE_PLANE] = (_IntersectionTestFnPtr)&_CapsulePlane;
 	_intersectionTestTable[eSHAPE_CAPSULE][eSHAPE_SPHERE] = (_IntersectionTestFnPtr)&_CapsuleSphere;
-	_intersectionTestTable[eSHAPE_CAPSULE][eSHAPE_CYLINDER] = 0;
+	_intersectionTestTable[eSHAPE_CAPSULE][eSHAPE_CYLINDER] = (_IntersectionTestFnPtr)&_ConvexConvex;
 	_intersectionTestTable[eSHAPE_CAPSULE][eSHAPE_CAPSULE] = (_IntersectionTestFnPtr)&_CapsuleCapsule;
-	_intersectionTestTable[eSHAPE_CAPSULE][eSHAPE_BOX] = (_IntersectionTestFnPtr)&_CapsuleBox;
+	_intersectionTestTable[eSHAPE_CAPSULE][eSHAPE_BOX] = (_IntersectionTestFnPtr)&_ConvexConvex;
 	_intersectionTestTable[eSHAPE_CAPSULE][eSHAPE_TRIANGLE] = (_IntersectionTestFnPtr)&_CapsuleTriangle;
 	_intersectionTestTable[eSHAPE_CAPSULE][eSHAPE_MESH] = (_IntersectionTestFnPtr)&_ShapeMesh;
 	_intersectionTestTable[eSHAPE_CAPSULE][eSHAPE_TERRAIN_MESH] = (_IntersectionTestFnPtr)&_ShapeTerrainMesh;
+	_intersectionTestTable[eSHAPE_CAPSULE][eSHAPE_CONVEX_HULL] = (_IntersectionTestFnPtr)&_ConvexConvex;
 
 	_intersectionTestTable[eSHAPE_BOX][eSHAPE_BOX] = (_IntersectionTestFnPtr)&_BoxBox;
 	_intersectionTestTable[eSHAPE_BOX][eSHAPE_RAY] = (_IntersectionTestFnPtr)&_BoxRay;
 	_intersectionTestTable[eSHAPE_BOX][eSHAPE_PLANE] = (_IntersectionTestFnPtr)&_BoxPlane;
 	_intersectionTestTable[eSHAPE_BOX][eSHAPE_SPHERE] = (_IntersectionTestFnPtr)&_BoxSphere;
-	_intersectionTestTable[eSHAPE_BOX][eSHAPE_CAPSULE] = (_IntersectionTestFnPtr)&_BoxCapsule;
+	_intersectionTestTable[eSHAPE_BOX][eSHAPE_CAPSULE] = (_IntersectionTestFnPtr)&_ConvexConvex;
+	_intersectionTestTable[eSHAPE_BOX][eSHAPE_CYLINDER] = (_IntersectionTestFnPtr)&_ConvexConvex;
+	_intersectionTestTable[eSHAPE_BOX][eSHAPE_TRIANGLE] = (_IntersectionTestFnPtr)&_ConvexConvex;
+	_intersectionTestTable[eSHAPE_BOX][eSHAPE_MESH] = (_IntersectionTestFnPtr)&_ShapeMesh;
 	_intersectionTestTable[eSHAPE_BOX][eSHAPE_TERRAIN_MESH] = (_IntersectionTestFnPtr)&_ShapeTerrainMesh;
+	_intersectionTestTable[eSHAPE_BOX][eSHAPE_CONVEX_HULL] = (_IntersectionTestFnPtr)&_ConvexConvex;
 
 	_intersectionTestTable[eSHAPE_TRIANGLE][eSHAPE_RAY] = (_IntersectionTestFnPtr)&_TriangleRay;
 	_intersectionTestTable[eSHAPE_TRIANGLE][eSHAPE_PLANE] = (_IntersectionTestFnPtr)&_TrianglePlane;
 	_intersectionTestTable[eSHAPE_TRIANGLE][eSHAPE_SPHERE] = (_IntersectionTestFnPtr)&_TriangleSphere;
-	_intersectionTestTable[eSHAPE_TRIANGLE][eSHAPE_CYLINDER] = 0;
+	_intersectionTestTable[eSHAPE_TRIANGLE][eSHAPE_CYLINDER] = (_IntersectionTestFnPtr)&_ConvexConvex;
 	_intersectionTestTable[eSHAPE_TRIANGLE][eSHAPE_CAPSULE] = (_IntersectionTestFnPtr)&_TriangleCapsule;
-	_intersectionTestTable[eSHAPE_TRIANGLE][eSHAPE_TRIANGLE] = 0;
+	_intersectionTestTable[eSHAPE_TRIANGLE][eSHAPE_TRIANGLE] = (_IntersectionTestFnPtr)&_ConvexConvex;
+	_intersectionTestTable[eSHAPE_TRIANGLE][eSHAPE_BOX] = (_IntersectionTestFnPtr)&_ConvexConvex;
 	_intersectionTestTable[eSHAPE_TRIANGLE][eSHAPE_TERRAIN_MESH] = 0;
+	_intersectionTestTable[eSHAPE_TRIANGLE][eSHAPE_CONVEX_HULL] = (_IntersectionTestFnPtr)&_ConvexConvex;
 
 	_intersectionTestTable[eSHAPE_MESH][eSHAPE_RAY] = (_IntersectionTestFnPtr)&_MeshShape;
 	_intersectionTestTable[eSHAPE_MESH][eSHAPE_PLANE] = (_IntersectionTestFnPtr)&_MeshShape;
 	_intersectionTestTable[eSHAPE_MESH][eSHAPE_SPHERE] = (_IntersectionTestFnPtr)&_MeshShape;
 	_intersectionTestTable[eSHAPE_MESH][eSHAPE_CYLINDER] = (_IntersectionTestFnPtr)&_MeshShape;
 	_intersectionTestTable[eSHAPE_MESH][eSHAPE_CAPSULE] = (_IntersectionTestFnPtr)&_MeshShape;
+	_intersectionTestTable[eSHAPE_MESH][eSHAPE_BOX] = (_IntersectionTestFnPtr)&_MeshShape;
 	_intersectionTestTable[eSHAPE_MESH][eSHAPE_TRIANGLE] = 0;
 	_intersectionTestTable[eSHAPE_MESH][eSHAPE_MESH] = 0;
+	_intersectionTestTable[eSHAPE_MESH][eSHAPE_CONVEX_HULL] = (_IntersectionTestFnPtr)&_MeshShape;
 
 	_intersectionTestTable[eSHAPE_TERRAIN_MESH][eSHAPE_RAY] = (_IntersectionTestFnPtr)&_TerrainMeshShape;
 	_intersectionTestTable[eSHAPE_TERRAIN_MESH][eSHAPE_PLANE] = (_IntersectionTestFnPtr)&_TerrainMeshShape;
@@ -155,6 +188,18 @@ void FillIntersectionTestTable()
 	_intersectionTestTable[eSHAPE_TERRAIN_MESH][eSHAPE_CAPSULE] = (_IntersectionTestFnPtr)&_TerrainMeshShape;
 	_intersectionTestTable[eSHAPE_TERRAIN_MESH][eSHAPE_TRIANGLE] = 0;
 	_intersectionTestTable[eSHAPE_TERRAIN_MESH][eSHAPE_MESH] = 0;
+	_intersectionTestTable[eSHAPE_TERRAIN_MESH][eSHAPE_CONVEX_HULL] = (_IntersectionTestFnPtr)&_TerrainMeshShape;
+
+	_intersectionTestTable[eSHAPE_CONVEX_HULL][eSHAPE_RAY] = (_IntersectionTestFnPtr)&_ConvexHullRay;
+	_intersectionTestTable[eSHAPE_CONVEX_HULL][eSHAPE_PLANE] = (_IntersectionTestFnPtr)&_ConvexHullPlane;
+	_intersectionTestTable[eSHAPE_CONVEX_HULL][eSHAPE_SPHERE] = (_IntersectionTestFnPtr)&_ConvexConvex;
+	_intersectionTestTable[eSHAPE_CONVEX_HULL][eSHAPE_CYLINDER] = (_IntersectionTestFnPtr)&_ConvexConvex;
+	_intersectionTestTable[eSHAPE_CONVEX_HULL][eSHAPE_CAPSULE] = (_IntersectionTestFnPtr)&_ConvexConvex;
+	_intersectionTestTable[eSHAPE_CONVEX_HULL][eSHAPE_BOX] = (_IntersectionTestFnPtr)&_ConvexConvex;
+	_intersectionTestTable[eSHAPE_CONVEX_HULL][eSHAPE_TRIANGLE] = (_IntersectionTestFnPtr)&_ConvexConvex;
+	_intersectionTestTable[eSHAPE_CONVEX_HULL][eSHAPE_CONVEX_HULL] = (_IntersectionTestFnPtr)&_ConvexConvex;
+	_intersectionTestTable[eSHAPE_CONVEX_HULL][eSHAPE_MESH] = (_IntersectionTestFnPtr)&_ShapeMesh;
+	_intersectionTestTable[eSHAPE_CONVEX_HULL][eSHAPE_TERRAIN_MESH] = (_IntersectionTestFnPtr)&_ShapeTerrainMesh;
 
 	_intersectionTestTable[eSHAPE_CIRCLE][eSHAPE_CIRCLE] = (_IntersectionTestFnPtr)&_CircleCircle;
 }
@@ -838,7 +883,29 @@ bool _SphereBox(const sphere* psphere, const box* pbox, SIntersection* pinters)
 		q += min(max(d, -pbox->dim[i]), pbox->dim[i]) * pbox->axis[i];
 	}
 
-	pinters->dist = (d = (psphere->c - q).Length()) - psphere->r;
+	if ((d = (psphere->c - q).Length()) < FLT_EPSILON)
+	{
+		// Center inside the box, push out through the closest face
+		Vec3f outward;
+		float pen, minpen = FLT_MAX;
+		for (int i = 0; i < 3; ++i)
+		{
+			float dcaxis = Vec3Dot(dc, pbox->axis[i]);
+			if ((pen = pbox->dim[i] - fabsf(dcaxis)) < minpen)
+			{
+				minpen = pen;
+				outward = (dcaxis < 0) ? -pbox->axis[i] : pbox->axis[i];
+			}
+		}
+
+		pinters->dist = -minpen - psphere->r;
+		pinters->n = -outward;
+		pinters->p = psphere->c + outward * minpen;
+		pinters->feature = eINTERSECTION_FEATURE_BASE_SHAPE;
+		return true;
+	}
+
+	pinters->dist = d - psphere->r;
 	pinters->n = -(psphere->c - q) / d;
 	pinters->p = q;
 	pinters->feature = eINTERSECTION_FEATURE_BASE_SHAPE;
@@ -1236,7 +1303,7 @@ bool _CapsuleCapsule(const capsule* pcapsule1, const capsule* pcapsule2, SInters
 	{
 		inters = 1;
 		pinters->feature = eINTERSECTION_FEATURE_BASE_SHAPE;
-		pinters->p = capsules[0]->c + s[0] * capsules[0]->axis;
+		pinters->p = capsules[0]->c + (s[0] / dlnsq) * capsules[0]->axis;
 		pinters->n = d * sgnnz(Vec3Dot(dc, d));
 		pinters->dist = sqr(Vec3Dot(dc, d)) / dlnsq;
 	}
@@ -2104,691 +2171,253 @@ bool _BoxCapsule(const box* pbox, const capsule* pcapsule, SIntersection* pinter
 //
 ///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 
-inline int _TestLineSegmentAABB(const Vec3f& p0, const Vec3f& p1, const AABB& aabb)
-{
-	Vec3f c = (aabb.vMin + aabb.vMax) * 0.5f;
-	Vec3f e = aabb.vMax - c;
-	Vec3f m = (p0 + p1) * 0.5f;
-	Vec3f d = p1 - m;
-	m = m - c;
-
-	// Try world coordinate axes as separating axes
-	float adx = fabsf(d.x);
-	if (fabsf(m.x) > e.x + adx) return 0;
-	float ady = fabsf(d.y);
-	if (fabsf(m.y) > e.y + ady) return 0;
-	float adz = fabsf(d.z);
-	if (fabsf(m.z) > e.z + adz) return 0;
-
-	adx += FLT_EPSILON; ady += FLT_EPSILON; adz += FLT_EPSILON;
-	if (fabsf(m.y * d.z - m.z * d.y) > e.y * adz + e.z * ady) return 0;
-	if (fabsf(m.z * d.x - m.x * d.z) > e.x * adz + e.z * adx) return 0;
-	if (fabsf(m.x * d.y - m.y * d.x) > e.x * ady + e.y * adx) return 0;
-
-	// No separating axis found
-	return 1;
-}
-
-
-//struct TriBuffer
-//{
-//	unsigned int* buffer;
-//	unsigned int capacity;
-//	unsigned int size;
-//
-//	TriBuffer() : buffer(0), capacity(0), size(0) {}
-//};
-//
-//void CreateMeshTreeNode(mesh* pmesh, mesh_tree_node* pnode, const TriBuffer& parentTris, bool octree, unsigned int maxDepth, Vec3f* triCache, unsigned int depth = 1)
-//{
-//	TriBuffer tris;
-//	unsigned int itri;
-//	for (unsigned int i = 0; i < parentTris.size; ++i)
-//	{
-//		itri = parentTris.buffer[i];
-//
-//		static Vec3f p[3];
-//		p[0] = triCache[itri];
-//		p[1] = triCache[itri + 1];
-//		p[2] = triCache[itri + 2];
-//
-//		if (/*pnode->aabb.ContainsPoint(p[0]) || pnode->aabb.ContainsPoint(p[1]) || pnode->aabb.ContainsPoint(p[2]) ||*/
-//			_TestLineSegmentAABB(p[0], p[1], pnode->aabb)
-//			|| _TestLineSegmentAABB(p[1], p[2], pnode->aabb)
-//			|| _TestLineSegmentAABB(p[2], p[0], pnode->aabb))
-//		{
-//			if (!tris.buffer || tris.size >= tris.capacity)
-//			{
-//				unsigned int newCapacity = tris.capacity + 20;
-//				unsigned int* newBuffer = new unsigned int[newCapacity];
-//				if (tris.buffer)
-//				{
-//					memcpy(newBuffer, tris.buffer, tris.size * sizeof(unsigned int));
-//					delete[] tris.buffer;
-//					tris.buffer = 0;
-//				}
-//
-//				tris.buffer = newBuffer;
-//				tris.capacity = newCapacity;
-//			}
-//
-//			tris.buffer[tris.size] = itri;
-//			tris.size++;
-//		}
-//	}
-//
-//	if (depth < maxDepth && tris.size > 16) // min 16 triangles in one BV
-//	{
-//		pnode->tris = 0;
-//		pnode->num_tris = 0;
-//		pnode->num_children = (octree ? 8 : 4);
-//		pnode->children = new mesh_tree_node[pnode->num_children];
-//
-//		Vec3f vMin = pnode->aabb.vMin, vMax = pnode->aabb.vMax;
-//		Vec3f vCenter = (vMin + vMax) * 0.5f;
-//		if (octree)
-//		{
-//			pnode->children[0].aabb = AABB(vMin, vCenter);
-//			pnode->children[1].aabb = AABB(Vec3f(vMin.x, vMin.y, vCenter.z), Vec3f(vCenter.x, vCenter.y, vMax.z));
-//			pnode->children[2].aabb = AABB(Vec3f(vCenter.x, vMin.y, vCenter.z), Vec3f(vMax.x, vCenter.y, vMax.z));
-//			pnode->children[3].aabb = AABB(Vec3f(vCenter.x, vMin.y, vMin.z), Vec3f(vMax.x, vCenter.y, vCenter.z));
-//			pnode->children[4].aabb = AABB(Vec3f(vMin.x, vCenter.y, vMin.z), Vec3f(vCenter.x, vMax.y, vCenter.z));
-//			pnode->children[5].aabb = AABB(Vec3f(vMin.x, vCenter.y, vCenter.z), Vec3f(vCenter.x, vMax.y, vMax.z));
-//			pnode->children[6].aabb = AABB(Vec3f(vCenter.x, vCenter.y, vCenter.z), Vec3f(vMax.x, vMax.y, vMax.z));
-//			pnode->children[7].aabb = AABB(Vec3f(vCenter.x, vCenter.y, vMin.z), Vec3f(vMax.x, vMax.y, vCenter.z));
-//		}
-//		else
-//		{
-//			pnode->children[0].aabb = AABB(vMin, Vec3f(vCenter.x, vMax.y, vCenter.z));
-//			pnode->children[1].aabb = AABB(Vec3f(vCenter.x, vMin.y, vMin.z), Vec3f(vMax.x, vMax.y, vCenter.z));
-//			pnode->children[2].aabb = AABB(Vec3f(vCenter.x, vMin.y, vCenter.z), Vec3f(vMax.x, vMax.y, vMax.z));
-//			pnode->children[3].aabb = AABB(Vec3f(vMin.x, vMin.y, vCenter.z), Vec3f(vCenter.x, vMax.y, vMax.z));
-//		}
-//
-//		for (unsigned int i = 0; i < pnode->num_children; ++i)
-//			CreateMeshTreeNode(pmesh, &pnode->children[i], tris, octree, maxDepth, triCache, depth + 1);
-//	}
-//	else
-//	{
-//		pnode->num_children = 0;
-//		pnode->children = 0;
-//		pnode->num_tris = tris.size;
-//		if (pnode->num_tris > 0)
-//		{
-//			// !! We do not copy the buffer here! Instead we takeover control of it
-//			pnode->tris = tris.buffer;
-//			tris.buffer = 0;
-//		}
-//
-//		static bool seeded = false;
-//		if (!seeded)
-//		{
-//			srand(static_cast<unsigned>(time(0)));
-//			seeded = true;
-//		}
-//
-//		pnode->_color.r = static_cast<float>(rand()) / static_cast<float>(RAND_MAX);
-//		pnode->_color.g = static_cast<float>(rand()) / static_cast<float>(RAND_MAX);
-//		pnode->_color.b = static_cast<float>(rand()) / static_cast<float>(RAND_MAX);
-//
-//		//PhysDebug::VisualizeAABB(pnode->aabb, pnode->_color);
-//	}
-//
-//	if (tris.buffer)
-//	{
-//		delete[] tris.buffer;
-//		tris.buffer = 0;
-//	}
-//}
-//
-//void mesh::CreateTree(bool octree, unsigned int maxDepth)
-//{
-//	ClearTree();
-//	if (!points || !indices || num_points == 0 || num_indices == 0)
-//		return;
-//
-//	for (unsigned int i = 0; i < num_points; ++i)
-//		root.aabb.AddPoint(points[i]);
-//
-//	TriBuffer rootTris;
-//	rootTris.capacity = (unsigned int)(num_indices / 3);
-//	rootTris.buffer = new unsigned int[rootTris.capacity];
-//
-//	// Cache triangle points
-//	Vec3f* triCache = (Vec3f*)malloc(sizeof(Vec3f) * num_indices);
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 //
-//	for (unsigned int i = 0; i < num_indices; i += 3)
-//	{
-//		rootTris.buffer[rootTris.size++] = i;
-//		triCache[i] = points[indices[i]];
-//		triCache[i + 1] = points[indices[i + 1]];
-//		triCache[i + 2] = points[indices[i + 2]];
-//	}
+//	Mesh BVH
 //
-//	CreateMeshTreeNode(this, &root, rootTris, octree, maxDepth, triCache);
+//	Binned SAH builder (I. Wald, "On fast Construction of SAH-based Bounding Volume Hierarchies", 2007).
+//	The triangles are binned by their centroids and each node is split at the bin boundary with the lowest
+//	surface area heuristic cost over all three axes. Every triangle ends up in exactly one leaf.
+//	The two subtrees of large nodes are built in parallel into separate node arrays that are appended afterwards.
 //
-//	if (rootTris.buffer)
-//	{
-//		delete[] rootTris.buffer;
-//		rootTris.buffer = 0;
-//	}
-//
-//	free(triCache);
-//}
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#define MESH_BVH_NUM_BINS 16
+#define MESH_BVH_PARALLEL_MIN_TRIS 8192 // smaller subtrees are built on the calling thread
+#define MESH_BVH_PARALLEL_MAX_DEPTH 3 // at most 2^3 threads
 
-// If triangle just touches a side of the aabb, this is still reported as an intersection
-bool _TestAABBTriangle(const AABB& aabb, const Vec3f& p1, const Vec3f& p2, const Vec3f& p3, bool& onlyTouching)
+// Half the surface area. Only used to compare costs, so the factor does not matter.
+inline float AABBHalfArea(const AABB& aabb)
 {
-	onlyTouching = true;
-	geo::plane triplane = geo::plane(p1, p2, p3);
-	float r, s;
-	Vec3f c = (aabb.vMin + aabb.vMax) * 0.5f, e = aabb.vMax - c;
-	Vec3f v[] = { p1 - c, p2 - c, p3 - c };
+	Vec3f d = aabb.vMax - aabb.vMin;
+	return d.x * d.y + d.y * d.z + d.z * d.x;
+}
 
-	// Test cross product between 3 axes and edges in aabb space
-	static const Vec3f u[] = { Vec3f(1, 0, 0), Vec3f(0, 1, 0), Vec3f(0, 0, 1) };
-	Vec3f f[] = { v[1] - v[0], v[2] - v[1], v[0] - v[2] }, a;
-	float q, qmin, qmax;
-	bool thisOnlyTouching = false;
-	for (int i = 0; i < 3; ++i)
-		for (int j = 0; j < 3; ++j)
-		{
-			a = Vec3Cross(u[i], f[j]);
-			r = e[0] * fabsf(Vec3Dot(u[0], a)) + e[1] * fabsf(Vec3Dot(u[1], a)) + e[2] * fabsf(Vec3Dot(u[2], a));
+inline unsigned int MeshBVH_BinIndex(float c, float cmin, float scale)
+{
+	unsigned int bin = (unsigned int)((c - cmin) * scale);
+	return (bin < MESH_BVH_NUM_BINS) ? bin : MESH_BVH_NUM_BINS - 1;
+}
 
-			qmin = FLT_MAX; qmax = -FLT_MAX;
-			for (int k = 0; k < 3; ++k)
-			{
-				q = Vec3Dot(v[k], a);
-				if (q < qmin) qmin = q;
-				if (q > qmax) qmax = q;
-			}
-			if (!(-r <= qmax && r >= qmin))
-				return false;
-			thisOnlyTouching |= (-r == qmax || r == qmin);
-		}
-	onlyTouching &= thisOnlyTouching;
-
-	// Test AABB-AABB
-	static AABB triaabb;
-	triaabb.Reset();
-	triaabb.AddPoint(p1);
-	triaabb.AddPoint(p2);
-	triaabb.AddPoint(p3);
-	thisOnlyTouching = false;
-	for (int i = 0; i < 3; ++i)
+// Appends src to dst and offsets the second child indices of the appended inner nodes
+inline void MeshBVH_AppendNodes(vector<mesh_bvh_node>& dst, const vector<mesh_bvh_node>& src)
+{
+	unsigned int offset = (unsigned int)dst.size();
+	dst.insert(dst.end(), src.begin(), src.end());
+	for (unsigned int i = offset; i < dst.size(); ++i)
 	{
-		if (aabb.vMin[i] > triaabb.vMax[i] || triaabb.vMin[i] > aabb.vMax[i])
-			return false;
-		thisOnlyTouching |= (aabb.vMin[i] == triaabb.vMax[i] || triaabb.vMin[i] == aabb.vMax[i]);
+		if (!dst[i].IsLeaf())
+			dst[i].first += offset;
 	}
-	onlyTouching &= thisOnlyTouching;
+}
 
-	// Test triangle plane against aabb
-	s = fabsf(Vec3Dot(triplane.n, c) - triplane.d);
-	r = Vec3Dot(e, triplane.n.Abs());
-	if (s > r)
-		return false;
-	onlyTouching &= (s == r);
+struct mesh_bvh_build_tri
+{
+	AABB aabb;
+	Vec3f centroid;
+	unsigned int itri;
+};
 
-	return true;
-}
+struct mesh_bvh_builder
+{
+	mesh_bvh_build_tri* tris; // partitioned in place, subtrees work on disjoint ranges
+	unsigned int maxTrisPerLeaf;
 
-void MeshTree_Insert(const mesh* pmesh, mesh_tree_node* pnode, bool octree, unsigned int itri, const Vec3f& p1, const Vec3f& p2, const Vec3f& p3, unsigned int maxTrisPerLeaf);
+	// Appends the subtree of the triangles tris[begin..end) to nodes
+	void Build(unsigned int begin, unsigned int end, unsigned int depth, vector<mesh_bvh_node>& nodes) const;
+};
 
-void MeshTree_SplitNode(const mesh* pmesh, mesh_tree_node* pnode, unsigned int maxTrisPerLeaf, bool octree = true)
+void mesh_bvh_builder::Build(unsigned int begin, unsigned int end, unsigned int depth, vector<mesh_bvh_node>& nodes) const
 {
-	// Create children
-	pnode->num_children = octree ? 8 : 4;
-	pnode->pchildren = new mesh_tree_node[pnode->num_children];
-	
-	Vec3f vMin = pnode->aabb.vMin, vMax = pnode->aabb.vMax;
-	Vec3f vCenter = (vMin + vMax) * 0.5f;
-	if (octree)
-	{
-		pnode->pchildren[0].aabb = AABB(vMin, vCenter);
-		pnode->pchildren[1].aabb = AABB(Vec3f(vMin.x, vMin.y, vCenter.z), Vec3f(vCenter.x, vCenter.y, vMax.z));
-		pnode->pchildren[2].aabb = AABB(Vec3f(vCenter.x, vMin.y, vCenter.z), Vec3f(vMax.x, vCenter.y, vMax.z));
-		pnode->pchildren[3].aabb = AABB(Vec3f(vCenter.x, vMin.y, vMin.z), Vec3f(vMax.x, vCenter.y, vCenter.z));
-		pnode->pchildren[4].aabb = AABB(Vec3f(vMin.x, vCenter.y, vMin.z), Vec3f(vCenter.x, vMax.y, vCenter.z));
-		pnode->pchildren[5].aabb = AABB(Vec3f(vMin.x, vCenter.y, vCenter.z), Vec3f(vCenter.x, vMax.y, vMax.z));
-		pnode->pchildren[6].aabb = AABB(Vec3f(vCenter.x, vCenter.y, vCenter.z), Vec3f(vMax.x, vMax.y, vMax.z));
-		pnode->pchildren[7].aabb = AABB(Vec3f(vCenter.x, vCenter.y, vMin.z), Vec3f(vMax.x, vMax.y, vCenter.z));
-	}
-	else
+	unsigned int inode = (unsigned int)nodes.size();
+	nodes.emplace_back();
+
+	AABB bounds, cbounds;
+	bounds.Reset();
+	cbounds.Reset();
+	for (unsigned int i = begin; i < end; ++i)
 	{
-		pnode->pchildren[0].aabb = AABB(vMin, Vec3f(vCenter.x, vMax.y, vCenter.z));
-		pnode->pchildren[1].aabb = AABB(Vec3f(vCenter.x, vMin.y, vMin.z), Vec3f(vMax.x, vMax.y, vCenter.z));
-		pnode->pchildren[2].aabb = AABB(Vec3f(vCenter.x, vMin.y, vCenter.z), Vec3f(vMax.x, vMax.y, vMax.z));
-		pnode->pchildren[3].aabb = AABB(Vec3f(vMin.x, vMin.y, vCenter.z), Vec3f(vCenter.x, vMax.y, vMax.z));
+		bounds.vMin = Vec3Min(bounds.vMin, tris[i].aabb.vMin);
+		bounds.vMax = Vec3Max(bounds.vMax, tris[i].aabb.vMax);
+		cbounds.vMin = Vec3Min(cbounds.vMin, tris[i].centroid);
+		cbounds.vMax = Vec3Max(cbounds.vMax, tris[i].centroid);
 	}
 
-	/*for (int i = 0; i < pnode->num_children; ++i)
-		PhysDebug::VisualizeAABB(pnode->pchildren[i].aabb, SColor::White());*/
+	nodes[inode].aabb = bounds;
 
-	// Copy tris to children
-	for (const auto& itri : pnode->tris)
+	unsigned int count = end - begin;
+	if (count <= maxTrisPerLeaf || depth + 1 >= MESH_BVH_MAX_DEPTH)
 	{
-		const Vec3f& np1 = pmesh->points[pmesh->indices[itri]];
-		const Vec3f& np2 = pmesh->points[pmesh->indices[itri + 1]];
-		const Vec3f& np3 = pmesh->points[pmesh->indices[itri + 2]];
-		MeshTree_Insert(pmesh, pnode, octree, itri, np1, np2, np3, maxTrisPerLeaf);
+		nodes[inode].first = begin;
+		nodes[inode].count = count;
+		return;
 	}
 
-	// this tris array is not needed anymore
-	pnode->tris.resize(0);
-}
-
-// Returns false if the triangle is not inside pnode
-// Does not check if tri intersects with node - you must check before calling this method!
-void MeshTree_Insert(const mesh* pmesh, mesh_tree_node* pnode, bool octree, unsigned int itri, const Vec3f& p1, const Vec3f& p2, const Vec3f& p3, unsigned int maxTrisPerLeaf)
-{
-	if (!pnode)
-		return;
+	// Bin the triangles along all three axes in one pass.
+	// Empty (reset) bins do not change the merged boxes of the cost sweeps.
+	struct bvh_bin
+	{
+		AABB aabb;
+		unsigned int count;
+	} bins[3][MESH_BVH_NUM_BINS];
 
-	if (!pnode->pchildren) // leaf?
+	float scale[3];
+	for (int axis = 0; axis < 3; ++axis)
 	{
-		if (pnode->tris.size() < maxTrisPerLeaf)
-		{
-			// Add to leaf
-			pnode->tris.push_back(itri);
-			return;
-		}
-		else
+		float extent = cbounds.vMax[axis] - cbounds.vMin[axis];
+		scale[axis] = (extent > 0) ? MESH_BVH_NUM_BINS / extent : 0; // 0 puts all triangles into the first bin
+
+		for (unsigned int i = 0; i < MESH_BVH_NUM_BINS; ++i)
 		{
-			// Split leaf
-			MeshTree_SplitNode(pmesh, pnode, maxTrisPerLeaf, octree);
+			bins[axis][i].aabb.Reset();
+			bins[axis][i].count = 0;
 		}
 	}
 
-	// Insert into a children
-	bool onlyTouching;
-	for (int ichild = 0; ichild < pnode->num_children; ++ichild)
+	for (unsigned int i = begin; i < end; ++i)
 	{
-		if (_TestAABBTriangle(pnode->pchildren[ichild].aabb, p1, p2, p3, onlyTouching))
-			MeshTree_Insert(pmesh, &pnode->pchildren[ichild], octree, itri, p1, p2, p3, maxTrisPerLeaf);
+		const AABB& triBB = tris[i].aabb;
+		const Vec3f& c = tris[i].centroid;
+		for (int axis = 0; axis < 3; ++axis)
+		{
+			bvh_bin& bin = bins[axis][MeshBVH_BinIndex(c[axis], cbounds.vMin[axis], scale[axis])];
+			bin.aabb.vMin = Vec3Min(bin.aabb.vMin, triBB.vMin);
+			bin.aabb.vMax = Vec3Max(bin.aabb.vMax, triBB.vMax);
+			++bin.count;
+		}
 	}
-}
 
-// Minimizes y bounds of this and all sub nodes
-void MeshTree_CompactQuadtreeNode(const mesh* pmesh, mesh_tree_node* pnode)
-{
-	float ymin = FLT_MAX, ymax = -FLT_MAX;
-
-	if (pnode->pchildren)
+	// Find the bin boundary with the lowest cost. Split i puts bins [0..i] left and (i..NUM_BINS) right.
+	float rightArea[MESH_BVH_NUM_BINS];
+	unsigned int rightCount[MESH_BVH_NUM_BINS];
+	int bestAxis = -1;
+	unsigned int bestSplit = 0;
+	float bestCost = FLT_MAX;
+	AABB acc;
+	unsigned int accCount;
+	for (int axis = 0; axis < 3; ++axis)
 	{
-		for (unsigned int i = 0; i < pnode->num_children; ++i)
+		acc.Reset();
+		accCount = 0;
+		for (unsigned int i = MESH_BVH_NUM_BINS - 1; i > 0; --i)
 		{
-			mesh_tree_node* pchild = &pnode->pchildren[i];
-			MeshTree_CompactQuadtreeNode(pmesh, pchild);
-			if (pchild->aabb.vMin.y < ymin) ymin = pchild->aabb.vMin.y;
-			if (pchild->aabb.vMax.y > ymax) ymax = pchild->aabb.vMax.y;
+			acc.vMin = Vec3Min(acc.vMin, bins[axis][i].aabb.vMin);
+			acc.vMax = Vec3Max(acc.vMax, bins[axis][i].aabb.vMax);
+			accCount += bins[axis][i].count;
+			rightArea[i - 1] = accCount ? AABBHalfArea(acc) : 0;
+			rightCount[i - 1] = accCount;
 		}
-	}
-	else
-	{
-		// leaf
-		for (const auto& itri : pnode->tris)
-			for (int i = 0; i < 3; ++i)
+
+		acc.Reset();
+		accCount = 0;
+		for (unsigned int i = 0; i < MESH_BVH_NUM_BINS - 1; ++i)
+		{
+			acc.vMin = Vec3Min(acc.vMin, bins[axis][i].aabb.vMin);
+			acc.vMax = Vec3Max(acc.vMax, bins[axis][i].aabb.vMax);
+			accCount += bins[axis][i].count;
+			if (accCount == 0 || rightCount[i] == 0)
+				continue;
+
+			float cost = accCount * AABBHalfArea(acc) + rightCount[i] * rightArea[i];
+			if (cost < bestCost)
 			{
-				const Vec3f& p = pmesh->points[pmesh->indices[itri + i]];
-				if (p.y < ymin) ymin = p.y;
-				if (p.y > ymax) ymax = p.y;
+				bestCost = cost;
+				bestAxis = axis;
+				bestSplit = i;
 			}
+		}
 	}
 
-	if (ymax - ymin < 0.001f)
+	unsigned int mid;
+	if (bestAxis >= 0)
 	{
-		ymin -= 0.01f;
-		ymax += 0.01f;
+		float cmin = cbounds.vMin[bestAxis], axisScale = scale[bestAxis];
+		mid = (unsigned int)(std::partition(tris + begin, tris + end, [&](const mesh_bvh_build_tri& tri)
+		{
+			return MeshBVH_BinIndex(tri.centroid[bestAxis], cmin, axisScale) <= bestSplit;
+		}) - tris);
+	}
+	else
+	{
+		// All centroids coincide
+		mid = begin + count / 2;
 	}
 
-	pnode->aabb.vMin.y = ymin;
-	pnode->aabb.vMax.y = ymax;
+	if (count >= MESH_BVH_PARALLEL_MIN_TRIS && depth < MESH_BVH_PARALLEL_MAX_DEPTH)
+	{
+		vector<mesh_bvh_node> left, right;
+		std::future<void> leftTask = std::async(std::launch::async, [&]() { Build(begin, mid, depth + 1, left); });
+		Build(mid, end, depth + 1, right);
+		leftTask.get();
 
-	/*if (!pnode->pchildren)
-		PhysDebug::VisualizeAABB(pnode->aabb);*/
+		MeshBVH_AppendNodes(nodes, left);
+		nodes[inode].first = (unsigned int)nodes.size();
+		MeshBVH_AppendNodes(nodes, right);
+	}
+	else
+	{
+		Build(begin, mid, depth + 1, nodes);
+		nodes[inode].first = (unsigned int)nodes.size();
+		Build(mid, end, depth + 1, nodes);
+	}
 }
 
-void mesh::CreateTree(bool octree, unsigned int maxTrisPerLeaf)
+void mesh::CreateTree(unsigned int maxTrisPerLeaf)
 {
 	ClearTree();
-	if (!points || !indices || num_points == 0 || num_indices == 0)
+	if (!points || !indices || num_points == 0 || num_indices < 3)
 		return;
 
-	// Create root node
-	for (unsigned int i = 0; i < num_points; ++i)
-		root.aabb.AddPoint(points[i]);
-
-	// Root tree must not have 0 dimension on any axis
-	for (int i = 0; i < 3; ++i)
-	{
-		if (root.aabb.vMax[i] - root.aabb.vMin[i] < 0.001f)
-		{
-			root.aabb.vMin[i] -= 0.1f;
-			root.aabb.vMax[i] += 0.1f;
-		}
-	}
-
-	// Todo: Pre-allocate tree based on some heuristic to avoid some copies in Split operation
+	localBoundBox = ComputeOBB(points, num_points);
 
-	// Insert each triangle:
-	for (unsigned int itri = 0; itri < num_indices; itri += 3)
+	unsigned int ntris = num_indices / 3;
+	vector<mesh_bvh_build_tri> tris(ntris);
+	for (unsigned int itri = 0; itri < ntris; ++itri)
 	{
-		const Vec3f& p1 = points[indices[itri]];
-		const Vec3f& p2 = points[indices[itri + 1]];
-		const Vec3f& p3 = points[indices[itri + 2]];
-		//PhysDebug::VisualizePoint((p1 + p2 + p3) * 0.5f);
-		//PhysDebug::VisualizeVector((p1 + p2 + p3) * 0.5f, Vec3f(0, 1.0f, 0));
-		MeshTree_Insert(this, &root, octree, itri, p1, p2, p3, maxTrisPerLeaf);
+		const Vec3f& p1 = points[indices[itri * 3]];
+		const Vec3f& p2 = points[indices[itri * 3 + 1]];
+		const Vec3f& p3 = points[indices[itri * 3 + 2]];
+		tris[itri].aabb = AABB(Vec3Min(Vec3Min(p1, p2), p3), Vec3Max(Vec3Max(p1, p2), p3));
+		tris[itri].centroid = (tris[itri].aabb.vMin + tris[itri].aabb.vMax) * 0.5f;
+		tris[itri].itri = itri;
 	}
 
-	if (!octree)
-		MeshTree_CompactQuadtreeNode(this, &root);
-}
-
-
-//inline void VisualizeMeshTreeNode(mesh_tree_node* pnode)
-//{
-//	static bool seeded = false;
-//	if (!seeded)
-//	{
-//		srand(static_cast<unsigned>(time(0)));
-//		seeded = true;
-//	}
-//
-//	pnode->_color.r = static_cast<float>(rand()) / static_cast<float>(RAND_MAX);
-//	pnode->_color.g = static_cast<float>(rand()) / static_cast<float>(RAND_MAX);
-//	pnode->_color.b = static_cast<float>(rand()) / static_cast<float>(RAND_MAX);
-//
-//	PhysDebug::VisualizeAABB(pnode->aabb, pnode->_color);
-//}
-//
-//inline void VisualizeMeshTreeNodeTriAssignment(const mesh* pmesh, const mesh_tree_node* pnode, unsigned int itri)
-//{
-//	Vec3f p[3];
-//	p[0] = pmesh->points[pmesh->indices[itri]];
-//	p[1] = pmesh->points[pmesh->indices[itri + 1]];
-//	p[2] = pmesh->points[pmesh->indices[itri + 2]];
-//	Vec3f tricenter = (p[0] + p[1] + p[2]) / 3.0f;
-//	Vec3f aabbcenter = (pnode->aabb.vMin + pnode->aabb.vMax) * 0.5f;
-//
-//	PhysDebug::VisualizeVector(tricenter, aabbcenter - tricenter, pnode->_color);
-//}
-//
-//unsigned int DetermineMeshMaxTreeDepth(mesh_tree_node* pnode)
-//{
-//	if (!pnode)
-//	{
-//		return 0;
-//	}
-//	else if (!pnode->children)
-//	{
-//		return 1;
-//	}
-//	else
-//	{
-//		unsigned int depth, maxDepth = 0;
-//		for (unsigned int i = 0; i < pnode->num_children; ++i)
-//		{
-//			depth = DetermineMeshMaxTreeDepth(&pnode->children[i]);
-//			maxDepth = max(maxDepth, depth);
-//		}
-//
-//		return maxDepth + 1; // +1 for current node
-//	}
-//}
-//
-//void DumpMeshTree(const mesh* pmesh, const mesh_tree_node* pnode, unsigned int curDepth = 0)
-//{
-//	if (!pnode)
-//		return;
-//
-//	static string indent;
-//	indent = "  ";
-//	for (unsigned int i = 0; i < curDepth; ++i)
-//		indent += "  ";
-//
-//	static string tris;
-//	tris = "";
-//	if (pnode->tris)
-//	{
-//		tris += "{ ";
-//		for (unsigned int i = 0; i < pnode->num_tris; ++i)
-//		{
-//			if (i > 0)
-//				tris += ", ";
-//
-//			tris += std::to_string(pnode->tris[i]);
-//		}
-//		tris += " }";
-//	}
-//
-//	_d("%s[num_children=%d, num_tris=%d] %s", indent.c_str(), pnode->num_children, pnode->num_tris, tris.c_str());
-//
-//	if (pnode->children)
-//	{
-//		for (unsigned int i = 0; i < pnode->num_children; ++i)
-//			DumpMeshTree(pmesh, &pnode->children[i], curDepth + 1);
-//	}
-//}
-//
-//inline bool MeshTreeNodeContainsTri(const mesh* pmesh, const mesh_tree_node* pnode, unsigned int itri)
-//{
-//	static Vec3f p[3];
-//	p[0] = pmesh->points[pmesh->indices[itri]];
-//	p[1] = pmesh->points[pmesh->indices[itri + 1]];
-//	p[2] = pmesh->points[pmesh->indices[itri + 2]];
-//
-//	/*return _TestLineSegmentAABB(p[0], p[1], pnode->aabb)
-//		| _TestLineSegmentAABB(p[1], p[2], pnode->aabb)
-//		| _TestLineSegmentAABB(p[2], p[0], pnode->aabb);*/
-//
-//	return pnode->aabb.ContainsPoint(p[0])
-//		|| pnode->aabb.ContainsPoint(p[1])
-//		|| pnode->aabb.ContainsPoint(p[2])
-//		|| pnode->aabb.HitsLineSegment(p[0], p[1])
-//		|| pnode->aabb.HitsLineSegment(p[1], p[2])
-//		|| pnode->aabb.HitsLineSegment(p[2], p[0]);
-//}
-//
-//inline void SplitMeshTreeNode(mesh* pmesh, mesh_tree_node* pnode, bool octree)
-//{
-//	// Create children
-//	pnode->num_children = (octree ? 8 : 4);
-//	pnode->children = new mesh_tree_node[pnode->num_children];
-//
-//	Vec3f vMin = pnode->aabb.vMin, vMax = pnode->aabb.vMax;
-//	Vec3f vCenter = (vMin + vMax) * 0.5f;
-//	if (octree)
-//	{
-//		pnode->children[0].aabb = AABB(vMin, vCenter);
-//		pnode->children[1].aabb = AABB(Vec3f(vMin.x, vMin.y, vCenter.z), Vec3f(vCenter.x, vCenter.y, vMax.z));
-//		pnode->children[2].aabb = AABB(Vec3f(vCenter.x, vMin.y, vCenter.z), Vec3f(vMax.x, vCenter.y, vMax.z));
-//		pnode->children[3].aabb = AABB(Vec3f(vCenter.x, vMin.y, vMin.z), Vec3f(vMax.x, vCenter.y, vCenter.z));
-//		pnode->children[4].aabb = AABB(Vec3f(vMin.x, vCenter.y, vMin.z), Vec3f(vCenter.x, vMax.y, vCenter.z));
-//		pnode->children[5].aabb = AABB(Vec3f(vMin.x, vCenter.y, vCenter.z), Vec3f(vCenter.x, vMax.y, vMax.z));
-//		pnode->children[6].aabb = AABB(Vec3f(vCenter.x, vCenter.y, vCenter.z), Vec3f(vMax.x, vMax.y, vMax.z));
-//		pnode->children[7].aabb = AABB(Vec3f(vCenter.x, vCenter.y, vMin.z), Vec3f(vMax.x, vMax.y, vCenter.z));
-//	}
-//	else
-//	{
-//		pnode->children[0].aabb = AABB(vMin, Vec3f(vCenter.x, vMax.y, vCenter.z));
-//		pnode->children[1].aabb = AABB(Vec3f(vCenter.x, vMin.y, vMin.z), Vec3f(vMax.x, vMax.y, vCenter.z));
-//		pnode->children[2].aabb = AABB(Vec3f(vCenter.x, vMin.y, vCenter.z), Vec3f(vMax.x, vMax.y, vMax.z));
-//		pnode->children[3].aabb = AABB(Vec3f(vMin.x, vMin.y, vCenter.z), Vec3f(vCenter.x, vMax.y, vMax.z));
-//	}
-//
-//	// Insert existing tris into children
-//	if (pnode->tris)
-//	{
-//		mesh_tree_node* pchild = 0;
-//		for (unsigned int i = 0; i < pnode->num_tris; ++i)
-//		{
-//			for (unsigned int ichild = 0; ichild < pnode->num_children; ++ichild)
-//			{
-//				unsigned int itri = pnode->tris[i];
-//
-//				pchild = &pnode->children[ichild];
-//				if (!MeshTreeNodeContainsTri(pmesh, pchild, itri))
-//					continue;
-//
-//				if (!pchild->tris)
-//				{
-//					pchild->tris = new unsigned int[pnode->num_tris];
-//					pchild->num_tris = 0;
-//
-//					//VisualizeMeshTreeNode(pchild);
-//				}
-//
-//				pchild->tris[pchild->num_tris] = itri;
-//				pchild->num_tris++;
-//			}
-//		}
-//
-//		delete[] pnode->tris;
-//		pnode->tris = 0;
-//		pnode->num_tris = 0;
-//	}
-//}
-//
-//// maxTrisPerLeaf - algorithm will split leaf node when (maxTrisPerLeaf + 1)th tri is added to it
-//void InsertMeshTreeTriangle(mesh* pmesh, unsigned int itri, unsigned int maxTrisPerLeaf = 4, bool octree = true)
-//{
-//	struct open_node
-//	{
-//		mesh_tree_node* pnode;
-//		unsigned int depth;
-//
-//		open_node() : pnode(0), depth(0) {}
-//		open_node(mesh_tree_node* _pnode) : pnode(_pnode), depth(0) {}
-//		open_node(mesh_tree_node* _pnode, unsigned int _depth) : pnode(_pnode), depth(_depth) {}
-//	};
-//
-//	static std::stack<open_node> openNodes;
-//	openNodes.emplace(&pmesh->root);
-//
-//	bool propagate;
-//	mesh_tree_node* pnode = 0;
-//	while (openNodes.size() > 0)
-//	{
-//		open_node node = openNodes.top();
-//		openNodes.pop();
-//
-//		pnode = node.pnode;
-//		propagate = (bool)(pnode->children);
-//
-//		if (!propagate && pnode->num_tris >= maxTrisPerLeaf)
-//		{
-//			SplitMeshTreeNode(pmesh, pnode, octree);
-//			propagate = true;
-//		}
-//
-//		if (propagate)
-//		{
-//			for (unsigned int ichild = 0; ichild < pnode->num_children; ++ichild)
-//			{
-//				if (!MeshTreeNodeContainsTri(pmesh, pnode, itri))
-//					continue;
-//
-//				openNodes.emplace(&pnode->children[ichild], node.depth + 1);
-//			}
-//		}
-//		else
-//		{
-//			if (!pnode->tris)
-//			{
-//				pnode->tris = new unsigned int[maxTrisPerLeaf];
-//				pnode->num_tris = 0;
-//
-//				//VisualizeMeshTreeNode(pnode);
-//			}
-//
-//			pnode->tris[pnode->num_tris] = itri;
-//			pnode->num_tris++;
-//		}
-//	}
-//}
-//
-//void mesh::CreateTree(bool octree, unsigned int maxTrisPerLeaf /*= 8*/)
-//{
-//	_d("===== mesh::CreateTree(octree=%s, maxTrisPerLeaf=%d) =====", (octree ? "true" : "false"), maxTrisPerLeaf);
-//
-//	_d("  Clearing tree...");
-//	ClearTree();
-//
-//	if (!points || !indices || num_points == 0 || num_indices == 0)
-//		return;
-//
-//	_d("  Adding points...");
-//	for (unsigned int i = 0; i < num_points; ++i)
-//		root.aabb.AddPoint(points[i]);
-//
-//	float minAABBAxisDiff = 0.1f;
-//	for (unsigned int i = 0; i < 3; ++i)
-//	{
-//		float diff;
-//		if ((diff = root.aabb.vMax[i] - root.aabb.vMin[i]) < minAABBAxisDiff)
-//		{
-//			diff = (minAABBAxisDiff - diff) * 0.5f;
-//			root.aabb.vMin[i] -= diff;
-//			root.aabb.vMax[i] += diff;
-//		}
-//	}
-//
-//	// Slightly un-align root aabb so we can avoid perfectly matching node aabbs and triangle edges
-//	// for grid patterns.
-//	root.aabb.vMax += Vec3f(0.003f, 0.003f, 0.003f);
-//	root.aabb.vMin -= Vec3f(0.001f, 0.001f, 0.001f);
-//
-//	_d("  Inserting %d triangles...", (unsigned int)(num_indices / 3));
-//	for (unsigned int itri = 0; itri < num_indices; itri += 3)
-//		InsertMeshTreeTriangle(this, itri, maxTrisPerLeaf, octree);
-//	_d("  Done.");
-//	_d("");
-//
-//	//DumpMeshTree(this, &root);
-//	//_d("");
-//
-//	unsigned int maxTreeDepth = DetermineMeshMaxTreeDepth(&root);
-//	_d("  ===> Max Tree Depth: %d", maxTreeDepth);
-//	_d("");
-//}
+	mesh_bvh_builder builder;
+	builder.tris = tris.data();
+	builder.maxTrisPerLeaf = (maxTrisPerLeaf > 0) ? maxTrisPerLeaf : 1;
 
+	vector<mesh_bvh_node> bvh;
+	bvh.reserve(2 * ntris / builder.maxTrisPerLeaf + 1);
+	builder.Build(0, ntris, 0, bvh);
 
-void ClearMeshTreeNode(mesh_tree_node* pnode)
-{
-	if (!pnode) return;
-	if (pnode->pchildren)
+	// Make the triangles of each leaf contiguous
+	vector<unsigned int> unordered(indices, indices + ntris * 3);
+	for (unsigned int itri = 0; itri < ntris; ++itri)
 	{
-		for (unsigned int i = 0; i < pnode->num_children; ++i)
-			ClearMeshTreeNode(&pnode->pchildren[i]);
-
-		delete[] pnode->pchildren;
-		pnode->pchildren = 0;
+		for (unsigned int i = 0; i < 3; ++i)
+			indices[itri * 3 + i] = unordered[tris[itri].itri * 3 + i];
 	}
 
-	//pnode->tris.clear();
-
-	pnode->aabb.Reset();
-	pnode->num_children = 0;
+	num_nodes = (unsigned int)bvh.size();
+	nodes = MemoryTracker::NewArray<mesh_bvh_node>(eMEMTAG_PHYSICS_MESH, num_nodes);
+	std::copy(bvh.begin(), bvh.end(), nodes);
 }
 
 void mesh::ClearTree()
 {
-	ClearMeshTreeNode(&root);
-	root.tris.resize(0);
+	MemoryTracker::DeleteArray(eMEMTAG_PHYSICS_MESH, nodes, num_nodes);
+	num_nodes = 0;
 }
 
 
 AABB mesh::GetBoundBoxAxisAligned() const
 {
-	return root.aabb;
+	return nodes ? nodes[0].aabb : AABB(Vec3f(0), Vec3f(0));
 }
 
 OBB mesh::GetBoundBox() const
 {
-	OBB obb(root.aabb);
+	OBB obb(localBoundBox);
 	for (int i = 0; i < 3; ++i)
 		if (obb.dimensions[i] < FLT_EPSILON) obb.dimensions[i] = 0.01f;
 	obb.Transform(transform);
@@ -2832,119 +2461,477 @@ float mesh::GetDistance(const Vec3f & p) const
 }
 
 
-bool _MeshNodeShape(const mesh* pmesh, const mesh_tree_node* pnode, const shape* pshape, const AABB& shapeaabb, SIntersection* pinters)
+bool _MeshShape(const mesh* pmesh, const shape* pshape, SIntersection* pinters)
 {
-	// Check against node bounding box
+	if (!pmesh->nodes)
+		return false;
+
+	shape* ptshape = pshape->Clone();
+	if (!ptshape)
+		return false;
+
+	// Transform the other shape into object space of the mesh, so
+	// we can work on the BVH with axis aligned bound boxes
+	ptshape->Transform(pmesh->invTransform);
+
+	AABB shapeaabb = ptshape->GetBoundBoxAxisAligned();
+	PhysDebug::VisualizeAABB(shapeaabb, SColor::Purple(), true);
+
+	// Intersect infinite shapes directly with the node bound boxes
+	bool infinite = (ptshape->GetType() == eSHAPE_RAY || ptshape->GetType() == eSHAPE_PLANE);
+
 	static SIntersection bbinters;
 	static SIntersection tmpinters;
 	static triangle tri;
-	
-	OBB nodeBB(pnode->aabb);
+	OBB nodeBB;
 	box nodebox;
-	nodebox.c = nodeBB.center;
-	for (int i = 0; i < 3; ++i)
-	{
-		nodebox.axis[i] = nodeBB.directions[i];
-		nodebox.dim[i] = nodeBB.dimensions[i];
-	}
 
-	if (pshape->GetType() == eSHAPE_RAY || pshape->GetType() == eSHAPE_PLANE)
-	{
-		// Intersect infinite shapes directly with bound box
-		if (!_Intersection(&nodebox, pshape, &bbinters))
-			return false;
-	}
-	else
+	pinters->dist = FLT_MAX;
+
+	bool res = false;
+	unsigned int stack[MESH_BVH_MAX_DEPTH], nstack = 0;
+	stack[nstack++] = 0;
+	while (nstack > 0)
 	{
-		// TODO: Use OBB for shape
+		unsigned int inode = stack[--nstack];
+		const mesh_bvh_node& node = pmesh->nodes[inode];
+		if (infinite)
+		{
+			nodeBB = OBB(node.aabb);
+			nodebox.c = nodeBB.center;
+			for (int i = 0; i < 3; ++i)
+			{
+				nodebox.axis[i] = nodeBB.directions[i];
+				nodebox.dim[i] = nodeBB.dimensions[i];
+			}
 
-		//if (!_BoxBoxExists(pnodebox, pshapebox))
-		if (!pnode->aabb.Intersects(shapeaabb))
+			if (!_Intersection(&nodebox, ptshape, &bbinters))
+				continue;
+		}
+		else if (!node.aabb.Intersects(shapeaabb)) // TODO: Use OBB for shape
 		{
-			//PhysDebug::VisualizeAABB(pnode->aabb, SColor::Blue(), true);
-			return false;
+			continue;
 		}
-	}
 
-	bool inters = false;
-	if (pnode->pchildren)
-	{
-		for (unsigned int i = 0; i < pnode->num_children; ++i)
+		if (!node.IsLeaf())
 		{
-			inters |= _MeshNodeShape(pmesh, &pnode->pchildren[i], pshape, shapeaabb, pinters);
+			stack[nstack++] = node.first;
+			stack[nstack++] = inode + 1;
+			continue;
 		}
-	}
-	else if (!pnode->tris.empty())
-	{
-		//PhysDebug::VisualizeAABB(pnode->aabb, SColor::Red(), true);
 
-		for (const auto& itri : pnode->tris)
+		for (unsigned int itri = node.first; itri < node.first + node.count; ++itri)
 		{
-			tri.p[0] = pmesh->points[pmesh->indices[itri + 0]];
-			tri.p[1] = pmesh->points[pmesh->indices[itri + 1]];
-			tri.p[2] = pmesh->points[pmesh->indices[itri + 2]];
+			tri.p[0] = pmesh->points[pmesh->indices[itri * 3 + 0]];
+			tri.p[1] = pmesh->points[pmesh->indices[itri * 3 + 1]];
+			tri.p[2] = pmesh->points[pmesh->indices[itri * 3 + 2]];
 			tri.n = ((tri.p[1] - tri.p[0]) ^ (tri.p[2] - tri.p[0])).Normalized();
 
-			//for (int i = 0; i < 3; ++i)
-			//	PhysDebug::VisualizeVector(tri.p[i], tri.p[(i + 1) % 3] - tri.p[i], pnode->_color, true);
-
-			//PhysDebug::VisualizeVector(tri.p[0], tri.p[1] - tri.p[0], SColor::Red(), true);
-			//PhysDebug::VisualizeVector(tri.p[1], tri.p[2] - tri.p[1], SColor::Red(), true);
-			//PhysDebug::VisualizeVector(tri.p[2], tri.p[0] - tri.p[2], SColor::Red(), true);
-
 			// TODO: Actually save all contacts instead finding the minimum here?
-			if (!_Intersection(&tri, pshape, &tmpinters))
+			if (!_Intersection(&tri, ptshape, &tmpinters))
 				continue;
 
-			//PhysDebug::VisualizeVector(tri.p[0], tri.n, pnode->_color, true);
-
 			if (tmpinters.dist < pinters->dist)
 			{
-				inters = true;
+				res = true;
 				*pinters = tmpinters;
 			}
 		}
 	}
 
-	return inters;
+	delete ptshape;
+
+	if (res)
+	{
+		pinters->p = (pmesh->transform * Vec4f(pinters->p, 1.0f)).xyz();
+		pinters->n = (pmesh->transform * Vec4f(pinters->n, 0.0f)).xyz();
+	}
+
+	return res;
 }
 
-bool _MeshShape(const mesh* pmesh, const shape* pshape, SIntersection* pinters)
+bool _ShapeMesh(const shape* pshape, const mesh* pmesh, SIntersection *pinters)
 {
-	box nodebox;
-	Mat44 invTransform = SMatrixInvert(pmesh->transform);
+	bool res = _MeshShape(pmesh, pshape, pinters);
+	pinters->n *= -1.0f;
+	return res;
+}
 
-	shape* ptshape = pshape->Clone();
-	if (!ptshape)
+
+
+
+
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+//	Convex hull
+//
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+convex_hull_data::~convex_hull_data()
+{
+	delete[] points;
+	delete[] indices;
+	delete[] normals;
+	delete[] dists;
+	delete[] adjacency;
+	delete[] adjacency_offsets;
+}
+
+unsigned int convex_hull_data::GetSupport(const Vec3f& d, unsigned int start /*= 0*/) const
+{
+	unsigned int best = 0;
+	float dot, bestdot;
+	if (num_points <= CONVEX_HULL_HILL_CLIMBING_MIN_POINTS)
+	{
+		bestdot = Vec3Dot(points[0], d);
+		for (unsigned int i = 1; i < num_points; ++i)
+		{
+			if ((dot = Vec3Dot(points[i], d)) > bestdot)
+			{
+				bestdot = dot;
+				best = i;
+			}
+		}
+
+		return best;
+	}
+
+	// A linear function has no local maximum on the vertices of a convex polyhedron other than the global one,
+	// so we can walk to the neighbour farthest in direction d until there is none farther.
+	best = (start < num_points) ? start : 0;
+	bestdot = Vec3Dot(points[best], d);
+	for (bool improved = true; improved;)
+	{
+		improved = false;
+		for (unsigned int i = adjacency_offsets[best], end = adjacency_offsets[best + 1]; i < end; ++i)
+		{
+			if ((dot = Vec3Dot(points[adjacency[i]], d)) > bestdot)
+			{
+				bestdot = dot;
+				best = adjacency[i];
+				improved = true;
+			}
+		}
+	}
+
+	return best;
+}
+
+bool convex_hull::Create(const Vec3f* points, unsigned int num_points)
+{
+	SetData(0);
+	transform = Mat44::Identity;
+	invTransform = Mat44::Identity;
+	if (!points || num_points < 4)
 		return false;
 
-	if (ptshape->GetType() == eSHAPE_PLANE)
-		int a = 0;
+	Vec3f* hull = 0;
+	unsigned int nhullverts = 0, nhullfaces = 0;
+	QuickHull2(points, num_points, &hull, &nhullverts, 0, &nhullfaces);
+	if (!hull || nhullfaces < 4)
+	{
+		delete[] hull;
+		return false;
+	}
 
-	// Transform the other shape into object space of the mesh, so
-	// we can work on octree/quadtree with axis aligned bound boxes
-	ptshape->Transform(invTransform);
+	// QuickHull2() returns the 3 points of each face separately. The copies of a point are
+	// bitwise equal, so they are welded by sorting.
+	std::vector<unsigned int> order(nhullverts), remap(nhullverts);
+	for (unsigned int i = 0; i < nhullverts; ++i)
+		order[i] = i;
 
-	AABB shapeaabb = ptshape->GetBoundBoxAxisAligned();
-	PhysDebug::VisualizeAABB(shapeaabb, SColor::Purple(), true);
+	std::sort(order.begin(), order.end(), [hull](unsigned int a, unsigned int b)
+	{
+		if (hull[a].x != hull[b].x) return hull[a].x < hull[b].x;
+		if (hull[a].y != hull[b].y) return hull[a].y < hull[b].y;
+		return hull[a].z < hull[b].z;
+	});
 
-	pinters->dist = FLT_MAX;
+	convex_hull_data* pdata = new convex_hull_data();
+	pdata->points = new Vec3f[nhullverts];
+	for (unsigned int i = 0; i < nhullverts; ++i)
+	{
+		const Vec3f& p = hull[order[i]];
+		const Vec3f* plast = (pdata->num_points > 0) ? &pdata->points[pdata->num_points - 1] : 0;
+		if (!plast || p.x != plast->x || p.y != plast->y || p.z != plast->z)
+			pdata->points[pdata->num_points++] = p;
 
-	bool res = _MeshNodeShape(pmesh, &pmesh->root, ptshape, shapeaabb, pinters);
-	delete ptshape;
+		remap[order[i]] = pdata->num_points - 1;
+	}
 
-	if (res)
+	delete[] hull;
+
+	// Vertex adjacency from the face edges. Both directions of each edge are added, duplicates are removed.
+	std::vector<std::pair<unsigned int, unsigned int>> edges;
+	edges.reserve(nhullverts * 2);
+	for (unsigned int i = 0; i < nhullverts; ++i)
 	{
-		pinters->p = (pmesh->transform * Vec4f(pinters->p, 1.0f)).xyz();
-		pinters->n = (pmesh->transform * Vec4f(pinters->n, 0.0f)).xyz();
+		unsigned int a = remap[i], b = remap[(i % 3 == 2) ? i - 2 : i + 1];
+		edges.push_back(std::make_pair(a, b));
+		edges.push_back(std::make_pair(b, a));
 	}
 
-	return res;
+	std::sort(edges.begin(), edges.end());
+	edges.erase(std::unique(edges.begin(), edges.end()), edges.end());
+
+	pdata->adjacency = new unsigned int[edges.size()];
+	pdata->adjacency_offsets = new unsigned int[pdata->num_points + 1];
+	for (unsigned int i = 0, iedge = 0; i <= pdata->num_points; ++i)
+	{
+		pdata->adjacency_offsets[i] = iedge;
+		for (; iedge < edges.size() && edges[iedge].first == i; ++iedge)
+			pdata->adjacency[iedge] = edges[iedge].second;
+	}
+
+	// Face planes. Degenerate faces of (almost) coplanar points are left out, their neighbours cover them.
+	pdata->indices = new unsigned int[nhullfaces * 3];
+	pdata->normals = new Vec3f[nhullfaces];
+	pdata->dists = new float[nhullfaces];
+	for (unsigned int i = 0; i < nhullverts; i += 3)
+	{
+		const Vec3f &a = pdata->points[remap[i]], &b = pdata->points[remap[i + 1]], &c = pdata->points[remap[i + 2]];
+		Vec3f n = (b - a) ^ (c - a);
+		float nln = n.Length();
+		if (nln <= FLT_EPSILON * max((b - a).LengthSq(), (c - a).LengthSq()))
+			continue;
+
+		unsigned int* tri = &pdata->indices[pdata->num_faces * 3];
+		tri[0] = remap[i];
+		tri[1] = remap[i + 1];
+		tri[2] = remap[i + 2];
+		pdata->normals[pdata->num_faces] = n / nln;
+		pdata->dists[pdata->num_faces] = Vec3Dot(pdata->normals[pdata->num_faces], a);
+		pdata->num_faces++;
+	}
+
+	// Volume and center of mass of the tetrahedrons spanned by the faces and a point inside the hull
+	Vec3f ref(0);
+	for (unsigned int i = 0; i < pdata->num_points; ++i)
+		ref += pdata->points[i];
+
+	ref /= (float)pdata->num_points;
+
+	Vec3f centerSum(0);
+	for (unsigned int i = 0; i < pdata->num_faces; ++i)
+	{
+		const unsigned int* tri = &pdata->indices[i * 3];
+		const Vec3f &a = pdata->points[tri[0]], &b = pdata->points[tri[1]], &c = pdata->points[tri[2]];
+		float Vtet = Vec3Dot(a - ref, (b - ref) ^ (c - ref)) * (1.0f / 6.0f);
+		pdata->volume += Vtet;
+		centerSum += (a + b + c + ref) * (0.25f * Vtet);
+	}
+
+	if (pdata->volume <= FLT_EPSILON)
+	{
+		delete pdata;
+		return false;
+	}
+
+	pdata->center = centerSum / pdata->volume;
+
+	pdata->aabb.Reset();
+	for (unsigned int i = 0; i < pdata->num_points; ++i)
+		pdata->aabb.AddPoint(pdata->points[i]);
+
+	pdata->obb = ComputeOBB(pdata->points, pdata->num_points);
+
+	SetData(pdata);
+	return true;
 }
 
-bool _ShapeMesh(const shape* pshape, const mesh* pmesh, SIntersection *pinters)
+void convex_hull::SetData(convex_hull_data* pdata)
 {
-	bool res = _MeshShape(pmesh, pshape, pinters);
+	if (pdata)
+		++pdata->refs;
+
+	if (data && --data->refs == 0)
+		delete data;
+
+	data = pdata;
+}
+
+Vec3f convex_hull::Support(const Vec3f& d, unsigned int* phint /*= 0*/) const
+{
+	// The support point of the transformed hull in direction d is the transformed
+	// support point of the local hull in direction M^T * d
+	const Mat44& m = transform;
+	Vec3f dlocal(
+		m._11 * d.x + m._21 * d.y + m._31 * d.z,
+		m._12 * d.x + m._22 * d.y + m._32 * d.z,
+		m._13 * d.x + m._23 * d.y + m._33 * d.z);
+
+	unsigned int i = data->GetSupport(dlocal, phint ? *phint : 0);
+	if (phint)
+		*phint = i;
+
+	return (transform * Vec4f(data->points[i], 1.0f)).xyz();
+}
+
+Vec3f convex_hull::TransformNormal(const Vec3f& n) const
+{
+	// Normals are transformed with the inverse transposed
+	const Mat44& m = invTransform;
+	return Vec3f(
+		m._11 * n.x + m._21 * n.y + m._31 * n.z,
+		m._12 * n.x + m._22 * n.y + m._32 * n.z,
+		m._13 * n.x + m._23 * n.y + m._33 * n.z);
+}
+
+AABB convex_hull::GetBoundBoxAxisAligned() const
+{
+	if (!data)
+		return AABB(Vec3f(0), Vec3f(0));
+
+	AABB aabb(data->aabb);
+	aabb.Transform(transform);
+	return aabb;
+}
+
+OBB convex_hull::GetBoundBox() const
+{
+	if (!data)
+		return OBB();
+
+	OBB obb(data->obb);
+	obb.Transform(transform);
+	return obb;
+}
+
+float convex_hull::GetVolume() const
+{
+	if (!data)
+		return 0;
+
+	const Mat44& m = transform;
+	float det = m._11 * (m._22 * m._33 - m._23 * m._32)
+		- m._12 * (m._21 * m._33 - m._23 * m._31)
+		+ m._13 * (m._21 * m._32 - m._22 * m._31);
+
+	return data->volume * fabsf(det);
+}
+
+float convex_hull::GetDistance(const Vec3f& p) const
+{
+	if (!data)
+		return FLT_MAX;
+
+	// Inside, the closest point lies on the closest face plane
+	float maxdist = -FLT_MAX;
+	for (unsigned int i = 0; i < data->num_faces; ++i)
+	{
+		Vec3f n = TransformNormal(data->normals[i]);
+		Vec3f q = (transform * Vec4f(data->points[data->indices[i * 3]], 1.0f)).xyz();
+		maxdist = max(maxdist, Vec3Dot(p - q, n) / n.Length());
+	}
+
+	if (maxdist <= 0)
+		return -maxdist;
+
+	convex_support hullsupport, pointsupport;
+	_GetConvexSupport(this, &hullsupport);
+	_GetConvexSupport(&p, 1, &pointsupport);
+	return _GJKDistance(&hullsupport, &pointsupport);
+}
+
+shape* convex_hull::Clone() const
+{
+	convex_hull* phull = new convex_hull();
+	CopyTo(phull);
+	return phull;
+}
+
+void convex_hull::CopyTo(shape* pother) const
+{
+	if (pother && pother->GetType() == ty)
+	{
+		convex_hull* phull = static_cast<convex_hull*>(pother);
+		phull->SetData(data);
+		phull->transform = transform;
+		phull->invTransform = invTransform;
+	}
+}
+
+void convex_hull::Transform(const Mat44& mtx)
+{
+	transform = mtx * transform;
+	invTransform = SMatrixInvertAffine(transform);
+}
+
+bool _RayConvexHull(const ray* pray, const convex_hull* phull, SIntersection* pinters)
+{
+	const convex_hull_data* pdata = phull->data;
+	if (!pdata)
+		return false;
+
+	// Clip the line against all face planes in hull space. The line parameters are the same in both spaces.
+	Vec3f p = (phull->invTransform * Vec4f(pray->p, 1.0f)).xyz();
+	Vec3f v = (phull->invTransform * Vec4f(pray->v, 0.0f)).xyz();
+	float tenter = -FLT_MAX, texit = FLT_MAX;
+	unsigned int ienter = 0;
+	for (unsigned int i = 0; i < pdata->num_faces; ++i)
+	{
+		float vn = Vec3Dot(pdata->normals[i], v);
+		float dist = pdata->dists[i] - Vec3Dot(pdata->normals[i], p); // negative if p is in front of the face
+		if (fabsf(vn) < FLT_EPSILON)
+		{
+			if (dist < 0)
+				return false;
+
+			continue;
+		}
+
+		float t = dist / vn;
+		if (vn < 0)
+		{
+			if (t > tenter)
+			{
+				tenter = t;
+				ienter = i;
+			}
+		}
+		else if (t < texit)
+		{
+			texit = t;
+		}
+
+		if (tenter > texit)
+			return false;
+	}
+
+	pinters->p = pray->p + pray->v * tenter;
+	pinters->n = phull->TransformNormal(pdata->normals[ienter]).Normalized();
+	pinters->dist = 0.0f;
+	pinters->feature = eINTERSECTION_FEATURE_BASE_SHAPE;
+	return true;
+}
+
+bool _PlaneConvexHull(const plane* pplane, const convex_hull* phull, SIntersection* pinters)
+{
+	if (!phull->data)
+		return false;
+
+	// The plane cuts the hull if the hull has points on both sides
+	Vec3f lowest = phull->Support(-pplane->n);
+	float dlowest = Vec3Dot(lowest, pplane->n) - pplane->d;
+	if (dlowest > 0 || Vec3Dot(phull->Support(pplane->n), pplane->n) - pplane->d < 0)
+		return false;
+
+	pinters->p = lowest - pplane->n * dlowest;
+	pinters->n = pplane->n;
+	pinters->dist = dlowest;
+	pinters->feature = eINTERSECTION_FEATURE_BASE_SHAPE;
+	return true;
+}
+
+bool _ConvexHullRay(const convex_hull* phull, const ray* pray, SIntersection* pinters)
+{
+	return _RayConvexHull(pray, phull, pinters);
+}
+
+bool _ConvexHullPlane(const convex_hull* phull, const plane* pplane, SIntersection* pinters)
+{
+	bool res = _PlaneConvexHull(pplane, phull, pinters);
 	pinters->n *= -1.0f;
 	return res;
 }
@@ -35,6 +35,7 @@ enum EShapeType
 	eSHAPE_CIRCLE, // 3d circle
 	eSHAPE_MESH,
 	eSHAPE_TERRAIN_MESH,
+	eSHAPE_CONVEX_HULL,
 
 	NUM_SHAPE_TYPES
 };
@@ -46,6 +47,12 @@ struct shape
 protected:
 	EShapeType ty;
 public:
+	virtual ~shape() {}
+
+	// Shapes are small and frequently cloned, so they are allocated by the SmallObjectAllocator
+	static void* operator new(size_t sz);
+	static void operator delete(void* p, size_t sz);
+
 	EShapeType GetType() const { return ty; };
 	virtual AABB GetBoundBoxAxisAligned() const { return AABB(Vec3f(-FLT_MAX, -FLT_MAX, -FLT_MAX), Vec3f(FLT_MAX, FLT_MAX, FLT_MAX)); }
 	virtual OBB GetBoundBox() const { return OBB(); }
@@ -232,16 +239,19 @@ struct box : shape
 	virtual void Transform(const Mat44& mtx);
 };
 
-struct mesh_tree_node
+// Maximum depth of a mesh BVH. Deeper nodes become leaves, so traversal stacks of this size never overflow.
+#define MESH_BVH_MAX_DEPTH 64
+
+// Node of the bounding volume hierarchy of a mesh (32 bytes).
+// The nodes are stored depth-first in one array: the first child of an inner node directly follows it.
+struct mesh_bvh_node
 {
 	AABB aabb;
-	vector<unsigned int> tris; // for each tri: start index in indices array of mesh shape
-	mesh_tree_node* pchildren; // if 0, this node is a leaf
-	unsigned int num_children;
-	SColor _color;
+	unsigned int first; // leaf: index of the first triangle (its vertices are at indices[3 * first]), inner node: index of the second child
+	unsigned int count; // number of triangles of a leaf, 0 for inner nodes
 
-	mesh_tree_node() 
-		: tris(0), pchildren(0), num_children(0) {}
+	mesh_bvh_node() : first(0), count(0) {}
+	bool IsLeaf() const { return count > 0; }
 };
 
 struct mesh : shape
@@ -250,10 +260,13 @@ struct mesh : shape
 	unsigned int num_points;
 	unsigned int* indices; // triangles!
 	unsigned int num_indices; // must be a multiple of 3
-	mesh_tree_node root; // contains the whole mesh
+	mesh_bvh_node* nodes; // nodes[0] is the root and contains the whole mesh. 0 until CreateTree() is called
+	unsigned int num_nodes;
+	OBB localBoundBox; // tight fit of the points in mesh space, set by CreateTree()
 	Mat44 transform;
+	Mat44 invTransform; // must be kept in sync with transform
 
-	mesh() : points(0), indices(0) { ty = eSHAPE_MESH; }
+	mesh() : points(0), indices(0), nodes(0), num_nodes(0) { ty = eSHAPE_MESH; }
 	~mesh()
 	{
 		ClearTree();
@@ -265,10 +278,87 @@ struct mesh : shape
 	virtual OBB GetBoundBox() const;
 	virtual float GetVolume() const;
 	virtual float GetDistance(const Vec3f& p) const;
-	void CreateTree(bool octree = true, unsigned int maxTrisPerLeaf = 8);
+
+	// Builds the BVH with the surface area heuristic. Reorders the triangles in the indices array,
+	// so that the triangles of each leaf are contiguous. Large meshes are built on multiple threads.
+	void CreateTree(unsigned int maxTrisPerLeaf = 4);
 	void ClearTree();
 };
 
+// Hulls with at most this many points are searched linearly for the support point, larger ones by hill climbing
+#define CONVEX_HULL_HILL_CLIMBING_MIN_POINTS 64
+
+// Local space data of a convex hull. Immutable after creation and shared by all clones of the hull.
+struct convex_hull_data
+{
+	Vec3f* points;
+	unsigned int num_points;
+	unsigned int* indices; // 3 per face, counter-clockwise seen from outside
+	unsigned int num_faces;
+	Vec3f* normals; // outward face normals
+	float* dists; // face planes: Vec3Dot(normals[i], x) = dists[i]
+	unsigned int* adjacency; // neighbours of point i: adjacency[adjacency_offsets[i]] ... adjacency[adjacency_offsets[i + 1] - 1]
+	unsigned int* adjacency_offsets; // num_points + 1
+	Vec3f center; // center of mass
+	float volume;
+	AABB aabb;
+	OBB obb;
+	unsigned int refs; // number of convex_hulls referencing this data
+
+	convex_hull_data()
+		: points(0), num_points(0), indices(0), num_faces(0), normals(0), dists(0),
+		adjacency(0), adjacency_offsets(0), volume(0), refs(0) {}
+	~convex_hull_data();
+
+	// Summary:
+	//	Returns the index of the point farthest in direction d (local space). Large hulls are hill climbed
+	//	along the adjacency, starting at point start. Pass the result of the last query on the same hull as start
+	//	to find the support point in a few steps for coherent directions (e.g. during GJK).
+	unsigned int GetSupport(const Vec3f& d, unsigned int start = 0) const;
+};
+
+// Convex polyhedron with precomputed face planes and adjacency, e.g. for dynamic props.
+// Much cheaper than a mesh of the same triangles, because the hull is tested as a whole with GJK instead of per triangle.
+// The local space data is shared between clones, so cloning and transforming are O(1).
+struct convex_hull : shape
+{
+	convex_hull_data* data;
+	Mat44 transform;
+	Mat44 invTransform; // kept in sync by Transform()
+
+	convex_hull() : data(0) { ty = eSHAPE_CONVEX_HULL; }
+	~convex_hull() { SetData(0); }
+
+	// Summary:
+	//	Computes the hull of the points with QuickHull2() and resets the transform to identity.
+	// Returns:
+	//	false if the points do not span a volume
+	bool Create(const Vec3f* points, unsigned int num_points);
+
+	// Releases the current data and references the given one
+	void SetData(convex_hull_data* pdata);
+
+	// Summary:
+	//	Returns the point of the hull farthest in direction d, in world space.
+	//	phint is the start point of the hill climbing, see convex_hull_data::GetSupport(), and receives the found point.
+	Vec3f Support(const Vec3f& d, unsigned int* phint = 0) const;
+
+	// Transforms a local space face normal to world space. Not normalized.
+	Vec3f TransformNormal(const Vec3f& n) const;
+
+	virtual AABB GetBoundBoxAxisAligned() const;
+	virtual OBB GetBoundBox() const;
+	virtual float GetVolume() const;
+	virtual float GetDistance(const Vec3f& p) const;
+	virtual shape* Clone() const;
+	virtual void CopyTo(shape* pother) const;
+	virtual void Transform(const Mat44& mtx);
+
+private:
+	convex_hull(const convex_hull&);
+	convex_hull& operator =(const convex_hull&);
+};
+
 // Assumes regular, ordered grid of points that allow immediate access of triangles
 // without storing indices
 struct terrain_mesh : shape
@@ -362,6 +452,11 @@ bool _BoxCapsule(const box* pbox, const capsule* pcapsule, SIntersection* pinter
 bool _MeshShape(const mesh* pmesh, const shape* pshape, SIntersection* pinters);
 bool _ShapeMesh(const shape* pshape, const mesh* pmesh, SIntersection* pinters);
 
+bool _RayConvexHull(const ray* pray, const convex_hull* phull, SIntersection* pinters);
+bool _PlaneConvexHull(const plane* pplane, const convex_hull* phull, SIntersection* pinters);
+bool _ConvexHullRay(const convex_hull* phull, const ray* pray, SIntersection* pinters);
+bool _ConvexHullPlane(const convex_hull* phull, const plane* pplane, SIntersection* pinters);
+
 bool _TerrainMeshShape(const terrain_mesh* pmesh, const shape* pshape, SIntersection* pinters);
 bool _ShapeTerrainMesh(const shape* pshape, const terrain_mesh* pmesh, SIntersection* pinters);
 
@@ -224,13 +224,13 @@ public:
 	template<typename T>
 	void SetExternal(const typename ExternalEntityProperty<T>::Getter& getFn, const typename ExternalEntityProperty<T>::Setter& setFn)
 	{
-		SetExternal(new ExternalEntityProperty<T>(getFn, ExternalEntityProperty<T>::RefGetter(), setFn));
+		SetExternal(new ExternalEntityProperty<T>(getFn, typename ExternalEntityProperty<T>::RefGetter(), setFn));
 	}
 
 	template<typename T>
 	void SetExternalRef(const typename ExternalEntityProperty<T>::RefGetter& refGetFn, const typename ExternalEntityProperty<T>::Setter& setFn)
 	{
-		SetExternal(new ExternalEntityProperty<T>(ExternalEntityProperty<T>::Getter(), refGetFn, setFn));
+		SetExternal(new ExternalEntityProperty<T>(typename ExternalEntityProperty<T>::Getter(), refGetFn, setFn));
 	}
 
 	template<typename T>
@@ -328,6 +328,13 @@ public:
 	ENTITY_REGISTER_PROPERTY(SetExternalRef, const T&(C::*getter)(Args...), void(C::*setter)(const T&, Args...))
 	ENTITY_REGISTER_PROPERTY(SetExternalRef, const T&(C::*getter)(Args...) const, void(C::*setter)(const T&, Args...) const)
 
+	// Const getter with a non-const setter, e.g. for properties that have to go through a setter with side effects
+	template<typename T, typename C, typename ...Args>
+	void RegisterProperty(const string& name, C* c, const T&(C::*getter)(Args...) const, void(C::*setter)(const T&, Args...), Args... args)
+	{
+		AddProperty(name).SetExternalRef<T>(std::bind(getter, c, args...), std::bind(setter, c, std::placeholders::_1, args...));
+	}
+
 	template<typename T>
 	void SetProperty(const string& name, const T& val)
 	{
@@ -374,10 +381,24 @@ struct S_API IEntity : public EntityPropertyContainer
 
 	ILINE virtual IEntityClass* GetClass() const = 0;
 
+	// The position is relative to the world origin of the scene (see IScene::RebaseOrigin()).
+	// For child entities, it is relative to the parent.
 	ILINE virtual const Vec3f& GetPos() const = 0;
 	ILINE virtual void SetPos(const Vec3f& pos) = 0;
 	ILINE virtual void Translate(const Vec3f& translate) = 0;
 
+	// Summary:
+	//	High-precision position, independent of the world origin. Use this to store positions
+	//	in large worlds, where GetPos() would lose precision far away from the origin.
+	//	Only meaningful for entities without a parent.
+	ILINE virtual const Vec3d& GetWorldPos() const = 0;
+	ILINE virtual void SetWorldPos(const Vec3d& pos) = 0;
+
+	// Summary:
+	//	Moves the origin, GetPos() is relative to, to the given world position.
+	//	Keeps the world position. Called by the scene for all entities without a parent.
+	ILINE virtual void RebaseOrigin(const Vec3d& origin) = 0;
+
 	ILINE virtual const Quat& GetRotation() const = 0;
 	ILINE virtual void SetRotation(const Quat& rotation) = 0;
 	ILINE virtual void Rotate(const Quat& rotate) = 0;
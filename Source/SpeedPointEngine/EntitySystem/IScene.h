@@ -29,6 +29,8 @@ struct S_API IScene
 	virtual void SetName(const string& name) = 0;
 	virtual const string& GetName() const = 0;
 
+	// Can be called from worker threads, if the component pools used by the recipe are thread-safe
+	// (see ConcurrentComponentPool)
 	virtual IEntity* SpawnEntity(const string& name, IEntityClass* recipe = 0) = 0;
 	
 	// Adds the entity to the scene graph as an external entity. Ownership of the
@@ -44,6 +46,13 @@ struct S_API IScene
 	// This method does NOT take the extents of the entity into account.
 	// aabb - If not given returns all entities in the scene
 	virtual vector<IEntity*> GetEntities(const AABB& aabb = AABB(Vec3f(-FLT_MAX), Vec3f(FLT_MAX))) const = 0;
+
+	// Summary:
+	//	Moves the world origin to the given world position by translating all entities
+	//	without a parent once. Their world positions are kept, GetPos() becomes relative to the new origin.
+	//	Use IGameEngine::RebaseOrigin() to also rebase physics and rendering.
+	virtual void RebaseOrigin(const Vec3d& origin) = 0;
+	virtual const Vec3d& GetOrigin() const = 0;
 };
 
 SP_NMSPACE_END
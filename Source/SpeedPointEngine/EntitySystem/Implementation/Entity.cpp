@@ -28,9 +28,10 @@ S_API CEntity::CEntity()
 	m_bTransformInvalid(true),
 	m_Scale(1.0f)
 {
-	RegisterProperty("pos", &m_Pos);
-	RegisterProperty("rot", &m_Rot);
-	RegisterProperty("scale", &m_Scale);
+	// Go through the setters, so that m_WorldPos stays in sync and the components are notified
+	RegisterProperty("pos", this, &CEntity::GetPos, &CEntity::SetPos);
+	RegisterProperty("rot", this, &CEntity::GetRotation, &CEntity::SetRotation);
+	RegisterProperty("scale", this, &CEntity::GetScale, &CEntity::SetScale);
 	RegisterProperty("name", &m_Name);
 }
 
@@ -166,6 +167,8 @@ S_API const Vec3f& CEntity::GetPos() const
 
 S_API void CEntity::SetPos(const Vec3f& pos)
 {	
+	// Apply the difference, so the world position does not lose the precision of the origin
+	m_WorldPos += Vec3d(pos) - Vec3d(m_Pos);
 	m_Pos = pos;
 	OnEntityTransformed();
 }
@@ -175,6 +178,29 @@ S_API void CEntity::Translate(const Vec3f& translate)
 	SetPos(GetPos() + translate);
 }
 
+S_API const Vec3d& CEntity::GetWorldPos() const
+{
+	return m_WorldPos;
+}
+
+S_API void CEntity::SetWorldPos(const Vec3d& pos)
+{
+	m_Pos = Vec3f(pos - (m_WorldPos - Vec3d(m_Pos)));
+	m_WorldPos = pos;
+	OnEntityTransformed();
+}
+
+S_API void CEntity::RebaseOrigin(const Vec3d& origin)
+{
+	m_Pos = Vec3f(m_WorldPos - origin);
+	OnEntityTransformed();
+}
+
+S_API void CEntity::SetOrigin(const Vec3d& origin)
+{
+	m_WorldPos = origin + Vec3d(m_Pos);
+}
+
 S_API const Quat& CEntity::GetRotation() const
 {
 	return m_Rot;
@@ -37,6 +37,9 @@ private:
 	Vec3f m_Pos, m_Scale, m_Pivot;
 	Quat m_Rot;
 
+	// High-precision position. m_WorldPos - m_Pos is the current origin.
+	Vec3d m_WorldPos;
+
 	bool m_bTransformInvalid;
 	Mat44 m_Transform;
 
@@ -61,6 +64,14 @@ public:
 	ILINE virtual void SetPos(const Vec3f& pos);
 	ILINE virtual void Translate(const Vec3f& translate);
 
+	ILINE virtual const Vec3d& GetWorldPos() const;
+	ILINE virtual void SetWorldPos(const Vec3d& pos);
+	ILINE virtual void RebaseOrigin(const Vec3d& origin);
+
+	// Summary:
+	//	Sets the origin GetPos() is relative to, keeping GetPos(). Used by the scene when spawning the entity.
+	void SetOrigin(const Vec3d& origin);
+
 	ILINE virtual const Quat& GetRotation() const;
 	ILINE virtual void SetRotation(const Quat& rotation);
 	ILINE virtual void Rotate(const Quat& rotate);
@@ -65,6 +65,7 @@ S_API IEntity* Scene::SpawnEntity(const string& name, IEntityClass* pClass /*=0*
 {
 	CEntity* pEntity = m_Entities.Get();
 	pEntity->SetName(name.c_str());
+	pEntity->SetOrigin(m_Origin);
 
 	if (pClass)
 		pClass->Apply(pEntity);
@@ -128,6 +129,7 @@ S_API IEntity* Scene::GetFirstEntityByName(const string& name)
 S_API vector<IEntity*> Scene::GetEntities(const AABB& aabb /*= AABB(Vec3f(-FLT_MAX), Vec3f(FLT_MAX))*/) const
 {
 	vector<IEntity*> entities;
+	entities.reserve(m_Entities.GetUsedObjectCount() + m_ExternalEntities.size());
 
 	unsigned int iEntity = 0;
 	IEntity* pEntity = m_Entities.GetFirstUsedObject(iEntity);
@@ -149,4 +151,28 @@ S_API vector<IEntity*> Scene::GetEntities(const AABB& aabb /*= AABB(Vec3f(-FLT_M
 	return entities;
 }
 
+// -------------------------------------------------------------------------------------------------
+S_API void Scene::RebaseOrigin(const Vec3d& origin)
+{
+	m_Origin = origin;
+
+	// Child positions are relative to their parent and therefore not affected
+	unsigned int iEntity = 0;
+	CEntity* pEntity = m_Entities.GetFirstUsedObject(iEntity);
+	while (pEntity)
+	{
+		if (!pEntity->GetParent())
+			pEntity->RebaseOrigin(origin);
+
+		pEntity = m_Entities.GetNextUsedObject(iEntity);
+	}
+
+	for (auto itExtEntity = m_ExternalEntities.begin(); itExtEntity != m_ExternalEntities.end(); ++itExtEntity)
+	{
+		IEntity* pExtEntity = *itExtEntity;
+		if (pExtEntity && !pExtEntity->GetParent())
+			pExtEntity->RebaseOrigin(origin);
+	}
+}
+
 SP_NMSPACE_END
@@ -8,7 +8,7 @@
 #include "..\IScene.h"
 #include "Entity.h"
 #include <Common\SPrerequisites.h>
-#include <Common\ChunkedObjectPool.h>
+#include <Common\ConcurrentObjectPool.h>
 #include <vector>
 
 using std::vector;
@@ -19,8 +19,9 @@ class S_API Scene : public IScene
 {
 private:
 	string m_Name;
-	ChunkedObjectPool<CEntity> m_Entities;
+	ConcurrentObjectPool<CEntity> m_Entities; // allows SpawnEntity() from worker threads
 	vector<IEntity*> m_ExternalEntities;
+	Vec3d m_Origin;
 
 public:
 	Scene();
@@ -42,6 +43,9 @@ public:
 	virtual vector<IEntity*> GetEntitiesByName(const string& name);
 	virtual IEntity* GetFirstEntityByName(const string& name);
 	virtual vector<IEntity*> GetEntities(const AABB& aabb = AABB(Vec3f(-FLT_MAX), Vec3f(FLT_MAX))) const;
+
+	virtual void RebaseOrigin(const Vec3d& origin);
+	virtual const Vec3d& GetOrigin() const { return m_Origin; }
 };
 
 SP_NMSPACE_END
@@ -38,11 +38,17 @@ struct S_API SGameEngineInitParams
 	string logFilename;
 	bool showDebugInfo;
 
+	// If the camera gets farther away from the world origin than this distance, the origin is moved
+	// to the camera position at the beginning of the next frame (see IGameEngine::RebaseOrigin()).
+	// 0 to disable. A few hundred units keep positions near the camera at sub-millimeter precision.
+	float originRebaseDistance;
+
 	SGameEngineInitParams()
 		: rendererImplementation(S_DIRECTX11),
 		pCustomScene(0),
 		logFilename("SpeedPoint.log"),
-		showDebugInfo(false)
+		showDebugInfo(false),
+		originRebaseDistance(0)
 	{
 	}
 };
@@ -92,6 +98,14 @@ public: // Game / Application interface
 	// Loads the SPW world referenced by the absolute resource path
 	virtual SResult LoadWorld(const string& absResourcePath) = 0;
 
+	// Summary:
+	//	Moves the world origin to the given world position. All Vec3f positions of the scene, physics
+	//	and rendering (including the camera) are relative to this origin. Every object is translated
+	//	exactly once here, so there is no conversion when accessing the positions.
+	//	Use IEntity::GetWorldPos() to get the high-precision position of an entity.
+	virtual void RebaseOrigin(const Vec3d& origin) = 0;
+	virtual const Vec3d& GetWorldOrigin() const = 0;
+
 	// Executes an engine Update->Render cycle
 	virtual void DoFrame() = 0;
 
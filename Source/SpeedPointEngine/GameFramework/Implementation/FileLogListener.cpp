@@ -5,6 +5,7 @@ using std::ofstream;
 SP_NMSPACE_BEG
 
 FileLogListener::FileLogListener(const string& filename)
+	: m_LineQueue(4096)
 {
 	if (m_LogFile.is_open())
 		m_LogFile.close();
@@ -19,28 +20,53 @@ FileLogListener::~FileLogListener()
 
 void FileLogListener::OnLog(SResult res, const string& msg)
 {
-	m_LineQueue.push_back(msg);
+	while (!m_LineQueue.Push(msg))
+	{
+		std::lock_guard<std::mutex> lock(m_FileLock);
+		WriteLines();
+
+		// The file cannot be written, so spill the queued lines to make room instead of dropping them
+		string line;
+		while (m_LineQueue.Pop(line))
+			m_SpilledLines.push_back(std::move(line));
+	}
+}
+
+void FileLogListener::WriteLines()
+{
+	if (!m_LogFile.is_open() || !m_LogFile)
+		return;
+
+	for (auto itLine = m_SpilledLines.begin(); itLine != m_SpilledLines.end(); ++itLine)
+		m_LogFile << *itLine;
+
+	m_SpilledLines.clear();
+
+	string line;
+	while (m_LineQueue.Pop(line))
+		m_LogFile << line;
 }
 
 void FileLogListener::ReleaseQueue()
 {
-	if (m_LineQueue.size() == 0 || !m_LogFile)
+	if (m_LineQueue.IsEmpty())
 		return;
 
-	unsigned int nLines = m_LineQueue.size();
-	for (unsigned int i = 0; i < nLines; ++i)
-	{
-		m_LogFile << m_LineQueue.front();
-		m_LineQueue.pop_front();
-	}
+	std::lock_guard<std::mutex> lock(m_FileLock);
+	WriteLines();
 }
 
 void FileLogListener::Clear()
 {
+	std::lock_guard<std::mutex> lock(m_FileLock);
+
+	// Drop pending lines
+	string line;
+	while (m_LineQueue.Pop(line)) {}
+	m_SpilledLines.clear();
+
 	if (m_LogFile.is_open())
 		m_LogFile.close();
-
-	m_LineQueue.clear();
 }
 
 SP_NMSPACE_END
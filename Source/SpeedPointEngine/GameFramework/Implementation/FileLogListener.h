@@ -1,9 +1,10 @@
 #pragma once
 
 #include <Common\CLog.h>
-#include <deque>
+#include <Common\LockFreeQueue.h>
 #include <vector>
 #include <fstream>
+#include <mutex>
 
 SP_NMSPACE_BEG
 
@@ -13,7 +14,19 @@ class S_API FileLogListener : public ILogListener
 {
 private:
 	std::ofstream m_LogFile;
-	std::deque<string> m_LineQueue;
+	std::mutex m_FileLock;
+
+	// Lines can be logged from any thread. Usually the queue is released once per frame
+	// by the main thread. If it runs full, the logging thread releases it.
+	MPMCQueue<string> m_LineQueue;
+
+	// Lines that were moved out of the full queue while the file could not be written.
+	// Written before the queued lines. Protected by m_FileLock.
+	vector<string> m_SpilledLines;
+
+	// Writes spilled and queued lines if the file can be written, otherwise keeps them.
+	// m_FileLock must be held.
+	void WriteLines();
 
 public:
 	FileLogListener(const string& filename);
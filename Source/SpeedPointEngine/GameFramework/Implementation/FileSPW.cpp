@@ -404,7 +404,7 @@ S_API void CSPWLoader::ReadAndParseTerrainBlock(unsigned int blockIndent, const
 	Vec2f minXZ = pTerrain->GetMinXZ();
 	SPhysTerrainParams physTerrain;
 	physTerrain.heightScale	= pTerrain->GetHeightScale();
-	physTerrain.offset		= Vec3f(minXZ.x, 0, minXZ.y);
+	physTerrain.offset		= Vec3f(minXZ.x, 0, minXZ.y) - pTerrain->GetOrigin();
 	physTerrain.segments[0]	= terrain.segments; // Currently using the same resolution for rendering and proxy mesh
 	physTerrain.segments[1]	= terrain.segments;
 	physTerrain.size[0]		= terrain.size;
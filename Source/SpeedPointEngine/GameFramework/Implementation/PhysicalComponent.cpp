@@ -60,8 +60,9 @@ S_API void CPhysicalComponent::LoadProxyFromSPM(const string& proxyGeomFile)
 			SetMass(pi.mass);
 			if (!pi.proxyShapes.empty())
 			{
+				// Dynamic objects collide with the convex hull of mesh proxies
 				const SSPMColShape* pSPMColShape = pi.proxyShapes.at(0);
-				geo::shape* pshape = SPMManager::ConvertSPMColShapeToGeoShape(pSPMColShape);
+				geo::shape* pshape = SPMManager::ConvertSPMColShapeToGeoShape(pSPMColShape, GetBehavior() != ePHYSOBJ_BEHAVIOR_STATIC);
 				if (pshape)
 					SetProxyPtr(pshape);
 			}
@@ -159,6 +159,12 @@ S_API void CPhysDebugHelper::UpdateFromShape(const shape* pshape, const AABB& bo
 			pVB->UploadVertexData(minvtx, maxvtx - minvtx);
 			break;
 		}
+	case eSHAPE_CONVEX_HULL:
+		{
+			// The hull data does not change, only its transform
+			SetMeshTransform(static_cast<const convex_hull*>(pshape)->transform);
+			break;
+		}
 	case eSHAPE_BOX:
 		{
 			const box* pbox = (const box*)pshape;
@@ -9,6 +9,7 @@
 #include "SpeedPointEngine.h"
 #include <Renderer\IRenderer.h>
 #include <Common\ProfilingSystem.h>
+#include <Common\FrameMemory.h>
 #include <sstream>
 #include <iomanip>
 #include <limits>
@@ -43,6 +44,7 @@ void InitFontRenderSlot(SFontRenderSlot** pSlot, bool alignRight, bool keep, con
 S_API ProfilingDebugView::ProfilingDebugView()
 	: m_pCamStatus(0),
 	m_pFPS(0),
+	m_pFrameMemory(0),
 	m_bShow(false)
 {
 }
@@ -104,6 +106,27 @@ S_API void ProfilingDebugView::Update(IRenderer* renderer)
 		m_pTerrain->render = false;
 	}
 
+	// Frame memory
+	if (m_bShow)
+	{
+		InitFontRenderSlot(&m_pFrameMemory, true, true, SpeedPoint::SColor(1.f, 1.f, 1.f), 0, 78);
+		FrameMemoryIntrnl* pFrameMemory = FrameMemory::Get();
+		ss.str("");
+		ss << "FrameMem: " << (pFrameMemory->GetLastFrameBytes() / 1024) << "KB (peak " << (pFrameMemory->GetPeakFrameBytes() / 1024) << "KB) "
+			<< pFrameMemory->GetLastFrameAllocations() << " allocs, " << pFrameMemory->GetLastFrameOverflows() << " overflows";
+
+		unsigned int heapAllocations = pFrameMemory->GetLastFrameHeapAllocations();
+		if (heapAllocations != UINT_MAX)
+			ss << ", " << heapAllocations << " heap allocs";
+
+		m_pFrameMemory->text = ss.str();
+		m_pFrameMemory->render = true;
+	}
+	else if (m_pFrameMemory)
+	{
+		m_pFrameMemory->render = false;
+	}
+
 	// Profiling sections
 	if (m_bShow)
 	{
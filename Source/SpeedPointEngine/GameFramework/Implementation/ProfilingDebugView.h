@@ -23,6 +23,7 @@ private:
 	SFontRenderSlot* m_pCamStatus;
 	SFontRenderSlot* m_pFPS;
 	SFontRenderSlot* m_pTerrain;
+	SFontRenderSlot* m_pFrameMemory;
 	bool m_bShow;
 
 public:
@@ -179,7 +179,7 @@ S_API IGeometry* SPMManager::CreateGeometryFromSPM(const CSPMLoader* pSPM, const
 	return pGeom;
 }
 
-S_API geo::shape* SPMManager::ConvertSPMColShapeToGeoShape(const SSPMColShape* spmShape)
+S_API geo::shape* SPMManager::ConvertSPMColShapeToGeoShape(const SSPMColShape* spmShape, bool convexMeshes /*= false*/)
 {
 	if (!spmShape)
 		return 0;
@@ -190,8 +190,22 @@ S_API geo::shape* SPMManager::ConvertSPMColShapeToGeoShape(const SSPMColShape* s
 	case SPM_COLSHAPE_MESH:
 		{
 			const SSPMColShapeMesh* colmesh = dynamic_cast<const SSPMColShapeMesh*>(spmShape);
+			if (convexMeshes)
+			{
+				geo::convex_hull* phull = new geo::convex_hull();
+				if (phull->Create(reinterpret_cast<const Vec3f*>(colmesh->pVertices), colmesh->nVertices))
+				{
+					pshape = phull;
+					break;
+				}
+
+				CLog::Log(S_WARN, "SPMManager::ConvertSPMColShapeToGeoShape(): Failed create convex hull of collision mesh, using triangle mesh instead");
+				delete phull;
+			}
+
 			geo::mesh* pmesh = new geo::mesh();
 			pmesh->transform = Mat44::Identity;
+			pmesh->invTransform = Mat44::Identity;
 			
 			pmesh->num_points = colmesh->nVertices;
 			pmesh->points = new Vec3f[pmesh->num_points];
@@ -201,6 +215,8 @@ S_API geo::shape* SPMManager::ConvertSPMColShapeToGeoShape(const SSPMColShape* s
 			pmesh->indices = new unsigned int[pmesh->num_indices];
 			memcpy(pmesh->indices, colmesh->pIndices, sizeof(unsigned int) * pmesh->num_indices);
 
+			pmesh->CreateTree();
+
 			pshape = pmesh;
 			break;
 		}
@@ -38,7 +38,8 @@ public:
 	static void ClearInitialGeometryDesc(SInitialGeometryDesc& geomDesc);
 
 	// Allocates a new geo shape. Caller is responsible for deallocation
-	static geo::shape* ConvertSPMColShapeToGeoShape(const SSPMColShape* spmShape);
+	// If convexMeshes is true, mesh shapes are replaced by their convex hull (falls back to the mesh if the hull is degenerate)
+	static geo::shape* ConvertSPMColShapeToGeoShape(const SSPMColShape* spmShape, bool convexMeshes = false);
 
 	void Clear();
 };
@@ -27,6 +27,7 @@
 #include <Renderer\IResourcePool.h>
 #include <Renderer\DirectX11\DX11Renderer.h>
 #include <Common\ProfilingSystem.h>
+#include <Common\FrameMemory.h>
 #include <Common\SAssert_Impl.h>
 #include <Common\IShutdownHandler.h>
 #include <fstream>
@@ -41,7 +42,8 @@ S_API SpeedPointEngine::SpeedPointEngine()
 m_bLoggedSkipstages(false),
 m_pApplication(nullptr),
 m_pPhysicsDebugRenderer(0),
-m_FramesSinceGC(0)
+m_FramesSinceGC(0),
+m_OriginRebaseDistance(0)
 {
 	SpeedPointEnv::SetEngine(this);
 
@@ -132,6 +134,7 @@ S_API SResult SpeedPointEngine::Initialize(const SGameEngineInitParams& params)
 
 	// Debug
 	m_pProfilingDebugView->Show(params.showDebugInfo);
+	m_OriginRebaseDistance = params.originRebaseDistance;
 
 	return S_SUCCESS;
 }
@@ -347,6 +350,9 @@ S_API SResult SpeedPointEngine::LoadWorld(const string& absResourcePath)
 	Get3DEngine()->ClearRenderLights();
 	Get3DEngine()->ClearTerrain();
 
+	// Positions in world files are relative to the world's origin
+	RebaseOrigin(Vec3d(0.0));
+
 	CSPWLoader loader;
 	loader.Load(m_p3DEngine, m_pScene, absResourcePath);
 	
@@ -354,6 +360,29 @@ S_API SResult SpeedPointEngine::LoadWorld(const string& absResourcePath)
 	return S_SUCCESS;
 }
 
+// ----------------------------------------------------------------------------------
+S_API void SpeedPointEngine::RebaseOrigin(const Vec3d& origin)
+{
+	unsigned int rebaseSection = ProfilingSystem::StartSection("SpeedPointEngine::RebaseOrigin()");
+
+	Vec3f shift = Vec3f(origin - GetWorldOrigin());
+
+	m_pScene->RebaseOrigin(origin);
+	m_pPhysics->RebaseOrigin(origin);
+	m_p3DEngine->RebaseOrigin(origin);
+
+	IViewport* pViewport = m_pRenderer->GetTargetViewport();
+	if (pViewport && pViewport->GetCamera())
+		pViewport->GetCamera()->position -= shift;
+
+	ProfilingSystem::EndSection(rebaseSection);
+}
+
+S_API const Vec3d& SpeedPointEngine::GetWorldOrigin() const
+{
+	return m_pScene->GetOrigin();
+}
+
 // ----------------------------------------------------------------------------------
 S_API string SpeedPointEngine::GetShaderDirectoryPath() const
 {
@@ -387,6 +416,15 @@ S_API void SpeedPointEngine::DoFrame()
 	if (m_pApplication)
 		m_pApplication->Update(fTime);
 
+	// Keep the camera close to the origin, so that positions near it stay precise
+	IViewport* pViewport = m_pRenderer->GetTargetViewport();
+	if (m_OriginRebaseDistance > 0 && pViewport && pViewport->GetCamera())
+	{
+		Vec3f camPos = pViewport->GetCamera()->position;
+		if (camPos.LengthSq() > m_OriginRebaseDistance * m_OriginRebaseDistance)
+			RebaseOrigin(GetWorldOrigin() + Vec3d(camPos));
+	}
+
 	m_pPhysics->Update(fTime);
 
 	// Render
@@ -417,6 +455,9 @@ S_API void SpeedPointEngine::DoFrame()
 
 	// Notify profiling system about next frame
 	pProfilingSystem->NextFrame();
+
+	// Reset transient memory of the previous frame
+	FrameMemory::Get()->NextFrame();
 }
 
 
@@ -86,6 +86,7 @@ private:
 	bool			m_bLoggedSkipstages;
 	ISettings*		m_pSettings;		// Main Settings of the Game Engine	
 	unsigned int m_FramesSinceGC;
+	float m_OriginRebaseDistance;
 
 	ProfilingDebugView* m_pProfilingDebugView;
 	IPhysicsDebugRenderer* m_pPhysicsDebugRenderer;
@@ -146,6 +147,9 @@ public: // Game / Application interface
 
 	virtual SResult LoadWorld(const string& absResourcePath);
 
+	virtual void RebaseOrigin(const Vec3d& origin);
+	virtual const Vec3d& GetWorldOrigin() const;
+
 	virtual void DoFrame();
 
 	virtual void ShowDebugInfo(bool show = true);
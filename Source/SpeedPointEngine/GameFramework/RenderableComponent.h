@@ -65,6 +65,7 @@ public:
 
 	virtual SInstancedRenderDesc* GetRenderDesc();
 	virtual void Clear();
+	virtual void RebaseOrigin(const Vec3f& shift) {} // position is relative to the entity
 	virtual void Serialize(ISerContainer* ser, bool serialize = true);
 };
 
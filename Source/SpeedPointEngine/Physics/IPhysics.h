@@ -53,15 +53,20 @@ protected:
 public:
 	virtual ~IPhysics() {}
 
-	template<class PhysObjImpl>
+	// Use Pool = ConcurrentComponentPool<PhysObject, PhysObjImpl> to create objects from multiple threads
+	template<class PhysObjImpl, class Pool = ComponentPool<PhysObject, PhysObjImpl>>
 	ILINE void CreatePhysObjectPool()
 	{
-		SetPhysObjectPool(new ComponentPool<PhysObject, PhysObjImpl>());
+		SetPhysObjectPool(new Pool());
 	}
 
 	ILINE virtual PhysObject* CreatePhysObject() = 0;
 	ILINE virtual void ClearPhysObjects() = 0;
 
+	// Handles can be stored instead of pointers and are safely resolved to 0 once the object was released
+	ILINE virtual ObjectPoolHandle GetPhysObjectHandle(const PhysObject* pObject) const = 0;
+	ILINE virtual PhysObject* ResolvePhysObject(const ObjectPoolHandle& handle) const = 0;
+
 	// heightmap - one coherent row is w pixels and there are h rows.
 	// heightmapSz - (w,h) resolution of the heightmap data
 	ILINE virtual void CreateTerrainProxy(const float* heightmap, unsigned int heightmapSz[2], const SPhysTerrainParams& params) = 0;
@@ -70,6 +75,12 @@ public:
 
 	ILINE virtual void Update(float fTime) = 0;
 
+	// Summary:
+	//	Moves the world origin to the given world position by translating all objects and the terrain proxy once.
+	//	Positions in the simulation are relative to this origin.
+	ILINE virtual void RebaseOrigin(const Vec3d& origin) = 0;
+	ILINE virtual const Vec3d& GetOrigin() const = 0;
+
 	ILINE virtual void Pause(bool pause = true) = 0;
 	ILINE virtual bool IsPaused() const = 0;
 	ILINE virtual void ShowHelpers(bool show = true) = 0;
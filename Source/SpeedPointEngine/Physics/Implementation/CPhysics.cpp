@@ -10,10 +10,6 @@
 
 	- Use a BVH to increase broad-phase performance
 
-	- Cache contacts until their interpenetration depth < -epsilon
-		This aggregates contacts over frames and thus produces a set of contacts
-		required for example for box-box or capsule-lying-on-plane cases.
-	
 	- De-Activate objects that have little to no momentum
 		Wake them up again when they are involved in a colliding contact
 
@@ -29,7 +25,8 @@
 
 SP_NMSPACE_BEG
 
-#define RESTING_TOLERANCE 0.02f
+// Number of sequential impulse iterations over all contacts per step
+#define CONTACT_SOLVER_ITERATIONS 4
 
 using namespace geo;
 
@@ -77,6 +74,25 @@ S_API void CPhysics::ClearPhysObjects()
 
 		m_pObjects->ReleaseAll();
 	}
+
+	m_Contacts.clear();
+	m_PrevContacts.clear();
+}
+
+S_API ObjectPoolHandle CPhysics::GetPhysObjectHandle(const PhysObject* pObject) const
+{
+	if (!IS_VALID_PTR(m_pObjects))
+		return ObjectPoolHandle();
+
+	return m_pObjects->GetHandle(pObject);
+}
+
+S_API PhysObject* CPhysics::ResolvePhysObject(const ObjectPoolHandle& handle) const
+{
+	if (!IS_VALID_PTR(m_pObjects))
+		return 0;
+
+	return m_pObjects->Resolve(handle);
 }
 
 const char* GetIntersectionFeatureName(EIntersectionFeature f)
@@ -90,6 +106,27 @@ const char* GetIntersectionFeatureName(EIntersectionFeature f)
 	}
 }
 
+static inline bool HandleLess(const ObjectPoolHandle& h1, const ObjectPoolHandle& h2)
+{
+	return (h1.index < h2.index) || (h1.index == h2.index && h1.generation < h2.generation);
+}
+
+static bool ContactPairLess(const SPhysContact& c1, const SPhysContact& c2)
+{
+	return HandleLess(c1.hobj1, c2.hobj1) || (c1.hobj1 == c2.hobj1 && HandleLess(c1.hobj2, c2.hobj2));
+}
+
+S_API void CPhysics::PrepareContact(SPhysContact& contact)
+{
+	// Points of the last step with the same features in contact
+	const SPhysContact* pprev = 0;
+	auto itPrev = std::lower_bound(m_PrevContacts.begin(), m_PrevContacts.end(), contact, ContactPairLess);
+	if (itPrev != m_PrevContacts.end() && itPrev->hobj1 == contact.hobj1 && itPrev->hobj2 == contact.hobj2)
+		pprev = &(*itPrev);
+
+	PrepareContactConstraint(contact, contact.pobj1->GetState(), contact.pobj2->GetState(), pprev);
+}
+
 S_API void CPhysics::Update(float fTime)
 {
 	if (!m_pObjects)
@@ -100,16 +137,14 @@ S_API void CPhysics::Update(float fTime)
 
 	//fTime *= 0.2f;
 
-	unsigned int iObject = 0;
-	PhysObject* pObject = 0;
-
-	// Simulate objects further
-	for (pObject = m_pObjects->GetFirst(iObject); pObject; pObject = m_pObjects->GetNext(iObject))
+	// Simulate objects further and collect their broadphase proxies
+	m_BroadphaseProxies.clear();
+	m_pObjects->ForEach([this, fTime](PhysObject* pObject)
 	{
 		if (pObject->IsTrash())
 		{
 			m_pObjects->Release(&pObject);
-			continue;
+			return;
 		}
 
 		pObject->OnSimulationPrepare();
@@ -118,65 +153,101 @@ S_API void CPhysics::Update(float fTime)
 		if (m_bHelpersShown)
 			pObject->ShowHelper(m_bHelpersShown);
 
+		SPhysBroadphaseProxy proxy;
+		proxy.aabb = pObject->GetAABB();
+		proxy.isStatic = (pObject->GetBehavior() == ePHYSOBJ_BEHAVIOR_STATIC);
+		proxy.pobj = pObject;
+		proxy.hobj = GetPhysObjectHandle(pObject);
+		m_BroadphaseProxies.push_back(proxy);
+
 		//PhysDebug::VisualizeBox(pObject->GetProxy().aabbworld, SColor::White(), true);
-	}
+	});
 
 	m_Terrain.Update(fTime);
 	//PhysDebug::VisualizeBox(m_Terrain.GetAABB(), SColor::Yellow(), true);
 
 	// Determine pairs of objects that possibly collide
-	PhysObject *pobj1, *pobj2;
+	// Only the packed proxies are touched here, the objects are only dereferenced for actual pairs
+	// Pairs are ordered by handle, the terrain is always the second object.
 	m_Colliding.clear();
-	for (int i = 0; i < m_pObjects->GetNumObjects(); ++i)
+
+	unsigned int numProxies = (unsigned int)m_BroadphaseProxies.size();
+	for (unsigned int i = 0; i < numProxies; ++i)
 	{
-		pobj1 = m_pObjects->GetAt(i);
-		for (int j = i + 1; j < m_pObjects->GetNumObjects(); ++j)
+		const SPhysBroadphaseProxy& proxy1 = m_BroadphaseProxies[i];
+		for (unsigned int j = i + 1; j < numProxies; ++j)
 		{
-			pobj2 = m_pObjects->GetAt(j);
-
-			if (pobj1->GetBehavior() == ePHYSOBJ_BEHAVIOR_STATIC && pobj2->GetBehavior() == ePHYSOBJ_BEHAVIOR_STATIC)
+			const SPhysBroadphaseProxy& proxy2 = m_BroadphaseProxies[j];
+			if (proxy1.isStatic && proxy2.isStatic)
 				continue; // never collide two static objects
 
-			if (pobj1->GetAABB().Intersects(pobj2->GetAABB()))
-				m_Colliding.push_back(std::make_pair(pobj1, pobj2));
+			if (proxy1.aabb.Intersects(proxy2.aabb))
+			{
+				SPhysObjectPair pair = { proxy1.pobj, proxy2.pobj, proxy1.hobj, proxy2.hobj };
+				if (HandleLess(proxy2.hobj, proxy1.hobj))
+				{
+					std::swap(pair.pobj1, pair.pobj2);
+					std::swap(pair.hobj1, pair.hobj2);
+				}
+
+				m_Colliding.push_back(pair);
+			}
 		}
 
 		// == Test Intersection against terrain ==
 		//TODO: Use better bounding box hierarchy for terrain to prevent intersection test for each object
-		if (pobj1->GetBehavior() != ePHYSOBJ_BEHAVIOR_STATIC && pobj1->GetAABB().Intersects(m_Terrain.GetAABB()))
-			m_Colliding.push_back(std::make_pair(pobj1, static_cast<PhysObject*>(&m_Terrain)));
+		if (!proxy1.isStatic && proxy1.aabb.Intersects(m_Terrain.GetAABB()))
+		{
+			SPhysObjectPair pair = { proxy1.pobj, &m_Terrain, proxy1.hobj, ObjectPoolHandle() };
+			m_Colliding.push_back(pair);
+		}
 	}
 
-	// Find and resolve actual collisions
+	// Find actual collisions. Pairs without shapes are dropped from m_Colliding so the pair indices
+	// of the narrowphase contacts map back to it.
+	unsigned int numPairs = 0;
+	m_ShapePairs.resize(m_Colliding.size());
 	for (auto& collidingPair : m_Colliding)
 	{
-		PhysObject *pobj1 = collidingPair.first, *pobj2 = collidingPair.second;
-		const shape* pshape1 = pobj1->GetProxy().pshapeworld;
-		const shape* pshape2 = pobj2->GetProxy().pshapeworld;
+		const shape* pshape1 = collidingPair.pobj1->GetProxy().pshapeworld;
+		const shape* pshape2 = collidingPair.pobj2->GetProxy().pshapeworld;
 		if (!pshape1 || !pshape2)
 			continue;
 
-		if (m_bHelpersShown)
-		{
-			/*PhysDebug::VisualizeAABB(pobj1->GetAABB(), SColor::Red(), true);
-			PhysDebug::VisualizeAABB(pobj2->GetAABB(), SColor::Red(), true);*/
-		}
+		m_ShapePairs[numPairs] = shape_pair(pshape1, pshape2);
+		m_Colliding[numPairs++] = collidingPair;
+	}
 
-		SIntersection inters;
-		if (!_Intersection(pshape1, pshape2, &inters))
-			continue;
+	m_Colliding.resize(numPairs);
+	_NarrowphaseBatch(m_ShapePairs.data(), numPairs, &m_Narrowphase);
+
+	// Living objects are resolved right away
+	m_Contacts.clear();
+	for (auto& narrowphaseContact : m_Narrowphase.contacts)
+	{
+		const SPhysObjectPair& pair = m_Colliding[narrowphaseContact.pair];
+		PhysObject *pobj1 = pair.pobj1, *pobj2 = pair.pobj2;
+		const SContactManifold& manifold = narrowphaseContact.manifold;
 
 		if (m_bHelpersShown)
 		{
-			//PhysDebug::VisualizePoint(pobj1->GetState()->pos, SColor::Green(), true);
+			for (unsigned int ipt = 0; ipt < manifold.num_points; ++ipt)
+			{
+				//PhysDebug::VisualizePoint(pobj1->GetState()->pos, SColor::Green(), true);
 
-			PhysDebug::VisualizePoint(inters.p, SColor::Red(), true);
-			//PhysDebug::VisualizeVector(inters.p, inters.n * 3.0f, SColor::Red(), true);
-			PhysDebug::VisualizeVector(inters.p, inters.n * inters.dist, SColor::Yellow(), true);
+				const SContactPoint& point = manifold.points[ipt];
+				PhysDebug::VisualizePoint(point.p, SColor::Red(), true);
+				//PhysDebug::VisualizeVector(point.p, manifold.n * 3.0f, SColor::Red(), true);
+				PhysDebug::VisualizeVector(point.p, manifold.n * point.dist, SColor::Yellow(), true);
+			}
 		}
 
 		if (pobj1->GetBehavior() == ePHYSOBJ_BEHAVIOR_LIVING || pobj2->GetBehavior() == ePHYSOBJ_BEHAVIOR_LIVING)
 		{
+			// Living objects do not rotate, so the deepest point is enough
+			SIntersection inters;
+			manifold.GetDeepestIntersection(&inters);
+
 			// TODO: Implement check between two living entities?
 			PhysObject *pliving, *pother;
 			if (pobj1->GetBehavior() == ePHYSOBJ_BEHAVIOR_LIVING)
@@ -195,74 +266,63 @@ S_API void CPhysics::Update(float fTime)
 			continue;
 		}
 
+		m_Contacts.emplace_back();
+		SPhysContact& contact = m_Contacts.back();
+		contact.pobj1 = pobj1;
+		contact.pobj2 = pobj2;
+		contact.hobj1 = pair.hobj1;
+		contact.hobj2 = pair.hobj2;
+		contact.manifold = manifold;
+		PrepareContact(contact);
+	}
 
-		SPhysObjectState *A = pobj1->GetState(), *B = pobj2->GetState();
-
-		Vec3f Apvel = A->v + (A->w ^ (inters.p - A->pos));
-		Vec3f Bpvel = B->v + (B->w ^ (inters.p - B->pos));
-		float vrel_ln = Vec3Dot(inters.n, Bpvel - Apvel);
-		if (vrel_ln <= RESTING_TOLERANCE) // not a separating contact
-		{
-			Vec3f r_a = inters.p - A->pos;
-			Vec3f r_b = inters.p - B->pos;
-
-			//~~
-			//TODO: Determine restitution coefficient by the combination of the colliding materials.
-			float rest_coeff = 0.2f; // 0 = no bounce,  1 = 100% bounce
-			//~~
+	// Start with the impulses of the last step once all contacts know their restitution
+	for (auto& contact : m_Contacts)
+		WarmStartContactConstraint(contact, contact.pobj1->GetState(), contact.pobj2->GetState());
 
-			float D_a = Vec3Dot(inters.n, (A->Iinv * (r_a ^ inters.n)) ^ r_a);
-			float D_b = Vec3Dot(inters.n, (B->Iinv * (r_b ^ inters.n)) ^ r_b);
+	// Resolve all contact points with sequential impulses
+	for (int iteration = 0; iteration < CONTACT_SOLVER_ITERATIONS; ++iteration)
+	{
+		for (auto& contact : m_Contacts)
+			SolveContactConstraint(contact, contact.pobj1->GetState(), contact.pobj2->GetState());
+	}
 
-			float j = -(1.0f + rest_coeff) * vrel_ln / (A->Minv + B->Minv + D_a + D_b);
-			Vec3f force = j * -inters.n;
+	// Resolve interpenetration once per pair, by the deepest point
+	if (!m_bPaused)
+	{
+		for (auto& contact : m_Contacts)
+		{
+			float mindist = 0;
+			for (unsigned int ipt = 0; ipt < contact.manifold.num_points; ++ipt)
+				mindist = min(mindist, contact.manifold.points[ipt].dist);
 
-			if (fabsf(vrel_ln) <= RESTING_TOLERANCE) // resting or sliding contact
+			if (mindist < 0)
 			{
-				// Apply normal force
-				Vec3f AFnormal, BFnormal;
-				A->P += (AFnormal = Vec3Dot(inters.n, Apvel) * inters.n) * fTime;
-				B->P += (BFnormal = Vec3Dot(inters.n, Bpvel) * inters.n) * fTime;
+				SPhysObjectState *A = contact.pobj1->GetState(), *B = contact.pobj2->GetState();
+				Vec3f dv = (contact.manifold.n * mindist) / (A->Minv + B->Minv);
+				A->pos += (dv * A->Minv) / 5.0f;
+				B->pos -= (dv * B->Minv) / 5.0f;
 			}
-			else // colliding contact
-			{
-				// Apply impulse
-				A->P += force;
-				B->P -= force;
-				A->v = A->P * A->Minv;
-				B->v = B->P * B->Minv;
-			}	
-
-			// Apply friction
-			float frictionFactor = 0.95f;
-			Vec3f AFfric = frictionFactor * (((inters.p - Apvel) - Vec3Dot(-Apvel, inters.n) * inters.n) - inters.p);
-			Vec3f BFfric = frictionFactor * (((inters.p - Bpvel) - Vec3Dot(-Bpvel, inters.n) * inters.n) - inters.p);
-
-			A->P += AFfric;
-			B->P += BFfric;
-			A->L += (r_a ^ AFfric);
-			B->L += (r_b ^ BFfric);
-			A->L *= frictionFactor;
-			B->L *= frictionFactor;
-
-			// Apply change in rotation due to contact
-			A->L += r_a ^ force;
-			B->L -= r_b ^ force;
-			A->w = A->Iinv * A->L;
-			B->w = B->Iinv * B->L;
-		}
-
-		// Resolve interpenetration
-		if (inters.dist < 0 && !m_bPaused)
-		{
-			Vec3f dv = (inters.n * inters.dist) / (A->Minv + B->Minv);
-			A->pos += (dv * A->Minv) / 5.0f;
-			B->pos -= (dv * B->Minv) / 5.0f;
 		}
 	}
 
-	for (pObject = m_pObjects->GetFirst(iObject); pObject; pObject = m_pObjects->GetNext(iObject))
-		pObject->OnSimulationFinished();
+	// Keep the accumulated impulses for warm-starting the next step
+	std::sort(m_Contacts.begin(), m_Contacts.end(), ContactPairLess);
+	m_PrevContacts.swap(m_Contacts);
+
+	m_pObjects->ForEach([](PhysObject* pObject) { pObject->OnSimulationFinished(); });
+}
+
+S_API void CPhysics::RebaseOrigin(const Vec3d& origin)
+{
+	Vec3f shift = Vec3f(origin - m_Origin);
+	m_Origin = origin;
+
+	// Objects of entities are synchronized in OnSimulationPrepare() anyway, so translate all of them
+	if (m_pObjects)
+		m_pObjects->ForEach([&shift](PhysObject* pObject) { pObject->GetState()->pos -= shift; });
+
+	m_Terrain.RebaseOrigin(origin);
 }
 
 S_API void CPhysics::CreateTerrainProxy(const float* heightmap, unsigned int heightmapSz[2], const SPhysTerrainParams& params)
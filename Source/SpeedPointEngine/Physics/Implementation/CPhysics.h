@@ -1,19 +1,61 @@
 #pragma once
 
 #include "PhysTerrain.h"
+#include "ContactSolver.h"
 #include "..\IPhysics.h"
+#include <Common\ContactManifold.h>
+#include <Common\Narrowphase.h>
 #include <Common\SPrerequisites.h>
 
 SP_NMSPACE_BEG
 
+// Broadphase data of an object, copied once per step so that the pair test does not touch the objects
+struct SPhysBroadphaseProxy
+{
+	AABB aabb; // aabbworld
+	bool isStatic; // behavior is ePHYSOBJ_BEHAVIOR_STATIC
+	PhysObject* pobj;
+	ObjectPoolHandle hobj; // handle of the object in m_pObjects
+};
+
+// Pair of objects whose bounding boxes intersect, ordered by handle so that the same two objects
+// form the same pair in every step, regardless of the order of the broadphase proxies.
+struct SPhysObjectPair
+{
+	PhysObject* pobj1;
+	PhysObject* pobj2;
+	ObjectPoolHandle hobj1;
+	ObjectPoolHandle hobj2; // unset for the terrain
+};
+
+// Contact of two non-living objects, see SContactConstraint
+struct SPhysContact : SContactConstraint
+{
+	PhysObject* pobj1;
+	PhysObject* pobj2;
+	ObjectPoolHandle hobj1; // Key of the warm-start cache. Handles instead of pointers, so an object
+	ObjectPoolHandle hobj2; // in a reused pool slot does not inherit the impulses of the old one.
+};
+
 class S_API CPhysics : public IPhysics
 {
 private:
 	IComponentPool<PhysObject>* m_pObjects;
-	vector<std::pair<PhysObject*, PhysObject*>> m_Colliding;
+
+	// Broadphase data of all objects, rebuilt each step. Keeps its capacity.
+	vector<SPhysBroadphaseProxy> m_BroadphaseProxies;
+	vector<SPhysObjectPair> m_Colliding;
+	vector<geo::shape_pair> m_ShapePairs; // shapes of m_Colliding, same order
+	geo::narrowphase_batch m_Narrowphase;
+	vector<SPhysContact> m_Contacts;
+	vector<SPhysContact> m_PrevContacts; // sorted by object handles
 	PhysTerrain m_Terrain;
 	bool m_bPaused;
 	bool m_bHelpersShown;
+	Vec3d m_Origin;
+
+	// Prepares the contact with the impulses of the same pair of objects in the last step
+	void PrepareContact(SPhysContact& contact);
 
 protected:
 	virtual void SetPhysObjectPool(IComponentPool<PhysObject>* pPool);
@@ -24,10 +66,14 @@ public:
 
 	ILINE virtual PhysObject* CreatePhysObject();
 	ILINE virtual void ClearPhysObjects();
+	ILINE virtual ObjectPoolHandle GetPhysObjectHandle(const PhysObject* pObject) const;
+	ILINE virtual PhysObject* ResolvePhysObject(const ObjectPoolHandle& handle) const;
 	ILINE virtual void CreateTerrainProxy(const float* heightmap, unsigned int heightmapSz[2], const SPhysTerrainParams& params);
 	ILINE virtual void UpdateTerrainProxy(const float* heightmap, unsigned int heightmapSz[2], const AABB& bounds = AABB());
 	ILINE virtual void ClearTerrainProxy();
 	ILINE virtual void Update(float fTime);
+	ILINE virtual void RebaseOrigin(const Vec3d& origin);
+	ILINE virtual const Vec3d& GetOrigin() const { return m_Origin; }
 
 	ILINE virtual void Pause(bool pause = true) { m_bPaused = pause; };
 	ILINE virtual bool IsPaused() const { return m_bPaused; };
@@ -0,0 +1,115 @@
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+//	SpeedPoint Game Engine
+//	Copyright (c) 2011-2018 Pascal Rosenkranz, All rights reserved.
+//
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#include "ContactSolver.h"
+
+SP_NMSPACE_BEG
+
+using namespace geo;
+
+// Applies impulse to the second object at r2 and the opposite impulse to the first object at r1
+static void ApplyContactImpulse(SPhysObjectState* A, SPhysObjectState* B, const Vec3f& r1, const Vec3f& r2, const Vec3f& impulse)
+{
+	if (A->Minv > 0)
+	{
+		A->P -= impulse;
+		A->L -= r1 ^ impulse;
+		A->v = A->P * A->Minv;
+		A->w = A->Iinv * A->L;
+	}
+
+	if (B->Minv > 0)
+	{
+		B->P += impulse;
+		B->L += r2 ^ impulse;
+		B->v = B->P * B->Minv;
+		B->w = B->Iinv * B->L;
+	}
+}
+
+// Inverse effective mass of the two objects at the contact point along direction d
+static float GetInvContactMass(const SPhysObjectState* A, const SPhysObjectState* B, const Vec3f& r1, const Vec3f& r2, const Vec3f& d)
+{
+	float D_a = Vec3Dot(d, (A->Iinv * (r1 ^ d)) ^ r1);
+	float D_b = Vec3Dot(d, (B->Iinv * (r2 ^ d)) ^ r2);
+	return A->Minv + B->Minv + D_a + D_b;
+}
+
+void PrepareContactConstraint(SContactConstraint& constraint, SPhysObjectState* A, SPhysObjectState* B, const SContactConstraint* pprev)
+{
+	const SContactManifold& manifold = constraint.manifold;
+
+	//~~
+	//TODO: Determine restitution coefficient by the combination of the colliding materials.
+	float rest_coeff = 0.2f; // 0 = no bounce,  1 = 100% bounce
+	//~~
+
+	for (unsigned int ipt = 0; ipt < manifold.num_points; ++ipt)
+	{
+		const SContactPoint& point = manifold.points[ipt];
+		Vec3f &r1 = constraint.r1[ipt], &r2 = constraint.r2[ipt];
+		r1 = point.p - A->pos;
+		r2 = point.p - B->pos;
+
+		constraint.kn[ipt] = GetInvContactMass(A, B, r1, r2, manifold.n);
+
+		Vec3f Apvel = A->v + (A->w ^ r1);
+		Vec3f Bpvel = B->v + (B->w ^ r2);
+		float vrel_ln = Vec3Dot(manifold.n, Bpvel - Apvel);
+		constraint.bias[ipt] = (vrel_ln < -RESTING_TOLERANCE) ? -rest_coeff * vrel_ln : 0; // resting contacts do not bounce
+
+		int iprevpt = pprev ? pprev->manifold.FindPoint(point.id) : -1;
+		constraint.jn[ipt] = (iprevpt >= 0) ? pprev->jn[iprevpt] : 0;
+		constraint.jt[ipt] = (iprevpt >= 0) ? pprev->jt[iprevpt] : Vec3f(0);
+	}
+}
+
+void WarmStartContactConstraint(const SContactConstraint& constraint, SPhysObjectState* A, SPhysObjectState* B)
+{
+	for (unsigned int ipt = 0; ipt < constraint.manifold.num_points; ++ipt)
+		ApplyContactImpulse(A, B, constraint.r1[ipt], constraint.r2[ipt], constraint.manifold.n * constraint.jn[ipt] + constraint.jt[ipt]);
+}
+
+void SolveContactConstraint(SContactConstraint& constraint, SPhysObjectState* A, SPhysObjectState* B)
+{
+	const Vec3f& n = constraint.manifold.n;
+
+	//~~
+	//TODO: Determine friction coefficient by the combination of the colliding materials.
+	float friction = 0.6f;
+	//~~
+
+	for (unsigned int ipt = 0; ipt < constraint.manifold.num_points; ++ipt)
+	{
+		const Vec3f &r1 = constraint.r1[ipt], &r2 = constraint.r2[ipt];
+
+		// Normal impulse. The accumulated impulse may only push the objects apart.
+		Vec3f vrel = (B->v + (B->w ^ r2)) - (A->v + (A->w ^ r1));
+		float jnOld = constraint.jn[ipt];
+		constraint.jn[ipt] = max(jnOld + (constraint.bias[ipt] - Vec3Dot(n, vrel)) / constraint.kn[ipt], 0.0f);
+		ApplyContactImpulse(A, B, r1, r2, n * (constraint.jn[ipt] - jnOld));
+
+		// Friction impulse, limited to the friction cone
+		vrel = (B->v + (B->w ^ r2)) - (A->v + (A->w ^ r1));
+		Vec3f vt = vrel - n * Vec3Dot(n, vrel);
+		float vtlen = vt.Length();
+		if (vtlen < FLT_EPSILON)
+			continue;
+
+		Vec3f t = vt / vtlen;
+		Vec3f jtOld = constraint.jt[ipt];
+		Vec3f jt = jtOld - t * (vtlen / GetInvContactMass(A, B, r1, r2, t));
+		float jtmax = friction * constraint.jn[ipt];
+		if (jt.LengthSq() > jtmax * jtmax)
+			jt = (jtmax > 0) ? jt.Normalized() * jtmax : Vec3f(0);
+
+		constraint.jt[ipt] = jt;
+		ApplyContactImpulse(A, B, r1, r2, jt - jtOld);
+	}
+}
+
+SP_NMSPACE_END
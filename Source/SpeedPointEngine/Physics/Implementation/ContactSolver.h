@@ -0,0 +1,47 @@
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+//	SpeedPoint Game Engine
+//	Copyright (c) 2011-2018 Pascal Rosenkranz, All rights reserved.
+//
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include "..\PhysObject.h"
+#include <Common\ContactManifold.h>
+#include <Common\SPrerequisites.h>
+
+// Approaching speed along the normal below which a contact is resting and does not bounce
+#define RESTING_TOLERANCE 0.02f
+
+SP_NMSPACE_BEG
+
+// Contact manifold of two objects with the impulses of the sequential impulse solver. The impulses are accumulated
+// over the solver iterations and reused as initial guess in the next step for points with the same id (warm-starting).
+struct SContactConstraint
+{
+	geo::SContactManifold manifold;
+	Vec3f r1[MAX_CONTACT_POINTS]; // contact point relative to the first object
+	Vec3f r2[MAX_CONTACT_POINTS];
+	float kn[MAX_CONTACT_POINTS]; // inverse effective mass along the normal
+	float bias[MAX_CONTACT_POINTS]; // separating velocity to reach (restitution)
+	float jn[MAX_CONTACT_POINTS]; // accumulated normal impulse
+	Vec3f jt[MAX_CONTACT_POINTS]; // accumulated friction impulse
+};
+
+// Summary:
+//	Computes the effective masses and restitution of all points of the manifold.
+//	Points with the same id as a point of pprev start with its impulses, see WarmStartContactConstraint().
+//	pprev is the constraint of the same two objects in the last step, or 0.
+void PrepareContactConstraint(SContactConstraint& constraint, SPhysObjectState* A, SPhysObjectState* B, const SContactConstraint* pprev);
+
+// Summary:
+//	Applies the initial impulses of the constraint to A and B.
+//	Call this only after all constraints of the step are prepared, as the restitution depends on the velocities before.
+void WarmStartContactConstraint(const SContactConstraint& constraint, SPhysObjectState* A, SPhysObjectState* B);
+
+// Summary:
+//	One sequential impulse iteration over all points of the constraint
+void SolveContactConstraint(SContactConstraint& constraint, SPhysObjectState* A, SPhysObjectState* B);
+
+SP_NMSPACE_END
@@ -88,7 +88,6 @@ S_API void PhysObject::Update(float fTime)
 {
 	if (m_State.Minv > 0)
 	{
-		Mat33 R = m_State.rotation.ToRotationMatrix33();
 		Mat33 Ibodyinv = m_State.Ibodyinv;
 
 		// Ibodyinv is multiplied with Volume already, so only multiply with density to get Mass
@@ -97,7 +96,7 @@ S_API void PhysObject::Update(float fTime)
 		Ibodyinv._22 *= densityInv;
 		Ibodyinv._33 *= densityInv;
 
-		m_State.Iinv = R * Ibodyinv * R.Transposed();
+		m_State.Iinv = m_State.rotation.RotateTensor(Ibodyinv);
 
 		m_State.v = m_State.Minv * m_State.P;
 		m_State.w = m_State.Iinv * m_State.L; // L / I
@@ -109,11 +108,7 @@ S_API void PhysObject::Update(float fTime)
 
 	m_State.pos += m_State.v * fTime;
 
-	float wln = m_State.w.Length();
-	if (wln < FLT_EPSILON)
-		m_State.rotation = Quat(cosf(wln * fTime * 0.5f), m_State.w * (fTime * 0.5f)) * m_State.rotation;
-	else
-		m_State.rotation = Quat::FromAxisAngle(m_State.w / wln, wln * fTime) * m_State.rotation;
+	m_State.rotation = m_State.rotation.Integrated(m_State.w, fTime);
 
 	// TODO: Accumulate forces
 	Vec3f force;
@@ -138,21 +133,15 @@ S_API void PhysObject::Update(float fTime)
 	// Update world-space proxy shape
 	if (m_Proxy.pshape)
 	{
-		STransformationDesc transform;
-		transform.translation = Mat44::MakeTranslationMatrix(m_State.pos - m_State.centerOfMass);
-		transform.scale = Mat44::MakeScaleMatrix(m_Scale);
-
-		if (m_Behavior == ePHYSOBJ_BEHAVIOR_LIVING)
-			transform.rotation = Mat44::Identity;
-		else
-			transform.rotation = m_State.rotation.ToRotationMatrix();
-
-		Mat44 mtx = transform.BuildTRS();
+		Mat44 mtx;
+		MakeTransformationTRS(m_State.pos - m_State.centerOfMass,
+			(m_Behavior == ePHYSOBJ_BEHAVIOR_LIVING) ? Quat() : m_State.rotation, m_Scale, &mtx);
 
 		if (m_Proxy.pshape->GetType() == eSHAPE_MESH)
 		{
 			geo::mesh* pmesh = dynamic_cast<geo::mesh*>(m_Proxy.pshape);
 			pmesh->transform = mtx;
+			pmesh->invTransform = SMatrixInvertAffine(mtx);
 			m_Proxy.aabbworld = m_Proxy.aabb;
 			m_Proxy.aabbworld.Transform(pmesh->transform);
 			
@@ -246,6 +235,46 @@ S_API void PhysObject::ResolveLivingContact(const PhysObject* pother, const SInt
 float __sqr(float f) { return f * f; }
 float __cube(float f) { return f * f * f; }
 
+// Volume, center of mass and inertia tensor (around the center of mass) of a closed triangle mesh
+static void CalculatePolyhedronMassProperties(const Vec3f* points, const unsigned int* indices, unsigned int num_indices,
+	Mat33& Ibody, float& V, Vec3f& centerOfMass)
+{
+	// reference point = Vec3f(0)
+
+	const float ONE_SIXTH = 1.0f / 6.0f;
+	Vec3f p[3], Xtet;
+	float Vtet, Adet;
+	Mat33 A, C;
+	Mat33 Ccan; // covariance of canonical tetrahedron
+	Ccan._11 = Ccan._22 = Ccan._33 = 1.0f / 60.0f;
+	Ccan._12 = Ccan._13 = Ccan._21 = Ccan._23 = Ccan._31 = Ccan._32 = 1.0f / 120.0f;
+
+	V = 0;
+
+	for (unsigned int tri = 0; tri < num_indices; tri += 3)
+	{
+		for (int i = 0; i < 3; ++i)
+			p[i] = points[indices[tri + i]];
+
+		A = Mat33::FromColumns(p[0], p[1], p[2]);
+		Adet = A.Determinant();
+
+		C += Adet * A * Ccan * A.Transposed();
+		Vtet = ONE_SIXTH * Adet; // might be negative
+		Xtet = (p[0] + p[1] + p[2] + Vec3f(0)) * 0.25f;
+		if (V + Vtet < FLT_EPSILON)
+			continue;
+
+		centerOfMass = (centerOfMass * V + Xtet * Vtet) / (V + Vtet);
+		V += Vtet;
+	}
+
+	// Translate covariance by -centerOfMass
+	C += V * (2.0f * Vec3MulT(-centerOfMass, centerOfMass) + Vec3MulT(-centerOfMass, -centerOfMass));
+
+	Ibody = Mat33::Identity * C.Trace() - C;
+}
+
 S_API void PhysObject::RecalculateInertia()
 {
 	if (!m_Proxy.pshape || m_Behavior == ePHYSOBJ_BEHAVIOR_STATIC)
@@ -310,46 +339,18 @@ S_API void PhysObject::RecalculateInertia()
 		{
 			mesh* pmesh = (mesh*)m_Proxy.pshape;
 			if (pmesh->points && pmesh->num_points > 0 && pmesh->indices && pmesh->num_indices > 0)
-			{
-				// reference point = Vec3f(0)
-
-				const float ONE_SIXTH = 1.0f / 6.0f;
-				Vec3f p[3], Xtet;
-				float Vtet, Adet;
-				Mat33 A, C;
-				Mat33 Ccan; // covariance of canonical tetrahedron
-				Ccan._11 = Ccan._22 = Ccan._33 = 1.0f / 60.0f;
-				Ccan._12 = Ccan._13 = Ccan._21 = Ccan._23 = Ccan._31 = Ccan._32 = 1.0f / 120.0f;
-
-				V = 0;
-
-				for (unsigned int tri = 0; tri < pmesh->num_indices; tri += 3)
-				{
-					for (int i = 0; i < 3; ++i)
-						p[i] = pmesh->points[pmesh->indices[tri + i]];
-
-					A = Mat33::FromColumns(p[0], p[1], p[2]);
-					Adet = A.Determinant();
-
-					C += Adet * A * Ccan * A.Transposed();
-					Vtet = ONE_SIXTH * Adet; // might be negative
-					Xtet = (p[0] + p[1] + p[2] + Vec3f(0)) * 0.25f;
-					if (V + Vtet < FLT_EPSILON)
-						continue;
-
-					centerOfMass = (centerOfMass * V + Xtet * Vtet) / (V + Vtet);
-					V += Vtet;
-				}
-
-				// Translate covariance by -centerOfMass
-				C += V * (2.0f * Vec3MulT(-centerOfMass, centerOfMass) + Vec3MulT(-centerOfMass, -centerOfMass));
-
-				Ibody = Mat33::Identity * C.Trace() - C;
-			}
+				CalculatePolyhedronMassProperties(pmesh->points, pmesh->indices, pmesh->num_indices, Ibody, V, centerOfMass);
+			else
+				V = 1.0f;
+			break;
+		}
+	case eSHAPE_CONVEX_HULL:
+		{
+			convex_hull* phull = (convex_hull*)m_Proxy.pshape;
+			if (phull->data)
+				CalculatePolyhedronMassProperties(phull->data->points, phull->data->indices, phull->data->num_faces * 3, Ibody, V, centerOfMass);
 			else
-			{
 				V = 1.0f;
-			}
 			break;
 		}
 	default:
@@ -392,7 +393,7 @@ S_API void PhysObject::SetProxyPtr(geo::shape* pshape)
 	}
 }
 
-S_API void PhysObject::SetMeshProxy(const Vec3f* ppoints, u32 npoints, const u32* pindices, u32 nindices, bool octree, u16 maxTrisPerLeaf)
+S_API void PhysObject::SetMeshProxy(const Vec3f* ppoints, u32 npoints, const u32* pindices, u32 nindices, u16 maxTrisPerLeaf)
 {
 	mesh* pmesh = new mesh();
 
@@ -411,8 +412,7 @@ S_API void PhysObject::SetMeshProxy(const Vec3f* ppoints, u32 npoints, const u32
 	}
 
 	pmesh->transform = Mat44::Identity;
-	pmesh->root.pchildren = 0;
-	pmesh->root.num_children = 0;
+	pmesh->invTransform = Mat44::Identity;
 	
 	// Create bv tree
 	if (pmesh->points && pmesh->indices)
@@ -421,7 +421,7 @@ S_API void PhysObject::SetMeshProxy(const Vec3f* ppoints, u32 npoints, const u32
 		QueryPerformanceFrequency(&freq);
 		QueryPerformanceCounter(&start);
 
-		pmesh->CreateTree(octree, maxTrisPerLeaf);
+		pmesh->CreateTree(maxTrisPerLeaf);
 
 		QueryPerformanceCounter(&end);
 		double elapsed = (double)(end.QuadPart - start.QuadPart) / freq.QuadPart;
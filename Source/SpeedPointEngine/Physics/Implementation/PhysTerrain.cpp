@@ -8,9 +8,6 @@
 #include "PhysTerrain.h"
 #include "PhysDebug.h"
 #include <Common\Vector2.h>
-#include <stack>
-
-#define TERRAIN_PROXY_Y_BOUNDS_BIAS 0.5f
 
 SP_NMSPACE_BEG
 
@@ -22,19 +19,6 @@ inline float SampleHeightmap(const float* heightmap, const Vec2f& tc, const unsi
 	return heightmap[pc[1] * heightmapSz[0] + pc[0]];
 }
 
-void UpdatePhysTerrainProxyNodeYBounds(geo::mesh_tree_node* pnode, float miny, float maxy, float bias = 0.0f)
-{
-	//	 Assuming it's a quad-tree !!
-	pnode->aabb.vMin.y = miny - bias;
-	pnode->aabb.vMax.y = maxy + bias;
-
-	if (pnode->pchildren)
-	{
-		for (unsigned int i = 0; i < pnode->num_children; ++i)
-			UpdatePhysTerrainProxyNodeYBounds(&pnode->pchildren[i], miny, maxy, bias);
-	}
-}
-
 ///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 
 S_API PhysTerrain::PhysTerrain()
@@ -43,37 +27,6 @@ S_API PhysTerrain::PhysTerrain()
 
 ///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 
-inline void DumpMeshTree(const geo::mesh* pmesh)
-{
-	struct open_node
-	{
-		const geo::mesh_tree_node* pnode;
-		unsigned int depth;
-		open_node(const geo::mesh_tree_node* _pnode, unsigned int _depth) : pnode(_pnode), depth(_depth) {}
-	};
-
-	string indent;
-	std::stack<open_node> openNodes;
-	openNodes.emplace(&pmesh->root, 0);
-	while (!openNodes.empty())
-	{
-		open_node node = openNodes.top();
-		openNodes.pop();
-
-		indent = "";
-		for (unsigned int i = 0; i < node.depth; ++i)
-			indent += "  ";
-
-		CLog::Log(S_DEBUG, "  %s[%d tris]", indent.c_str(), node.pnode->tris.size());
-
-		if (node.pnode->pchildren)
-		{
-			for (unsigned int i = 0; i < node.pnode->num_children; ++i)
-				openNodes.emplace(&node.pnode->pchildren[i], node.depth + 1);
-		}
-	}
-}
-
 S_API void PhysTerrain::Create(const float* heightmap, unsigned int heightmapSz[2], const SPhysTerrainParams& params)
 {
 	if (!heightmap || params.segments[0] == 0 || params.segments[1] == 0)
@@ -83,6 +36,7 @@ S_API void PhysTerrain::Create(const float* heightmap, unsigned int heightmapSz[
 	}
 
 	m_Params = params;
+	m_WorldOffset = m_Origin + Vec3d(params.offset);
 
 #define EXCESSIVE_PROXY_TREE_DEPTH 100
 	if (m_Params.maxTrisPerLeaf > EXCESSIVE_PROXY_TREE_DEPTH)
@@ -138,9 +92,6 @@ S_API void PhysTerrain::Create(const float* heightmap, unsigned int heightmapSz[
 	double elapsed = (double)(end.QuadPart - start.QuadPart) / freq.QuadPart;
 	CLog::Log(S_DEBUG, "Created terrain proxy mesh in %.4f milliseconds", elapsed * 1000.0f);
 
-	//DumpMeshTree(pmesh);
-	//UpdatePhysTerrainProxyNodeYBounds(&pmesh->root, miny, maxy, TERRAIN_PROXY_Y_BOUNDS_BIAS);
-	
 	SetProxyPtr(pmesh);
 
 	UpdateHelper();
@@ -209,6 +160,40 @@ S_API void PhysTerrain::UpdateHeightmap(const float* heightmap, unsigned int hei
 
 ///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 
+S_API void PhysTerrain::RebaseOrigin(const Vec3d& origin)
+{
+	m_Origin = origin;
+
+	geo::terrain_mesh* pmesh = dynamic_cast<geo::terrain_mesh*>(m_Proxy.pshape);
+	if (!pmesh)
+		return;
+
+	const SPhysTerrainParams& params = m_Params;
+	Vec3f offset = Vec3f(m_WorldOffset - origin);
+	float dy = offset.y - params.offset.y;
+	Vec2f segSz(params.size[0] / params.segments[0], params.size[1] / params.segments[1]);
+
+	pmesh->aabb.Reset();
+	unsigned int ipoint;
+	for (unsigned int row = 0; row < (params.segments[1] + 1); ++row)
+		for (unsigned int col = 0; col < (params.segments[0] + 1); ++col)
+		{
+			// Same as in Create()
+			Vec3f& p = pmesh->points[ipoint = (row * (params.segments[0] + 1) + col)];
+			p.x = col * segSz.x + offset.x;
+			p.y += dy;
+			p.z = row * segSz.y + offset.z;
+			pmesh->aabb.AddPoint(p);
+		}
+
+	m_Params.offset = offset;
+
+	if (m_Proxy.phelper && m_Proxy.phelper->IsShown())
+		m_Proxy.phelper->UpdateFromShape(pmesh);
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
 S_API void PhysTerrain::UpdateHelper()
 {
 }
@@ -10,6 +10,8 @@ class S_API PhysTerrain : public PhysObject
 {
 private:
 	SPhysTerrainParams m_Params;
+	Vec3d m_Origin;
+	Vec3d m_WorldOffset; // m_Params.offset relative to the world origin
 
 protected:
 	virtual void UpdateHelper();
@@ -20,6 +22,11 @@ public:
 	void Clear();
 	void Create(const float* heightmap, unsigned int heightmapSz[2], const SPhysTerrainParams& params);
 	void UpdateHeightmap(const float* heightmap, unsigned int heightmapSz[2], const AABB& bounds = AABB());
+
+	// Summary:
+	//	Translates the proxy mesh, so that it is relative to the given world origin.
+	//	The xz-coordinates are recalculated from the grid, so repeated rebasing does not accumulate rounding errors.
+	void RebaseOrigin(const Vec3d& origin);
 };
 
 SP_NMSPACE_END
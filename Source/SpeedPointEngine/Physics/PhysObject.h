@@ -118,7 +118,7 @@ public:
 	// !! If pshape is a mesh, its tree must be initialized already
 	void SetProxyPtr(geo::shape* pshape);
 
-	void SetMeshProxy(const Vec3f* ppoints, u32 npoints, const u32* pindices, u32 nindices, bool octree = true, u16 maxTrisPerLeaf = 8);
+	void SetMeshProxy(const Vec3f* ppoints, u32 npoints, const u32* pindices, u32 nindices, u16 maxTrisPerLeaf = 4);
 	const SProxyPart& GetProxy() const { return m_Proxy; }
 
 	SPhysObjectState* GetState() { return &m_State; }
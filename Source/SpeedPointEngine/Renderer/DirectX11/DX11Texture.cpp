@@ -10,6 +10,7 @@
 #include "..\IRenderer.h"
 
 #include <Common\ImageLoader.h>
+#include <Common\MemoryTracker.h>
 
 SP_NMSPACE_BEG
 
@@ -218,6 +219,8 @@ m_pDXTexture(0),
 m_pDXStagingTexture(0),
 m_pDXSRV(nullptr),
 m_pStagedData(0),
+m_StagedDataSz(0),
+m_StagingTextureSz(0),
 m_bStaged(false),
 m_bLocked(false),
 m_bSliceLocked(false),
@@ -693,13 +696,7 @@ S_API SResult DX11Texture::LoadFromFile(const string& cFileName, unsigned int w,
 	// Store staged data
 
 	if (m_bStaged)
-	{
-		if (IS_VALID_PTR(m_pStagedData))
-			free(m_pStagedData);
-
-		m_pStagedData = malloc(bitmap.imageSize);
-		memcpy(m_pStagedData, bitmap.buffer, bitmap.imageSize);
-	}	
+		SetStagedData(bitmap.buffer, bitmap.imageSize);
 
 	CLog::Log(S_DEBUG, "Loaded texture %s (type: %s, stag: %s, dyn: %s)", cFileName.c_str(),
 		GetTextureTypeName(m_Type), m_bStaged ? "true" : "false", m_bDynamic ? "true" : "false");
@@ -907,8 +904,7 @@ S_API SResult DX11Texture::ResizeArray(unsigned int count)
 	}
 
 	// Release old texture
-	m_pDXStagingTexture->Release();
-	m_pDXStagingTexture = 0;
+	ReleaseArrayStagingTexture();
 	
 	m_pDXTexture->Release();
 	m_pDXTexture = 0;
@@ -971,11 +967,7 @@ S_API SResult DX11Texture::CreateArrayStagingTexture(const D3D11_SUBRESOURCE_DAT
 {
 	HRESULT hr;
 
-	if (m_pDXStagingTexture)
-	{
-		m_pDXStagingTexture->Release();
-		m_pDXStagingTexture = 0;
-	}
+	ReleaseArrayStagingTexture();
 
 	D3D11_TEXTURE2D_DESC stagingTexDesc;
 	memcpy(&stagingTexDesc, &m_DXTextureDesc, sizeof(stagingTexDesc));
@@ -989,9 +981,51 @@ S_API SResult DX11Texture::CreateArrayStagingTexture(const D3D11_SUBRESOURCE_DAT
 	if (Failure(hr) || !m_pDXStagingTexture)
 		return CLog::Log(S_ERROR, "Failed to create staging texture for dynamic texture array (%s)", m_Specification.c_str());
 
+	// Only counts mip level 0
+	m_StagingTextureSz = (size_t)stagingTexDesc.Width * stagingTexDesc.Height * GetTextureBPP(m_Type) * stagingTexDesc.ArraySize;
+	MemoryTracker::OnAlloc(eMEMTAG_TEXTURE_STAGING, m_StagingTextureSz);
+
 	return S_SUCCESS;
 }
 
+// -----------------------------------------------------------------------------------------------
+S_API void DX11Texture::ReleaseArrayStagingTexture()
+{
+	if (!m_pDXStagingTexture)
+		return;
+
+	m_pDXStagingTexture->Release();
+	m_pDXStagingTexture = 0;
+
+	MemoryTracker::OnFree(eMEMTAG_TEXTURE_STAGING, m_StagingTextureSz);
+	m_StagingTextureSz = 0;
+}
+
+// -----------------------------------------------------------------------------------------------
+S_API void DX11Texture::SetStagedData(const void* pData, size_t sz)
+{
+	FreeStagedData();
+
+	m_pStagedData = malloc(sz);
+	memcpy(m_pStagedData, pData, sz);
+
+	m_StagedDataSz = sz;
+	MemoryTracker::OnAlloc(eMEMTAG_TEXTURE_STAGING, m_StagedDataSz);
+}
+
+// -----------------------------------------------------------------------------------------------
+S_API void DX11Texture::FreeStagedData()
+{
+	if (!IS_VALID_PTR(m_pStagedData))
+		return;
+
+	free(m_pStagedData);
+	m_pStagedData = 0;
+
+	MemoryTracker::OnFree(eMEMTAG_TEXTURE_STAGING, m_StagedDataSz);
+	m_StagedDataSz = 0;
+}
+
 // -----------------------------------------------------------------------------------------------
 S_API SResult DX11Texture::CreateEmptyIntrnl(unsigned int arraySize, unsigned int w, unsigned int h, unsigned int mipLevels, ETextureType type, SColor clearcolor)
 {
@@ -1175,12 +1209,9 @@ S_API SResult DX11Texture::CreateEmptyIntrnl(unsigned int arraySize, unsigned in
 	}
 
 	// Store staging data
-	m_pStagedData = 0;
+	FreeStagedData();
 	if (m_bStaged && !m_bArray)
-	{
-		m_pStagedData = malloc(initData[0].SysMemSlicePitch);
-		memcpy(m_pStagedData, initData[0].pSysMem, initData[0].SysMemSlicePitch);
-	}
+		SetStagedData(initData[0].pSysMem, initData[0].SysMemSlicePitch);
 
 	
 	for (unsigned int i = 0; i < m_DXTextureDesc.ArraySize; ++i)
@@ -1694,14 +1725,11 @@ S_API void* DX11Texture::GetStagedData()
 // -----------------------------------------------------------------------------------------------
 S_API void DX11Texture::Clear(void)
 {
-	if (IS_VALID_PTR(m_pStagedData))
-		free(m_pStagedData);
-
-	m_pStagedData = 0;
+	FreeStagedData();
 
 	SP_SAFE_RELEASE(m_pDXSRV);
 	SP_SAFE_RELEASE(m_pDXTexture);
-	SP_SAFE_RELEASE(m_pDXStagingTexture);
+	ReleaseArrayStagingTexture();
 
 	m_bLocked = false;
 
@@ -73,6 +73,10 @@ private:
 
 	void* m_pStagedData;
 
+	// Reported to the MemoryTracker as eMEMTAG_TEXTURE_STAGING
+	size_t m_StagedDataSz;
+	size_t m_StagingTextureSz;
+
 	// We can't copy subresources from the array staging texture to live texture
 	// while other slices are still locked. So we have to queue them up until all slices unlocked
 	std::vector<SLockedTextureArraySlice> m_DirtyArraySlices;
@@ -81,6 +85,9 @@ private:
 	bool CheckMipMapAutogenSupported(DXGI_FORMAT format);
 	SResult CreateEmptyIntrnl(unsigned int arraySize, unsigned int w, unsigned int h, unsigned int mipLevels, ETextureType type, SColor clearcolor);
 	SResult CreateArrayStagingTexture(const D3D11_SUBRESOURCE_DATA* pInitialData = 0);
+	void ReleaseArrayStagingTexture();
+	void SetStagedData(const void* pData, size_t sz);
+	void FreeStagedData();
 	unsigned int GetSubresourceIndex(unsigned int mipLevel, unsigned int arraySlice = 0);
 
 public:
@@ -88,7 +88,7 @@ struct S_API STerrainConstants
 	float segmentSize;
 
 	unsigned int numLayers; // max: MAX_TERRAIN_LAYERS_IN_SHADER
-	char __padding[12];
+	float3 origin; // world origin, subtracted from the terrain vertex positions
 
 	float4 layerParams[MAX_TERRAIN_LAYERS_IN_SHADER]; // for each layer, (scale, UNUSED, UNUSED, UNUSED)
 };
@@ -0,0 +1,261 @@
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+//	SpeedPoint Game Engine
+//	Copyright (c) 2011-2018 Pascal Rosenkranz, All rights reserved.
+//
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#include "UnitTest.h"
+#include <Common\BoundingVolumes.h>
+#include <Common\Quaternion.h>
+#include <vector>
+#include <random>
+
+using namespace SpeedPoint;
+using namespace SpeedPoint::UnitTest;
+
+namespace
+{
+	float RandomFloat(std::mt19937& rng, float min, float max)
+	{
+		return min + (max - min) * (float)(rng() & 0xFFFFFF) / (float)0xFFFFFF;
+	}
+
+	Vec3f RandomVec3(std::mt19937& rng, float min, float max)
+	{
+		return Vec3f(RandomFloat(rng, min, max), RandomFloat(rng, min, max), RandomFloat(rng, min, max));
+	}
+
+	Vec3f RandomDirection(std::mt19937& rng)
+	{
+		Vec3f d;
+		do
+		{
+			d = RandomVec3(rng, -1.0f, 1.0f);
+		} while (d.LengthSq() < 0.01f || d.LengthSq() > 1.0f);
+
+		return d.Normalized();
+	}
+
+	// Rotated box of 4 x 2 x 1 with 90% of the points crowded at one end, like a mesh with a detailed part.
+	// The first 8 points are the corners.
+	std::vector<Vec3f> BiasedBox(std::mt19937& rng, unsigned int n, const Quat& rotation)
+	{
+		std::vector<Vec3f> points(n);
+		for (unsigned int i = 0; i < n; ++i)
+		{
+			Vec3f p;
+			if (i < 8)
+				p = Vec3f((i & 1) ? 4.0f : 0, (i & 2) ? 2.0f : 0, (i & 4) ? 1.0f : 0);
+			else
+				p = Vec3f(RandomFloat(rng, 0, (i < n * 9 / 10) ? 0.4f : 4.0f), RandomFloat(rng, 0, 2.0f), RandomFloat(rng, 0, 1.0f));
+
+			points[i] = rotation * p;
+		}
+
+		return points;
+	}
+
+	// Points on the surface of a rotated ellipsoid
+	std::vector<Vec3f> Ellipsoid(std::mt19937& rng, unsigned int n, const Quat& rotation, const Vec3f& radii, const Vec3f& center)
+	{
+		std::vector<Vec3f> points(n);
+		for (unsigned int i = 0; i < n; ++i)
+			points[i] = rotation * (RandomDirection(rng) * radii) + center;
+
+		return points;
+	}
+
+	bool SphereContains(const BoundSphere& sphere, const std::vector<Vec3f>& points)
+	{
+		for (const Vec3f& p : points)
+		{
+			if ((p - sphere.c).Length() > sphere.r * 1.0001f + 1e-5f)
+				return false;
+		}
+
+		return true;
+	}
+
+	bool OBBContains(const OBB& obb, const std::vector<Vec3f>& points)
+	{
+		for (const Vec3f& p : points)
+		{
+			for (int j = 0; j < 3; ++j)
+			{
+				if (fabsf(Vec3Dot(p - obb.center, obb.directions[j])) > obb.dimensions[j] * 1.0001f + 1e-4f)
+					return false;
+			}
+		}
+
+		return true;
+	}
+
+	float Volume(const OBB& obb)
+	{
+		return 8.0f * obb.dimensions[0] * obb.dimensions[1] * obb.dimensions[2];
+	}
+
+	float Volume(const std::vector<Vec3f>& points)
+	{
+		AABB aabb;
+		aabb.Reset();
+		for (const Vec3f& p : points)
+			aabb.AddPoint(p);
+
+		Vec3f d = aabb.vMax - aabb.vMin;
+		return d.x * d.y * d.z;
+	}
+
+	template<unsigned int K>
+	bool KDOPIsTight(const KDOP<K>& dop, const std::vector<Vec3f>& points)
+	{
+		for (unsigned int i = 0; i < KDOP<K>::NUM_AXES; ++i)
+		{
+			float dmin = FLT_MAX, dmax = -FLT_MAX;
+			for (const Vec3f& p : points)
+			{
+				float d = Vec3Dot(KDOP<K>::GetAxis(i), p);
+				dmin = std::min(dmin, d);
+				dmax = std::max(dmax, d);
+			}
+
+			if (dop.dmin[i] != dmin || dop.dmax[i] != dmax)
+				return false;
+		}
+
+		for (const Vec3f& p : points)
+		{
+			if (!dop.ContainsPoint(p))
+				return false;
+		}
+
+		return true;
+	}
+}
+
+SP_TEST(BoundingVolumes_SphereFit)
+{
+	std::mt19937 rng(41);
+	for (unsigned int run = 0; run < 50; ++run)
+	{
+		unsigned int n = 1 + (rng() % 2000);
+		std::vector<Vec3f> points = Ellipsoid(rng, n, Quat::FromAxisAngle(RandomDirection(rng), RandomFloat(rng, -3.14f, 3.14f)),
+			RandomVec3(rng, 0.1f, 5.0f), RandomVec3(rng, -100.0f, 100.0f));
+
+		BoundSphere ritter = ComputeBoundSphereRitter(&points[0], n);
+		BoundSphere welzl = ComputeBoundSphereWelzl(&points[0], n);
+		SP_CHECK(SphereContains(ritter, points));
+		SP_CHECK(SphereContains(welzl, points));
+		SP_CHECK(welzl.r <= ritter.r * 1.0001f);
+	}
+
+	// Known minimal spheres
+	const float radius = 3.0f;
+	std::vector<Vec3f> sphere = Ellipsoid(rng, 5000, Quat(), Vec3f(radius), Vec3f(1.0f, 2.0f, 3.0f));
+	BoundSphere welzl = ComputeBoundSphereWelzl(&sphere[0], (unsigned int)sphere.size());
+	SP_CHECK(welzl.r <= radius * 1.0001f && welzl.r >= radius * 0.99f);
+
+	std::vector<Vec3f> box = BiasedBox(rng, 1000, Quat::FromAxisAngle(Vec3f(1.0f, 1.0f, 0).Normalized(), 0.5f));
+	welzl = ComputeBoundSphereWelzl(&box[0], (unsigned int)box.size());
+	SP_CHECK_NEAR(welzl.r, sqrtf(21.0f) * 0.5f, 1e-4f);
+
+	Vec3f line[3] = { Vec3f(0), Vec3f(1.0f), Vec3f(2.0f) };
+	welzl = ComputeBoundSphereWelzl(line, 3);
+	SP_CHECK_NEAR(welzl.r, sqrtf(3.0f), 1e-5f);
+	SP_CHECK_NEAR(welzl.c.y, 1.0f, 1e-5f);
+
+	welzl = ComputeBoundSphereWelzl(line, 0);
+	SP_CHECK(welzl.r == 0);
+}
+
+SP_TEST(BoundingVolumes_OBBFit)
+{
+	std::mt19937 rng(42);
+	for (unsigned int run = 0; run < 20; ++run)
+	{
+		Quat rotation = Quat::FromAxisAngle(RandomDirection(rng), RandomFloat(rng, -3.14f, 3.14f));
+		std::vector<Vec3f> points = (run % 2 == 0)
+			? BiasedBox(rng, 2000, rotation)
+			: Ellipsoid(rng, 2000, rotation, RandomVec3(rng, 0.1f, 5.0f), RandomVec3(rng, -100.0f, 100.0f));
+
+		float aabbVolume = Volume(points);
+		OBB pcaPoints = ComputeOBB(&points[0], (unsigned int)points.size(), eOBB_FIT_PCA_POINTS);
+		OBB pcaHull = ComputeOBB(&points[0], (unsigned int)points.size(), eOBB_FIT_PCA_HULL);
+		SP_CHECK(OBBContains(pcaPoints, points));
+		SP_CHECK(OBBContains(pcaHull, points));
+		SP_CHECK(Volume(pcaPoints) <= aabbVolume * 1.0001f);
+		SP_CHECK(Volume(pcaHull) <= aabbVolume * 1.0001f);
+
+		for (int j = 0; j < 3; ++j)
+			SP_CHECK_NEAR(pcaHull.directions[j].Length(), 1.0f, 1e-4f);
+	}
+
+	// The vertex distribution tilts the principal axes of the points, but not those of the hull
+	std::vector<Vec3f> box = BiasedBox(rng, 20000, Quat::FromAxisAngle(Vec3f(1.0f, 1.0f, 0).Normalized(), 0.5f));
+	OBB pcaPoints = ComputeOBB(&box[0], (unsigned int)box.size(), eOBB_FIT_PCA_POINTS);
+	OBB pcaHull = ComputeOBB(&box[0], (unsigned int)box.size(), eOBB_FIT_PCA_HULL);
+	SP_CHECK_NEAR(Volume(pcaHull), 8.0f, 8.0f * 0.01f);
+	SP_CHECK(Volume(pcaHull) < Volume(pcaPoints));
+
+	// Flat point set
+	std::vector<Vec3f> flat = { Vec3f(0, 0, 0), Vec3f(1.0f, 0, 0), Vec3f(0, 0, 1.0f), Vec3f(1.0f, 0, 1.0f), Vec3f(0.5f, 0, 0.5f) };
+	OBB flatOBB = ComputeOBB(&flat[0], (unsigned int)flat.size());
+	SP_CHECK(OBBContains(flatOBB, flat));
+	SP_CHECK(Volume(flatOBB) < 1e-5f);
+}
+
+SP_TEST(BoundingVolumes_KDOPFit)
+{
+	std::mt19937 rng(43);
+	std::vector<Vec3f> points = Ellipsoid(rng, 5000, Quat::FromAxisAngle(RandomDirection(rng), 0.7f), Vec3f(4.0f, 1.5f, 0.5f), Vec3f(10.0f, 0, -3.0f));
+	KDOP<14> dop14 = ComputeKDOP<14>(&points[0], (unsigned int)points.size());
+	KDOP<18> dop18 = ComputeKDOP<18>(&points[0], (unsigned int)points.size());
+	KDOP<26> dop26 = ComputeKDOP<26>(&points[0], (unsigned int)points.size());
+	SP_CHECK(KDOPIsTight(dop14, points));
+	SP_CHECK(KDOPIsTight(dop18, points));
+	SP_CHECK(KDOPIsTight(dop26, points));
+
+	// The first three slabs are the AABB, the diagonal slabs cut off its corners
+	AABB aabb = dop26.GetAABB();
+	SP_CHECK(aabb.vMin.x == dop14.dmin[0] && aabb.vMax.z == dop14.dmax[2]);
+	SP_CHECK(!dop14.ContainsPoint(aabb.vMin) && !dop26.ContainsPoint(aabb.vMax));
+}
+
+// Fit time and tightness of the volumes for a typical mesh vertex set
+SP_BENCHMARK(BoundingVolumes_Fit)
+{
+	std::mt19937 rng(44);
+	const unsigned int n = 100000;
+	const unsigned int numRuns = 10;
+	std::vector<Vec3f> points = BiasedBox(rng, n, Quat::FromAxisAngle(Vec3f(1.0f, 1.0f, 0).Normalized(), 0.5f));
+
+
+	// Uniform cloud in a cube, where Ritter's initial diameter is usually not the final one
+	std::vector<Vec3f> cloud(n);
+	for (unsigned int i = 0; i < n; ++i)
+		cloud[i] = RandomVec3(rng, -1.0f, 1.0f);
+
+	BoundSphere ritter, welzl;
+	OBB pcaPoints, pcaHull;
+	KDOP<14> dop14;
+	KDOP<26> dop26;
+	double tRitter = MeasureMin(numRuns, [&]() { ritter = ComputeBoundSphereRitter(&cloud[0], n); });
+	double tWelzl = MeasureMin(numRuns, [&]() { welzl = ComputeBoundSphereWelzl(&cloud[0], n); });
+	double tPCAPoints = MeasureMin(numRuns, [&]() { pcaPoints = ComputeOBB(&points[0], n, eOBB_FIT_PCA_POINTS); });
+	double tPCAHull = MeasureMin(numRuns, [&]() { pcaHull = ComputeOBB(&points[0], n, eOBB_FIT_PCA_HULL); });
+	double tDOP14 = MeasureMin(numRuns, [&]() { dop14 = ComputeKDOP<14>(&points[0], n); });
+	double tDOP26 = MeasureMin(numRuns, [&]() { dop26 = ComputeKDOP<26>(&points[0], n); });
+	DoNotOptimize(dop14);
+	DoNotOptimize(dop26);
+
+	printf("  %u points in a cube with minimal sphere r <= %.3f\n", n, sqrtf(3.0f));
+	printf("  Ritter       r = %.3f  %7.2f ms\n", ritter.r, tRitter * 1e3);
+	printf("  Welzl        r = %.3f  %7.2f ms\n", welzl.r, tWelzl * 1e3);
+	printf("  %u points in a box of volume 8\n", n);
+	printf("  OBB points   V = %.3f  %7.2f ms\n", Volume(pcaPoints), tPCAPoints * 1e3);
+	printf("  OBB hull     V = %.3f  %7.2f ms\n", Volume(pcaHull), tPCAHull * 1e3);
+	printf("  AABB         V = %.3f\n", Volume(points));
+	printf("  14-DOP               %7.2f ms\n", tDOP14 * 1e3);
+	printf("  26-DOP               %7.2f ms\n", tDOP26 * 1e3);
+}
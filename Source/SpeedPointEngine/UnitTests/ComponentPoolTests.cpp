@@ -0,0 +1,111 @@
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+//	SpeedPoint Game Engine
+//	Copyright (c) 2011-2018 Pascal Rosenkranz, All rights reserved.
+//
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#include "UnitTest.h"
+#include <Common\ComponentPool.h>
+#include <vector>
+
+using namespace SpeedPoint::UnitTest;
+
+namespace
+{
+	struct ITestComponent
+	{
+		virtual ~ITestComponent() {}
+		virtual unsigned int GetId() const = 0;
+	};
+
+	struct CTestComponent : public ITestComponent
+	{
+		unsigned int id;
+		float payload[12];
+
+		virtual unsigned int GetId() const { return id; }
+	};
+
+	typedef ComponentPool<ITestComponent, CTestComponent> TestComponentPool;
+}
+
+SP_TEST(ComponentPool_ForEachVisitsAll)
+{
+	TestComponentPool pool;
+	std::vector<ITestComponent*> components(100);
+	for (unsigned int i = 0; i < components.size(); ++i)
+		static_cast<CTestComponent*>(components[i] = pool.Get())->id = i;
+
+	// Release every third component from inside the interface ForEach()
+	IComponentPool<ITestComponent>* pInterface = &pool;
+	std::vector<unsigned int> numVisits(components.size(), 0);
+	pInterface->ForEach([&](ITestComponent* pComponent)
+	{
+		unsigned int id = pComponent->GetId();
+		++numVisits[id];
+		if (id % 3 == 0 && id + 1 < components.size() && components[id + 1])
+			pInterface->Release(&components[id + 1]);
+	});
+
+	// Components are visited in creation order, so the released ones were not visited before
+	for (unsigned int i = 0; i < components.size(); ++i)
+		SP_CHECK(numVisits[i] == (components[i] ? 1u : 0u));
+
+	unsigned int numTyped = 0;
+	pool.ForEach([&numTyped](CTestComponent* pComponent) { ++numTyped; });
+	SP_CHECK(numTyped == pInterface->GetNumObjects());
+
+	unsigned int numRangeFor = 0;
+	for (CTestComponent* pComponent : pool)
+		numRangeFor += (pComponent ? 1 : 0);
+
+	SP_CHECK(numRangeFor == numTyped);
+}
+
+// Iteration cost per component of the different ways to walk a component pool
+SP_BENCHMARK(ComponentPool_Iterate)
+{
+	const unsigned int sizes[] = { 1000, 10000, 100000 };
+	for (unsigned int size : sizes)
+	{
+		TestComponentPool pool;
+		for (unsigned int i = 0; i < size; ++i)
+			static_cast<CTestComponent*>(pool.Get())->id = i;
+
+		// Keep the compiler from devirtualizing the interface calls
+		IComponentPool<ITestComponent>* volatile pOpaqueInterface = &pool;
+		IComponentPool<ITestComponent>* pInterface = pOpaqueInterface;
+
+		unsigned int numRuns = (size >= 100000 ? 5 : 20);
+		unsigned int sum = 0;
+
+		// Virtual GetFirst()/GetNext() per component, as all loops did before
+		double getNext = MeasureMin(numRuns, [&]()
+		{
+			unsigned int id;
+			for (ITestComponent* pComponent = pInterface->GetFirst(id); pComponent; pComponent = pInterface->GetNext(id))
+				sum += static_cast<CTestComponent*>(pComponent)->id;
+		});
+
+		double interfaceForEach = MeasureMin(numRuns, [&]()
+		{
+			pInterface->ForEach([&sum](ITestComponent* pComponent) { sum += static_cast<CTestComponent*>(pComponent)->id; });
+		});
+
+		double typedForEach = MeasureMin(numRuns, [&]()
+		{
+			pool.ForEach([&sum](CTestComponent* pComponent) { sum += pComponent->id; });
+		});
+
+		double rangeFor = MeasureMin(numRuns, [&]()
+		{
+			for (CTestComponent* pComponent : pool)
+				sum += pComponent->id;
+		});
+
+		DoNotOptimize(sum);
+		printf("  %6u components: GetFirst/GetNext %5.2f ns, IComponentPool::ForEach %5.2f ns, ComponentPool::ForEach %5.2f ns, range-for %5.2f ns\n",
+			size, getNext * 1e9 / size, interfaceForEach * 1e9 / size, typedForEach * 1e9 / size, rangeFor * 1e9 / size);
+	}
+}
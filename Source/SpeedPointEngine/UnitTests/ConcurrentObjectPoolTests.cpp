@@ -0,0 +1,164 @@
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+//	SpeedPoint Game Engine
+//	Copyright (c) 2011-2018 Pascal Rosenkranz, All rights reserved.
+//
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#include "UnitTest.h"
+#include <Common\ConcurrentObjectPool.h>
+#include <vector>
+#include <random>
+#include <thread>
+#include <atomic>
+#include <algorithm>
+
+using namespace SpeedPoint::UnitTest;
+
+namespace
+{
+	struct SStressObject
+	{
+		unsigned int owner; // thread index
+		unsigned int sequence;
+	};
+
+	struct SLiveObject
+	{
+		SStressObject* pObject;
+		ObjectPoolHandle handle;
+		unsigned int sequence;
+	};
+}
+
+// N threads get and release objects at random. Each thread writes its index and a sequence number
+// into its objects and checks that they are unchanged when releasing them. If two threads got the
+// same slot, one of them finds the other one's values.
+SP_TEST(ConcurrentObjectPool_Stress)
+{
+	const unsigned int numThreads = 8;
+	const unsigned int numOpsPerThread = 200000;
+	const unsigned int maxLivePerThread = 300;
+
+	ConcurrentObjectPool<SStressObject, 16> pool;
+	std::atomic<unsigned int> numCorrupted(0), numStaleResolved(0), numFailedGets(0);
+	std::vector<std::vector<SLiveObject>> live(numThreads);
+	std::atomic<bool> start(false);
+
+	std::vector<std::thread> threads;
+	for (unsigned int thread = 0; thread < numThreads; ++thread)
+	{
+		threads.emplace_back([&, thread]()
+		{
+			std::mt19937 rng(thread + 1);
+			std::vector<SLiveObject>& objects = live[thread];
+			unsigned int sequence = 0;
+
+			while (!start.load())
+				std::this_thread::yield();
+
+			for (unsigned int op = 0; op < numOpsPerThread; ++op)
+			{
+				// Also interleave the threads on machines with few cores
+				if ((op & 63) == 0)
+					std::this_thread::yield();
+
+				bool get = objects.empty() || (objects.size() < maxLivePerThread && (rng() & 1));
+				if (get)
+				{
+					SLiveObject object;
+					object.pObject = pool.Get(&object.handle);
+					if (!object.pObject)
+					{
+						++numFailedGets;
+						continue;
+					}
+
+					object.sequence = ++sequence;
+					object.pObject->owner = thread;
+					object.pObject->sequence = object.sequence;
+					objects.push_back(object);
+				}
+				else
+				{
+					unsigned int i = rng() % objects.size();
+					SLiveObject object = objects[i];
+					objects[i] = objects.back();
+					objects.pop_back();
+
+					if (object.pObject->owner != thread || object.pObject->sequence != object.sequence)
+						++numCorrupted;
+
+					if (pool.Resolve(object.handle) != object.pObject)
+						++numCorrupted;
+
+					// Alternate between releasing by pointer and by handle
+					ObjectPoolHandle handle = object.handle;
+					if (rng() & 1)
+						pool.Release(&object.pObject);
+					else
+						pool.Release(object.handle);
+
+					if (pool.Resolve(handle))
+						++numStaleResolved;
+				}
+			}
+		});
+	}
+
+	start.store(true);
+	for (std::thread& thread : threads)
+		thread.join();
+
+	SP_CHECK(numCorrupted.load() == 0);
+	SP_CHECK(numStaleResolved.load() == 0);
+	SP_CHECK(numFailedGets.load() == 0);
+
+	// The remaining objects are all distinct and intact
+	std::vector<SStressObject*> remaining;
+	for (unsigned int thread = 0; thread < numThreads; ++thread)
+	{
+		for (const SLiveObject& object : live[thread])
+		{
+			SP_CHECK(object.pObject->owner == thread && object.pObject->sequence == object.sequence);
+			remaining.push_back(object.pObject);
+		}
+	}
+
+	std::sort(remaining.begin(), remaining.end());
+	SP_CHECK(std::adjacent_find(remaining.begin(), remaining.end()) == remaining.end());
+	SP_CHECK(pool.GetUsedObjectCount() == remaining.size());
+
+	unsigned int numIterated = 0;
+	pool.ForEach([&numIterated](SStressObject* pObject) { ++numIterated; });
+	SP_CHECK(numIterated == remaining.size());
+
+	pool.ReleaseAll();
+	SP_CHECK(pool.GetUsedObjectCount() == 0);
+}
+
+SP_TEST(ConcurrentObjectPool_StaleHandleAfterClear)
+{
+	ConcurrentObjectPool<SStressObject, 8> pool;
+	std::vector<ObjectPoolHandle> handles(20);
+	for (unsigned int i = 0; i < handles.size(); ++i)
+		pool.Get(&handles[i])->sequence = i;
+
+	for (unsigned int i = 0; i < handles.size(); i += 3)
+	{
+		pool.Release(handles[i]);
+		pool.Get(&handles[i])->sequence = i;
+	}
+
+	pool.Clear();
+
+	std::vector<ObjectPoolHandle> newHandles(handles.size());
+	for (unsigned int i = 0; i < newHandles.size(); ++i)
+		pool.Get(&newHandles[i])->sequence = 100 + i;
+
+	for (unsigned int i = 0; i < handles.size(); ++i)
+	{
+		SP_CHECK(pool.Resolve(handles[i]) == 0);
+		SP_CHECK(pool.Resolve(newHandles[i]) != 0 && pool.Resolve(newHandles[i])->sequence == 100 + i);
+	}
+}
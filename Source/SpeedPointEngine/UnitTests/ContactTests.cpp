@@ -0,0 +1,240 @@
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+//	SpeedPoint Game Engine
+//	Copyright (c) 2011-2018 Pascal Rosenkranz, All rights reserved.
+//
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#include "UnitTest.h"
+#include <Common\ContactManifold.h>
+#include <Physics\Implementation\ContactSolver.h>
+#include <vector>
+#include <algorithm>
+#include <cfloat>
+
+using namespace SpeedPoint;
+using namespace SpeedPoint::geo;
+using namespace SpeedPoint::UnitTest;
+
+namespace
+{
+	box AxisAlignedBox(const Vec3f& center, const Vec3f& dim)
+	{
+		box b;
+		b.c = center;
+		b.axis[0] = Vec3f(1.0f, 0, 0);
+		b.axis[1] = Vec3f(0, 1.0f, 0);
+		b.axis[2] = Vec3f(0, 0, 1.0f);
+		b.dim = dim;
+		return b;
+	}
+
+	// Box with half-dimensions dim, or a static object if mass is 0
+	SPhysObjectState BoxState(const Vec3f& pos, const Vec3f& dim, float mass)
+	{
+		SPhysObjectState state;
+		state.pos = pos;
+		state.v = state.P = state.w = state.L = Vec3f(0);
+		state.M = mass;
+		state.Minv = (mass > 0) ? 1.0f / mass : 0;
+		state.Iinv = Mat33(0.0f);
+		if (mass > 0)
+		{
+			state.Iinv._11 = 3.0f / (mass * (dim.y * dim.y + dim.z * dim.z));
+			state.Iinv._22 = 3.0f / (mass * (dim.x * dim.x + dim.z * dim.z));
+			state.Iinv._33 = 3.0f / (mass * (dim.x * dim.x + dim.y * dim.y));
+		}
+
+		return state;
+	}
+
+	struct SStack
+	{
+		std::vector<SPhysObjectState> states; // states[0] is the static ground
+		std::vector<Vec3f> dims;
+		std::vector<SContactConstraint> constraints, prevConstraints; // constraints[i] between box i and i + 1
+	};
+
+	// Stack of numBoxes cubes of edge length 1 on a static ground box, each overlapping the one below by 1mm
+	SStack CreateStack(unsigned int numBoxes)
+	{
+		SStack stack;
+		stack.dims.push_back(Vec3f(10.0f, 1.0f, 10.0f));
+		stack.states.push_back(BoxState(Vec3f(0, -1.0f, 0), stack.dims[0], 0));
+		for (unsigned int i = 0; i < numBoxes; ++i)
+		{
+			stack.dims.push_back(Vec3f(0.5f));
+			stack.states.push_back(BoxState(Vec3f(0, 0.499f + 0.999f * i, 0), stack.dims.back(), 1.0f));
+		}
+
+		stack.constraints.resize(numBoxes);
+		stack.prevConstraints.resize(numBoxes);
+		for (SContactConstraint& constraint : stack.prevConstraints)
+			constraint.manifold.num_points = 0;
+
+		return stack;
+	}
+
+	// One step of the rigid body pipeline as in PhysObject::Update() and CPhysics::Update(): integration, gravity,
+	// contact manifolds, sequential impulses and the position correction. The boxes are not rotated.
+	void StepStack(SStack& stack, float dt, unsigned int numIterations, bool warmStart)
+	{
+		for (unsigned int i = 1; i < stack.states.size(); ++i)
+		{
+			SPhysObjectState& state = stack.states[i];
+			state.v = state.P * state.Minv;
+			state.w = state.Iinv * state.L;
+			state.pos += state.v * dt;
+			state.P += Vec3f(0, -9.81f, 0) * (state.M * dt);
+		}
+
+		for (unsigned int i = 0; i < stack.constraints.size(); ++i)
+		{
+			box lower = AxisAlignedBox(stack.states[i].pos, stack.dims[i]);
+			box upper = AxisAlignedBox(stack.states[i + 1].pos, stack.dims[i + 1]);
+			SContactConstraint& constraint = stack.constraints[i];
+			if (!_ContactManifold(&lower, &upper, &constraint.manifold))
+				constraint.manifold.num_points = 0;
+
+			PrepareContactConstraint(constraint, &stack.states[i], &stack.states[i + 1], warmStart ? &stack.prevConstraints[i] : 0);
+		}
+
+		for (unsigned int i = 0; i < stack.constraints.size(); ++i)
+			WarmStartContactConstraint(stack.constraints[i], &stack.states[i], &stack.states[i + 1]);
+
+		for (unsigned int iteration = 0; iteration < numIterations; ++iteration)
+		{
+			for (unsigned int i = 0; i < stack.constraints.size(); ++i)
+				SolveContactConstraint(stack.constraints[i], &stack.states[i], &stack.states[i + 1]);
+		}
+
+		for (SContactConstraint& constraint : stack.constraints)
+		{
+			float mindist = 0;
+			for (unsigned int ipt = 0; ipt < constraint.manifold.num_points; ++ipt)
+				mindist = min(mindist, constraint.manifold.points[ipt].dist);
+
+			SPhysObjectState *A = &stack.states[&constraint - &stack.constraints[0]], *B = A + 1;
+			Vec3f dv = (constraint.manifold.n * mindist) / (A->Minv + B->Minv);
+			A->pos += (dv * A->Minv) / 5.0f;
+			B->pos -= (dv * B->Minv) / 5.0f;
+		}
+
+		stack.prevConstraints.swap(stack.constraints);
+	}
+
+	float TotalNormalImpulse(const SContactConstraint& constraint)
+	{
+		float jn = 0;
+		for (unsigned int ipt = 0; ipt < constraint.manifold.num_points; ++ipt)
+			jn += constraint.jn[ipt];
+		return jn;
+	}
+}
+
+// A box resting flat on a plane touches it with the 4 corners of its bottom face
+SP_TEST(Contact_BoxOnPlaneManifold)
+{
+	plane ground(Vec3f(0, 1.0f, 0), 0.0f);
+	box b = AxisAlignedBox(Vec3f(1.0f, 0.49f, -2.0f), Vec3f(1.0f, 0.5f, 2.0f));
+
+	SContactManifold manifold;
+	SP_CHECK(_ContactManifold(&ground, &b, &manifold));
+	SP_CHECK(manifold.num_points == 4);
+	SP_CHECK_NEAR(manifold.n.y, 1.0f, 1e-6f);
+
+	float minX = FLT_MAX, maxX = -FLT_MAX, minZ = FLT_MAX, maxZ = -FLT_MAX;
+	for (unsigned int ipt = 0; ipt < manifold.num_points; ++ipt)
+	{
+		const SContactPoint& pt = manifold.points[ipt];
+		SP_CHECK_NEAR(pt.dist, -0.01f, 1e-5f);
+		SP_CHECK_NEAR(pt.p.y, 0, 1e-5f); // on the plane
+		minX = std::min(minX, pt.p.x);
+		maxX = std::max(maxX, pt.p.x);
+		minZ = std::min(minZ, pt.p.z);
+		maxZ = std::max(maxZ, pt.p.z);
+
+		// Distinct ids
+		for (unsigned int j = 0; j < ipt; ++j)
+			SP_CHECK(manifold.points[j].id != pt.id);
+	}
+
+	SP_CHECK_NEAR(minX, 0, 1e-5f);
+	SP_CHECK_NEAR(maxX, 2.0f, 1e-5f);
+	SP_CHECK_NEAR(minZ, -4.0f, 1e-5f);
+	SP_CHECK_NEAR(maxZ, 0, 1e-5f);
+
+	// The ids of the corners stay the same when the box sinks in further, so the contacts can be warm-started
+	box deeper = b;
+	deeper.c.y -= 0.02f;
+	SContactManifold manifold2;
+	SP_CHECK(_ContactManifold(&ground, &deeper, &manifold2));
+	SP_CHECK(manifold2.num_points == 4);
+	for (unsigned int ipt = 0; ipt < manifold.num_points; ++ipt)
+	{
+		int i2 = manifold2.FindPoint(manifold.points[ipt].id);
+		SP_CHECK(i2 >= 0);
+		if (i2 >= 0)
+			SP_CHECK((manifold2.points[i2].p - manifold.points[ipt].p).Length() < 1e-5f);
+	}
+
+	// Swapped shapes: normal from the box to the plane, points on the box
+	SContactManifold flipped;
+	SP_CHECK(_ContactManifold(&b, &ground, &flipped));
+	SP_CHECK(flipped.num_points == 4);
+	SP_CHECK_NEAR(flipped.n.y, -1.0f, 1e-6f);
+	for (unsigned int ipt = 0; ipt < flipped.num_points; ++ipt)
+		SP_CHECK_NEAR(flipped.points[ipt].p.y, -0.01f, 1e-5f);
+
+	// Resting on a ground box instead of the plane
+	box groundBox = AxisAlignedBox(Vec3f(0, -5.0f, 0), Vec3f(10.0f, 5.0f, 10.0f));
+	SContactManifold boxManifold;
+	SP_CHECK(_ContactManifold(&groundBox, &b, &boxManifold));
+	SP_CHECK(boxManifold.num_points == 4);
+	SP_CHECK_NEAR(boxManifold.n.y, 1.0f, 1e-6f);
+
+	// Tilted about z, only the two corners of one edge touch
+	box tilted = b;
+	float angle = 0.1f;
+	tilted.axis[0] = Vec3f(cosf(angle), sinf(angle), 0);
+	tilted.axis[1] = Vec3f(-sinf(angle), cosf(angle), 0);
+	tilted.c.y = 0.5f * cosf(angle) + 1.0f * sinf(angle) - 0.01f;
+	SP_CHECK(_ContactManifold(&ground, &tilted, &manifold));
+	SP_CHECK(manifold.num_points == 2);
+}
+
+// Boxes resting on each other with as many solver iterations as CPhysics. With the impulses of the last step as initial
+// guess, the iterations converge to the impulses that carry the weight of the stack over the steps and it does not sink.
+SP_TEST(Contact_StackWarmStart)
+{
+	const float dt = 1.0f / 60.0f;
+	const unsigned int numBoxes = 5, numSteps = 120, numIterations = 4;
+
+	SStack warm = CreateStack(numBoxes), cold = CreateStack(numBoxes);
+	float startY = warm.states[numBoxes].pos.y;
+	for (unsigned int step = 0; step < numSteps; ++step)
+	{
+		StepStack(warm, dt, numIterations, true);
+		StepStack(cold, dt, numIterations, false);
+	}
+
+	// Each contact keeps its 4 points and carries the weight of the boxes above it
+	for (unsigned int i = 0; i < numBoxes; ++i)
+	{
+		const SContactConstraint& constraint = warm.prevConstraints[i];
+		SP_CHECK(constraint.manifold.num_points == 4);
+
+		float weight = 9.81f * dt * (numBoxes - i);
+		SP_CHECK_NEAR(TotalNormalImpulse(constraint), weight, 0.05f * weight);
+	}
+
+	// Vertically at rest. The boxes are never rotated here, so the angular velocity leaves some tangential wobble.
+	for (unsigned int i = 1; i <= numBoxes; ++i)
+		SP_CHECK(fabsf(warm.states[i].v.y) < 0.01f);
+
+	float warmSink = startY - warm.states[numBoxes].pos.y;
+	float coldSink = startY - cold.states[numBoxes].pos.y;
+	SP_CHECK(warmSink < 0.02f);
+	SP_CHECK(coldSink > 10.0f * warmSink);
+	printf("  top box of %u sank by %.4f with warm-starting, %.4f without after %u steps\n", numBoxes, warmSink, coldSink, numSteps);
+}
@@ -0,0 +1,249 @@
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+//	SpeedPoint Game Engine
+//	Copyright (c) 2011-2018 Pascal Rosenkranz, All rights reserved.
+//
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#include "UnitTest.h"
+#include <Common\geo.h>
+#include <Common\Quaternion.h>
+#include <vector>
+#include <random>
+#include <algorithm>
+
+using namespace SpeedPoint;
+using namespace SpeedPoint::geo;
+using namespace SpeedPoint::UnitTest;
+
+namespace
+{
+	float RandomFloat(std::mt19937& rng, float min, float max)
+	{
+		return min + (max - min) * (float)(rng() & 0xFFFFFF) / (float)0xFFFFFF;
+	}
+
+	Vec3f RandomVec3(std::mt19937& rng, float min, float max)
+	{
+		return Vec3f(RandomFloat(rng, min, max), RandomFloat(rng, min, max), RandomFloat(rng, min, max));
+	}
+
+	Vec3f RandomDirection(std::mt19937& rng)
+	{
+		Vec3f v;
+		do
+		{
+			v = RandomVec3(rng, -1.0f, 1.0f);
+		} while (v.LengthSq() < 0.01f || v.LengthSq() > 1.0f);
+
+		return v.Normalized();
+	}
+
+	// Points in a cube or close to the surface of a sphere
+	std::vector<Vec3f> RandomCloud(std::mt19937& rng, unsigned int n, bool sphere)
+	{
+		std::vector<Vec3f> points(n);
+		for (Vec3f& p : points)
+			p = sphere ? RandomDirection(rng) * RandomFloat(rng, 0.9f, 1.0f) : RandomVec3(rng, -1.0f, 1.0f);
+		return points;
+	}
+
+	// Rotation, non-uniform scale and translation
+	Mat44 RandomTransform(std::mt19937& rng)
+	{
+		Quat q = Quat::FromAxisAngle(RandomDirection(rng), RandomFloat(rng, -3.14f, 3.14f));
+		Mat44 mtx;
+		MakeTransformationTRS(RandomVec3(rng, -3.0f, 3.0f), q, RandomVec3(rng, 0.5f, 2.0f), &mtx);
+		return mtx;
+	}
+
+	Vec3f BruteForceSupport(const std::vector<Vec3f>& points, const Vec3f& d)
+	{
+		Vec3f best = points[0];
+		for (const Vec3f& p : points)
+		{
+			if (Vec3Dot(p, d) > Vec3Dot(best, d))
+				best = p;
+		}
+
+		return best;
+	}
+}
+
+// Hill climbing and the linear search find the farthest point of the input in all directions, also transformed
+SP_TEST(ConvexHull_Support)
+{
+	std::mt19937 rng(81);
+	unsigned int numHillClimbing = 0;
+	for (unsigned int i = 0; i < 200; ++i)
+	{
+		unsigned int n = 8 + rng() % 600;
+		std::vector<Vec3f> points = RandomCloud(rng, n, (i & 1) != 0);
+		convex_hull hull;
+		SP_CHECK(hull.Create(&points[0], n));
+		if (!hull.data)
+			continue;
+
+		if (hull.data->num_points > CONVEX_HULL_HILL_CLIMBING_MIN_POINTS)
+			++numHillClimbing;
+
+		Mat44 mtx = RandomTransform(rng);
+		hull.Transform(mtx);
+		std::vector<Vec3f> worldPoints(n);
+		for (unsigned int j = 0; j < n; ++j)
+			worldPoints[j] = (mtx * Vec4f(points[j], 1.0f)).xyz();
+
+		// Coherent directions with the hint of the last query as during GJK, and random ones without
+		unsigned int hint = 0;
+		Vec3f d = RandomDirection(rng);
+		for (unsigned int j = 0; j < 200; ++j)
+		{
+			d = (j & 1) ? RandomDirection(rng) : (d + RandomVec3(rng, -0.1f, 0.1f)).Normalized();
+			Vec3f expected = BruteForceSupport(worldPoints, d);
+			Vec3f withHint = hull.Support(d, &hint);
+			Vec3f withoutHint = hull.Support(d);
+			SP_CHECK(Vec3Dot(withHint, d) >= Vec3Dot(expected, d) - 1e-4f);
+			SP_CHECK(Vec3Dot(withoutHint, d) >= Vec3Dot(expected, d) - 1e-4f);
+		}
+	}
+
+	SP_CHECK(numHillClimbing > 50);
+}
+
+// Volume and center of mass against boxes and tetrahedrons, and the face planes against the input points
+SP_TEST(ConvexHull_MassProperties)
+{
+	std::mt19937 rng(82);
+
+	// Box corners with points inside, which must not change the hull
+	Vec3f dim(1.0f, 2.0f, 3.0f), center(0.5f, -1.0f, 2.0f);
+	std::vector<Vec3f> boxPoints;
+	for (int k = 0; k < 8; ++k)
+		boxPoints.push_back(center + Vec3f((k & 1) ? dim.x : -dim.x, (k & 2) ? dim.y : -dim.y, (k & 4) ? dim.z : -dim.z));
+
+	for (int k = 0; k < 100; ++k)
+		boxPoints.push_back(center + Vec3f(RandomFloat(rng, -dim.x, dim.x), RandomFloat(rng, -dim.y, dim.y), RandomFloat(rng, -dim.z, dim.z)) * 0.99f);
+
+	convex_hull boxHull;
+	SP_CHECK(boxHull.Create(&boxPoints[0], (unsigned int)boxPoints.size()));
+	SP_CHECK(boxHull.data->num_points == 8);
+	SP_CHECK_NEAR(boxHull.data->volume, 48.0f, 1e-3f);
+	SP_CHECK((boxHull.data->center - center).Length() < 1e-4f);
+
+	// The volume scales with the determinant of the transform
+	Mat44 mtx;
+	MakeTransformationTRS(Vec3f(1.0f, 2.0f, 3.0f), Quat::FromAxisAngle(Vec3f(0, 1.0f, 0), 0.7f), Vec3f(1.0f, 2.0f, 0.5f), &mtx);
+	boxHull.Transform(mtx);
+	SP_CHECK_NEAR(boxHull.GetVolume(), 48.0f, 1e-3f);
+
+	// Tetrahedrons: V = |det(b - a, c - a, d - a)| / 6, center is the mean of the corners
+	for (unsigned int i = 0; i < 100; ++i)
+	{
+		Vec3f p[4];
+		for (int j = 0; j < 4; ++j)
+			p[j] = RandomVec3(rng, -2.0f, 2.0f);
+
+		float V = fabsf(Vec3Dot(p[1] - p[0], (p[2] - p[0]) ^ (p[3] - p[0]))) / 6.0f;
+		if (V < 0.1f)
+			continue;
+
+		convex_hull tet;
+		SP_CHECK(tet.Create(p, 4));
+		SP_CHECK_NEAR(tet.data->volume, V, 1e-4f * V + 1e-5f);
+		SP_CHECK((tet.data->center - (p[0] + p[1] + p[2] + p[3]) * 0.25f).Length() < 1e-4f);
+	}
+
+	// Random clouds: all points lie behind all outward face planes, so the volume is below the one of the
+	// bounding box and the center of mass inside
+	for (unsigned int i = 0; i < 100; ++i)
+	{
+		unsigned int n = 8 + rng() % 400;
+		std::vector<Vec3f> points = RandomCloud(rng, n, (i & 1) != 0);
+		convex_hull hull;
+		SP_CHECK(hull.Create(&points[0], n));
+		if (!hull.data)
+			continue;
+
+		const convex_hull_data* pdata = hull.data;
+		float maxDist = -FLT_MAX, maxCenterDist = -FLT_MAX;
+		for (unsigned int f = 0; f < pdata->num_faces; ++f)
+		{
+			for (const Vec3f& p : points)
+				maxDist = std::max(maxDist, Vec3Dot(pdata->normals[f], p) - pdata->dists[f]);
+
+			maxCenterDist = std::max(maxCenterDist, Vec3Dot(pdata->normals[f], pdata->center) - pdata->dists[f]);
+		}
+
+		SP_CHECK(maxDist < 1e-4f);
+		SP_CHECK(maxCenterDist < 0);
+		SP_CHECK(pdata->volume > 0 && pdata->volume <= 8.0f);
+		if ((i & 1) && n >= 200)
+			SP_CHECK(pdata->volume > 0.5f * (4.0f / 3.0f) * SP_PI * 0.9f * 0.9f * 0.9f);
+	}
+
+	// Degenerate inputs do not create a hull
+	Vec3f flat[5] = { Vec3f(0, 0, 0), Vec3f(1.0f, 0, 0), Vec3f(0, 0, 1.0f), Vec3f(1.0f, 0, 1.0f), Vec3f(0.5f, 0, 0.5f) };
+	convex_hull degenerate;
+	SP_CHECK(!degenerate.Create(flat, 5));
+	SP_CHECK(!degenerate.data);
+}
+
+SP_BENCHMARK(ConvexHull_SupportQueries)
+{
+	std::mt19937 rng(83);
+	const unsigned int numQueries = 100000;
+	std::vector<Vec3f> directions(numQueries);
+	Vec3f d = RandomDirection(rng);
+	for (Vec3f& dir : directions)
+		dir = d = (d + RandomVec3(rng, -0.2f, 0.2f)).Normalized();
+
+	const unsigned int sizes[] = { 64, 256, 1024, 4096 };
+	for (unsigned int size : sizes)
+	{
+		// All points on the sphere, so that all become hull points
+		std::vector<Vec3f> points(size);
+		for (Vec3f& p : points)
+			p = RandomDirection(rng);
+
+		convex_hull hull;
+		hull.Create(&points[0], size);
+		const convex_hull_data* pdata = hull.data;
+
+		unsigned int sum = 0;
+		double tHint = MeasureMin(5, [&]()
+		{
+			unsigned int hint = 0;
+			for (const Vec3f& dir : directions)
+				sum += (hint = pdata->GetSupport(dir, hint));
+		});
+
+		double tNoHint = MeasureMin(5, [&]()
+		{
+			for (const Vec3f& dir : directions)
+				sum += pdata->GetSupport(dir);
+		});
+
+		double tLinear = MeasureMin(5, [&]()
+		{
+			for (const Vec3f& dir : directions)
+			{
+				unsigned int best = 0;
+				float bestdot = Vec3Dot(pdata->points[0], dir), dot;
+				for (unsigned int i = 1; i < pdata->num_points; ++i)
+				{
+					if ((dot = Vec3Dot(pdata->points[i], dir)) > bestdot)
+					{
+						bestdot = dot;
+						best = i;
+					}
+				}
+
+				sum += best;
+			}
+		});
+
+		DoNotOptimize(sum);
+		printf("  %4u hull points: hill climbing %6.1f ns (no hint %6.1f ns), linear %6.1f ns per query\n",
+			pdata->num_points, tHint * 1e9 / numQueries, tNoHint * 1e9 / numQueries, tLinear * 1e9 / numQueries);
+	}
+}
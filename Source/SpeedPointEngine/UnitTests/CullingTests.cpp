@@ -0,0 +1,143 @@
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+//	SpeedPoint Game Engine
+//	Copyright (c) 2011-2018 Pascal Rosenkranz, All rights reserved.
+//
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#include "UnitTest.h"
+#include <Common\Camera.h>
+#include <Common\BoundBox.h>
+#include <vector>
+#include <random>
+
+using namespace SpeedPoint;
+using namespace SpeedPoint::UnitTest;
+
+namespace
+{
+	float RandomFloat(std::mt19937& rng, float min, float max)
+	{
+		return min + (max - min) * (float)(rng() & 0xFFFFFF) / (float)0xFFFFFF;
+	}
+
+	// Camera at the origin, looking at (0, 0, -1), 60 degrees fov, 1..500 depth
+	ViewFrustum MakeFrustum()
+	{
+		Mat44 mtxView, mtxProj;
+		SPMatrixLookAtRH(&mtxView, Vec3f(0, 0, 0), Vec3f(0, 0, -1.0f), Vec3f(0, 1.0f, 0));
+		SPMatrixPerspectiveFovRH(&mtxProj, 1.047f, 16.0f / 9.0f, 1.0f, 500.0f);
+		return ViewFrustum(mtxView, mtxProj);
+	}
+
+	// Boxes scattered around the camera, about a fifth of them end up inside the frustum
+	void MakeRandomAABBs(std::vector<AABB>& aabbs, unsigned int n, unsigned int seed)
+	{
+		std::mt19937 rng(seed);
+		aabbs.resize(n);
+		for (AABB& aabb : aabbs)
+		{
+			Vec3f c(RandomFloat(rng, -600.0f, 600.0f), RandomFloat(rng, -100.0f, 100.0f), RandomFloat(rng, -600.0f, 600.0f));
+			Vec3f e(RandomFloat(rng, 0.5f, 5.0f), RandomFloat(rng, 0.5f, 5.0f), RandomFloat(rng, 0.5f, 5.0f));
+			aabb = AABB(c - e, c + e);
+		}
+	}
+
+	bool IsBitSet(const std::vector<unsigned int>& visible, unsigned int i)
+	{
+		return ((visible[i >> 5] >> (i & 31)) & 1) != 0;
+	}
+}
+
+SP_TEST(ViewFrustum_CullMatchesIsVisible)
+{
+	ViewFrustum frustum = MakeFrustum();
+
+	// Boxes in front of, behind and beside the camera, and one that contains the camera
+	SP_CHECK(frustum.IsVisible(AABB(Vec3f(-1.0f, -1.0f, -11.0f), Vec3f(1.0f, 1.0f, -9.0f))));
+	SP_CHECK(!frustum.IsVisible(AABB(Vec3f(-1.0f, -1.0f, 9.0f), Vec3f(1.0f, 1.0f, 11.0f))));
+	SP_CHECK(!frustum.IsVisible(AABB(Vec3f(100.0f, -1.0f, -11.0f), Vec3f(102.0f, 1.0f, -9.0f))));
+	SP_CHECK(!frustum.IsVisible(AABB(Vec3f(-1.0f, -1.0f, -600.0f), Vec3f(1.0f, 1.0f, -550.0f))));
+	SP_CHECK(frustum.IsVisible(AABB(Vec3f(-5.0f, -5.0f, -5.0f), Vec3f(5.0f, 5.0f, 5.0f))));
+	SP_CHECK(frustum.IsVisible(BoundSphere(Vec3f(0, 0, -100.0f), 1.0f)));
+	SP_CHECK(!frustum.IsVisible(BoundSphere(Vec3f(0, 0, 100.0f), 1.0f)));
+
+	// Odd count, so the scalar remainder of the SIMD loop is covered as well
+	const unsigned int n = 10007;
+	std::vector<AABB> aabbs;
+	MakeRandomAABBs(aabbs, n, 1);
+
+	std::vector<unsigned int> visible((n + 31) / 32, 0xFFFFFFFFu);
+	unsigned int numVisible = frustum.CullAABBs(&aabbs[0], n, &visible[0]);
+
+	std::vector<BoundSphere> spheres(n);
+	for (unsigned int i = 0; i < n; ++i)
+		spheres[i] = BoundSphere((aabbs[i].vMin + aabbs[i].vMax) * 0.5f, ((aabbs[i].vMax - aabbs[i].vMin) * 0.5f).Length());
+
+	std::vector<unsigned int> visibleSpheres((n + 31) / 32, 0xFFFFFFFFu);
+	unsigned int numVisibleSpheres = frustum.CullSpheres(&spheres[0], n, &visibleSpheres[0]);
+
+	unsigned int numExpected = 0, numExpectedSpheres = 0;
+	for (unsigned int i = 0; i < n; ++i)
+	{
+		bool isVisible = frustum.IsVisible(aabbs[i]);
+		SP_CHECK(IsBitSet(visible, i) == isVisible);
+		numExpected += isVisible ? 1 : 0;
+
+		bool isSphereVisible = frustum.IsVisible(spheres[i]);
+		SP_CHECK(IsBitSet(visibleSpheres, i) == isSphereVisible);
+		numExpectedSpheres += isSphereVisible ? 1 : 0;
+
+		// The sphere encloses the box, so it is never culled when the box is visible
+		SP_CHECK(!isVisible || isSphereVisible);
+	}
+
+	SP_CHECK(numVisible == numExpected);
+	SP_CHECK(numVisibleSpheres == numExpectedSpheres);
+	SP_CHECK(numVisible > 0 && numVisible < n);
+
+	// Bits past n in the last word are cleared
+	SP_CHECK((visible.back() >> (n & 31)) == 0);
+}
+
+// Batched CullAABBs() against calling IsVisible() for each object, as the render loop would without the batch
+SP_BENCHMARK(ViewFrustum_CullAABBs)
+{
+	ViewFrustum frustum = MakeFrustum();
+	const unsigned int counts[] = { 10000, 100000 };
+	for (unsigned int n : counts)
+	{
+		std::vector<AABB> aabbs;
+		MakeRandomAABBs(aabbs, n, 2);
+
+		std::vector<unsigned int> visible((n + 31) / 32);
+		unsigned int numRuns = 1000000 / n;
+		unsigned int numVisible = 0;
+
+		double tPerObject = MeasureMin(numRuns, [&]()
+		{
+			numVisible = 0;
+			for (unsigned int i = 0; i < n; ++i)
+			{
+				if (frustum.IsVisible(aabbs[i]))
+				{
+					visible[i >> 5] |= 1u << (i & 31);
+					++numVisible;
+				}
+				else
+				{
+					visible[i >> 5] &= ~(1u << (i & 31));
+				}
+			}
+		});
+
+		double tBatch = MeasureMin(numRuns, [&]()
+		{
+			numVisible = frustum.CullAABBs(&aabbs[0], n, &visible[0]);
+		});
+
+		DoNotOptimize(visible);
+		printf("  %6u AABBs (%u visible): per object %8.1f us, CullAABBs %8.1f us (%.2fx)\n",
+			n, numVisible, tPerObject * 1e6, tBatch * 1e6, tPerObject / tBatch);
+	}
+}
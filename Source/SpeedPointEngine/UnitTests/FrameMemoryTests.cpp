@@ -0,0 +1,133 @@
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+//	SpeedPoint Game Engine
+//	Copyright (c) 2011-2018 Pascal Rosenkranz, All rights reserved.
+//
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#include "UnitTest.h"
+#include <Common\FrameMemory.h>
+#include <sstream>
+#include <vector>
+
+using namespace SpeedPoint;
+using namespace SpeedPoint::UnitTest;
+
+SP_TEST(FrameMemory_ValidUntilNextFrame)
+{
+	FrameMemoryIntrnl frameMemory;
+	frameMemory.SetCapacity(4096);
+
+	unsigned char* pFrame0 = (unsigned char*)frameMemory.Allocate(1000);
+	memset(pFrame0, 0xA0, 1000);
+	frameMemory.NextFrame();
+
+	// Frame 1 uses the other buffer, frame 0 memory is untouched
+	unsigned char* pFrame1 = (unsigned char*)frameMemory.Allocate(1000);
+	memset(pFrame1, 0xA1, 1000);
+	SP_CHECK(pFrame1 + 1000 <= pFrame0 || pFrame0 + 1000 <= pFrame1);
+	for (unsigned int i = 0; i < 1000; ++i)
+		SP_CHECK(pFrame0[i] == 0xA0);
+
+	frameMemory.NextFrame();
+
+	// Frame 2 reuses the buffer of frame 0
+	unsigned char* pFrame2 = (unsigned char*)frameMemory.Allocate(1000);
+	SP_CHECK(pFrame2 == pFrame0);
+	for (unsigned int i = 0; i < 1000; ++i)
+		SP_CHECK(pFrame1[i] == 0xA1);
+
+	SP_CHECK(((size_t)frameMemory.Allocate(3, 64) & 63) == 0);
+}
+
+SP_TEST(FrameMemory_OverflowGrowsBuffer)
+{
+	FrameMemoryIntrnl frameMemory;
+	frameMemory.SetCapacity(1024);
+
+	for (unsigned int i = 0; i < 8; ++i)
+		SP_CHECK(frameMemory.Allocate(512) != 0);
+
+	frameMemory.NextFrame();
+	SP_CHECK(frameMemory.GetLastFrameAllocations() == 8);
+	SP_CHECK(frameMemory.GetLastFrameOverflows() == 6);
+	SP_CHECK(frameMemory.GetLastFrameBytes() == 8 * 512);
+	SP_CHECK(frameMemory.GetPeakFrameBytes() == 8 * 512);
+
+	// Both buffers were grown to the peak after one reset each
+	for (unsigned int frame = 0; frame < 2; ++frame)
+	{
+		frameMemory.NextFrame();
+		for (unsigned int i = 0; i < 8; ++i)
+			frameMemory.Allocate(512);
+	}
+
+	frameMemory.NextFrame();
+	SP_CHECK(frameMemory.GetLastFrameOverflows() == 0);
+}
+
+namespace
+{
+	struct SEntityStub
+	{
+		float pos[3];
+	};
+
+	const unsigned int NUM_ENTITIES = 1000;
+}
+
+// Heap allocations and time per frame of the per-frame patterns converted to frame memory:
+// the RenderMeshes profiling label (stringstream) and the per-frame mesh and AABB lists of C3DEngine::CollectVisibleObjects().
+SP_BENCHMARK(FrameMemory_HeapAllocations)
+{
+	std::vector<SEntityStub> entities(NUM_ENTITIES);
+	const unsigned int numFrames = 200;
+	size_t sum = 0;
+
+	unsigned int heapBefore = GetNumHeapAllocations();
+	double before = MeasureMin(1, [&]()
+	{
+		for (unsigned int frame = 0; frame < numFrames; ++frame)
+		{
+			std::stringstream timerName;
+			timerName << "C3DEngine::RenderCollected() - Render RenderObjects (" << NUM_ENTITIES << ")";
+			sum += timerName.str().size();
+
+			std::vector<SEntityStub*> result;
+			for (SEntityStub& entity : entities)
+				result.push_back(&entity);
+
+			sum += result.size();
+		}
+	});
+	heapBefore = GetNumHeapAllocations() - heapBefore;
+
+	FrameMemoryIntrnl* pFrameMemory = FrameMemory::Get();
+	pFrameMemory->NextFrame();
+	pFrameMemory->NextFrame();
+
+	unsigned int heapAfter = GetNumHeapAllocations();
+	double after = MeasureMin(1, [&]()
+	{
+		for (unsigned int frame = 0; frame < numFrames; ++frame)
+		{
+			const size_t timerNameSz = 96;
+			char* timerName = (char*)FrameMemory::Allocate(timerNameSz);
+			sum += snprintf(timerName, timerNameSz, "C3DEngine::RenderCollected() - Render RenderObjects (%u)", NUM_ENTITIES);
+
+			FrameVector<SEntityStub*> result;
+			result.reserve(entities.size());
+			for (SEntityStub& entity : entities)
+				result.push_back(&entity);
+
+			sum += result.size();
+			pFrameMemory->NextFrame();
+		}
+	});
+	heapAfter = GetNumHeapAllocations() - heapAfter;
+
+	DoNotOptimize(sum);
+	printf("  heap: %.1f allocations per frame, %.2f us per frame\n", (double)heapBefore / numFrames, before * 1e6 / numFrames);
+	printf("  frame memory: %.1f allocations per frame, %.2f us per frame (%u bytes peak)\n",
+		(double)heapAfter / numFrames, after * 1e6 / numFrames, (unsigned int)pFrameMemory->GetPeakFrameBytes());
+}
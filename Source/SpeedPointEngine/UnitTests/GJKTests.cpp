@@ -0,0 +1,302 @@
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+//	SpeedPoint Game Engine
+//	Copyright (c) 2011-2018 Pascal Rosenkranz, All rights reserved.
+//
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#include "UnitTest.h"
+#include <Common\GJK.h>
+#include <vector>
+#include <random>
+#include <algorithm>
+
+using namespace SpeedPoint;
+using namespace SpeedPoint::geo;
+using namespace SpeedPoint::UnitTest;
+
+namespace
+{
+	float RandomFloat(std::mt19937& rng, float min, float max)
+	{
+		return min + (max - min) * (float)(rng() & 0xFFFFFF) / (float)0xFFFFFF;
+	}
+
+	Vec3f RandomVec3(std::mt19937& rng, float min, float max)
+	{
+		return Vec3f(RandomFloat(rng, min, max), RandomFloat(rng, min, max), RandomFloat(rng, min, max));
+	}
+
+	Vec3f RandomDirection(std::mt19937& rng)
+	{
+		Vec3f v;
+		do
+		{
+			v = RandomVec3(rng, -1.0f, 1.0f);
+		} while (v.LengthSq() < 0.01f || v.LengthSq() > 1.0f);
+
+		return v.Normalized();
+	}
+
+	void RandomBasis(std::mt19937& rng, Vec3f axis[3])
+	{
+		axis[0] = RandomDirection(rng);
+		axis[1] = (axis[0] ^ RandomDirection(rng)).Normalized();
+		axis[2] = axis[0] ^ axis[1];
+	}
+
+	box RandomBox(std::mt19937& rng, bool axisAligned)
+	{
+		box b;
+		b.c = RandomVec3(rng, -2.0f, 2.0f);
+		if (axisAligned)
+		{
+			b.axis[0] = Vec3f(1.0f, 0, 0);
+			b.axis[1] = Vec3f(0, 1.0f, 0);
+			b.axis[2] = Vec3f(0, 0, 1.0f);
+		}
+		else
+		{
+			RandomBasis(rng, b.axis);
+		}
+
+		b.dim = RandomVec3(rng, 0.2f, 1.5f);
+		return b;
+	}
+
+	shape* RandomShape(std::mt19937& rng, EShapeType type)
+	{
+		switch (type)
+		{
+		case eSHAPE_SPHERE: return new sphere(RandomVec3(rng, -2.0f, 2.0f), RandomFloat(rng, 0.3f, 1.5f));
+		case eSHAPE_CAPSULE: return new capsule(RandomVec3(rng, -2.0f, 2.0f), RandomDirection(rng), RandomFloat(rng, 0.2f, 1.5f), RandomFloat(rng, 0.2f, 1.0f));
+		case eSHAPE_CYLINDER: return new cylinder(RandomVec3(rng, -2.0f, 2.0f), RandomDirection(rng), RandomFloat(rng, 0.2f, 1.5f), RandomFloat(rng, 0.2f, 1.0f));
+		case eSHAPE_TRIANGLE: return new triangle(RandomVec3(rng, -2.0f, 2.0f), RandomVec3(rng, -2.0f, 2.0f), RandomVec3(rng, -2.0f, 2.0f));
+		case eSHAPE_BOX: return new box(RandomBox(rng, false));
+		default:
+			return 0;
+		}
+	}
+
+	void Translate(shape* pshape, const Vec3f& t)
+	{
+		switch (pshape->GetType())
+		{
+		case eSHAPE_SPHERE: ((sphere*)pshape)->c += t; break;
+		case eSHAPE_CAPSULE: ((capsule*)pshape)->c += t; break;
+		case eSHAPE_CYLINDER: ((cylinder*)pshape)->p[0] += t; ((cylinder*)pshape)->p[1] += t; break;
+		case eSHAPE_BOX: ((box*)pshape)->c += t; break;
+		case eSHAPE_TRIANGLE: for (int i = 0; i < 3; ++i) ((triangle*)pshape)->p[i] += t; break;
+		default:
+			break;
+		}
+	}
+
+	// Closest point of the box to p
+	Vec3f ClosestPointOnBox(const box& b, const Vec3f& p)
+	{
+		Vec3f closest = b.c;
+		for (int i = 0; i < 3; ++i)
+		{
+			float d = Vec3Dot(p - b.c, b.axis[i]);
+			closest += b.axis[i] * std::min(std::max(d, -b.dim[i]), b.dim[i]);
+		}
+
+		return closest;
+	}
+
+	float Distance(const shape* pshape1, const shape* pshape2)
+	{
+		convex_support support1, support2;
+		_GetConvexSupport(pshape1, &support1);
+		_GetConvexSupport(pshape2, &support2);
+		return _GJKDistance(&support1, &support2);
+	}
+
+	const EShapeType convexShapes[] = { eSHAPE_SPHERE, eSHAPE_CAPSULE, eSHAPE_CYLINDER, eSHAPE_BOX, eSHAPE_TRIANGLE };
+}
+
+// Distances and closest points against the exact solutions for spheres and boxes
+SP_TEST(GJK_Distance)
+{
+	std::mt19937 rng(71);
+	unsigned int numSeparated = 0;
+	for (unsigned int i = 0; i < 5000; ++i)
+	{
+		// Sphere - rotated box: the closest point of the box to the center
+		box b = RandomBox(rng, false);
+		sphere s(b.c + RandomVec3(rng, -2.0f, 2.0f), RandomFloat(rng, 0.1f, 1.0f));
+		Vec3f boxPoint = ClosestPointOnBox(b, s.c);
+		float expected = std::max((s.c - boxPoint).Length() - s.r, 0.0f);
+
+		convex_support supportSphere, supportBox;
+		_GetConvexSupport(&s, &supportSphere);
+		_GetConvexSupport(&b, &supportBox);
+		Vec3f closest1, closest2;
+		float dist = _GJKDistance(&supportSphere, &supportBox, &closest1, &closest2);
+		SP_CHECK_NEAR(dist, expected, 1e-4f);
+		SP_CHECK(_GJKIntersects(&supportSphere, &supportBox) == (dist == 0));
+		if (dist > 0)
+		{
+			++numSeparated;
+			SP_CHECK_NEAR((closest1 - closest2).Length(), dist, 1e-4f);
+			SP_CHECK_NEAR((closest1 - s.c).Length(), s.r, 1e-4f);
+			SP_CHECK((closest2 - boxPoint).Length() < 1e-3f);
+		}
+
+		// Axis aligned boxes: the length of the gaps along the axes.
+		// Box 1 also as a point cloud of its corners.
+		box a1 = RandomBox(rng, true), a2 = RandomBox(rng, true);
+		Vec3f gap, corners[8];
+		for (int axis = 0; axis < 3; ++axis)
+			gap[axis] = std::max(fabsf(a2.c[axis] - a1.c[axis]) - a1.dim[axis] - a2.dim[axis], 0.0f);
+
+		for (int k = 0; k < 8; ++k)
+			corners[k] = a1.c + Vec3f((k & 1) ? a1.dim.x : -a1.dim.x, (k & 2) ? a1.dim.y : -a1.dim.y, (k & 4) ? a1.dim.z : -a1.dim.z);
+
+		convex_support supportCorners;
+		_GetConvexSupport(corners, 8, &supportCorners);
+		_GetConvexSupport(&a2, &supportBox);
+		SP_CHECK_NEAR(Distance(&a1, &a2), gap.Length(), 1e-4f);
+		SP_CHECK_NEAR(_GJKDistance(&supportCorners, &supportBox), gap.Length(), 1e-4f);
+	}
+
+	SP_CHECK(numSeparated > 1000 && numSeparated < 4500);
+}
+
+// Penetration depth and normal of EPA against the exact solutions for boxes and spheres
+SP_TEST(GJK_PenetrationDepth)
+{
+	std::mt19937 rng(72);
+	for (unsigned int i = 0; i < 5000; ++i)
+	{
+		// Overlapping axis aligned boxes separate along the axis with the smallest overlap
+		box a1 = RandomBox(rng, true), a2 = RandomBox(rng, true);
+		float minOverlap = FLT_MAX;
+		for (int axis = 0; axis < 3; ++axis)
+			minOverlap = std::min(minOverlap, a1.dim[axis] + a2.dim[axis] - fabsf(a2.c[axis] - a1.c[axis]));
+
+		SIntersection inters;
+		bool intersects = _ConvexConvex(&a1, &a2, &inters);
+		SP_CHECK(intersects == (minOverlap >= 0));
+		if (intersects && minOverlap > 1e-3f)
+		{
+			SP_CHECK_NEAR(inters.dist, -minOverlap, 1e-3f);
+			SP_CHECK_NEAR(fabsf(inters.n.x) + fabsf(inters.n.y) + fabsf(inters.n.z), 1.0f, 1e-3f);
+		}
+
+		// Sphere with the center inside a rotated box: EPA on the point core
+		box b = RandomBox(rng, false);
+		Vec3f local = RandomVec3(rng, -0.95f, 0.95f);
+		sphere s(b.c + b.axis[0] * (local.x * b.dim.x) + b.axis[1] * (local.y * b.dim.y) + b.axis[2] * (local.z * b.dim.z), RandomFloat(rng, 0.1f, 1.0f));
+		float faceDist = FLT_MAX;
+		for (int axis = 0; axis < 3; ++axis)
+			faceDist = std::min(faceDist, b.dim[axis] - fabsf(local[axis] * b.dim[axis]));
+
+		SP_CHECK(_ConvexConvex(&s, &b, &inters));
+		SP_CHECK_NEAR(inters.dist, -(faceDist + s.r), 1e-3f);
+		SP_CHECK_NEAR(inters.n.Length(), 1.0f, 1e-4f);
+	}
+
+	// Overlapping spheres are handled by GJK on the cores, without EPA
+	sphere s1(Vec3f(0, 0, 0), 1.0f), s2(Vec3f(1.5f, 0, 0), 1.0f);
+	SIntersection inters;
+	SP_CHECK(_ConvexConvex(&s1, &s2, &inters));
+	SP_CHECK_NEAR(inters.dist, -0.5f, 1e-5f);
+	SP_CHECK_NEAR(inters.n.x, 1.0f, 1e-5f);
+	SP_CHECK_NEAR(inters.p.x, 1.0f, 1e-5f);
+}
+
+// Moving shape2 by the returned normal and depth has to separate the shapes.
+// The curved rim of cylinders is sampled by GJK/EPA, which misses the exact depth in a few configurations.
+SP_TEST(GJK_SeparationAlongNormal)
+{
+	FillIntersectionTestTable();
+	std::mt19937 rng(73);
+	unsigned int numSamples = 0, numFailed = 0, numSamplesCylinder = 0, numFailedCylinder = 0;
+	for (EShapeType type1 : convexShapes)
+	{
+		for (EShapeType type2 : convexShapes)
+		{
+			for (unsigned int i = 0; i < 1000; ++i)
+			{
+				shape* pshape1 = RandomShape(rng, type1);
+				shape* pshape2 = RandomShape(rng, type2);
+
+				SIntersection inters;
+				if (_ConvexConvex(pshape1, pshape2, &inters))
+				{
+					// Contact normal points from shape1 to shape2 and p lies on shape1
+					Translate(pshape2, inters.n * (-inters.dist + 2e-3f));
+					float dist = Distance(pshape1, pshape2);
+					bool separated = (dist > 0 && dist < 4e-3f);
+
+					bool cylinder = (type1 == eSHAPE_CYLINDER || type2 == eSHAPE_CYLINDER);
+					++(cylinder ? numSamplesCylinder : numSamples);
+					if (!separated)
+						++(cylinder ? numFailedCylinder : numFailed);
+				}
+
+				delete pshape1;
+				delete pshape2;
+			}
+		}
+	}
+
+	SP_CHECK(numSamples > 3000);
+	SP_CHECK(numFailed == 0);
+	SP_CHECK(numFailedCylinder * 500 < numSamplesCylinder);
+	printf("  %u of %u contacts fail to separate (%u of %u with cylinders)\n", numFailed, numSamples, numFailedCylinder, numSamplesCylinder);
+}
+
+SP_BENCHMARK(GJK_Intersection)
+{
+	FillIntersectionTestTable();
+	std::mt19937 rng(74);
+	const unsigned int n = 20000;
+	const EShapeType pairs[][2] =
+	{
+		{ eSHAPE_SPHERE, eSHAPE_BOX },
+		{ eSHAPE_CAPSULE, eSHAPE_CAPSULE },
+		{ eSHAPE_BOX, eSHAPE_BOX },
+		{ eSHAPE_BOX, eSHAPE_CYLINDER },
+		{ eSHAPE_TRIANGLE, eSHAPE_BOX }
+	};
+
+	for (const EShapeType* pair : pairs)
+	{
+		std::vector<shape*> shapes1, shapes2;
+		for (unsigned int i = 0; i < n; ++i)
+		{
+			shapes1.push_back(RandomShape(rng, pair[0]));
+			shapes2.push_back(RandomShape(rng, pair[1]));
+		}
+
+		SIntersection inters;
+		unsigned int numHits = 0;
+		double tTable = MeasureMin(5, [&]()
+		{
+			for (unsigned int i = 0; i < n; ++i)
+				numHits += _Intersection(shapes1[i], shapes2[i], &inters) ? 1 : 0;
+		});
+
+		double tGJK = MeasureMin(5, [&]()
+		{
+			for (unsigned int i = 0; i < n; ++i)
+				numHits += _ConvexConvex(shapes1[i], shapes2[i], &inters) ? 1 : 0;
+		});
+
+		// Names without the "SHAPE_" prefix
+		char name[64];
+		snprintf(name, sizeof(name), "%s-%s", GetShapeTypeName(pair[0]) + 6, GetShapeTypeName(pair[1]) + 6);
+
+		DoNotOptimize(numHits);
+		printf("  %-17s table %6.2f, GJK/EPA %6.2f million tests/s\n", name, n / tTable * 1e-6, n / tGJK * 1e-6);
+
+		for (unsigned int i = 0; i < n; ++i)
+		{
+			delete shapes1[i];
+			delete shapes2[i];
+		}
+	}
+}
@@ -0,0 +1,198 @@
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+//	SpeedPoint Game Engine
+//	Copyright (c) 2011-2018 Pascal Rosenkranz, All rights reserved.
+//
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#include "UnitTest.h"
+#include <Common\LockFreeQueue.h>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+using namespace SpeedPoint::UnitTest;
+
+namespace
+{
+	// Reference: what the engine used before, a std::deque behind a mutex
+	template<typename T>
+	class CMutexQueue
+	{
+	private:
+		std::deque<T> m_Items;
+		std::mutex m_Mutex;
+
+	public:
+		bool Push(const T& item)
+		{
+			std::lock_guard<std::mutex> lock(m_Mutex);
+			m_Items.push_back(item);
+			return true;
+		}
+
+		bool Pop(T& item)
+		{
+			std::lock_guard<std::mutex> lock(m_Mutex);
+			if (m_Items.empty())
+				return false;
+
+			item = m_Items.front();
+			m_Items.pop_front();
+			return true;
+		}
+	};
+
+	// Pushes 1..numItems from each producer and pops until all items arrived.
+	// Returns the sum of all popped items.
+	template<typename Q>
+	unsigned long long RunProducersConsumers(Q& queue, unsigned int numProducers, unsigned int numConsumers, unsigned int numItems)
+	{
+		std::atomic<unsigned int> numPopped(0);
+		std::atomic<unsigned long long> sum(0);
+		const unsigned int numTotal = numProducers * numItems;
+
+		std::vector<std::thread> threads;
+		for (unsigned int producer = 0; producer < numProducers; ++producer)
+		{
+			threads.emplace_back([&queue, numItems]()
+			{
+				for (unsigned int i = 1; i <= numItems; ++i)
+				{
+					while (!queue.Push(i))
+						std::this_thread::yield();
+				}
+			});
+		}
+
+		for (unsigned int consumer = 0; consumer < numConsumers; ++consumer)
+		{
+			threads.emplace_back([&queue, &numPopped, &sum, numTotal]()
+			{
+				unsigned long long localSum = 0;
+				unsigned int item;
+				while (numPopped.load(std::memory_order_relaxed) < numTotal)
+				{
+					if (queue.Pop(item))
+					{
+						localSum += item;
+						numPopped.fetch_add(1, std::memory_order_relaxed);
+					}
+					else
+					{
+						std::this_thread::yield();
+					}
+				}
+
+				sum += localSum;
+			});
+		}
+
+		for (std::thread& thread : threads)
+			thread.join();
+
+		return sum.load();
+	}
+}
+
+SP_TEST(SPSCQueue_OrderAndCapacity)
+{
+	SPSCQueue<unsigned int> queue(5);
+	SP_CHECK(queue.GetCapacity() == 8);
+
+	for (unsigned int i = 0; i < 8; ++i)
+		SP_CHECK(queue.Push(i));
+
+	SP_CHECK(!queue.Push(8u));
+
+	unsigned int item;
+	for (unsigned int i = 0; i < 8; ++i)
+		SP_CHECK(queue.Pop(item) && item == i);
+
+	SP_CHECK(!queue.Pop(item));
+
+	// Batches wrap around the end of the ring
+	unsigned int batch[6] = { 10, 11, 12, 13, 14, 15 };
+	SP_CHECK(queue.PushBatch(batch, 6) == 6);
+	SP_CHECK(queue.PushBatch(batch, 6) == 2);
+
+	unsigned int popped[8];
+	SP_CHECK(queue.PopBatch(popped, 8) == 8);
+	SP_CHECK(popped[5] == 15 && popped[6] == 10 && popped[7] == 11);
+	SP_CHECK(queue.IsEmpty());
+}
+
+SP_TEST(LockFreeQueue_Threads)
+{
+	const unsigned int numItems = 100000;
+	const unsigned long long itemSum = (unsigned long long)numItems * (numItems + 1) / 2;
+
+	SPSCQueue<unsigned int> spsc(256);
+	SP_CHECK(RunProducersConsumers(spsc, 1, 1, numItems) == itemSum);
+
+	MPMCQueue<unsigned int> mpmc(256);
+	SP_CHECK(RunProducersConsumers(mpmc, 4, 4, numItems) == 4 * itemSum);
+}
+
+// Throughput of the lock-free queues against a std::deque behind a mutex.
+// Single thread measures the uncontended cost of one push and one pop.
+SP_BENCHMARK(LockFreeQueue_Throughput)
+{
+	const unsigned int numItems = 1000000;
+	const unsigned int numRuns = 3;
+
+	{
+		SPSCQueue<unsigned int> spsc(1024);
+		MPMCQueue<unsigned int> mpmc(1024);
+		CMutexQueue<unsigned int> locked;
+		unsigned int item, sum = 0;
+
+		auto pushPop = [&](auto& queue)
+		{
+			return MeasureMin(numRuns, [&]()
+			{
+				for (unsigned int i = 0; i < numItems; ++i)
+				{
+					queue.Push(i);
+					queue.Pop(item);
+					sum += item;
+				}
+			});
+		};
+
+		double tSPSC = pushPop(spsc), tMPMC = pushPop(mpmc), tLocked = pushPop(locked);
+		DoNotOptimize(sum);
+		printf("  1 thread push+pop:  SPSC %6.2f ns, MPMC %6.2f ns, mutex+deque %6.2f ns per item\n",
+			tSPSC * 1e9 / numItems, tMPMC * 1e9 / numItems, tLocked * 1e9 / numItems);
+	}
+
+	struct SThreadCase
+	{
+		unsigned int numProducers;
+		unsigned int numConsumers;
+	};
+
+	const SThreadCase cases[] = { { 1, 1 }, { 4, 1 }, { 4, 4 } };
+	for (const SThreadCase& c : cases)
+	{
+		unsigned int itemsPerProducer = numItems / c.numProducers;
+		double tLockFree, tLocked;
+		if (c.numProducers == 1 && c.numConsumers == 1)
+		{
+			tLockFree = MeasureMin(numRuns, [&]() { SPSCQueue<unsigned int> queue(1024); RunProducersConsumers(queue, 1, 1, itemsPerProducer); });
+		}
+		else
+		{
+			tLockFree = MeasureMin(numRuns, [&]() { MPMCQueue<unsigned int> queue(1024); RunProducersConsumers(queue, c.numProducers, c.numConsumers, itemsPerProducer); });
+		}
+
+		tLocked = MeasureMin(numRuns, [&]() { CMutexQueue<unsigned int> queue; RunProducersConsumers(queue, c.numProducers, c.numConsumers, itemsPerProducer); });
+
+		unsigned int numTotal = itemsPerProducer * c.numProducers;
+		printf("  %uP/%uC: %s %6.1f Mitems/s, mutex+deque %6.1f Mitems/s\n", c.numProducers, c.numConsumers,
+			(c.numProducers == 1 && c.numConsumers == 1) ? "SPSC" : "MPMC", numTotal / tLockFree * 1e-6, numTotal / tLocked * 1e-6);
+	}
+
+	printf("  hardware threads: %u\n", std::thread::hardware_concurrency());
+}
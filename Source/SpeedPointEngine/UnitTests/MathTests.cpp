@@ -0,0 +1,327 @@
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+//	SpeedPoint Game Engine
+//	Copyright (c) 2011-2018 Pascal Rosenkranz, All rights reserved.
+//
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#include "UnitTest.h"
+#include <Common\Mat44.h>
+#include <Common\Vector2.h>
+#include <Common\Quaternion.h>
+#include <vector>
+#include <random>
+#include <cstring>
+
+using namespace SpeedPoint;
+using namespace SpeedPoint::UnitTest;
+
+namespace
+{
+	const unsigned int NUM_SAMPLES = 10000;
+
+	float RandomFloat(std::mt19937& rng, float min, float max)
+	{
+		return min + (max - min) * (float)(rng() & 0xFFFFFF) / (float)0xFFFFFF;
+	}
+
+	Vec3f RandomVec3(std::mt19937& rng, float min, float max)
+	{
+		return Vec3f(RandomFloat(rng, min, max), RandomFloat(rng, min, max), RandomFloat(rng, min, max));
+	}
+
+	Quat RandomRotation(std::mt19937& rng)
+	{
+		return Quat::FromAxisAngle(RandomVec3(rng, -1.0f, 1.0f).Normalized(), RandomFloat(rng, -3.14f, 3.14f));
+	}
+
+	// General matrix with a dominant diagonal, so it is rarely close to singular
+	Mat44 RandomMatrix(std::mt19937& rng)
+	{
+		Mat44 m;
+		for (int i = 0; i < 4; ++i)
+		{
+			for (int j = 0; j < 4; ++j)
+				m.m[i][j] = RandomFloat(rng, -1.0f, 1.0f) + (i == j ? 2.0f : 0.0f);
+		}
+
+		return m;
+	}
+
+	Mat44 RandomTRS(std::mt19937& rng)
+	{
+		Mat44 m;
+		MakeTransformationTRS(RandomVec3(rng, -100.0f, 100.0f), RandomRotation(rng), RandomVec3(rng, 0.5f, 2.0f), &m);
+		return m;
+	}
+
+	bool BitEqual(const Mat44& a, const Mat44& b)
+	{
+		return memcmp(a.m, b.m, sizeof(a.m)) == 0;
+	}
+
+	// Returns max |a * b - I|
+	float IdentityResidual(const Mat44& a, const Mat44& b)
+	{
+		Mat44 p = SMatrixMultiplyScalar(a, b);
+		float maxResidual = 0;
+		for (int i = 0; i < 4; ++i)
+		{
+			for (int j = 0; j < 4; ++j)
+			{
+				float residual = fabsf(p.m[i][j] - (i == j ? 1.0f : 0.0f));
+				if (residual > maxResidual)
+					maxResidual = residual;
+			}
+		}
+
+		return maxResidual;
+	}
+
+	// The templated core is usable in constant expressions
+	constexpr Vec3f c_a(1.0f, 2.0f, 3.0f), c_b(4.0f, 5.0f, 6.0f);
+	static_assert((c_a + c_b * 2.0f - 1.0f) == Vec3f(8.0f, 11.0f, 14.0f), "Vec3f arithmetic");
+	static_assert(Vec3Dot(c_a, c_b) == 32.0f && (c_a ^ c_b) == Vec3f(-3.0f, 6.0f, -3.0f), "Vec3f dot and cross");
+	static_assert(Vec3Min(c_a, c_b) == c_a && VecMax(c_a, c_b) == c_b && -c_a != c_a, "Vec3f min and max");
+	static_assert((Vec4f(c_a, 1.0f) / 2.0f).w == 0.5f && Vec2f(1.0f, 2.0f) * Vec2f(3.0f) == Vec2f(3.0f, 6.0f), "Vec2f and Vec4f");
+	static_assert((Mat33(2.0f, 0, 0, 0, 3.0f, 0, 0, 0, 4.0f) * Mat33::FromRows(c_a, c_b, c_a) * c_a).z == 4.0f * 14.0f, "Mat33 products");
+	static_assert(Mat44::MakeTranslationMatrix(c_a).MultiplyScalar(Vec4f(c_b, 1.0f)).xyz() == c_a + c_b, "Mat44 * Vec4f");
+	static_assert((MatMul(Mat44::MakeScaleMatrix(c_b), Mat44::MakeTranslationMatrix(c_a))._14 == 4.0f), "Mat44 * Mat44");
+
+	// Sizes without a specialization
+	constexpr Vec<5, float> c_v5(1.0f, 2.0f, 3.0f, 4.0f, 5.0f);
+	constexpr Mat<2, 3, float> c_m23(1.0f, 2.0f, 3.0f, 4.0f, 5.0f, 6.0f);
+	static_assert(Dot(c_v5, c_v5 * 2.0f) == 110.0f, "Vec<5, float>");
+	static_assert((c_m23 * Transpose(c_m23)).Get<1, 1>() == 77.0f && (c_m23 * c_a).Get<1>() == 32.0f, "Mat<2, 3, float>");
+
+	static_assert(alignof(Vec4fA) == 16 && alignof(Mat44A) == 16, "Aligned variants");
+}
+
+// Multiply, transform and transpose sum in the same order as the scalar code, so they must be bit-exact
+SP_TEST(Math_SIMDBitExact)
+{
+	std::mt19937 rng(11);
+	for (unsigned int i = 0; i < NUM_SAMPLES; ++i)
+	{
+		Mat44 a = RandomMatrix(rng), b = RandomTRS(rng);
+		SP_CHECK(BitEqual(a * b, SMatrixMultiplyScalar(a, b)));
+		SP_CHECK(BitEqual(b * a, SMatrixMultiplyScalar(b, a)));
+
+		SVector4 v(RandomFloat(rng, -10.0f, 10.0f), RandomFloat(rng, -10.0f, 10.0f), RandomFloat(rng, -10.0f, 10.0f), 1.0f);
+		SVector4 bv = b * v, bvs = b.MultiplyScalar(v);
+		SP_CHECK(bv.x == bvs.x && bv.y == bvs.y && bv.z == bvs.z && bv.w == bvs.w);
+
+		Mat44 t = SMatrixTranspose(a);
+		for (int r = 0; r < 4; ++r)
+		{
+			for (int c = 0; c < 4; ++c)
+				SP_CHECK(t.m[r][c] == a.m[c][r]);
+		}
+
+		Quat q1 = RandomRotation(rng), q2 = RandomRotation(rng);
+		Quat q = q1 * q2, qs = q1.MultiplyScalar(q2);
+		SP_CHECK(q.w == qs.w && q.v.x == qs.v.x && q.v.y == qs.v.y && q.v.z == qs.v.z);
+	}
+}
+
+// The SIMD inverse uses a different cofactor expansion than the scalar one (Intel AP-928 vs. CryCommon),
+// so the inverses are compared by their residual max |M * M^-1 - I| instead of element by element.
+// Measured over these 10k matrices (entries in [-1, 3], condition numbers up to ~1e3): scalar <= 7.6e-5,
+// SSE <= 3.1e-5, and per matrix the SSE residual is at most 1.2x the scalar one (plus 1e-6 rounding floor).
+// Both grow with the condition number. For near-singular matrices (entries in [-1, 2]) the residuals reach
+// 1e-3 and more, and the SSE one can be 2x-5x the scalar one.
+SP_TEST(Math_InverseTolerance)
+{
+	std::mt19937 rng(12);
+	float maxScalar = 0, maxSIMD = 0;
+	for (unsigned int i = 0; i < NUM_SAMPLES; ++i)
+	{
+		Mat44 m = RandomMatrix(rng);
+		float residualScalar = IdentityResidual(m, SMatrixInvertScalar(m));
+		float residualSIMD = IdentityResidual(m, SMatrixInvert(m));
+		SP_CHECK(residualSIMD <= 2.0f * residualScalar + 1e-6f);
+
+		if (residualScalar > maxScalar)
+			maxScalar = residualScalar;
+		if (residualSIMD > maxSIMD)
+			maxSIMD = residualSIMD;
+	}
+
+	SP_CHECK(maxScalar <= 1e-4f);
+	SP_CHECK(maxSIMD <= 1e-4f);
+
+	// Affine inverse of TRS matrices, where translations up to 100 dominate the error
+	float maxAffine = 0;
+	for (unsigned int i = 0; i < NUM_SAMPLES; ++i)
+	{
+		Mat44 m = RandomTRS(rng);
+		Mat44 invScalar = SMatrixInvertAffineScalar(m), inv = SMatrixInvertAffine(m);
+		float residual = IdentityResidual(m, inv);
+		if (residual > maxAffine)
+			maxAffine = residual;
+
+		for (int r = 0; r < 4; ++r)
+		{
+			for (int c = 0; c < 4; ++c)
+				SP_CHECK_NEAR(inv.m[r][c], invScalar.m[r][c], 1e-4f + 1e-6f * fabsf(invScalar.m[r][c]));
+		}
+	}
+
+	SP_CHECK(maxAffine <= 5e-5f);
+	printf("  max residual: inverse scalar %.2g, SIMD %.2g, affine %.2g\n", maxScalar, maxSIMD, maxAffine);
+}
+
+SP_TEST(Math_QuatRotateTolerance)
+{
+	std::mt19937 rng(13);
+	for (unsigned int i = 0; i < NUM_SAMPLES; ++i)
+	{
+		Quat q = RandomRotation(rng);
+		Vec3f p = RandomVec3(rng, -10.0f, 10.0f);
+
+		// Reference: two Hamilton products q * (0, p) * q^*
+		Quat r = q.MultiplyScalar(Quat(0, p)).MultiplyScalar(Quat(q.w, -q.v));
+		Vec3f rotated = q * p;
+		SP_CHECK_NEAR(rotated.x, r.v.x, 1e-5f * 10.0f);
+		SP_CHECK_NEAR(rotated.y, r.v.y, 1e-5f * 10.0f);
+		SP_CHECK_NEAR(rotated.z, r.v.z, 1e-5f * 10.0f);
+	}
+}
+
+// The operators of the templated core against the component-wise expressions they replace
+SP_TEST(Math_TemplatedCoreBitExact)
+{
+	std::mt19937 rng(15);
+	for (unsigned int i = 0; i < NUM_SAMPLES; ++i)
+	{
+		Vec3f a = RandomVec3(rng, -10.0f, 10.0f), b = RandomVec3(rng, -10.0f, 10.0f);
+		float k = RandomFloat(rng, 0.1f, 2.0f), kinv = 1.0f / k;
+
+		Vec3f r = (a + b) * k - a / k + b * a;
+		SP_CHECK(r.x == (a.x + b.x) * k - a.x * kinv + b.x * a.x);
+		SP_CHECK(r.y == (a.y + b.y) * k - a.y * kinv + b.y * a.y);
+		SP_CHECK(r.z == (a.z + b.z) * k - a.z * kinv + b.z * a.z);
+		SP_CHECK(Vec3Dot(a, b) == a.x * b.x + a.y * b.y + a.z * b.z);
+		SP_CHECK(a.Length() == sqrtf(a.x * a.x + a.y * a.y + a.z * a.z));
+
+		Vec4f a4(a, k), b4(b, -k), r4 = a4 * b4 - k;
+		SP_CHECK(r4.x == a.x * b.x - k && r4.w == k * -k - k);
+		SP_CHECK(Dot(a4, b4) == a.x * b.x + a.y * b.y + a.z * b.z + k * -k);
+
+		Mat33 m = Mat33::FromRows(a, b, r), n = Mat33::FromColumns(b, r, a);
+		Mat33 mn = m * n;
+		SP_CHECK(mn._23 == m._21 * n._13 + m._22 * n._23 + m._23 * n._33);
+		SP_CHECK(mn._31 == m._31 * n._11 + m._32 * n._21 + m._33 * n._31);
+		SP_CHECK((m * a).y == m._21 * a.x + m._22 * a.y + m._23 * a.z);
+
+		Mat44 m44 = RandomTRS(rng);
+		Mat44A aligned = m44;
+		SP_CHECK(BitEqual(aligned * m44, m44 * m44));
+		Vec4fA v = Vec4f(a, 1.0f);
+		SP_CHECK(aligned * v == m44 * Vec4f(a, 1.0f));
+	}
+
+	std::vector<Vec4fA> av(3);
+	std::vector<Mat44A> am(3);
+	SP_CHECK(((size_t)&av[1] & 15) == 0 && ((size_t)&am[1] & 15) == 0);
+}
+
+// Cost per call of the math operations with the SIMD paths and the scalar reference implementations
+SP_BENCHMARK(Math_Operations)
+{
+	const unsigned int n = 4096;
+	const unsigned int numRuns = 20;
+	std::mt19937 rng(14);
+
+	std::vector<Mat44> a(n), b(n), out(n);
+	std::vector<Quat> qa(n), qb(n), qout(n);
+	std::vector<Vec3f> p(n), pout(n);
+	std::vector<SVector4> v(n), vout(n);
+	for (unsigned int i = 0; i < n; ++i)
+	{
+		a[i] = RandomMatrix(rng);
+		b[i] = RandomTRS(rng);
+		qa[i] = RandomRotation(rng);
+		qb[i] = RandomRotation(rng);
+		p[i] = RandomVec3(rng, -10.0f, 10.0f);
+		v[i] = SVector4(p[i].x, p[i].y, p[i].z, 1.0f);
+	}
+
+#define SP_MATH_BENCHMARK(name, simdExpr, scalarExpr) \
+	{ \
+		double tSIMD = MeasureMin(numRuns, [&]() { for (unsigned int i = 0; i < n; ++i) simdExpr; }); \
+		double tScalar = MeasureMin(numRuns, [&]() { for (unsigned int i = 0; i < n; ++i) scalarExpr; }); \
+		printf("  %-22s SIMD %6.2f ns, scalar %6.2f ns (%.2fx)\n", name, tSIMD * 1e9 / n, tScalar * 1e9 / n, tScalar / tSIMD); \
+	}
+
+	SP_MATH_BENCHMARK("Mat44 * Mat44", out[i] = a[i] * b[i], out[i] = SMatrixMultiplyScalar(a[i], b[i]));
+	SP_MATH_BENCHMARK("Mat44 * Vec4", vout[i] = b[i] * v[i], vout[i] = b[i].MultiplyScalar(v[i]));
+	SP_MATH_BENCHMARK("SMatrixTranspose", out[i] = SMatrixTranspose(a[i]), out[i] = Mat44(
+		a[i]._11, a[i]._21, a[i]._31, a[i]._41, a[i]._12, a[i]._22, a[i]._32, a[i]._42,
+		a[i]._13, a[i]._23, a[i]._33, a[i]._43, a[i]._14, a[i]._24, a[i]._34, a[i]._44));
+	SP_MATH_BENCHMARK("SMatrixInvert", out[i] = SMatrixInvert(a[i]), out[i] = SMatrixInvertScalar(a[i]));
+	SP_MATH_BENCHMARK("SMatrixInvertAffine", out[i] = SMatrixInvertAffine(b[i]), out[i] = SMatrixInvertAffineScalar(b[i]));
+	SP_MATH_BENCHMARK("Quat * Quat", qout[i] = qa[i] * qb[i], qout[i] = qa[i].MultiplyScalar(qb[i]));
+	SP_MATH_BENCHMARK("Quat * Vec3f", pout[i] = qa[i] * p[i],
+		pout[i] = (qa[i].w * qa[i].w - Vec3Dot(qa[i].v, qa[i].v)) * p[i] + (2.0f * Vec3Dot(qa[i].v, p[i])) * qa[i].v + (2.0f * qa[i].w) * Vec3Cross(qa[i].v, p[i]));
+
+#undef SP_MATH_BENCHMARK
+
+	DoNotOptimize(out);
+	DoNotOptimize(qout);
+	DoNotOptimize(pout);
+	DoNotOptimize(vout);
+}
+
+// Vector expressions of the templated operators against the same code written per component,
+// e.g. a particle update. Both should compile to the same loop.
+SP_BENCHMARK(Math_VectorExpressions)
+{
+	const unsigned int n = 65536;
+	const unsigned int numRuns = 50;
+	const float dt = 1.0f / 60.0f, damping = 0.99f;
+	const Vec3f gravity(0, -9.81f, 0);
+	std::mt19937 rng(16);
+
+	std::vector<Vec3f> pos(n), vel(n);
+	std::vector<Vec4f> v4(n);
+	std::vector<Vec4fA> v4a(n);
+	for (unsigned int i = 0; i < n; ++i)
+	{
+		pos[i] = RandomVec3(rng, -10.0f, 10.0f);
+		vel[i] = RandomVec3(rng, -1.0f, 1.0f);
+		v4[i] = v4a[i] = Vec4f(pos[i], 1.0f);
+	}
+
+	double tOperators = MeasureMin(numRuns, [&]()
+	{
+		for (unsigned int i = 0; i < n; ++i)
+		{
+			vel[i] = vel[i] * damping + gravity * dt;
+			pos[i] += vel[i] * dt;
+		}
+	});
+
+	double tComponents = MeasureMin(numRuns, [&]()
+	{
+		for (unsigned int i = 0; i < n; ++i)
+		{
+			vel[i].x = vel[i].x * damping + gravity.x * dt;
+			vel[i].y = vel[i].y * damping + gravity.y * dt;
+			vel[i].z = vel[i].z * damping + gravity.z * dt;
+			pos[i].x += vel[i].x * dt;
+			pos[i].y += vel[i].y * dt;
+			pos[i].z += vel[i].z * dt;
+		}
+	});
+
+	DoNotOptimize(pos);
+	printf("  Vec3f update: operators %6.3f ns, per component %6.3f ns (%.2fx)\n", tOperators * 1e9 / n, tComponents * 1e9 / n, tComponents / tOperators);
+
+	const Vec4f scale(0.5f, 2.0f, 1.0f, 1.0f);
+	double tVec4 = MeasureMin(numRuns, [&]() { for (unsigned int i = 0; i < n; ++i) v4[i] = v4[i] * scale + 1.0f; });
+	double tVec4A = MeasureMin(numRuns, [&]() { for (unsigned int i = 0; i < n; ++i) v4a[i] = v4a[i] * scale + 1.0f; });
+	DoNotOptimize(v4);
+	DoNotOptimize(v4a);
+	printf("  Vec4f madd: Vec4f %6.3f ns, Vec4fA %6.3f ns\n", tVec4 * 1e9 / n, tVec4A * 1e9 / n);
+}
@@ -0,0 +1,370 @@
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+//	SpeedPoint Game Engine
+//	Copyright (c) 2011-2018 Pascal Rosenkranz, All rights reserved.
+//
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#include "UnitTest.h"
+#include <Common\geo.h>
+#include <Common\RayPacket.h>
+#include <vector>
+#include <random>
+#include <algorithm>
+
+using namespace SpeedPoint;
+using namespace SpeedPoint::geo;
+using namespace SpeedPoint::UnitTest;
+
+namespace
+{
+	float RandomFloat(std::mt19937& rng, float min, float max)
+	{
+		return min + (max - min) * (float)(rng() & 0xFFFFFF) / (float)0xFFFFFF;
+	}
+
+	Vec3f RandomVec3(std::mt19937& rng, float min, float max)
+	{
+		return Vec3f(RandomFloat(rng, min, max), RandomFloat(rng, min, max), RandomFloat(rng, min, max));
+	}
+
+	// Height field of size x size quads with hills, scaled by 2 along x and moved to (1, 2, -3)
+	mesh* CreateTerrain(unsigned int size)
+	{
+		mesh* pmesh = new mesh();
+		pmesh->num_points = (size + 1) * (size + 1);
+		pmesh->points = new Vec3f[pmesh->num_points];
+		for (unsigned int z = 0; z <= size; ++z)
+		{
+			for (unsigned int x = 0; x <= size; ++x)
+			{
+				float fx = (float)x / size * 10.0f - 5.0f, fz = (float)z / size * 10.0f - 5.0f;
+				pmesh->points[z * (size + 1) + x] = Vec3f(fx, 0.8f * sinf(fx) * cosf(0.7f * fz), fz);
+			}
+		}
+
+		pmesh->num_indices = size * size * 6;
+		pmesh->indices = new unsigned int[pmesh->num_indices];
+		unsigned int k = 0;
+		for (unsigned int z = 0; z < size; ++z)
+		{
+			for (unsigned int x = 0; x < size; ++x)
+			{
+				unsigned int a = z * (size + 1) + x, b = a + 1, c = a + size + 1, d = c + 1;
+				unsigned int quad[6] = { a, c, b, b, c, d };
+				for (unsigned int j = 0; j < 6; ++j)
+					pmesh->indices[k++] = quad[j];
+			}
+		}
+
+		pmesh->transform = Mat44::MakeTranslationMatrix(Vec3f(1.0f, 2.0f, -3.0f)) * Mat44::MakeScaleMatrix(Vec3f(2.0f, 1.0f, 1.0f));
+		pmesh->invTransform = SMatrixInvertAffine(pmesh->transform);
+		return pmesh;
+	}
+
+	// Triangles at x = 2^-i, so that each binned split only separates a few of them from the rest
+	mesh* CreateGeometricStrip(unsigned int ntris)
+	{
+		mesh* pmesh = new mesh();
+		pmesh->num_points = ntris * 3;
+		pmesh->points = new Vec3f[pmesh->num_points];
+		pmesh->num_indices = ntris * 3;
+		pmesh->indices = new unsigned int[pmesh->num_indices];
+		for (unsigned int i = 0; i < ntris; ++i)
+		{
+			float x = ldexpf(1.0f, -(int)i);
+			pmesh->points[i * 3] = Vec3f(x, 0, 0);
+			pmesh->points[i * 3 + 1] = Vec3f(x, 1.0f, 0);
+			pmesh->points[i * 3 + 2] = Vec3f(x, 0, 1.0f);
+			for (unsigned int j = 0; j < 3; ++j)
+				pmesh->indices[i * 3 + j] = i * 3 + j;
+		}
+
+		pmesh->transform = Mat44::Identity;
+		pmesh->invTransform = Mat44::Identity;
+		return pmesh;
+	}
+
+	// The same triangle ntris times
+	mesh* CreateCoincidentTriangles(unsigned int ntris)
+	{
+		mesh* pmesh = new mesh();
+		pmesh->num_points = 3;
+		pmesh->points = new Vec3f[3];
+		pmesh->points[0] = Vec3f(0, 0, 0);
+		pmesh->points[1] = Vec3f(1.0f, 0, 0);
+		pmesh->points[2] = Vec3f(0, 1.0f, 0);
+		pmesh->num_indices = ntris * 3;
+		pmesh->indices = new unsigned int[pmesh->num_indices];
+		for (unsigned int i = 0; i < pmesh->num_indices; ++i)
+			pmesh->indices[i] = i % 3;
+
+		pmesh->transform = Mat44::Identity;
+		pmesh->invTransform = Mat44::Identity;
+		return pmesh;
+	}
+
+	bool Contains(const AABB& outer, const AABB& inner)
+	{
+		return outer.vMin.x <= inner.vMin.x && outer.vMin.y <= inner.vMin.y && outer.vMin.z <= inner.vMin.z
+			&& outer.vMax.x >= inner.vMax.x && outer.vMax.y >= inner.vMax.y && outer.vMax.z >= inner.vMax.z;
+	}
+
+	AABB TriangleAABB(const mesh* pmesh, unsigned int itri)
+	{
+		const Vec3f& p1 = pmesh->points[pmesh->indices[itri * 3]];
+		const Vec3f& p2 = pmesh->points[pmesh->indices[itri * 3 + 1]];
+		const Vec3f& p3 = pmesh->points[pmesh->indices[itri * 3 + 2]];
+		return AABB(Vec3Min(Vec3Min(p1, p2), p3), Vec3Max(Vec3Max(p1, p2), p3));
+	}
+
+	struct STreeStats
+	{
+		unsigned int maxDepth;
+		unsigned int numErrors;
+	};
+
+	// Walks the tree and counts nodes that do not contain their children, oversized leaves above the maximum depth
+	// and triangles that are referenced by no leaf or more than one
+	STreeStats CheckTree(const mesh* pmesh, unsigned int maxTrisPerLeaf)
+	{
+		STreeStats stats = { 0, 0 };
+		unsigned int ntris = pmesh->num_indices / 3;
+		std::vector<unsigned int> refs(ntris, 0);
+
+		std::vector<std::pair<unsigned int, unsigned int>> stack; // node, depth
+		stack.push_back(std::make_pair(0u, 0u));
+		while (!stack.empty())
+		{
+			unsigned int inode = stack.back().first, depth = stack.back().second;
+			stack.pop_back();
+			stats.maxDepth = std::max(stats.maxDepth, depth);
+
+			const mesh_bvh_node& node = pmesh->nodes[inode];
+			if (node.IsLeaf())
+			{
+				if (node.count > maxTrisPerLeaf && depth + 1 < MESH_BVH_MAX_DEPTH)
+					++stats.numErrors;
+
+				for (unsigned int itri = node.first; itri < node.first + node.count && itri < ntris; ++itri)
+				{
+					++refs[itri];
+					if (!Contains(node.aabb, TriangleAABB(pmesh, itri)))
+						++stats.numErrors;
+				}
+
+				if (node.first + node.count > ntris)
+					++stats.numErrors;
+
+				continue;
+			}
+
+			unsigned int children[2] = { inode + 1, node.first };
+			for (unsigned int child : children)
+			{
+				if (child >= pmesh->num_nodes || !Contains(node.aabb, pmesh->nodes[child].aabb))
+				{
+					++stats.numErrors;
+					continue;
+				}
+
+				stack.push_back(std::make_pair(child, depth + 1));
+			}
+		}
+
+		for (unsigned int itri = 0; itri < ntris; ++itri)
+		{
+			if (refs[itri] != 1)
+				++stats.numErrors;
+		}
+
+		return stats;
+	}
+
+	// Same as _MeshShape(), but tests all triangles instead of traversing the tree
+	bool BruteForceMeshShape(const mesh* pmesh, const shape* pshape, SIntersection* pinters)
+	{
+		shape* ptshape = pshape->Clone();
+		ptshape->Transform(pmesh->invTransform);
+
+		triangle tri;
+		SIntersection tmpinters;
+		pinters->dist = FLT_MAX;
+		bool res = false;
+		for (unsigned int i = 0; i < pmesh->num_indices; i += 3)
+		{
+			tri.p[0] = pmesh->points[pmesh->indices[i]];
+			tri.p[1] = pmesh->points[pmesh->indices[i + 1]];
+			tri.p[2] = pmesh->points[pmesh->indices[i + 2]];
+			tri.n = ((tri.p[1] - tri.p[0]) ^ (tri.p[2] - tri.p[0])).Normalized();
+			if (_Intersection(&tri, ptshape, &tmpinters) && tmpinters.dist < pinters->dist)
+			{
+				res = true;
+				*pinters = tmpinters;
+			}
+		}
+
+		delete ptshape;
+		return res;
+	}
+
+	std::vector<sphere> RandomSpheres(std::mt19937& rng, unsigned int n)
+	{
+		std::vector<sphere> spheres(n);
+		for (unsigned int i = 0; i < n; ++i)
+			spheres[i] = sphere(Vec3f(1.0f, 2.0f, -3.0f) + Vec3f(RandomFloat(rng, -11.0f, 11.0f), RandomFloat(rng, -1.5f, 1.5f), RandomFloat(rng, -5.5f, 5.5f)), RandomFloat(rng, 0.05f, 0.5f));
+		return spheres;
+	}
+
+	std::vector<ray> RandomRays(std::mt19937& rng, unsigned int n)
+	{
+		std::vector<ray> rays(n);
+		for (unsigned int i = 0; i < n; ++i)
+		{
+			Vec3f target = Vec3f(1.0f, 2.0f, -3.0f) + Vec3f(RandomFloat(rng, -12.0f, 12.0f), 0, RandomFloat(rng, -6.0f, 6.0f));
+			Vec3f origin = target + Vec3f(RandomFloat(rng, -3.0f, 3.0f), 5.0f, RandomFloat(rng, -3.0f, 3.0f));
+			rays[i] = ray(origin, target - origin);
+		}
+
+		return rays;
+	}
+}
+
+// Every triangle ends up in exactly one leaf, and every node contains its children
+SP_TEST(MeshBVH_Structure)
+{
+	const unsigned int leafSizes[] = { 1, 4, 16 };
+	for (unsigned int maxTrisPerLeaf : leafSizes)
+	{
+		// 2 * 96^2 triangles, enough to build the upper levels on multiple threads
+		mesh* pterrain = CreateTerrain(96);
+		std::vector<unsigned int> triangles(pterrain->indices, pterrain->indices + pterrain->num_indices);
+		pterrain->CreateTree(maxTrisPerLeaf);
+
+		STreeStats stats = CheckTree(pterrain, maxTrisPerLeaf);
+		SP_CHECK(stats.numErrors == 0);
+		SP_CHECK(stats.maxDepth < MESH_BVH_MAX_DEPTH);
+		SP_CHECK(Contains(pterrain->nodes[0].aabb, AABB(Vec3f(-5.0f, -0.79f, -5.0f), Vec3f(5.0f, 0.79f, 5.0f))));
+
+		// The triangles are only reordered
+		std::vector<unsigned int> reordered(pterrain->indices, pterrain->indices + pterrain->num_indices);
+		std::vector<std::vector<unsigned int>> a, b;
+		for (size_t i = 0; i < triangles.size(); i += 3)
+		{
+			a.push_back(std::vector<unsigned int>(triangles.begin() + i, triangles.begin() + i + 3));
+			b.push_back(std::vector<unsigned int>(reordered.begin() + i, reordered.begin() + i + 3));
+		}
+
+		std::sort(a.begin(), a.end());
+		std::sort(b.begin(), b.end());
+		SP_CHECK(a == b);
+
+		delete pterrain;
+	}
+
+	// Degenerate inputs: all centroids coincide, and a chain that is much deeper than a balanced tree (7 levels)
+	mesh* pstack = CreateCoincidentTriangles(1000);
+	pstack->CreateTree();
+	STreeStats stackStats = CheckTree(pstack, 4);
+	SP_CHECK(stackStats.numErrors == 0);
+	SP_CHECK(stackStats.maxDepth < MESH_BVH_MAX_DEPTH);
+	delete pstack;
+
+	mesh* pstrip = CreateGeometricStrip(120);
+	pstrip->CreateTree(1);
+	STreeStats stripStats = CheckTree(pstrip, 1);
+	SP_CHECK(stripStats.numErrors == 0);
+	SP_CHECK(stripStats.maxDepth > 20 && stripStats.maxDepth < MESH_BVH_MAX_DEPTH);
+	delete pstrip;
+}
+
+// Queries through the tree find the same contacts as testing all triangles
+SP_TEST(MeshBVH_Queries)
+{
+	FillIntersectionTestTable();
+	std::mt19937 rng(61);
+	mesh* pterrain = CreateTerrain(32);
+	pterrain->CreateTree();
+
+	std::vector<sphere> spheres = RandomSpheres(rng, 2000);
+	unsigned int numHits = 0;
+	for (const sphere& s : spheres)
+	{
+		SIntersection tree, brute;
+		bool treeHit = _MeshShape(pterrain, &s, &tree);
+		bool bruteHit = BruteForceMeshShape(pterrain, &s, &brute);
+		SP_CHECK(treeHit == bruteHit);
+		if (treeHit && bruteHit)
+		{
+			++numHits;
+			SP_CHECK(tree.dist == brute.dist);
+		}
+	}
+
+	SP_CHECK(numHits > spheres.size() / 20 && numHits < spheres.size());
+
+	std::vector<ray> rays = RandomRays(rng, 2000);
+	for (const ray& r : rays)
+	{
+		SIntersection tree, brute;
+		bool treeHit = _MeshShape(pterrain, &r, &tree);
+		bool bruteHit = BruteForceMeshShape(pterrain, &r, &brute);
+		SP_CHECK(treeHit == bruteHit);
+		if (treeHit && bruteHit)
+			SP_CHECK(tree.dist == brute.dist);
+	}
+
+	delete pterrain;
+}
+
+// The octree this BVH replaced no longer exists, so the queries are compared against testing all triangles
+SP_BENCHMARK(MeshBVH_BuildAndQuery)
+{
+	FillIntersectionTestTable();
+	std::mt19937 rng(62);
+	const unsigned int sizes[] = { 64, 256, 512 };
+	for (unsigned int size : sizes)
+	{
+		mesh* pterrain = CreateTerrain(size);
+		unsigned int ntris = pterrain->num_indices / 3;
+
+		double tBuild = MeasureMin(5, [&]() { pterrain->CreateTree(); });
+		printf("  %u triangles: build %7.2f ms (%u nodes)", ntris, tBuild * 1e3, pterrain->num_nodes);
+
+		std::vector<sphere> spheres = RandomSpheres(rng, 2000);
+		SIntersection inters;
+		unsigned int numHits = 0;
+		double tSpheres = MeasureMin(5, [&]()
+		{
+			numHits = 0;
+			for (const sphere& s : spheres)
+				numHits += _MeshShape(pterrain, &s, &inters) ? 1 : 0;
+		});
+
+		std::vector<ray> rays = RandomRays(rng, 2000);
+		std::vector<ray_hit> hits(rays.size());
+		double tRays = MeasureMin(5, [&]()
+		{
+			for (size_t i = 0; i < rays.size(); ++i)
+				_RayMeshNearest(&rays[i], pterrain, &hits[i]);
+		});
+
+		printf(", sphere %7.2f us, nearest ray %6.2f us", tSpheres * 1e6 / spheres.size(), tRays * 1e6 / rays.size());
+
+		if (size <= 64)
+		{
+			double tBrute = MeasureMin(1, [&]()
+			{
+				for (const sphere& s : spheres)
+					numHits += BruteForceMeshShape(pterrain, &s, &inters) ? 1 : 0;
+			});
+
+			printf(" (all triangles: sphere %7.2f us)", tBrute * 1e6 / spheres.size());
+		}
+
+		DoNotOptimize(numHits);
+		DoNotOptimize(hits);
+		printf("\n");
+		delete pterrain;
+	}
+}
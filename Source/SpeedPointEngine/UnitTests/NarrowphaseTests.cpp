@@ -0,0 +1,248 @@
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+//	SpeedPoint Game Engine
+//	Copyright (c) 2011-2018 Pascal Rosenkranz, All rights reserved.
+//
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#include "UnitTest.h"
+#include <Common\Narrowphase.h>
+#include <vector>
+#include <memory>
+#include <random>
+#include <algorithm>
+
+using namespace SpeedPoint;
+using namespace SpeedPoint::geo;
+using namespace SpeedPoint::UnitTest;
+
+namespace
+{
+	float RandomFloat(std::mt19937& rng, float min, float max)
+	{
+		return min + (max - min) * (float)(rng() & 0xFFFFFF) / (float)0xFFFFFF;
+	}
+
+	Vec3f RandomVec3(std::mt19937& rng, float min, float max)
+	{
+		return Vec3f(RandomFloat(rng, min, max), RandomFloat(rng, min, max), RandomFloat(rng, min, max));
+	}
+
+	Vec3f RandomDirection(std::mt19937& rng)
+	{
+		Vec3f v;
+		do
+		{
+			v = RandomVec3(rng, -1.0f, 1.0f);
+		} while (v.LengthSq() < 0.01f || v.LengthSq() > 1.0f);
+
+		return v.Normalized();
+	}
+
+	// Spheres and capsules in a cube of the given size, boxes as well if withBoxes is set
+	std::vector<std::unique_ptr<shape>> RandomShapes(std::mt19937& rng, unsigned int n, float size, bool withBoxes)
+	{
+		std::vector<std::unique_ptr<shape>> shapes;
+		for (unsigned int i = 0; i < n; ++i)
+		{
+			Vec3f c = RandomVec3(rng, 0, size);
+			unsigned int ty = rng() % (withBoxes ? 3 : 2);
+			if (ty == 0)
+			{
+				shapes.emplace_back(new sphere(c, RandomFloat(rng, 0.2f, 1.0f)));
+			}
+			else if (ty == 1)
+			{
+				// Some capsules along the coordinate axes, so that there are parallel pairs
+				Vec3f axis = (rng() % 4 == 0) ? Vec3f(0, 1.0f, 0) : RandomDirection(rng);
+				shapes.emplace_back(new capsule(c, axis, RandomFloat(rng, 0.1f, 1.5f), RandomFloat(rng, 0.2f, 0.8f)));
+			}
+			else
+			{
+				box* pbox = new box();
+				pbox->c = c;
+				pbox->axis[0] = Vec3f(1.0f, 0, 0);
+				pbox->axis[1] = Vec3f(0, 1.0f, 0);
+				pbox->axis[2] = Vec3f(0, 0, 1.0f);
+				pbox->dim = RandomVec3(rng, 0.2f, 1.0f);
+				shapes.emplace_back(pbox);
+			}
+		}
+
+		return shapes;
+	}
+
+	// All pairs with overlapping bounding boxes, in random order, like the broadphase would report them
+	std::vector<shape_pair> CandidatePairs(std::mt19937& rng, const std::vector<std::unique_ptr<shape>>& shapes)
+	{
+		std::vector<shape_pair> pairs;
+		for (size_t i = 0; i < shapes.size(); ++i)
+		{
+			AABB aabb1 = shapes[i]->GetBoundBoxAxisAligned();
+			for (size_t j = i + 1; j < shapes.size(); ++j)
+			{
+				if (!aabb1.Intersects(shapes[j]->GetBoundBoxAxisAligned()))
+					continue;
+
+				if (rng() & 1)
+					pairs.push_back(shape_pair(shapes[i].get(), shapes[j].get()));
+				else
+					pairs.push_back(shape_pair(shapes[j].get(), shapes[i].get()));
+			}
+		}
+
+		std::shuffle(pairs.begin(), pairs.end(), rng);
+		return pairs;
+	}
+
+	// Summary:
+	//	Compares the batched contacts against _ContactManifold() of each pair.
+	//	Pairs that touch only within tolerance may be reported by one side only.
+	// Returns:
+	//	The number of intersecting pairs
+	unsigned int CheckAgainstScalar(const std::vector<shape_pair>& pairs, const narrowphase_batch& batch)
+	{
+		const float tolerance = 1e-4f;
+		std::vector<int> contactOfPair(pairs.size(), -1);
+		for (size_t i = 0; i < batch.contacts.size(); ++i)
+		{
+			unsigned int ipair = batch.contacts[i].pair;
+			SP_CHECK(ipair < pairs.size());
+			if (ipair >= pairs.size())
+				continue;
+
+			SP_CHECK(contactOfPair[ipair] == -1); // at most one manifold per pair
+			contactOfPair[ipair] = (int)i;
+		}
+
+		unsigned int numIntersecting = 0;
+		for (size_t ipair = 0; ipair < pairs.size(); ++ipair)
+		{
+			SContactManifold expected;
+			bool intersecting = _ContactManifold(pairs[ipair].pshape1, pairs[ipair].pshape2, &expected);
+			if (intersecting)
+				++numIntersecting;
+
+			int icontact = contactOfPair[ipair];
+			if (intersecting != (icontact >= 0))
+			{
+				// Only allowed for touching pairs
+				const SContactManifold& manifold = intersecting ? expected : batch.contacts[icontact].manifold;
+				SP_CHECK(manifold.num_points > 0 && fabsf(manifold.points[0].dist) < tolerance);
+				continue;
+			}
+
+			if (!intersecting)
+				continue;
+
+			const SContactManifold& manifold = batch.contacts[icontact].manifold;
+			SP_CHECK(manifold.num_points == expected.num_points);
+			SP_CHECK(manifold.feature == expected.feature);
+			SP_CHECK_NEAR(manifold.n.Length(), 1.0f, tolerance);
+			SP_CHECK((manifold.n - expected.n).Length() < tolerance);
+			for (unsigned int ipt = 0; ipt < std::min(manifold.num_points, expected.num_points); ++ipt)
+			{
+				SP_CHECK(manifold.points[ipt].id == expected.points[ipt].id);
+				SP_CHECK((manifold.points[ipt].p - expected.points[ipt].p).Length() < tolerance);
+				SP_CHECK_NEAR(manifold.points[ipt].dist, expected.points[ipt].dist, tolerance);
+			}
+		}
+
+		return numIntersecting;
+	}
+}
+
+// The SIMD buckets and the scalar remainders give the same manifolds as _ContactManifold() for every pair,
+// for all bucket sizes and orders of the shapes within the pairs
+SP_TEST(Narrowphase_BatchMatchesScalar)
+{
+	FillIntersectionTestTable();
+	std::mt19937 rng(91);
+
+	narrowphase_batch batch; // reused over all runs as in CPhysics
+	unsigned int numIntersecting = 0, numPairs = 0;
+	for (unsigned int run = 0; run < 60; ++run)
+	{
+		// Few shapes for buckets smaller than a SIMD register, many for full registers plus remainders
+		unsigned int numShapes = (run < 20) ? 2 + rng() % 8 : 50 + rng() % 300;
+		std::vector<std::unique_ptr<shape>> shapes = RandomShapes(rng, numShapes, (float)numShapes * 0.1f + 2.0f, (run % 3) == 0);
+		std::vector<shape_pair> pairs = CandidatePairs(rng, shapes);
+
+		_NarrowphaseBatch(pairs.data(), (unsigned int)pairs.size(), &batch);
+		numIntersecting += CheckAgainstScalar(pairs, batch);
+		numPairs += (unsigned int)pairs.size();
+	}
+
+	SP_CHECK(numIntersecting > 1000);
+	SP_CHECK(numIntersecting < numPairs);
+
+	// Sphere exactly touching, sphere centered on a capsule cap, crossed capsules and a sphere centered in a box
+	sphere s1(Vec3f(0, 0, 0), 1.0f), s2(Vec3f(1.5f, 0, 0), 0.5f);
+	capsule c1(Vec3f(0, 0, 0), Vec3f(0, 1.0f, 0), 1.0f, 0.5f), c2(Vec3f(0, 0, 0.5f), Vec3f(1.0f, 0, 0), 1.0f, 0.25f);
+	sphere s3(Vec3f(0, 1.5f, 0), 0.25f);
+	box b1;
+	b1.c = Vec3f(0.2f, 0, 0);
+	b1.axis[0] = Vec3f(1.0f, 0, 0);
+	b1.axis[1] = Vec3f(0, 1.0f, 0);
+	b1.axis[2] = Vec3f(0, 0, 1.0f);
+	b1.dim = Vec3f(1.0f, 2.0f, 2.0f);
+	std::vector<shape_pair> special;
+	for (int i = 0; i < 4; ++i)
+	{
+		special.push_back(shape_pair(&s1, &s2));
+		special.push_back(shape_pair(&c1, &s3));
+		special.push_back(shape_pair(&s3, &c1));
+		special.push_back(shape_pair(&c1, &c2));
+		special.push_back(shape_pair(&s1, &b1));
+	}
+
+	_NarrowphaseBatch(special.data(), (unsigned int)special.size(), &batch);
+	SP_CHECK(CheckAgainstScalar(special, batch) == 20);
+
+	// The sphere leaves the box through the closest face at x = -0.8
+	SContactManifold manifold;
+	SP_CHECK(_ContactManifold(&s1, &b1, &manifold));
+	SP_CHECK((manifold.n - Vec3f(1.0f, 0, 0)).Length() < 1e-5f);
+	SP_CHECK_NEAR(manifold.points[0].dist, -1.8f, 1e-5f);
+	SP_CHECK((manifold.points[0].p - Vec3f(-0.8f, 0, 0)).Length() < 1e-5f);
+
+	// No pairs, no contacts
+	_NarrowphaseBatch(0, 0, &batch);
+	SP_CHECK(batch.contacts.empty());
+}
+
+SP_BENCHMARK(Narrowphase_Batch)
+{
+	FillIntersectionTestTable();
+	std::mt19937 rng(92);
+
+	const unsigned int counts[] = { 1000, 4000, 16000 };
+	for (unsigned int numShapes : counts)
+	{
+		// About 8 candidates per shape
+		std::vector<std::unique_ptr<shape>> shapes = RandomShapes(rng, numShapes, powf((float)numShapes, 1.0f / 3.0f) * 1.6f, false);
+		std::vector<shape_pair> pairs = CandidatePairs(rng, shapes);
+		unsigned int numPairs = (unsigned int)pairs.size();
+
+		narrowphase_batch batch;
+		double tBatch = MeasureMin(5, [&]()
+		{
+			_NarrowphaseBatch(pairs.data(), numPairs, &batch);
+			DoNotOptimize(batch.contacts.size());
+		});
+
+		unsigned int numScalar = 0;
+		double tScalar = MeasureMin(5, [&]()
+		{
+			numScalar = 0;
+			SContactManifold manifold;
+			for (const shape_pair& pair : pairs)
+				numScalar += _ContactManifold(pair.pshape1, pair.pshape2, &manifold) ? 1 : 0;
+			DoNotOptimize(numScalar);
+		});
+
+		printf("  %5u spheres/capsules, %6u pairs, %6u contacts: batched %5.1f ns, scalar %5.1f ns per pair (%.2fx)\n",
+			numShapes, numPairs, (unsigned int)batch.contacts.size(),
+			tBatch * 1e9 / numPairs, tScalar * 1e9 / numPairs, tScalar / tBatch);
+	}
+}
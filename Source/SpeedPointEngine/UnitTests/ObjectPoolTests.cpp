@@ -0,0 +1,316 @@
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+//	SpeedPoint Game Engine
+//	Copyright (c) 2011-2018 Pascal Rosenkranz, All rights reserved.
+//
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#include "UnitTest.h"
+#include <Common\ChunkedObjectPool.h>
+#include <vector>
+#include <random>
+#include <algorithm>
+
+using namespace SpeedPoint::UnitTest;
+
+namespace
+{
+	struct SPoolObject
+	{
+		unsigned int id;
+		float payload[15];
+	};
+}
+
+SP_TEST(ObjectPool_ForEachReleaseAny)
+{
+	const unsigned int numObjects = 500;
+	ChunkedObjectPool<SPoolObject, 16> pool;
+	std::vector<SPoolObject*> objects(numObjects);
+	for (unsigned int i = 0; i < numObjects; ++i)
+	{
+		objects[i] = pool.Get();
+		objects[i]->id = i;
+	}
+
+	// Each visited object releases another random object. Before, this moved the last dense
+	// entry into the hole, so objects were visited twice.
+	std::mt19937 rng(5);
+	std::vector<unsigned int> numVisits(numObjects, 0);
+	std::vector<bool> released(numObjects, false);
+	pool.ForEach([&](SPoolObject* pObject)
+	{
+		SP_CHECK(!released[pObject->id]);
+		++numVisits[pObject->id];
+
+		unsigned int other = rng() % numObjects;
+		if (!released[other] && other != pObject->id)
+		{
+			released[other] = true;
+			pool.Release(&objects[other]);
+		}
+	});
+
+	unsigned int numAlive = 0;
+	for (unsigned int i = 0; i < numObjects; ++i)
+	{
+		SP_CHECK(numVisits[i] <= 1);
+		if (!released[i])
+		{
+			SP_CHECK(numVisits[i] == 1);
+			++numAlive;
+		}
+	}
+
+	// The holes are closed after ForEach() returns
+	SP_CHECK(pool.GetUsedObjectCount() == numAlive);
+	for (unsigned int i = 0; i < pool.GetUsedObjectCount(); ++i)
+	{
+		SP_CHECK(pool.GetAt(i) != 0);
+		SP_CHECK(pool.GetIndex(pool.GetAt(i)) == i);
+	}
+
+	SP_CHECK(pool.GetAt(numAlive) == 0);
+}
+
+SP_TEST(ObjectPool_ForEachGetAndReleaseAll)
+{
+	ChunkedObjectPool<SPoolObject, 8> pool;
+	for (unsigned int i = 0; i < 20; ++i)
+		pool.Get()->id = i;
+
+	// Objects created during ForEach() are visited as well
+	unsigned int numVisited = 0;
+	pool.ForEach([&](SPoolObject* pObject)
+	{
+		++numVisited;
+		if (pObject->id < 20)
+			pool.Get()->id = 100 + pObject->id;
+
+		pool.Release(&pObject);
+	});
+
+	SP_CHECK(numVisited == 40);
+	SP_CHECK(pool.GetUsedObjectCount() == 0);
+
+	unsigned int objindex;
+	SP_CHECK(pool.GetFirstUsedObject(objindex) == 0);
+}
+
+SP_TEST(ObjectPool_GetReusesFreedChunk)
+{
+	const unsigned int chunkSize = 16;
+	ChunkedObjectPool<SPoolObject, chunkSize> pool;
+	std::vector<SPoolObject*> objects(4 * chunkSize);
+	for (unsigned int i = 0; i < objects.size(); ++i)
+		objects[i] = pool.Get();
+
+	SP_CHECK(pool.GetFreeCount() == 0);
+
+	// Free a few slots of the second and the fourth chunk
+	std::vector<SPoolObject*> released;
+	for (unsigned int i = 0; i < 3; ++i)
+	{
+		released.push_back(objects[chunkSize + 5 + i]);
+		released.push_back(objects[3 * chunkSize + 2 + i]);
+		pool.Release(&objects[chunkSize + 5 + i]);
+		pool.Release(&objects[3 * chunkSize + 2 + i]);
+	}
+
+	SP_CHECK(pool.GetFreeCount() == 6);
+
+	// All free slots are used before a new chunk is added
+	for (unsigned int i = 0; i < 6; ++i)
+	{
+		SPoolObject* pObject = pool.Get();
+		SP_CHECK(std::find(released.begin(), released.end(), pObject) != released.end());
+	}
+
+	SP_CHECK(pool.GetFreeCount() == 0);
+	pool.Get();
+	SP_CHECK(pool.GetFreeCount() == chunkSize - 1);
+}
+
+SP_TEST(ObjectPool_FreeChunksAfterCompact)
+{
+	ChunkedObjectPool<SPoolObject, 8> pool;
+	std::vector<SPoolObject*> objects(64);
+	for (unsigned int i = 0; i < objects.size(); ++i)
+		objects[i] = pool.Get();
+
+	for (unsigned int i = 0; i < objects.size(); i += 2)
+		pool.Release(&objects[i]);
+
+	SP_CHECK(pool.Compact() == 4);
+	SP_CHECK(pool.GetFreeCount() == 0);
+
+	for (unsigned int i = 0; i < 8; ++i)
+		SP_CHECK(pool.Get() != 0);
+
+	SP_CHECK(pool.GetUsedObjectCount() == 40);
+	SP_CHECK(pool.GetFreeCount() == 0);
+
+	pool.ReleaseAll();
+	SP_CHECK(pool.GetUsedObjectCount() == 0);
+	SP_CHECK(pool.GetFreeCount() == 40);
+	for (unsigned int i = 0; i < 40; ++i)
+		SP_CHECK(pool.Get() != 0);
+
+	SP_CHECK(pool.GetFreeCount() == 0);
+}
+
+SP_TEST(ObjectPool_CompactMovesAndStaleHandles)
+{
+	const unsigned int chunkSize = 8;
+	ChunkedObjectPool<SPoolObject, chunkSize> pool;
+	std::vector<ObjectPoolHandle> handles(8 * chunkSize);
+	std::vector<SPoolObject*> objects(handles.size());
+	for (unsigned int i = 0; i < handles.size(); ++i)
+	{
+		objects[i] = pool.Get(&handles[i]);
+		objects[i]->id = i;
+	}
+
+	// Keep every fourth object, so 16 objects are spread over all 8 chunks
+	for (unsigned int i = 0; i < handles.size(); ++i)
+	{
+		if (i % 4 != 0)
+			pool.Release(handles[i]);
+	}
+
+	auto getNumChunks = [&pool]() { return (pool.GetUsedObjectCount() + pool.GetFreeCount()) / chunkSize; };
+	SP_CHECK(getNumChunks() == 8);
+	SP_CHECK_NEAR(pool.GetFragmentation(), 0.75f, 1e-6f);
+
+	struct SMove
+	{
+		SPoolObject* pNew;
+		ObjectPoolHandle oldHandle, newHandle;
+	};
+
+	std::vector<SMove> moves;
+	unsigned int numDeleted = pool.Compact([&](SPoolObject* pOld, SPoolObject* pNew, const ObjectPoolHandle& oldHandle, const ObjectPoolHandle& newHandle)
+	{
+		SP_CHECK(pOld == objects[pNew->id]);
+		SMove move = { pNew, oldHandle, newHandle };
+		moves.push_back(move);
+	});
+
+	SP_CHECK(numDeleted == 6);
+	SP_CHECK(getNumChunks() == 2);
+	SP_CHECK(pool.GetFragmentation() == 0.0f);
+	SP_CHECK(pool.GetUsedObjectCount() == 16);
+
+	// The objects of the last 6 chunks moved, the ones of the first 2 chunks stayed
+	SP_CHECK(moves.size() == 12);
+	for (const SMove& move : moves)
+	{
+		SP_CHECK(move.pNew->id >= 2 * chunkSize);
+		SP_CHECK(move.oldHandle == handles[move.pNew->id]);
+		SP_CHECK(move.newHandle != move.oldHandle);
+		SP_CHECK(pool.Resolve(move.oldHandle) == 0);
+		SP_CHECK(pool.Resolve(move.newHandle) == move.pNew);
+		SP_CHECK(pool.GetHandle(move.pNew) == move.newHandle);
+		handles[move.pNew->id] = move.newHandle;
+	}
+
+	for (unsigned int i = 0; i < handles.size(); i += 4)
+	{
+		SP_CHECK(pool.Resolve(handles[i]) != 0 && pool.Resolve(handles[i])->id == i);
+		if (i < 2 * chunkSize)
+			SP_CHECK(pool.Resolve(handles[i]) == objects[i]);
+	}
+
+	// Objects got after compaction do not resolve from the old handles either
+	for (unsigned int i = 0; i < 48; ++i)
+		pool.Get();
+
+	for (const SMove& move : moves)
+		SP_CHECK(pool.Resolve(move.oldHandle) == 0);
+}
+
+SP_TEST(ObjectPool_StaleHandleAfterClear)
+{
+	ChunkedObjectPool<SPoolObject, 8> pool;
+	std::vector<ObjectPoolHandle> handles(20);
+	for (unsigned int i = 0; i < handles.size(); ++i)
+		pool.Get(&handles[i])->id = i;
+
+	// Some slots are at a higher generation than others
+	for (unsigned int i = 0; i < handles.size(); i += 3)
+	{
+		pool.Release(handles[i]);
+		pool.Get(&handles[i])->id = i;
+	}
+
+	pool.Clear();
+	SP_CHECK(pool.GetUsedObjectCount() == 0);
+
+	// The new chunks reuse the same slot indices, but none of the old handles resolves
+	std::vector<ObjectPoolHandle> newHandles(handles.size());
+	for (unsigned int i = 0; i < newHandles.size(); ++i)
+		pool.Get(&newHandles[i])->id = 100 + i;
+
+	for (unsigned int i = 0; i < handles.size(); ++i)
+	{
+		SP_CHECK(pool.Resolve(handles[i]) == 0);
+		SP_CHECK(pool.Resolve(newHandles[i]) != 0 && pool.Resolve(newHandles[i])->id == 100 + i);
+		for (unsigned int j = 0; j < newHandles.size(); ++j)
+			SP_CHECK(newHandles[j] != handles[i]);
+	}
+}
+
+// Costs per object of indexed access, iteration and get/release churn, as used by the physics broadphase
+// and the component pools.
+SP_BENCHMARK(ObjectPool_Access)
+{
+	const unsigned int sizes[] = { 1000, 10000, 100000 };
+	for (unsigned int size : sizes)
+	{
+		ChunkedObjectPool<SPoolObject, 64> pool;
+		std::vector<ObjectPoolHandle> handles(size);
+		for (unsigned int i = 0; i < size; ++i)
+			pool.Get(&handles[i])->id = i;
+
+		// Leave every fourth slot free, so the pool is not trivially packed
+		for (unsigned int i = 0; i < size; i += 4)
+			pool.Release(handles[i]);
+
+		unsigned int numUsed = pool.GetUsedObjectCount();
+		unsigned int numRuns = (size >= 100000 ? 3 : 10);
+		unsigned int sum = 0;
+
+		double getAt = MeasureMin(numRuns, [&]()
+		{
+			for (unsigned int i = 0; i < numUsed; ++i)
+				sum += pool.GetAt(i)->id;
+		});
+
+		double iterate = MeasureMin(numRuns, [&]()
+		{
+			unsigned int objindex;
+			for (SPoolObject* pObject = pool.GetFirstUsedObject(objindex); pObject; pObject = pool.GetNextUsedObject(objindex))
+				sum += pObject->id;
+		});
+
+		// Releases random objects and gets new ones, which have to find the free slots again
+		std::mt19937 rng(7);
+		const unsigned int numChurn = 10000;
+		double churn = MeasureMin(numRuns, [&]()
+		{
+			for (unsigned int i = 0; i < numChurn; ++i)
+			{
+				unsigned int idx = 1 + (rng() % (size - 1)) / 4 * 4 + rng() % 3;
+				if (idx >= size)
+					continue;
+
+				pool.Release(handles[idx]);
+				pool.Get(&handles[idx])->id = idx;
+			}
+		});
+
+		DoNotOptimize(sum);
+		printf("  %6u objects: GetAt %6.2f ns, GetFirst/GetNext %6.2f ns, Release+Get %8.2f ns per object\n",
+			size, getAt * 1e9 / numUsed, iterate * 1e9 / numUsed, churn * 1e9 / numChurn);
+	}
+}
@@ -0,0 +1,245 @@
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+//	SpeedPoint Game Engine
+//	Copyright (c) 2011-2018 Pascal Rosenkranz, All rights reserved.
+//
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#include "UnitTest.h"
+#include <Common\RayPacket.h>
+#include <vector>
+#include <random>
+#include <cstring>
+
+using namespace SpeedPoint;
+using namespace SpeedPoint::geo;
+using namespace SpeedPoint::UnitTest;
+
+namespace
+{
+	float RandomFloat(std::mt19937& rng, float min, float max)
+	{
+		return min + (max - min) * (float)(rng() & 0xFFFFFF) / (float)0xFFFFFF;
+	}
+
+	Vec3f RandomVec3(std::mt19937& rng, float min, float max)
+	{
+		return Vec3f(RandomFloat(rng, min, max), RandomFloat(rng, min, max), RandomFloat(rng, min, max));
+	}
+
+	// Torus with a wavy tube, scaled by 2 along x and moved to (3, -1, 0)
+	mesh* CreateTorus(unsigned int rings, unsigned int segments)
+	{
+		mesh* pmesh = new mesh();
+		pmesh->num_points = (rings + 1) * (segments + 1);
+		pmesh->points = new Vec3f[pmesh->num_points];
+		for (unsigned int r = 0; r <= rings; ++r)
+		{
+			for (unsigned int s = 0; s <= segments; ++s)
+			{
+				float theta = 2.0f * SP_PI * r / rings, phi = 2.0f * SP_PI * s / segments;
+				float tube = 0.35f + 0.02f * sinf(7.0f * phi);
+				pmesh->points[r * (segments + 1) + s] = Vec3f(
+					(1.0f + tube * cosf(theta)) * cosf(phi), tube * sinf(theta), (1.0f + tube * cosf(theta)) * sinf(phi));
+			}
+		}
+
+		pmesh->num_indices = rings * segments * 6;
+		pmesh->indices = new unsigned int[pmesh->num_indices];
+		unsigned int k = 0;
+		for (unsigned int r = 0; r < rings; ++r)
+		{
+			for (unsigned int s = 0; s < segments; ++s)
+			{
+				unsigned int a = r * (segments + 1) + s, b = a + 1, c = a + segments + 1, d = c + 1;
+				unsigned int quad[6] = { a, c, b, b, c, d };
+				for (unsigned int j = 0; j < 6; ++j)
+					pmesh->indices[k++] = quad[j];
+			}
+		}
+
+		pmesh->transform = Mat44::MakeTranslationMatrix(Vec3f(3.0f, -1.0f, 0)) * Mat44::MakeScaleMatrix(Vec3f(2.0f, 1.0f, 1.0f));
+		pmesh->invTransform = SMatrixInvertAffine(pmesh->transform);
+		pmesh->CreateTree();
+		return pmesh;
+	}
+
+	// Picking rays of a camera above the mesh, looking down
+	std::vector<ray> CoherentRays(unsigned int width, unsigned int height)
+	{
+		std::vector<ray> rays(width * height);
+		for (unsigned int y = 0; y < height; ++y)
+		{
+			for (unsigned int x = 0; x < width; ++x)
+			{
+				Vec3f dir(((float)x - width * 0.5f) / width * 1.2f, -1.0f, ((float)y - height * 0.5f) / height * 1.2f);
+				rays[y * width + x] = ray(Vec3f(3.0f, 4.0f, 0), dir);
+			}
+		}
+
+		return rays;
+	}
+
+	// Rays from random points around the mesh to random points near its center ring, so that some miss
+	std::vector<ray> IncoherentRays(std::mt19937& rng, unsigned int n)
+	{
+		std::vector<ray> rays(n);
+		for (unsigned int i = 0; i < n; ++i)
+		{
+			Vec3f origin = Vec3f(3.0f, -1.0f, 0) + RandomVec3(rng, -1.0f, 1.0f).Normalized() * 5.0f;
+			float phi = RandomFloat(rng, 0, 2.0f * SP_PI);
+			Vec3f target = Vec3f(3.0f + 2.0f * cosf(phi), -1.0f, sinf(phi)) + RandomVec3(rng, -1.0f, 1.0f);
+			rays[i] = ray(origin, target - origin);
+		}
+
+		return rays;
+	}
+
+	// Nearest hit by testing all triangles in world space (Moeller-Trumbore)
+	float BruteForceNearest(const ray& r, const mesh* pmesh)
+	{
+		float nearest = FLT_MAX;
+		for (unsigned int i = 0; i < pmesh->num_indices; i += 3)
+		{
+			Vec3f p0 = (pmesh->transform * Vec4f(pmesh->points[pmesh->indices[i]], 1.0f)).xyz();
+			Vec3f p1 = (pmesh->transform * Vec4f(pmesh->points[pmesh->indices[i + 1]], 1.0f)).xyz();
+			Vec3f p2 = (pmesh->transform * Vec4f(pmesh->points[pmesh->indices[i + 2]], 1.0f)).xyz();
+			Vec3f e1 = p1 - p0, e2 = p2 - p0;
+			Vec3f pv = Vec3Cross(r.v, e2);
+			float det = Vec3Dot(e1, pv);
+			if (fabsf(det) < 1e-12f)
+				continue;
+
+			float invDet = 1.0f / det;
+			Vec3f tv = r.p - p0;
+			float u = Vec3Dot(tv, pv) * invDet;
+			if (u < 0 || u > 1.0f)
+				continue;
+
+			Vec3f qv = Vec3Cross(tv, e1);
+			float v = Vec3Dot(r.v, qv) * invDet;
+			if (v < 0 || u + v > 1.0f)
+				continue;
+
+			float t = Vec3Dot(e2, qv) * invDet;
+			if (t >= 0 && t < nearest)
+				nearest = t;
+		}
+
+		return nearest;
+	}
+
+	unsigned int CountMismatches(const std::vector<ray_hit>& a, const std::vector<ray_hit>& b)
+	{
+		unsigned int mismatches = 0;
+		for (size_t i = 0; i < a.size(); ++i)
+		{
+			if (memcmp(&a[i], &b[i], sizeof(ray_hit)) != 0)
+				++mismatches;
+		}
+
+		return mismatches;
+	}
+}
+
+// The packets must return exactly the hits of the single rays, also for an odd number of rays
+SP_TEST(RayPacket_MatchesSingleRays)
+{
+	std::mt19937 rng(51);
+	mesh* pmesh = CreateTorus(64, 128);
+
+	std::vector<ray> coherent = CoherentRays(61, 37);
+	std::vector<ray> incoherent = IncoherentRays(rng, 2003);
+	const std::vector<ray>* raySets[] = { &coherent, &incoherent };
+	for (const std::vector<ray>* prays : raySets)
+	{
+		const std::vector<ray>& rays = *prays;
+		unsigned int n = (unsigned int)rays.size();
+
+		std::vector<ray_hit> single(n);
+		unsigned int numHits = 0;
+		for (unsigned int i = 0; i < n; ++i)
+			numHits += _RayMeshNearest(&rays[i], pmesh, &single[i]) ? 1 : 0;
+
+		SP_CHECK(numHits > n / 10 && numHits < n);
+
+		const unsigned int packetSizes[] = { 4, 8, 16 };
+		for (unsigned int packetSize : packetSizes)
+		{
+			std::vector<ray_hit> packet(n);
+			_RayPacketMeshNearest(&rays[0], n, pmesh, &packet[0], packetSize);
+			SP_CHECK(CountMismatches(single, packet) == 0);
+		}
+	}
+
+	delete pmesh;
+}
+
+// Nearest hits of the BVH traversal against testing all triangles
+SP_TEST(RayPacket_NearestHit)
+{
+	std::mt19937 rng(52);
+	mesh* pmesh = CreateTorus(16, 32);
+	std::vector<ray> rays = IncoherentRays(rng, 500);
+	std::vector<ray_hit> hits(rays.size());
+	_RayPacketMeshNearest(&rays[0], (unsigned int)rays.size(), pmesh, &hits[0]);
+	for (size_t i = 0; i < rays.size(); ++i)
+	{
+		float expected = BruteForceNearest(rays[i], pmesh);
+		SP_CHECK(hits[i].hit() == (expected < FLT_MAX));
+		if (hits[i].hit() && expected < FLT_MAX)
+		{
+			SP_CHECK_NEAR(hits[i].t, expected, 1e-4f * expected);
+
+			const unsigned int* tri = &pmesh->indices[hits[i].tri];
+			Vec3f p = pmesh->points[tri[0]] * (1.0f - hits[i].u - hits[i].v) + pmesh->points[tri[1]] * hits[i].u + pmesh->points[tri[2]] * hits[i].v;
+			Vec3f hitPoint = rays[i].p + rays[i].v * hits[i].t;
+			SP_CHECK(((pmesh->transform * Vec4f(p, 1.0f)).xyz() - hitPoint).Length() < 1e-3f);
+		}
+	}
+
+	// Pointing away from the mesh
+	ray away(Vec3f(3.0f, 4.0f, 0), Vec3f(0, 1.0f, 0));
+	ray_hit hit;
+	SP_CHECK(!_RayMeshNearest(&away, pmesh, &hit) && !hit.hit());
+
+	delete pmesh;
+}
+
+SP_BENCHMARK(RayPacket_Throughput)
+{
+	std::mt19937 rng(53);
+	mesh* pmesh = CreateTorus(128, 256);
+	const unsigned int numRuns = 5;
+
+	std::vector<ray> coherent = CoherentRays(256, 256);
+	std::vector<ray> incoherent = IncoherentRays(rng, 256 * 256);
+	const char* names[] = { "coherent", "incoherent" };
+	const std::vector<ray>* raySets[] = { &coherent, &incoherent };
+	for (unsigned int set = 0; set < 2; ++set)
+	{
+		const std::vector<ray>& rays = *raySets[set];
+		unsigned int n = (unsigned int)rays.size();
+		std::vector<ray_hit> hits(n);
+
+		double tSingle = MeasureMin(numRuns, [&]()
+		{
+			for (unsigned int i = 0; i < n; ++i)
+				_RayMeshNearest(&rays[i], pmesh, &hits[i]);
+		});
+
+		printf("  %u %s rays: single %6.2f Mrays/s", n, names[set], n / tSingle * 1e-6);
+
+		const unsigned int packetSizes[] = { 4, 8, 16 };
+		for (unsigned int packetSize : packetSizes)
+		{
+			double tPacket = MeasureMin(numRuns, [&]() { _RayPacketMeshNearest(&rays[0], n, pmesh, &hits[0], packetSize); });
+			printf(", packet %u %6.2f", packetSize, n / tPacket * 1e-6);
+		}
+
+		DoNotOptimize(hits);
+		printf("\n");
+	}
+
+	delete pmesh;
+}
@@ -0,0 +1,191 @@
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+//	SpeedPoint Game Engine
+//	Copyright (c) 2011-2018 Pascal Rosenkranz, All rights reserved.
+//
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#include "UnitTest.h"
+#include <Common\Mat44.h>
+#include <Common\Quaternion.h>
+#include <vector>
+#include <random>
+#include <algorithm>
+#include <cfloat>
+
+using namespace SpeedPoint;
+using namespace SpeedPoint::UnitTest;
+
+namespace
+{
+	float RandomFloat(std::mt19937& rng, float min, float max)
+	{
+		return min + (max - min) * (float)(rng() & 0xFFFFFF) / (float)0xFFFFFF;
+	}
+
+	Vec3f RandomVec3(std::mt19937& rng, float min, float max)
+	{
+		return Vec3f(RandomFloat(rng, min, max), RandomFloat(rng, min, max), RandomFloat(rng, min, max));
+	}
+
+	// The part of the rigid body state that PhysObject::Update() integrates
+	struct SBody
+	{
+		Vec3f pos, scale, L;
+		Quat rotation;
+		Mat33 Ibodyinv, Iinv;
+		Vec3f w;
+		Mat44 transform, invTransform;
+	};
+
+	SBody RandomBody(std::mt19937& rng)
+	{
+		SBody body;
+		body.pos = RandomVec3(rng, -100.0f, 100.0f);
+		body.scale = RandomVec3(rng, 0.5f, 2.0f);
+		body.L = RandomVec3(rng, -5.0f, 5.0f);
+		body.rotation = Quat::FromAxisAngle(RandomVec3(rng, -1.0f, 1.0f).Normalized(), RandomFloat(rng, -3.14f, 3.14f));
+
+		Vec3f Ibody = RandomVec3(rng, 0.5f, 2.0f);
+		body.Ibodyinv = Mat33(1.0f / Ibody.x, 0, 0, 0, 1.0f / Ibody.y, 0, 0, 0, 1.0f / Ibody.z);
+		return body;
+	}
+
+	// The step as PhysObject::Update() did it before the fused functions
+	void StepSeparate(SBody& body, float dt)
+	{
+		Mat33 R = body.rotation.ToRotationMatrix33();
+		body.Iinv = R * body.Ibodyinv * R.Transposed();
+		body.w = body.Iinv * body.L;
+
+		float wln = body.w.Length();
+		if (wln < FLT_EPSILON)
+			body.rotation = Quat(cosf(wln * dt * 0.5f), body.w * (dt * 0.5f)) * body.rotation;
+		else
+			body.rotation = Quat::FromAxisAngle(body.w / wln, wln * dt) * body.rotation;
+
+		MakeTransformationTRS(body.pos, body.rotation.ToRotationMatrix(), body.scale, &body.transform);
+		body.invTransform = SMatrixInvert(body.transform);
+	}
+
+	void StepFused(SBody& body, float dt)
+	{
+		body.Iinv = body.rotation.RotateTensor(body.Ibodyinv);
+		body.w = body.Iinv * body.L;
+		body.rotation = body.rotation.Integrated(body.w, dt);
+
+		MakeTransformationTRS(body.pos, body.rotation, body.scale, &body.transform);
+		body.invTransform = SMatrixInvertAffine(body.transform);
+	}
+
+	float MaxDifference(const Mat33& a, const Mat33& b)
+	{
+		float maxDiff = 0;
+		for (int i = 0; i < 3; ++i)
+		{
+			for (int j = 0; j < 3; ++j)
+				maxDiff = std::max(maxDiff, fabsf(a.m[i][j] - b.m[i][j]));
+		}
+
+		return maxDiff;
+	}
+
+	float MaxDifference(const Mat44& a, const Mat44& b)
+	{
+		float maxDiff = 0;
+		for (int i = 0; i < 4; ++i)
+		{
+			for (int j = 0; j < 4; ++j)
+				maxDiff = std::max(maxDiff, fabsf(a.m[i][j] - b.m[i][j]));
+		}
+
+		return maxDiff;
+	}
+}
+
+// One simulation step of the fused functions against the separate matrices and FromAxisAngle()
+SP_TEST(RigidBody_FusedStepMatchesSeparate)
+{
+	std::mt19937 rng(31);
+	const float dt = 1.0f / 60.0f;
+	float maxQuat = 0, maxIinv = 0, maxTransform = 0, maxInverse = 0;
+	for (unsigned int i = 0; i < 10000; ++i)
+	{
+		SBody separate = RandomBody(rng), fused = separate;
+		StepSeparate(separate, dt);
+		StepFused(fused, dt);
+
+		float dot = fused.rotation.w * separate.rotation.w + Vec3Dot(fused.rotation.v, separate.rotation.v);
+		maxQuat = std::max(maxQuat, 1.0f - fabsf(dot));
+		maxIinv = std::max(maxIinv, MaxDifference(fused.Iinv, separate.Iinv));
+		maxTransform = std::max(maxTransform, MaxDifference(fused.transform, separate.transform));
+		maxInverse = std::max(maxInverse, MaxDifference(SMatrixMultiplyScalar(fused.transform, fused.invTransform), Mat44::Identity));
+
+		// The unnormalized quaternion gives the same rotation matrix
+		SP_CHECK(MaxDifference((fused.rotation * 3.0f).ToRotationMatrix33(), fused.rotation.ToRotationMatrix33()) < 1e-6f);
+	}
+
+	// Up to 17 rad/s, so the first order map is off by up to 2e-3 rad after one step.
+	// The residual of the inverse is relative to translations of up to 100.
+	SP_CHECK(maxQuat < 1e-6f);
+	SP_CHECK(maxIinv < 1e-5f);
+	SP_CHECK(maxTransform < 5e-3f);
+	SP_CHECK(maxInverse < 1e-4f);
+	printf("  max error: quat 1-|dot| %.2g, Iinv %.2g, transform %.2g, inverse residual %.2g\n", maxQuat, maxIinv, maxTransform, maxInverse);
+}
+
+// The first order exponential map under-rotates by about theta^2 / 12 per step
+SP_TEST(RigidBody_IntegratedAngleError)
+{
+	const Vec3f axis = Vec3f(1.0f, 2.0f, -0.5f).Normalized();
+	const float dt = 1.0f / 60.0f;
+	const float rates[] = { 0.5f, 2.0f, 6.0f, 14.0f };
+	for (float rate : rates)
+	{
+		Quat q = Quat().Integrated(axis * rate, dt);
+		float angle = 2.0f * atan2f(q.v.Length(), q.w);
+		float theta = rate * dt;
+		SP_CHECK(angle <= theta);
+		SP_CHECK_NEAR(angle / theta, 1.0f - theta * theta / 12.0f, 1e-4f);
+		SP_CHECK_NEAR(q.Length(), 1.0f, 1e-6f);
+	}
+}
+
+SP_BENCHMARK(RigidBody_Step)
+{
+	std::mt19937 rng(32);
+	const unsigned int n = 4096;
+	const unsigned int numSteps = 20;
+	const float dt = 1.0f / 60.0f;
+
+	std::vector<SBody> initial(n);
+	for (unsigned int i = 0; i < n; ++i)
+		initial[i] = RandomBody(rng);
+
+	std::vector<SBody> bodies;
+	double tSeparate = MeasureMin(10, [&]()
+	{
+		bodies = initial;
+		for (unsigned int step = 0; step < numSteps; ++step)
+		{
+			for (unsigned int i = 0; i < n; ++i)
+				StepSeparate(bodies[i], dt);
+		}
+	});
+
+	DoNotOptimize(bodies);
+
+	double tFused = MeasureMin(10, [&]()
+	{
+		bodies = initial;
+		for (unsigned int step = 0; step < numSteps; ++step)
+		{
+			for (unsigned int i = 0; i < n; ++i)
+				StepFused(bodies[i], dt);
+		}
+	});
+
+	DoNotOptimize(bodies);
+	printf("  %u bodies x %u steps: separate %6.2f ns, fused %6.2f ns per body and step (%.2fx)\n",
+		n, numSteps, tSeparate * 1e9 / (n * numSteps), tFused * 1e9 / (n * numSteps), tSeparate / tFused);
+}
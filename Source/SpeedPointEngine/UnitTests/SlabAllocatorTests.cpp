@@ -0,0 +1,151 @@
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+//	SpeedPoint Game Engine
+//	Copyright (c) 2011-2018 Pascal Rosenkranz, All rights reserved.
+//
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#include "UnitTest.h"
+#include <Common\SlabAllocator.h>
+#include <vector>
+#include <algorithm>
+
+using namespace SpeedPoint;
+using namespace SpeedPoint::UnitTest;
+
+SP_TEST(SlabAllocator_BlockSize)
+{
+	SlabAllocator tiny(1);
+	SP_CHECK(tiny.GetBlockSize() == SLAB_BLOCK_ALIGNMENT);
+
+	SlabAllocator odd(20);
+	SP_CHECK(odd.GetBlockSize() == 32);
+
+	SlabAllocator exact(48);
+	SP_CHECK(exact.GetBlockSize() == 48);
+
+	for (unsigned int i = 0; i < 10; ++i)
+		SP_CHECK(((size_t)odd.Allocate() % SLAB_BLOCK_ALIGNMENT) == 0);
+}
+
+SP_TEST(SlabAllocator_FreeListReuse)
+{
+	const unsigned int blocksPerSlab = 8;
+	SlabAllocator slab(32, blocksPerSlab);
+	SP_CHECK(slab.GetNumSlabs() == 0);
+
+	std::vector<void*> blocks;
+	for (unsigned int i = 0; i < blocksPerSlab; ++i)
+		blocks.push_back(slab.Allocate());
+
+	SP_CHECK(slab.GetNumSlabs() == 1);
+	SP_CHECK(slab.GetNumUsedBlocks() == blocksPerSlab);
+
+	// The first slab hands out blocks in address order
+	for (unsigned int i = 1; i < blocksPerSlab; ++i)
+		SP_CHECK((char*)blocks[i] == (char*)blocks[i - 1] + 32);
+
+	// Freed blocks are reused last in, first out before a new slab is added
+	slab.Free(blocks[2]);
+	slab.Free(blocks[5]);
+	SP_CHECK(slab.GetNumUsedBlocks() == blocksPerSlab - 2);
+	SP_CHECK(slab.Allocate() == blocks[5]);
+	SP_CHECK(slab.Allocate() == blocks[2]);
+	SP_CHECK(slab.GetNumSlabs() == 1);
+
+	void* pNewSlabBlock = slab.Allocate();
+	SP_CHECK(slab.GetNumSlabs() == 2);
+	SP_CHECK(std::find(blocks.begin(), blocks.end(), pNewSlabBlock) == blocks.end());
+
+	slab.Free(0);
+	SP_CHECK(slab.GetNumUsedBlocks() == blocksPerSlab + 1);
+
+	slab.Clear();
+	SP_CHECK(slab.GetNumSlabs() == 0);
+	SP_CHECK(slab.GetNumUsedBlocks() == 0);
+}
+
+#if SLAB_POISON
+SP_TEST(SlabAllocator_Poisoning)
+{
+	SlabAllocator slab(64, 4);
+	unsigned char* pBlock = (unsigned char*)slab.Allocate();
+
+	// Allocated blocks are filled with 0xCD
+	for (unsigned int i = 0; i < 64; ++i)
+		SP_CHECK(pBlock[i] == 0xCD);
+
+	memset(pBlock, 0x11, 64);
+	slab.Free(pBlock);
+
+	// Freed blocks are filled with 0xDD, except for the free list link at the start
+	for (unsigned int i = sizeof(void*); i < 64; ++i)
+		SP_CHECK(pBlock[i] == 0xDD);
+
+	// Blocks that were never handed out are poisoned as freed
+	unsigned char* pUnused = pBlock + 64;
+	for (unsigned int i = sizeof(void*); i < 64; ++i)
+		SP_CHECK(pUnused[i] == 0xDD);
+
+	SP_CHECK(slab.Allocate() == pBlock);
+	for (unsigned int i = 0; i < 64; ++i)
+		SP_CHECK(pBlock[i] == 0xCD);
+}
+#endif
+
+SP_TEST(SmallObjectAllocator_SizeClasses)
+{
+	SmallObjectAllocator allocator;
+
+	struct SSizeClassCase
+	{
+		size_t size;
+		size_t blockSize;
+	};
+
+	const SSizeClassCase cases[] = { { 1, 16 }, { 15, 16 }, { 16, 16 }, { 17, 32 }, { 32, 32 }, { 33, 48 }, { 255, 256 }, { 256, 256 } };
+	for (const SSizeClassCase& c : cases)
+	{
+		unsigned int numUsedBefore = allocator.GetNumUsedBlocks(c.blockSize);
+		void* p = allocator.Allocate(c.size);
+		SP_CHECK(p != 0);
+		SP_CHECK(((size_t)p % SLAB_BLOCK_ALIGNMENT) == 0);
+		SP_CHECK(allocator.GetNumUsedBlocks(c.blockSize) == numUsedBefore + 1);
+		SP_CHECK(allocator.GetNumUsedBlocks(c.size) == numUsedBefore + 1);
+
+		// Neighbouring size classes are not affected
+		if (c.blockSize > 16)
+			SP_CHECK(allocator.GetNumUsedBlocks(c.blockSize - 16) == 0);
+		if (c.blockSize < 256)
+			SP_CHECK(allocator.GetNumUsedBlocks(c.blockSize + 16) == 0);
+
+		allocator.Free(p, c.size);
+		SP_CHECK(allocator.GetNumUsedBlocks(c.blockSize) == numUsedBefore);
+	}
+}
+
+SP_TEST(SmallObjectAllocator_HeapFallback)
+{
+	SmallObjectAllocator allocator;
+
+	// Sizes above 256 bytes and 0 bytes go to the heap and do not use any size class
+	const size_t sizes[] = { 0, 257, 4096 };
+	for (size_t size : sizes)
+	{
+		void* p = allocator.Allocate(size);
+		SP_CHECK(p != 0);
+		SP_CHECK(((size_t)p % SLAB_BLOCK_ALIGNMENT) == 0);
+		SP_CHECK(allocator.GetNumUsedBlocks(size) == 0);
+
+		for (size_t blockSize = 16; blockSize <= SMALL_OBJECT_MAX_SIZE; blockSize += 16)
+			SP_CHECK(allocator.GetNumUsedBlocks(blockSize) == 0);
+
+		if (size > 0)
+			memset(p, 0x5A, size);
+
+		allocator.Free(p, size);
+	}
+
+	allocator.Free(0, 16);
+	allocator.Free(0, 257);
+}
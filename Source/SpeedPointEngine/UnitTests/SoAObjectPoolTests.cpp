@@ -0,0 +1,220 @@
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+//	SpeedPoint Game Engine
+//	Copyright (c) 2011-2018 Pascal Rosenkranz, All rights reserved.
+//
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#include "UnitTest.h"
+#include <Common\SoAObjectPool.h>
+#include <Common\BoundBox.h>
+#include <vector>
+#include <random>
+#include <memory>
+
+using namespace SpeedPoint;
+using namespace SpeedPoint::UnitTest;
+
+namespace
+{
+	// Field that owns memory and counts live instances, to check that the streams construct,
+	// move and destroy their elements properly
+	struct SOwningField
+	{
+		static int numAlive;
+		std::unique_ptr<unsigned int> pValue;
+
+		SOwningField() : pValue(new unsigned int(UINT_MAX)) { ++numAlive; }
+		SOwningField(SOwningField&& other) : pValue(std::move(other.pValue)) { ++numAlive; }
+		SOwningField& operator =(SOwningField&& other) { pValue = std::move(other.pValue); return *this; }
+		~SOwningField() { --numAlive; }
+	};
+
+	int SOwningField::numAlive = 0;
+
+	struct SSoATestObject
+	{
+		unsigned int id;
+	};
+
+	enum ETestStream
+	{
+		eTEST_STREAM_OWNING = 0,
+		eTEST_STREAM_ID
+	};
+}
+
+SP_TEST(SoAObjectPool_NonTrivialFields)
+{
+	{
+		SoAObjectPool<SSoATestObject, SOwningField, unsigned int> pool;
+		std::vector<SSoATestObject*> objects(500);
+		for (unsigned int i = 0; i < objects.size(); ++i)
+		{
+			unsigned int idx;
+			objects[i] = pool.Get(&idx);
+			objects[i]->id = i;
+			SP_CHECK(*pool.GetStream<eTEST_STREAM_OWNING>()[idx].pValue == UINT_MAX);
+
+			*pool.GetStream<eTEST_STREAM_OWNING>()[idx].pValue = i;
+			pool.GetStream<eTEST_STREAM_ID>()[idx] = i;
+		}
+
+		// The streams were reallocated several times, elements must have been moved, not copied bitwise
+		SP_CHECK(SOwningField::numAlive == (int)objects.size());
+
+		std::mt19937 rng(3);
+		for (unsigned int n = 0; n < 200; ++n)
+		{
+			unsigned int i = rng() % objects.size();
+			if (objects[i])
+				pool.Release(&objects[i]);
+		}
+
+		SP_CHECK(SOwningField::numAlive == (int)pool.GetUsedObjectCount());
+
+		// Hot data of the moved objects still belongs to them
+		for (unsigned int i = 0; i < objects.size(); ++i)
+		{
+			if (!objects[i])
+				continue;
+
+			unsigned int idx = pool.GetIndex(objects[i]);
+			SP_CHECK(idx < pool.GetUsedObjectCount());
+			SP_CHECK(pool.GetStream<eTEST_STREAM_ID>()[idx] == i);
+			SP_CHECK(*pool.GetStream<eTEST_STREAM_OWNING>()[idx].pValue == i);
+		}
+
+		pool.ReleaseAll();
+		SP_CHECK(SOwningField::numAlive == 0);
+
+		for (unsigned int i = 0; i < 10; ++i)
+			pool.Get();
+
+		SP_CHECK(SOwningField::numAlive == 10);
+	}
+
+	SP_CHECK(SOwningField::numAlive == 0);
+}
+
+namespace
+{
+	// Sized and laid out roughly like PhysObject: vtable, SPhysObjectState, SProxyPart, scale, flags
+	class CAoSBody
+	{
+	public:
+		float damping;
+		Vec3f centerOfMass;
+		Vec3f pos, v, P, F;
+		bool livingMoves, livingOnGround;
+		float rotation[4];
+		Vec3f w, L;
+		float M, Minv;
+		float Iinv[9], Ibodyinv[9];
+		float V;
+		bool gravity;
+		AABB aabb, aabbworld;
+		void* pshape;
+		void* pshapeworld;
+		void* phelper;
+		Vec3f scale;
+		bool bHelperShown, bTrash;
+		int behavior;
+
+		virtual ~CAoSBody() {}
+	};
+
+	struct SSoABody
+	{
+		CAoSBody* pBody;
+	};
+
+	enum EBodyStream
+	{
+		eBODY_STREAM_POS = 0,
+		eBODY_STREAM_VELOCITY,
+		eBODY_STREAM_MOMENTUM,
+		eBODY_STREAM_ANGULAR_MOMENTUM,
+		eBODY_STREAM_AABB,
+		eBODY_STREAM_INV_MASS
+	};
+}
+
+// Linear part of PhysObject::Update() on AoS objects in a ChunkedObjectPool vs. the same
+// fields (pos, v, P, L, aabbworld, Minv) as SoA streams of an SoAObjectPool.
+SP_BENCHMARK(SoAObjectPool_Integrate)
+{
+	const unsigned int sizes[] = { 1000, 10000, 100000, 1000000 };
+	const float dt = 1.0f / 60.0f, damping = 0.99f;
+	const Vec3f gravity(0, -9.81f, 0);
+
+	printf("  sizeof(CAoSBody) = %u, SoA bytes per body = %u\n", (unsigned int)sizeof(CAoSBody),
+		(unsigned int)(4 * sizeof(Vec3f) + sizeof(AABB) + sizeof(float)));
+
+	for (unsigned int size : sizes)
+	{
+		ChunkedObjectPool<CAoSBody> aosBodies;
+		SoAObjectPool<SSoABody, Vec3f, Vec3f, Vec3f, Vec3f, AABB, float> soaBodies;
+		for (unsigned int i = 0; i < size; ++i)
+		{
+			CAoSBody* pBody = aosBodies.Get();
+			pBody->pos = Vec3f((float)i, 0, 0);
+			pBody->P = Vec3f(0, 1.0f, 0);
+			pBody->L = Vec3f(0, 0, 1.0f);
+			pBody->Minv = 1.0f;
+			pBody->aabbworld = AABB(pBody->pos - Vec3f(0.5f), pBody->pos + Vec3f(0.5f));
+
+			unsigned int idx;
+			soaBodies.Get(&idx)->pBody = pBody;
+			soaBodies.GetStream<eBODY_STREAM_POS>()[idx] = pBody->pos;
+			soaBodies.GetStream<eBODY_STREAM_MOMENTUM>()[idx] = pBody->P;
+			soaBodies.GetStream<eBODY_STREAM_ANGULAR_MOMENTUM>()[idx] = pBody->L;
+			soaBodies.GetStream<eBODY_STREAM_AABB>()[idx] = pBody->aabbworld;
+			soaBodies.GetStream<eBODY_STREAM_INV_MASS>()[idx] = pBody->Minv;
+		}
+
+		unsigned int numRuns = (size >= 1000000 ? 3 : (size >= 100000 ? 5 : 20));
+
+		double aos = MeasureMin(numRuns, [&]()
+		{
+			aosBodies.ForEach([&](CAoSBody* pBody)
+			{
+				pBody->v = pBody->Minv * pBody->P;
+				Vec3f dx = pBody->v * dt;
+				pBody->pos += dx;
+				pBody->P += gravity * (dt / pBody->Minv);
+				pBody->P *= damping;
+				pBody->L *= damping;
+				pBody->aabbworld.vMin += dx;
+				pBody->aabbworld.vMax += dx;
+			});
+		});
+
+		double soa = MeasureMin(numRuns, [&]()
+		{
+			unsigned int num = soaBodies.GetUsedObjectCount();
+			Vec3f* pos = soaBodies.GetStream<eBODY_STREAM_POS>();
+			Vec3f* v = soaBodies.GetStream<eBODY_STREAM_VELOCITY>();
+			Vec3f* P = soaBodies.GetStream<eBODY_STREAM_MOMENTUM>();
+			Vec3f* L = soaBodies.GetStream<eBODY_STREAM_ANGULAR_MOMENTUM>();
+			AABB* aabbworld = soaBodies.GetStream<eBODY_STREAM_AABB>();
+			const float* Minv = soaBodies.GetStream<eBODY_STREAM_INV_MASS>();
+			for (unsigned int i = 0; i < num; ++i)
+			{
+				v[i] = Minv[i] * P[i];
+				Vec3f dx = v[i] * dt;
+				pos[i] += dx;
+				P[i] += gravity * (dt / Minv[i]);
+				P[i] *= damping;
+				L[i] *= damping;
+				aabbworld[i].vMin += dx;
+				aabbworld[i].vMax += dx;
+			}
+		});
+
+		DoNotOptimize(aosBodies.GetAt(0)->pos);
+		DoNotOptimize(soaBodies.GetStream<eBODY_STREAM_POS>()[0]);
+		printf("  %7u bodies: AoS %6.2f ns, SoA %6.2f ns per body (%.1fx)\n",
+			size, aos * 1e9 / size, soa * 1e9 / size, aos / soa);
+	}
+}
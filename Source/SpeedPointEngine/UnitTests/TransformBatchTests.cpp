@@ -0,0 +1,198 @@
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+//	SpeedPoint Game Engine
+//	Copyright (c) 2011-2018 Pascal Rosenkranz, All rights reserved.
+//
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#include "UnitTest.h"
+#include <Common\TransformBatch.h>
+#include <Common\BoundBox.h>
+#include <Common\Quaternion.h>
+#include <vector>
+#include <random>
+
+using namespace SpeedPoint;
+using namespace SpeedPoint::UnitTest;
+
+namespace
+{
+	float RandomFloat(std::mt19937& rng, float min, float max)
+	{
+		return min + (max - min) * (float)(rng() & 0xFFFFFF) / (float)0xFFFFFF;
+	}
+
+	Vec3f RandomVec3(std::mt19937& rng, float min, float max)
+	{
+		return Vec3f(RandomFloat(rng, min, max), RandomFloat(rng, min, max), RandomFloat(rng, min, max));
+	}
+
+	// Affine matrix with random rotation, non-uniform scale and translation
+	Mat44 RandomTRS(std::mt19937& rng)
+	{
+		Quat q = Quat::FromAxisAngle(RandomVec3(rng, -1.0f, 1.0f).Normalized(), RandomFloat(rng, -3.14f, 3.14f));
+		Mat44 m;
+		MakeTransformationTRS(RandomVec3(rng, -50.0f, 50.0f), q, RandomVec3(rng, 0.5f, 2.0f), &m);
+		return m;
+	}
+
+	AABB RandomAABB(std::mt19937& rng)
+	{
+		Vec3f c = RandomVec3(rng, -10.0f, 10.0f), e = RandomVec3(rng, 0.1f, 3.0f);
+		return AABB(c - e, c + e);
+	}
+
+	Vec3f TransformPoint(const Mat44& mtx, const Vec3f& p)
+	{
+		return (mtx * Vec4f(p, 1.0f)).xyz();
+	}
+
+	// Reference: the AABB of the 8 transformed corners
+	AABB TransformAABBCorners(const Mat44& mtx, const AABB& aabb)
+	{
+		AABB result;
+		result.Reset();
+		for (int i = 0; i < 8; ++i)
+		{
+			Vec3f corner((i & 1) ? aabb.vMax.x : aabb.vMin.x, (i & 2) ? aabb.vMax.y : aabb.vMin.y, (i & 4) ? aabb.vMax.z : aabb.vMin.z);
+			result.AddPoint(TransformPoint(mtx, corner));
+		}
+
+		return result;
+	}
+}
+
+// Odd counts, so the scalar remainder of the SIMD loops is covered as well
+SP_TEST(TransformBatch_MatchesSingleTransforms)
+{
+	std::mt19937 rng(21);
+	const unsigned int n = 1003;
+	for (unsigned int run = 0; run < 20; ++run)
+	{
+		Mat44 mtx = RandomTRS(rng);
+
+		std::vector<Vec3f> points(n), transformed(n), directions(n);
+		for (unsigned int i = 0; i < n; ++i)
+			points[i] = RandomVec3(rng, -10.0f, 10.0f);
+
+		TransformPoints(mtx, &points[0], &transformed[0], n);
+		TransformDirections(mtx, &points[0], &directions[0], n);
+		for (unsigned int i = 0; i < n; ++i)
+		{
+			Vec3f p = TransformPoint(mtx, points[i]);
+			SP_CHECK(transformed[i].x == p.x && transformed[i].y == p.y && transformed[i].z == p.z);
+
+			Vec3f d = (mtx * Vec4f(points[i], 0.0f)).xyz();
+			SP_CHECK_NEAR(directions[i].x, d.x, 1e-4f);
+			SP_CHECK_NEAR(directions[i].y, d.y, 1e-4f);
+			SP_CHECK_NEAR(directions[i].z, d.z, 1e-4f);
+		}
+
+		// In place
+		TransformPoints(mtx, &points[0], &points[0], n);
+		for (unsigned int i = 0; i < n; ++i)
+			SP_CHECK(points[i].x == transformed[i].x && points[i].y == transformed[i].y && points[i].z == transformed[i].z);
+
+		// AABBs, with one matrix for all and one matrix per box
+		std::vector<AABB> aabbs(n), out(n), outPerBox(n);
+		std::vector<Mat44> mtxs(n);
+		std::vector<const Mat44*> pmtxs(n);
+		for (unsigned int i = 0; i < n; ++i)
+		{
+			aabbs[i] = RandomAABB(rng);
+			mtxs[i] = (i % 2 == 0 ? mtx : RandomTRS(rng));
+			pmtxs[i] = &mtxs[i];
+		}
+
+		TransformAABBs(mtx, &aabbs[0], &out[0], n);
+		TransformAABBs(&pmtxs[0], &aabbs[0], &outPerBox[0], n);
+		for (unsigned int i = 0; i < n; ++i)
+		{
+			AABB expected = TransformAABBCorners(mtx, aabbs[i]);
+			SP_CHECK_NEAR(out[i].vMin.x, expected.vMin.x, 1e-3f);
+			SP_CHECK_NEAR(out[i].vMin.y, expected.vMin.y, 1e-3f);
+			SP_CHECK_NEAR(out[i].vMin.z, expected.vMin.z, 1e-3f);
+			SP_CHECK_NEAR(out[i].vMax.x, expected.vMax.x, 1e-3f);
+			SP_CHECK_NEAR(out[i].vMax.y, expected.vMax.y, 1e-3f);
+			SP_CHECK_NEAR(out[i].vMax.z, expected.vMax.z, 1e-3f);
+
+			AABB expectedPerBox = TransformAABBCorners(mtxs[i], aabbs[i]);
+			SP_CHECK_NEAR(outPerBox[i].vMin.x, expectedPerBox.vMin.x, 1e-3f);
+			SP_CHECK_NEAR(outPerBox[i].vMax.y, expectedPerBox.vMax.y, 1e-3f);
+			SP_CHECK_NEAR(outPerBox[i].vMax.z, expectedPerBox.vMax.z, 1e-3f);
+
+			// AABB::Transform() goes through the same kernel
+			AABB single = aabbs[i];
+			single.Transform(mtxs[i]);
+			SP_CHECK(single.vMin.x == outPerBox[i].vMin.x && single.vMax.z == outPerBox[i].vMax.z);
+		}
+
+		// Spheres enclose the transformed sphere surface
+		std::vector<BoundSphere> spheres(n), outSpheres(n);
+		for (unsigned int i = 0; i < n; ++i)
+			spheres[i] = BoundSphere(RandomVec3(rng, -10.0f, 10.0f), RandomFloat(rng, 0.1f, 3.0f));
+
+		TransformSpheres(mtx, &spheres[0], &outSpheres[0], n);
+		for (unsigned int i = 0; i < n; ++i)
+		{
+			Vec3f c = TransformPoint(mtx, spheres[i].c);
+			SP_CHECK_NEAR(outSpheres[i].c.x, c.x, 1e-4f);
+			SP_CHECK_NEAR(outSpheres[i].c.y, c.y, 1e-4f);
+			SP_CHECK_NEAR(outSpheres[i].c.z, c.z, 1e-4f);
+
+			for (unsigned int k = 0; k < 8; ++k)
+			{
+				Vec3f surface = spheres[i].c + RandomVec3(rng, -1.0f, 1.0f).Normalized() * spheres[i].r;
+				SP_CHECK((TransformPoint(mtx, surface) - outSpheres[i].c).Length() <= outSpheres[i].r * 1.0001f + 1e-4f);
+			}
+		}
+	}
+}
+
+// Batched kernels against transforming each element on its own, as the callers did before
+SP_BENCHMARK(TransformBatch_Throughput)
+{
+	std::mt19937 rng(22);
+	const unsigned int n = 65536;
+	const unsigned int numRuns = 50;
+	Mat44 mtx = RandomTRS(rng);
+
+	std::vector<Vec3f> points(n), out(n);
+	std::vector<AABB> aabbs(n), outAABBs(n);
+	for (unsigned int i = 0; i < n; ++i)
+	{
+		points[i] = RandomVec3(rng, -10.0f, 10.0f);
+		aabbs[i] = RandomAABB(rng);
+	}
+
+	double tSingle = MeasureMin(numRuns, [&]()
+	{
+		for (unsigned int i = 0; i < n; ++i)
+			out[i] = TransformPoint(mtx, points[i]);
+	});
+
+	double tBatch = MeasureMin(numRuns, [&]() { TransformPoints(mtx, &points[0], &out[0], n); });
+	DoNotOptimize(out);
+	printf("  %u points: per point %6.2f Mpts/s, TransformPoints %6.2f Mpts/s (%.2fx)\n",
+		n, n / tSingle * 1e-6, n / tBatch * 1e-6, tSingle / tBatch);
+
+	double tCorners = MeasureMin(numRuns, [&]()
+	{
+		for (unsigned int i = 0; i < n; ++i)
+			outAABBs[i] = TransformAABBCorners(mtx, aabbs[i]);
+	});
+
+	double tTransform = MeasureMin(numRuns, [&]()
+	{
+		for (unsigned int i = 0; i < n; ++i)
+		{
+			outAABBs[i] = aabbs[i];
+			outAABBs[i].Transform(mtx);
+		}
+	});
+
+	double tBatchAABBs = MeasureMin(numRuns, [&]() { TransformAABBs(mtx, &aabbs[0], &outAABBs[0], n); });
+	DoNotOptimize(outAABBs);
+	printf("  %u AABBs: 8 corners %6.2f ns, AABB::Transform() %6.2f ns, TransformAABBs %6.2f ns per box\n",
+		n, tCorners * 1e9 / n, tTransform * 1e9 / n, tBatchAABBs * 1e9 / n);
+}
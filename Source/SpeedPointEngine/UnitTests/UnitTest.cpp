@@ -0,0 +1,119 @@
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+//	SpeedPoint Game Engine
+//	Copyright (c) 2011-2018 Pascal Rosenkranz, All rights reserved.
+//
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#include "UnitTest.h"
+#include <cstring>
+#include <cstdlib>
+#include <atomic>
+#include <new>
+
+static std::atomic<unsigned int> g_NumHeapAllocations(0);
+
+// Replaces the global operator new to count heap allocations. The array and nothrow variants
+// of the standard library forward to this one.
+void* operator new(size_t size)
+{
+	++g_NumHeapAllocations;
+	if (void* p = malloc(size > 0 ? size : 1))
+		return p;
+
+	throw std::bad_alloc();
+}
+
+void operator delete(void* p) noexcept
+{
+	free(p);
+}
+
+namespace SpeedPoint
+{
+	namespace UnitTest
+	{
+		static STestCase* g_pFirstTestCase = 0;
+		static unsigned int g_NumFailures = 0;
+
+		SRegisterTestCase::SRegisterTestCase(STestCase* pTestCase)
+		{
+			// Insert sorted by name, so the order does not depend on the link order
+			STestCase** ppNext = &g_pFirstTestCase;
+			while (*ppNext && strcmp((*ppNext)->name, pTestCase->name) < 0)
+				ppNext = &(*ppNext)->pNext;
+
+			pTestCase->pNext = *ppNext;
+			*ppNext = pTestCase;
+		}
+
+		void ReportFailure(const char* file, int line, const char* expression)
+		{
+			if (g_NumFailures < 1000)
+				printf("  %s(%d): check failed: %s\n", file, line, expression);
+
+			++g_NumFailures;
+		}
+
+		unsigned int GetNumHeapAllocations()
+		{
+			return g_NumHeapAllocations.load();
+		}
+	}
+}
+
+using namespace SpeedPoint::UnitTest;
+
+static bool MatchesFilter(const char* name, int numFilters, char** filters)
+{
+	if (numFilters == 0)
+		return true;
+
+	for (int i = 0; i < numFilters; ++i)
+	{
+		if (strncmp(name, filters[i], strlen(filters[i])) == 0)
+			return true;
+	}
+
+	return false;
+}
+
+int main(int argc, char** argv)
+{
+	bool runBenchmarks = false;
+	int numFilters = 0;
+	for (int i = 1; i < argc; ++i)
+	{
+		if (strcmp(argv[i], "-bench") == 0)
+			runBenchmarks = true;
+		else
+			argv[1 + numFilters++] = argv[i];
+	}
+
+	unsigned int numRun = 0, numFailed = 0;
+	for (STestCase* pTestCase = g_pFirstTestCase; pTestCase; pTestCase = pTestCase->pNext)
+	{
+		if (pTestCase->isBenchmark != runBenchmarks || !MatchesFilter(pTestCase->name, numFilters, argv + 1))
+			continue;
+
+		printf("[ RUN  ] %s\n", pTestCase->name);
+		unsigned int numFailuresBefore = g_NumFailures;
+		pTestCase->function();
+		++numRun;
+
+		if (g_NumFailures != numFailuresBefore)
+		{
+			++numFailed;
+			printf("[ FAIL ] %s\n", pTestCase->name);
+		}
+		else
+		{
+			printf("[  OK  ] %s\n", pTestCase->name);
+		}
+
+		fflush(stdout);
+	}
+
+	printf("%u of %u %s passed\n", numRun - numFailed, numRun, runBenchmarks ? "benchmarks" : "tests");
+	return (numFailed > 0 ? 1 : 0);
+}
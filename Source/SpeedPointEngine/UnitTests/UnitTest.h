@@ -0,0 +1,89 @@
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+//	SpeedPoint Game Engine
+//	Copyright (c) 2011-2018 Pascal Rosenkranz, All rights reserved.
+//
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+
+// Minimal test runner for the engine libraries.
+//
+// SP_TEST(name) defines a test that is run by default. SP_BENCHMARK(name) defines a benchmark that
+// is only run with the -bench argument. Both are registered at static initialization.
+// Further arguments filter the tests by name prefix:
+//
+//	UnitTests.exe [-bench] [name prefix...]
+
+namespace SpeedPoint
+{
+	namespace UnitTest
+	{
+		typedef void (*TestFunction)();
+
+		struct STestCase
+		{
+			const char* name;
+			TestFunction function;
+			bool isBenchmark;
+			STestCase* pNext;
+		};
+
+		struct SRegisterTestCase
+		{
+			SRegisterTestCase(STestCase* pTestCase);
+		};
+
+		// Counts a failed check of the current test and prints it
+		void ReportFailure(const char* file, int line, const char* expression);
+
+		// Returns:
+		//	The number of calls to the global operator new so far, on all threads
+		unsigned int GetNumHeapAllocations();
+
+		// Summary:
+		//	Calls fn() repeatedly and returns the fastest run in seconds
+		template<typename F>
+		double MeasureMin(unsigned int numRuns, F fn)
+		{
+			double best = 1e30;
+			for (unsigned int run = 0; run < numRuns; ++run)
+			{
+				auto start = std::chrono::high_resolution_clock::now();
+				fn();
+				double elapsed = std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - start).count();
+				if (elapsed < best)
+					best = elapsed;
+			}
+
+			return best;
+		}
+
+		// Prevents the compiler from optimizing away the computation of value
+		template<typename T>
+		inline void DoNotOptimize(const T& value)
+		{
+			static volatile const void* sink;
+			sink = &value;
+		}
+	}
+}
+
+#define SP_TEST_CASE(name, isBenchmark) \
+	static void SPTestCase_##name(); \
+	static SpeedPoint::UnitTest::STestCase g_SPTestCase_##name = { #name, SPTestCase_##name, isBenchmark, 0 }; \
+	static SpeedPoint::UnitTest::SRegisterTestCase g_SPRegisterTestCase_##name(&g_SPTestCase_##name); \
+	static void SPTestCase_##name()
+
+#define SP_TEST(name) SP_TEST_CASE(name, false)
+#define SP_BENCHMARK(name) SP_TEST_CASE(name, true)
+
+#define SP_CHECK(expression) \
+	do { if (!(expression)) SpeedPoint::UnitTest::ReportFailure(__FILE__, __LINE__, #expression); } while (0)
+
+#define SP_CHECK_NEAR(a, b, tolerance) \
+	do { if (!(fabs((double)(a) - (double)(b)) <= (double)(tolerance))) SpeedPoint::UnitTest::ReportFailure(__FILE__, __LINE__, #a " ~ " #b); } while (0)